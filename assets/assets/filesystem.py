@@ -23,13 +23,18 @@ from .base import AssetBase
 # http://elm-chan.org/docs/fat_e.html
 
 
-BLOCK_COUNT = 512
+BLOCK_COUNT = 4096
 IMAGE_SIZE = BLOCK_COUNT * 512
-FAT_SECTORS = 2
-FAT_DATA_ENTRIES = BLOCK_COUNT - 2 - FAT_SECTORS
-FAT_SIZE = 3 + FAT_DATA_ENTRIES + (FAT_DATA_ENTRIES + 1) // 2
+FAT_SECTORS = 12
+ROOT_ENTRY_COUNT = 64
+ROOT_SECTORS = ROOT_ENTRY_COUNT * 32 // 512
+DATA_START_SECTOR = 1 + FAT_SECTORS + ROOT_SECTORS
+FAT_DATA_ENTRIES = BLOCK_COUNT - DATA_START_SECTOR
+FAT_SIZE = 3 * ((FAT_DATA_ENTRIES + 3) // 2)
 
 assert (FAT_SIZE + 511) // 512 == FAT_SECTORS
+assert FAT_DATA_ENTRIES < 4085, 'Too many clusters for FAT12'
+assert ROOT_SECTORS * 512 == ROOT_ENTRY_COUNT * 32
 
 VOLUME_ID = int(datetime.datetime.now(datetime.UTC).timestamp()) & 0xFFFFFFFF
 VOLUME_NAME = 'BADGE'
@@ -75,7 +80,7 @@ class BootSector:
             ('B', 1),  # Sectors per cluster.
             ('H', 1),  # Sectors in reserved area.
             ('B', 1),  # Number of FATs. We only have a single copy.
-            ('H', 16),  # Number of entries in the root directory (16 entries of 32 bytes = 512 byte sector).
+            ('H', ROOT_ENTRY_COUNT),  # Number of entries in the root directory (16 entries per 512 byte sector).
             ('H', BLOCK_COUNT),  # Total number of sectors. Max 2**16-1 for FAT12/16 volume.
             ('B', self.media_type),
             ('H', FAT_SECTORS),  # FAT size in sectors.
@@ -133,6 +138,9 @@ class DirectoryEntry:
         safer and simpler. In proper systems, more complex logic is used (see http://elm-chan.org/docs/fat_e.html).
         """
         name = self.long_name.upper()
+        if name in ('.', '..'):
+            # Special entries at the start of subdirectories.
+            return name.ljust(11)
         if match := re.fullmatch(r'([A-Z0-9_]{1,8})\.([A-Z0-9_]{1,3})', name):
             prefix, suffix = match.groups()
             return prefix.ljust(8) + suffix.ljust(3)
@@ -158,7 +166,8 @@ class DirectoryEntry:
 
     def to_bytes(self):
         short_name = self.short_name
-        assert len(short_name) == 11 and VALID_SFN_REGEX.fullmatch(short_name), \
+        is_dot_entry = short_name.strip() in ('.', '..')
+        assert len(short_name) == 11 and (is_dot_entry or VALID_SFN_REGEX.fullmatch(short_name)), \
             f'Name "{short_name}" not a valid short name'
         name_bytes = short_name.encode('ascii')
         parts = [
@@ -232,10 +241,80 @@ class LongFileNameEntry:
         return data
 
 
+def path_hash(path: str) -> int:
+    """
+    32-bit FNV-1a hash of a file path with A-Z lowered, over its UTF-8 bytes. Must match `fs::data::path_hash` in
+    `fs/fs_data.hpp`, which only folds ASCII letters, so `str.lower()` would not match it for other letters.
+    """
+    value = 0x811C9DC5
+    for byte in path.encode('utf-8'):
+        if ord('A') <= byte <= ord('Z'):
+            byte += ord('a') - ord('A')
+        value ^= byte
+        value = (value * 0x01000193) & 0xFFFFFFFF
+    return value
+
+
+@dataclass
+class IndexedFile:
+    path: str
+    """ Full path of the file from the root directory, using forward slashes. """
+
+    offset: int
+    """ Byte offset of the file data within the disk image. """
+
+    size: int
+    """ File size in bytes. """
+
+
+class Directory:
+    path: str
+    entry: DirectoryEntry | None
+    parent: Directory | None
+    entries: list[DirectoryEntry | LongFileNameEntry]
+    subdirectories: dict[str, Directory]
+    clusters: list[int]
+
+    def __init__(self, path: str = '', entry: DirectoryEntry | None = None, parent: Directory | None = None):
+        self.path = path
+        self.entry = entry
+        self.parent = parent
+        self.entries = []
+        self.subdirectories = {}
+        self.clusters = []
+
+    @property
+    def is_root(self) -> bool:
+        return self.parent is None
+
+    @property
+    def cluster(self) -> int:
+        """ First cluster of this directory, or zero for the root directory (which is not stored in clusters). """
+        return self.clusters[0] if self.clusters else 0
+
+    def add_entry(self, entry: DirectoryEntry):
+        # Make sure the short name is unique within this directory.
+        existing = {e.short_name for e in self.entries if isinstance(e, DirectoryEntry)}
+        while entry.short_name in existing:
+            entry.disambiguation += 1
+        lfn_entries = entry.create_lfn_entries()
+        self.entries.extend(reversed(lfn_entries))
+        self.entries.append(entry)
+
+    def all_entries(self) -> list[DirectoryEntry | LongFileNameEntry]:
+        if self.is_root:
+            return self.entries
+        # Subdirectories start with the special "dot" and "dotdot" entries.
+        dot = DirectoryEntry(long_name='.', flags=DirEntryFlags.DIRECTORY, cluster=self.cluster)
+        dotdot = DirectoryEntry(long_name='..', flags=DirEntryFlags.DIRECTORY, cluster=self.parent.cluster)
+        return [dot, dotdot] + self.entries
+
+
 class Filesystem:
     boot_sector: BootSector
     table: list[int]
-    root_entries: list[DirectoryEntry | LongFileNameEntry]
+    root: Directory
+    files: list[IndexedFile]
     data: list[bytes | None]
 
     def __init__(self):
@@ -248,10 +327,11 @@ class Filesystem:
             # Remaining clusters are unused for now.
         ] + [0] * FAT_DATA_ENTRIES
 
-        self.root_entries = [
-            DirectoryEntry(long_name=self.boot_sector.volume_name, flags=DirEntryFlags.VOLUME_ID),
-        ]
+        self.root = Directory()
+        self.root.entries.append(
+            DirectoryEntry(long_name=self.boot_sector.volume_name, flags=DirEntryFlags.VOLUME_ID))
 
+        self.files = []
         self.data = [None] * FAT_DATA_ENTRIES
 
     def _claim_clusters(self, n_clusters) -> list[int]:
@@ -262,14 +342,22 @@ class Filesystem:
         if n_clusters > len(unused):
             raise Exception(f'Out of space; need {n_clusters} cluster(s) but only {len(unused)} free')
         claim = unused[:n_clusters]
+        # Clusters are never freed, so every claim is contiguous. The file index relies on this.
+        assert claim[-1] - claim[0] == n_clusters - 1, 'Fragmented cluster allocation'
         for i in range(n_clusters - 1):
             self.table[claim[i]] = claim[i + 1]
         self.table[claim[-1]] = END_OF_CHAIN
         return claim
 
+    def _store_clusters(self, clusters: list[int], content: bytes):
+        for i, cluster in enumerate(clusters):
+            self.data[cluster - 2] = content[i * 512:(i + 1) * 512]
+
     def _encode_fat12(self):
+        # Pad to an even number of entries, since entries are packed in pairs.
+        table = self.table + [0] * (len(self.table) % 2)
         table_bytes = []
-        for hi, lo in zip(self.table[:-1:2], self.table[1::2]):
+        for hi, lo in zip(table[0::2], table[1::2]):
             assert 0 <= hi <= 0xFFF
             assert 0 <= lo <= 0xFFF
             # Combine two 12-bit values into three little-endian bytes:
@@ -285,7 +373,21 @@ class Filesystem:
         assert len(data) == FAT_SIZE, f'Expected FAT data to be {FAT_SIZE} bytes, but is {len(data)}'
         return data
 
-    def add_file(self, name: str, content: bytes, *, hidden: bool = False):
+    def get_directory(self, path: str) -> Directory:
+        """
+        Get the directory with the given path, creating it (and any parents) if needed.
+        """
+        directory = self.root
+        for name in filter(None, path.split('/')):
+            if name not in directory.subdirectories:
+                entry = DirectoryEntry(long_name=name, flags=DirEntryFlags.DIRECTORY)
+                directory.add_entry(entry)
+                subdirectory = Directory(f'{directory.path}{name}/', entry, directory)
+                directory.subdirectories[name] = subdirectory
+            directory = directory.subdirectories[name]
+        return directory
+
+    def add_file(self, name: str, content: bytes, *, hidden: bool = False, directory: str = ''):
         flags = DirEntryFlags.ARCHIVE
         if hidden:
             flags = DirEntryFlags.HIDDEN | DirEntryFlags.SYSTEM
@@ -300,26 +402,48 @@ class Filesystem:
             size=len(content)
         )
 
-        lfn_entries = entry.create_lfn_entries()
-        self.root_entries.extend(reversed(lfn_entries))
-        self.root_entries.append(entry)
-
-        for i, cluster in enumerate(clusters):
-            if i + 1 < n_clusters:
-                self.data[cluster - 2] = content[i * 512:(i + 1) * 512]
-            else:
-                self.data[cluster - 2] = content[i * 512:]
+        parent = self.get_directory(directory)
+        parent.add_entry(entry)
+
+        if n_clusters > 0:
+            self._store_clusters(clusters, content)
+
+        offset = (DATA_START_SECTOR + clusters[0] - 2) * 512 if n_clusters > 0 else 0
+        self.files.append(IndexedFile(parent.path + name, offset, len(content)))
+
+    def _all_directories(self, directory: Directory | None = None):
+        directory = directory or self.root
+        yield directory
+        for subdirectory in directory.subdirectories.values():
+            yield from self._all_directories(subdirectory)
+
+    def _finalize_directories(self):
+        # Subdirectory contents are only known once all files are added, so claim their clusters last.
+        subdirectories = [d for d in self._all_directories() if not d.is_root]
+        for directory in subdirectories:
+            if directory.clusters:
+                continue  # Already finalized by a previous call.
+            n_entries = len(directory.entries) + 2
+            directory.clusters = self._claim_clusters((n_entries * 32 + 511) // 512)
+            directory.entry.cluster = directory.cluster
+        for directory in subdirectories:
+            content = b''.join(entry.to_bytes() for entry in directory.all_entries())
+            self._store_clusters(directory.clusters, content)
 
     def to_bytes(self):
+        self._finalize_directories()
+
         image_bytes = self.boot_sector.to_bytes()
 
         fat = self._encode_fat12()
         fat = fat.ljust(512 * FAT_SECTORS, b'\0')
         image_bytes += fat
 
-        assert len(self.root_entries) <= 16, f'Too many root entries, {len(self.root_entries)} > 16'
-        root_bytes = b''.join(entry.to_bytes() for entry in self.root_entries)
-        root_bytes = root_bytes.ljust(512, b'\0')
+        root_entries = self.root.all_entries()
+        assert len(root_entries) <= ROOT_ENTRY_COUNT, \
+            f'Too many root entries, {len(root_entries)} > {ROOT_ENTRY_COUNT}'
+        root_bytes = b''.join(entry.to_bytes() for entry in root_entries)
+        root_bytes = root_bytes.ljust(512 * ROOT_SECTORS, b'\0')
         image_bytes += root_bytes
 
         for data in self.data:
@@ -332,6 +456,22 @@ class Filesystem:
         assert len(image_bytes) == IMAGE_SIZE, f'Final image is {len(image_bytes)} bytes, expected {IMAGE_SIZE} bytes'
         return image_bytes
 
+    def build_index(self) -> list[int]:
+        """
+        Build an open addressing hash table over all files, with linear probing. Each slot holds the file index plus
+        one, or zero if the slot is empty. The table is kept at most half full so that probe sequences stay short.
+        """
+        size = 1
+        while size < 2 * len(self.files):
+            size *= 2
+        slots = [0] * size
+        for i, file in enumerate(self.files):
+            slot = path_hash(file.path) & (size - 1)
+            while slots[slot] != 0:
+                slot = (slot + 1) & (size - 1)
+            slots[slot] = i + 1
+        return slots
+
 
 class FilesystemAsset(AssetBase):
     def __init__(self):
@@ -346,7 +486,7 @@ class FilesystemAsset(AssetBase):
         self.dependencies.append(path)
         print(f'- File {name} added to disk image')
 
-    def add_archive(self, name: str, files: list[str]):
+    def add_archive(self, name: str, files: list[str], directory: str = ''):
         archive_buffer = io.BytesIO()
         archive = tarfile.open(name, 'w:gz', archive_buffer)
 
@@ -364,29 +504,56 @@ class FilesystemAsset(AssetBase):
         archive.close()
         del archive
 
-        self.fs.add_file(name, archive_buffer.getbuffer().tobytes())
+        self.fs.add_file(name, archive_buffer.getbuffer().tobytes(), directory=directory)
         print(f'- Archive {name} added to disk image')
 
-    def add(self, *, path: str, hidden: bool = False, archive: list[str] | None = None):
+    def add(self, *, path: str, hidden: bool = False, archive: list[str] | None = None, directory: str = ''):
         if archive:
-            self.add_archive(path, archive)
+            self.add_archive(path, archive, directory)
         else:
-            self.add_file(path, hidden=hidden)
+            self.add_file(path, hidden=hidden, directory=directory)
 
     def get_output(self):
         data = self.fs.to_bytes()
         print(f'- FAT filesystem image, {len(data) / 1024:.1f} KiB')
 
+        # Most of the volume is free space. Only include data up to the last used sector in the firmware, since the
+        # rest is never looked at until the host writes to it.
+        used_size = max([len(data.rstrip(b'\0'))] + [file.offset + file.size for file in self.fs.files])
+        data = data[:(used_size + 511) // 512 * 512]
+        print(f'- Disk image data, {len(data) / 1024:.1f} KiB')
+
+        index = self.fs.build_index()
+        print(f'- File index, {len(self.fs.files)} files in {len(index)} slots')
+
         header_lines = [
+            f'constexpr uint32_t DISK_IMAGE_ID = 0x{self.fs.boot_sector.volume_id:08x};',
             f'constexpr uint32_t DISK_IMAGE_SIZE = {len(data)};',
             f'constexpr uint32_t DISK_IMAGE_BLOCK_COUNT = {BLOCK_COUNT};',
             'extern const uint8_t DISK_IMAGE[];',
+            '',
+            f'constexpr uint32_t DISK_FILE_COUNT = {len(self.fs.files)};',
+            f'constexpr uint32_t DISK_FILE_INDEX_SIZE = {len(index)};',
+            'extern const fs::data::File DISK_FILES[];',
+            'extern const uint16_t DISK_FILE_INDEX[];',
         ]
         source_lines = [
             '#include <usb/tusb_config.h>',
             '',
-            'static_assert(DISK_IMAGE_BLOCK_COUNT * USB_MSC_BLOCK_SIZE == DISK_IMAGE_SIZE);',
+            'static_assert(DISK_IMAGE_SIZE <= DISK_IMAGE_BLOCK_COUNT * USB_MSC_BLOCK_SIZE);',
+            '',
+        ] + AssetBase.format_data_array(name='DISK_IMAGE', data=data) + [
+            '',
+            f'const fs::data::File DISK_FILES[{max(1, len(self.fs.files))}] = {{',
+        ] + [
+            f'    {{ "{file.path}", 0x{path_hash(file.path):08x}, {file.offset}, {file.size} }},'
+            for file in self.fs.files
+        ] + [
+            '};',
+            '',
+            '// Make sure the hash used to look up files matches the one used to build the index.',
+            'static_assert(fs::data::path_hash("README.txt") == 0x{:08x});'.format(path_hash('README.txt')),
             '',
-        ] + AssetBase.format_data_array(name='DISK_IMAGE', data=data)
+        ] + AssetBase.format_data_array(name='DISK_FILE_INDEX', data=index, data_type='uint16_t', data_bits=16)
 
         return header_lines, source_lines
@@ -60,6 +60,7 @@ class AssetCollection:
             '#include <badge/animation.hpp>',
             '#include <badge/font_data.hpp>',
             '#include <badge/image.hpp>',
+            '#include <fs/fs_data.hpp>',
             '',
         ]
         source_lines = [
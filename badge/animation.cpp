@@ -7,7 +7,11 @@
 namespace anim
 {
 
-    void Animation::initialize() {
+    void Animation::initialize(std::span<uint8_t> memory) {
+        assert(memory.size() >= MEMORY_SIZE);
+        palette = reinterpret_cast<Pixel *>(memory.data());
+        frame = memory.data() + 256 * sizeof(Pixel);
+
         current_ptr = data.data();
 
         n_frames = *current_ptr++;
@@ -15,7 +19,6 @@ namespace anim
         bpp = *current_ptr++;
 
         const auto n_colors = 1 << bpp;
-        palette.reset(new Pixel[n_colors]);
         for (int i = 0; i < n_colors; i++) {
             const auto r = *current_ptr++;
             const auto g = *current_ptr++;
@@ -23,8 +26,6 @@ namespace anim
             palette[i] = rgb888(r, g, b);
         }
 
-        frame.reset(new uint8_t[lcd::WIDTH * lcd::HEIGHT]);
-
         current_frame = 0;
         countdown = interval;
         frame0_ptr = current_ptr;
@@ -35,11 +36,15 @@ namespace anim
         countdown -= delta_ms;
         while (countdown < 0) {
             countdown += interval;
-            current_frame = (current_frame + 1) % n_frames;
-            read_frame();
+            next_frame();
         }
     }
 
+    void Animation::next_frame() {
+        current_frame = (current_frame + 1) % n_frames;
+        read_frame();
+    }
+
     void Animation::draw() const {
         auto* ptr = lcd::get_offscreen_ptr_unsafe();
         for (int y = 0; y < lcd::HEIGHT; y++) {
@@ -50,8 +55,8 @@ namespace anim
     }
 
     void Animation::reset() {
-        palette.reset();
-        frame.reset();
+        palette = nullptr;
+        frame = nullptr;
     }
 
     void Animation::read_frame() {
@@ -1,9 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <memory>
 #include <span>
 
+#include <badge/lcd.hpp>
 #include <badge/pixel.hpp>
 
 namespace anim
@@ -11,10 +12,16 @@ namespace anim
 
     class Animation {
     public:
+        /// Memory `initialize()` needs for the palette and the current frame.
+        static constexpr size_t MEMORY_SIZE = 256 * sizeof(Pixel) + lcd::WIDTH * lcd::HEIGHT;
+
         explicit Animation(std::span<const uint8_t> data) : data(data) {};
 
-        void initialize();
+        /// Start from the first frame, decoding into `memory`, which must last until `reset()`.
+        void initialize(std::span<uint8_t> memory);
         void update(int delta_ms);
+        /// Decode the next frame, as `update()` does once per frame interval.
+        void next_frame();
         void draw() const;
         void reset();
 
@@ -28,8 +35,8 @@ namespace anim
         int countdown = 0;
         const uint8_t* frame0_ptr = nullptr;
         const uint8_t* current_ptr = nullptr;
-        std::unique_ptr<Pixel[]> palette = {};
-        std::unique_ptr<uint8_t[]> frame = {};
+        Pixel *palette = nullptr;
+        uint8_t *frame = nullptr;
 
         void read_frame();
 
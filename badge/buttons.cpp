@@ -1,43 +1,201 @@
 #include "buttons.hpp"
 
+#include <bit>
+#include <cstring>
+
 #include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+#include <utils/ring_buffer.hpp>
 
 namespace buttons
 {
-    constexpr uint32_t MASK = 0
-        | (1 << BTN_UP)
-        | (1 << BTN_DOWN)
-        | (1 << BTN_LEFT)
-        | (1 << BTN_RIGHT)
-        | (1 << BTN_PUSH)
-        | (1 << BTN_A)
-        | (1 << BTN_B)
-        | (1 << BTN_C)
-        | (1 << BTN_D);
-
-    uint32_t current_state = 0;
-    uint32_t previous_state = 0;
-
-    void init_input(int pin) {
-        gpio_set_function(pin, GPIO_FUNC_SIO);
-        gpio_set_dir(pin, false);
-        gpio_set_input_enabled(pin, true);
-        gpio_pull_up(pin);
-    }
+
+    namespace
+    {
+        constexpr int MAX_EVENTS = 32;
+
+        /// Presses and releases from the interrupt handler, waiting for `update()`.
+        utils::RingBuffer<64 * sizeof(Event)> _queue;
+        static_assert(sizeof(Event) == 8);
+
+        /// Debounced level of each button, and when it last changed. Only changed with interrupts disabled.
+        volatile uint32_t _debounced = 0;
+        uint32_t _debounced_us[32] = {};
+
+        /// The state as seen by the UI, made of the events taken so far.
+        uint32_t _state = 0;
+        uint32_t _pressed_us[32] = {};
+        uint32_t _next_repeat_us[32] = {};
+        uint32_t _long_pressed = 0;
+
+        Event _events[MAX_EVENTS];
+        int _event_count = 0;
+
+        uint32_t current_state = 0;
+        uint32_t previous_state = 0;
+
+        bool override_active = false;
+        uint32_t override_state = 0;
+
+        void init_input(int pin) {
+            gpio_set_function(pin, GPIO_FUNC_SIO);
+            gpio_set_dir(pin, false);
+            gpio_set_input_enabled(pin, true);
+            gpio_pull_up(pin);
+        }
+
+        /// Buttons pull their pin low while pressed.
+        uint32_t read_levels() {
+            return ~gpio_get_all() & ALL;
+        }
+
+        /// Take a new level of a button, unless it changed too recently to be more than bounce. A level that is
+        /// still different once it settled is picked up by `settle()`.
+        void debounce(int pin, bool pressed, uint32_t now_us) {
+            if (pressed == ((_debounced >> pin) & 1) || now_us - _debounced_us[pin] < DEBOUNCE_US)
+                return;
+            _debounced = _debounced ^ (1u << pin);
+            _debounced_us[pin] = now_us;
+
+            // If the queue is full, the event is lost, but `update()` still catches up with the level.
+            const Event event = {now_us, static_cast<uint8_t>(pin), pressed ? EVENT_PRESS : EVENT_RELEASE};
+            _queue.push({reinterpret_cast<const uint8_t *>(&event), sizeof(event)});
+        }
+
+        void on_gpio_irq() {
+            const auto now_us = time_us_32();
+            const auto levels = read_levels();
+            for (auto bits = ALL; bits != 0; bits &= bits - 1) {
+                const int pin = std::countr_zero(bits);
+                const auto events = gpio_get_irq_event_mask(pin);
+                if (events == 0)
+                    continue;
+                gpio_acknowledge_irq(pin, events);
+                debounce(pin, (levels >> pin) & 1, now_us);
+            }
+        }
+
+        /// Take levels that differ from the debounced ones once their bouncing is over, as no edge may come then.
+        void settle() {
+            // The time is read with interrupts disabled, so no edge taken meanwhile is newer than it.
+            const auto status = save_and_disable_interrupts();
+            const auto now_us = time_us_32();
+            const auto levels = read_levels();
+            for (auto bits = levels ^ _debounced; bits != 0; bits &= bits - 1) {
+                const int pin = std::countr_zero(bits);
+                debounce(pin, (levels >> pin) & 1, now_us);
+            }
+            restore_interrupts(status);
+        }
+
+        bool pop(Event &event) {
+            const auto data = _queue.peek();
+            if (data.size() < sizeof(event))
+                return false; // Events never wrap around, as the size of the queue is a multiple of theirs.
+            memcpy(&event, data.data(), sizeof(event));
+            _queue.pop(sizeof(event));
+            return true;
+        }
+
+        void add_event(uint32_t time_us, int pin, EventType type) {
+            if (_event_count < MAX_EVENTS)
+                _events[_event_count++] = {time_us, static_cast<uint8_t>(pin), type};
+        }
+
+        /// Add the long presses and repeats of the held buttons that are due by `time_us`.
+        void add_held_events(uint32_t time_us) {
+            for (auto bits = _state; bits != 0; bits &= bits - 1) {
+                const int pin = std::countr_zero(bits);
+                if (!(_long_pressed & (1u << pin)) &&
+                    static_cast<int32_t>(time_us - _pressed_us[pin] - LONG_PRESS_US) >= 0) {
+                    add_event(_pressed_us[pin] + LONG_PRESS_US, pin, EVENT_LONG_PRESS);
+                    _long_pressed |= 1u << pin;
+                }
+                while (static_cast<int32_t>(time_us - _next_repeat_us[pin]) >= 0) {
+                    add_event(_next_repeat_us[pin], pin, EVENT_REPEAT);
+                    _next_repeat_us[pin] += REPEAT_INTERVAL_US;
+                }
+            }
+        }
+
+        void set_state(int pin, bool pressed, uint32_t time_us) {
+            if (pressed == ((_state >> pin) & 1))
+                return;
+            add_held_events(time_us);
+            _state ^= 1u << pin;
+            if (pressed) {
+                _pressed_us[pin] = time_us;
+                _next_repeat_us[pin] = time_us + REPEAT_DELAY_US;
+                _long_pressed &= ~(1u << pin);
+            }
+            add_event(time_us, pin, pressed ? EVENT_PRESS : EVENT_RELEASE);
+        }
+    } // namespace
 
     void init() {
         for (int i = 0; i < 32; i++)
-            if (MASK & (1 << i))
+            if (ALL & (1 << i))
                 init_input(i);
+
+        _debounced = read_levels();
+        gpio_add_raw_irq_handler_masked(ALL, on_gpio_irq);
+        for (int i = 0; i < 32; i++)
+            if (ALL & (1 << i))
+                gpio_set_irq_enabled(i, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
+        irq_set_enabled(IO_IRQ_BANK0, true);
     }
 
     void update() {
+        settle();
+
+        // Events from the buttons are dropped while overridden, and the difference made up afterwards.
+        _event_count = 0;
+        Event event;
+        while (pop(event))
+            if (!override_active)
+                set_state(event.button, event.type == EVENT_PRESS, event.time_us);
+
+        // Only read now, as an edge may have come in while the queue was drained. The time of each event taken is
+        // then no later than this, and held times do not wrap around.
+        const auto now_us = time_us_32();
+
+        const auto target = override_active ? override_state & ALL : _debounced;
+        for (auto bits = target ^ _state; bits != 0; bits &= bits - 1) {
+            const int pin = std::countr_zero(bits);
+            set_state(pin, (target >> pin) & 1, now_us);
+        }
+        add_held_events(now_us);
+
         previous_state = current_state;
-        current_state = ~gpio_get_all() & MASK;
+        current_state = _state;
+    }
+
+    std::optional<uint32_t> get_queued_time_us() {
+        const auto data = _queue.peek();
+        if (data.size() < sizeof(Event))
+            return std::nullopt;
+        Event event;
+        memcpy(&event, data.data(), sizeof(event));
+        return event.time_us;
+    }
+
+    std::span<const Event> get_events() {
+        return {_events, static_cast<size_t>(_event_count)};
+    }
+
+    uint32_t get_events(EventType type, uint32_t mask) {
+        uint32_t buttons = 0;
+        for (const auto &event : get_events())
+            if (event.type == type)
+                buttons |= 1u << event.button;
+        return buttons & mask;
     }
 
     uint32_t get(uint32_t mask) {
-        return (current_state & mask) & ~(previous_state & mask);
+        return get_events(EVENT_PRESS, mask);
     }
 
     uint32_t get_current(uint32_t mask) {
@@ -45,7 +203,17 @@ namespace buttons
     }
 
     uint32_t get_changed(uint32_t mask) {
-        return (current_state & mask) ^ (previous_state & mask);
+        const auto toggled = get_events(EVENT_PRESS, mask) | get_events(EVENT_RELEASE, mask);
+        return ((current_state ^ previous_state) & mask) | toggled;
+    }
+
+    void set_override(uint32_t state) {
+        override_active = true;
+        override_state = state;
+    }
+
+    void clear_override() {
+        override_active = false;
     }
 
 }
@@ -1,23 +1,81 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
+#include <span>
 
 #include "badge-2025.h"
 
 namespace buttons
 {
 
+    /// Mask of all buttons, as `1 << BTN_*`.
+    constexpr uint32_t ALL = 0
+        | (1 << BTN_UP)
+        | (1 << BTN_DOWN)
+        | (1 << BTN_LEFT)
+        | (1 << BTN_RIGHT)
+        | (1 << BTN_PUSH)
+        | (1 << BTN_A)
+        | (1 << BTN_B)
+        | (1 << BTN_C)
+        | (1 << BTN_D);
+
+    /// A change of level must last this long to count, so a bouncing contact makes a single press or release.
+    constexpr uint32_t DEBOUNCE_US = 5'000;
+
+    /// How long a button is held before it makes a long press, and before and between its repeats.
+    constexpr uint32_t LONG_PRESS_US = 600'000;
+    constexpr uint32_t REPEAT_DELAY_US = 400'000;
+    constexpr uint32_t REPEAT_INTERVAL_US = 100'000;
+
+    enum EventType : uint8_t {
+        EVENT_PRESS,
+        EVENT_RELEASE,
+        EVENT_LONG_PRESS, ///< Once per press, `LONG_PRESS_US` after it, if still held.
+        EVENT_REPEAT,     ///< Every `REPEAT_INTERVAL_US` while held, starting `REPEAT_DELAY_US` after the press.
+    };
+
+    struct Event {
+        uint32_t time_us; ///< When it happened, from `time_us_32()`.
+        uint8_t button;   ///< As `BTN_*`.
+        EventType type;
+    };
+
+    /**
+     * Set up the buttons. Presses and releases are caught by GPIO interrupts as they happen, debounced, and queued
+     * with their time, so even presses shorter than a frame are seen.
+     */
     void init();
+
+    /// Take the events queued since the last update, and add the long presses and repeats due by now.
     void update();
 
+    /// Time of the oldest press or release the next `update()` will take, if any.
+    std::optional<uint32_t> get_queued_time_us();
+
+    /// The events of the last `update()`, oldest first.
+    std::span<const Event> get_events();
+
+    /// Mask of the buttons in `mask` with an event of the given type in the last `update()`.
+    uint32_t get_events(EventType type, uint32_t mask);
+
+    /// Buttons pressed since the update before, even if they were released again already.
     uint32_t get(uint32_t mask);
     uint32_t get_current(uint32_t mask);
     uint32_t get_changed(uint32_t mask);
 
+    /// Make `update()` report the given button state (a mask of `1 << BTN_*`) instead of reading the GPIOs, until
+    /// `clear_override()` is called. Used to drive the UI from scripts.
+    void set_override(uint32_t state);
+    void clear_override();
+
 #define MAKE_BUTTON_FUNCS(name, NAME)                                                                                  \
     inline bool name() { return get(1 << NAME); }                                                                      \
     inline bool name##_current() { return get_current(1 << NAME); }                                                    \
-    inline bool name##_changed() { return get_changed(1 << NAME); }
+    inline bool name##_changed() { return get_changed(1 << NAME); }                                                    \
+    inline bool name##_long_press() { return get_events(EVENT_LONG_PRESS, 1 << NAME); }                                \
+    inline bool name##_repeat() { return get_events(EVENT_REPEAT, 1 << NAME); }
 
     MAKE_BUTTON_FUNCS(up, BTN_UP)
     MAKE_BUTTON_FUNCS(down, BTN_DOWN)
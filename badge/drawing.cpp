@@ -4,6 +4,8 @@
 
 #include <hardware/interp.h>
 
+#include "profiler.hpp"
+
 namespace drawing
 {
 
@@ -183,6 +185,7 @@ namespace drawing
     }
 
     void copy(int left, int top, int width, int height, int stride, const Pixel *pixels) {
+        profiler::Scope scope(profiler::ZONE_BLIT);
         const auto offset = validate_rect(left, top, width, height, stride);
         if (offset < 0)
             return;
@@ -197,6 +200,7 @@ namespace drawing
     }
 
     void copy_alpha(int left, int top, int width, int height, int stride, const Pixel *pixels, const uint8_t *alpha) {
+        profiler::Scope scope(profiler::ZONE_BLIT);
         const auto offset = validate_rect(left, top, width, height, stride);
         if (offset < 0)
             return;
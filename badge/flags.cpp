@@ -2,6 +2,7 @@
 
 #include <array>
 #include <assets.hpp>
+#include <bit>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
@@ -26,15 +27,21 @@ namespace flags
 
     static const auto FLAG_DIGESTS __attribute__((used)) = compute_digests();
 
-    static std::vector<Flag> _foundFlags = {};
-    static size_t _nextStorageIndex = 0;
+    /// Every flag there is. Built by shifting right, which stays defined with all 64 bits in use.
+    static constexpr FlagSet ALL_FLAGS = ~FlagSet{0} >> (64 - FLAG_COUNT);
 
-    static bool has_flag(Flag flag) {
-        for (auto f : _foundFlags) {
-            if (flag == f)
-                return true;
-        }
-        return false;
+    static FlagSet _foundFlags = 0;
+    static size_t _nextLogIndex = 0;
+
+    static FlagSet load_found_flags() {
+        const auto* words = storage::ram_data->found_flags;
+        return static_cast<FlagSet>(words[1]) << 32 | words[0];
+    }
+
+    static void store_found_flags() {
+        auto* words = storage::ram_data->found_flags;
+        words[0] = static_cast<uint32_t>(_foundFlags);
+        words[1] = static_cast<uint32_t>(_foundFlags >> 32);
     }
 
     static Flag validate_flag(const std::string &text) {
@@ -46,38 +53,59 @@ namespace flags
         return INVALID;
     }
 
-    void init() {
-        printf("> Loading flags from storage...\n");
-        // Reset our flag cache.
-        _foundFlags.clear();
-        // Go through stored flags and collect valid ones.
-        std::vector<std::string> valid_flags;
+    static void migrate_flag_log() {
+        // Version 0 storage only has the plaintext log, so this is the one time we need to validate every stored
+        // flag. Afterwards, the found flag set is the source of truth and the log is left as is.
+        printf("  Migrating flags from storage version %d\n", static_cast<int>(storage::ram_data->version));
         size_t idx = 0;
-        while (idx < storage::FLAG_STORAGE_SIZE) {
-            const auto n = strnlen(storage::ram_data->entered_flags + idx, storage::FLAG_STORAGE_SIZE - idx);
+        while (idx < storage::FLAG_LOG_SIZE) {
+            const auto n = strnlen(storage::ram_data->flag_log + idx, storage::FLAG_LOG_SIZE - idx);
             if (n == 0)
                 break;
-            const auto text = std::string(storage::ram_data->entered_flags + idx, n);
-            const auto flag = validate_flag(text);
-            if (flag != INVALID && !has_flag(flag)) {
-                printf("  Found flag %d\n", flag);
-                _foundFlags.push_back(flag);
-                valid_flags.push_back(text);
-            }
+            const auto flag = validate_flag(std::string(storage::ram_data->flag_log + idx, n));
+            if (flag != INVALID)
+                _foundFlags |= FlagSet{1} << flag;
             idx += n + 1;
         }
-        // Clear and write back all valid flags to storage.
-        memset(storage::ram_data->entered_flags, 0, storage::FLAG_STORAGE_SIZE);
-        idx = 0;
-        for (const auto& flag : valid_flags) {
-            memcpy(storage::ram_data->entered_flags + idx, flag.c_str(), flag.size());
-            idx += flag.size() + 1;
+        store_found_flags();
+        storage::ram_data->version = storage::STORAGE_VERSION;
+    }
+
+    static size_t find_log_end() {
+        size_t idx = 0;
+        while (idx < storage::FLAG_LOG_SIZE) {
+            const auto n = strnlen(storage::ram_data->flag_log + idx, storage::FLAG_LOG_SIZE - idx);
+            if (n == 0)
+                break;
+            idx += n + 1;
         }
-        assert(idx <= storage::FLAG_STORAGE_SIZE);
-        // Store the index we ended at, for when we want to add more entered flags to storage.
-        _nextStorageIndex = idx;
-        // Save the possibly updated flags. If we ended up with the same stored data we started with, then
-        // this function will simply return without doing unnecessary FLASH writes.
+        return idx;
+    }
+
+    static void append_to_log(const std::string &text) {
+#if FLAG_AUDIT_LOG
+        // Entries are never rewritten or compacted; once the log is full we only keep the found flag set.
+        if (_nextLogIndex + text.size() + 1 > storage::FLAG_LOG_SIZE) {
+            printf("  Flag log full\n");
+            return;
+        }
+        memcpy(storage::ram_data->flag_log + _nextLogIndex, text.c_str(), text.size());
+        _nextLogIndex += text.size() + 1;
+#else
+        (void)text;
+#endif
+    }
+
+    void init() {
+        printf("> Loading flags from storage...\n");
+        _foundFlags = 0;
+        if (storage::ram_data->version == 0)
+            migrate_flag_log();
+        _foundFlags = load_found_flags() & ALL_FLAGS;
+        printf("  Found %d flags\n", count_found_flags());
+        _nextLogIndex = find_log_end();
+        // Save the possibly migrated data. If nothing changed, then this function will simply return without doing
+        // unnecessary FLASH writes.
         storage::save();
     }
 
@@ -94,18 +122,25 @@ namespace flags
             return flag;
         }
         printf("  Accepting new flag %d\n", flag);
-        _foundFlags.push_back(flag);
-        memcpy(storage::ram_data->entered_flags + _nextStorageIndex, text.c_str(), text.size());
-        _nextStorageIndex += text.size() + 1;
-        assert(_nextStorageIndex <= storage::FLAG_STORAGE_SIZE);
+        _foundFlags |= FlagSet{1} << flag;
+        store_found_flags();
+        append_to_log(text);
         storage::save();
         return flag;
     }
 
-    const std::vector<Flag> &get_found_flags() {
+    bool has_flag(Flag flag) {
+        return flag < FLAG_COUNT && (_foundFlags & (FlagSet{1} << flag)) != 0;
+    }
+
+    FlagSet get_found_flags() {
         return _foundFlags;
     }
 
+    int count_found_flags() {
+        return std::popcount(_foundFlags);
+    }
+
     std::string get_konami_code() {
         // The konami flag is special because we need to print it ourselves.
         static constexpr auto KONAMI = get_plaintext_flag(BADGE_KONAMI);
@@ -2,7 +2,6 @@
 
 #include <cstdint>
 #include <string>
-#include <vector>
 
 #include <badge/image.hpp>
 
@@ -62,9 +61,17 @@ namespace flags
         INVALID,
     };
 
+    static_assert(FLAG_COUNT <= 64, "Found flags are stored as a 64-bit set");
+
+    /// Set of flags, with bit N set if flag N is included.
+    using FlagSet = uint64_t;
+
     void init();
     Flag enter_flag(const std::string& text);
-    const std::vector<Flag>& get_found_flags();
+
+    bool has_flag(Flag flag);
+    FlagSet get_found_flags();
+    int count_found_flags();
 
     std::string get_konami_code();
 
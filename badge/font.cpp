@@ -5,6 +5,7 @@
 
 #include <assets.hpp>
 #include <badge/drawing.hpp>
+#include <badge/profiler.hpp>
 
 namespace font
 {
@@ -41,6 +42,7 @@ namespace font
     TextDraw Font::render(std::string_view text) const {
         if (text.empty())
             return {};
+        profiler::Scope scope(profiler::ZONE_FONT);
 
         TextDraw result = {};
 
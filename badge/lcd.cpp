@@ -10,6 +10,8 @@
 
 #include <pico/stdlib.h>
 
+#include "profiler.hpp"
+
 #define WRITE_VALUE(name, value) gpio_put(name, (value) ? 1 : 0)
 #define WRITE_HIGH(name)         WRITE_VALUE(name, true)
 #define WRITE_LOW(name)          WRITE_VALUE(name, false)
@@ -36,6 +38,9 @@ namespace lcd::internal
 
     bool _dmaActive = true;
 
+    SwapCallback _swapCallback = nullptr;
+    uint32_t _frameCount = 0;
+
     void wait_for_spi() {
         if (_dmaActive) {
             dma_channel_wait_for_finish_blocking(txDmaChannel);
@@ -354,6 +359,15 @@ namespace lcd
         gpio_put(LCD_LED_PIN, true);
     }
 
+    void wait_for_transfer() {
+        wait_for_spi();
+    }
+
+    void set_spi_clock() {
+        wait_for_spi();
+        spi_set_baudrate(LCD_SPI_PORT, SPI_FREQ);
+    }
+
     Pixel *get_offscreen_ptr_unsafe() { return _offScreenFrame; }
 
     void swap() {
@@ -361,11 +375,27 @@ namespace lcd
         _onScreenFrame = _offScreenFrame;
         _offScreenFrame = tmp;
 
-        wait_for_spi();
+        {
+            profiler::Scope scope(profiler::ZONE_SPI_WAIT);
+            wait_for_spi();
+        }
         select_command();
         write(CMD_MEMORY_WRITE);
         select_data();
         write_dma16(_onScreenFrame, sizeof(Pixel) * WIDTH * HEIGHT);
+        _frameCount++;
+
+        // The previous frame stays intact in the off-screen buffer until the UI starts drawing the next one.
+        if (_swapCallback != nullptr)
+            _swapCallback(_onScreenFrame, _offScreenFrame);
+    }
+
+    uint32_t get_frame_count() {
+        return _frameCount;
+    }
+
+    void set_swap_callback(SwapCallback callback) {
+        _swapCallback = callback;
     }
 
 } // namespace lcd
@@ -167,8 +167,22 @@ namespace lcd
     void backlight_on(int pct);
     void backlight_off();
 
+    /// Wait for the frame being sent, so the system clock can be changed without garbling it.
+    void wait_for_transfer();
+
+    /// Set the SPI clock again after the system clock, which it is derived from, was changed.
+    void set_spi_clock();
+
     Pixel *get_offscreen_ptr_unsafe();
 
     void swap();
 
+    /// Number of frames swapped onto the screen so far.
+    uint32_t get_frame_count();
+
+    /// Called by `swap()` with the frame that is now being shown, and the frame that was shown before it.
+    using SwapCallback = void (*)(const Pixel *frame, const Pixel *previous);
+
+    void set_swap_callback(SwapCallback callback);
+
 } // namespace lcd
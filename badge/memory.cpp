@@ -0,0 +1,141 @@
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <pico.h>
+
+// The host build counts allocations the same way, with the host's allocator. It has no fixed heap or painted stack to
+// measure, so those figures stay zero there.
+#if PICO_ON_DEVICE
+extern "C" {
+    // Bounds of the core0 stack and the heap, from the Pico SDK linker script.
+    extern uint32_t __StackBottom[];
+    extern uint32_t __StackTop[];
+    extern char __HeapLimit[];
+}
+#endif
+
+namespace memory
+{
+
+    namespace
+    {
+#if PICO_ON_DEVICE
+        /// Fills the stack below where it has ever been.
+        constexpr uint32_t STACK_PAINT = 0xDEADBEEF;
+        /// Left unpainted below the stack pointer, for whatever an interrupt might push meanwhile.
+        constexpr size_t STACK_MARGIN = 64;
+#endif
+
+        uint32_t _live = 0;
+        uint32_t _peak = 0;
+        uint32_t _allocations = 0;
+        uint32_t _stateAllocations = 0;
+        uint32_t _statePeak = 0;
+        uint32_t _stateBase = 0; ///< Bytes allocated when the UI entered the current state.
+
+        void *allocate(size_t size) {
+            // The Pico SDK's malloc panics when out of memory by itself. The host's returns null.
+            auto *ptr = malloc(size != 0 ? size : 1);
+            if (ptr == nullptr)
+                panic("Out of memory for %zu bytes", size);
+            _live += malloc_usable_size(ptr);
+            _peak = std::max(_peak, _live);
+            _statePeak = std::max(_statePeak, _live);
+            _allocations++;
+            _stateAllocations++;
+            return ptr;
+        }
+
+        void deallocate(void *ptr) {
+            if (ptr == nullptr)
+                return;
+            _live -= malloc_usable_size(ptr);
+            free(ptr);
+        }
+
+#if PICO_ON_DEVICE
+        uint32_t find_stack_used() {
+            const auto *word = __StackBottom;
+            while (word < __StackTop && *word == STACK_PAINT)
+                word++;
+            return reinterpret_cast<uintptr_t>(__StackTop) - reinterpret_cast<uintptr_t>(word);
+        }
+#endif
+    } // namespace
+
+    void init() {
+#if PICO_ON_DEVICE
+        uint32_t sp;
+        asm volatile("mov %0, sp" : "=r"(sp));
+        auto *end = reinterpret_cast<uint32_t *>(sp - STACK_MARGIN);
+        for (auto *word = __StackBottom; word < end; word++)
+            *word = STACK_PAINT;
+#endif
+    }
+
+    Stats get_stats() {
+        Stats stats = {
+            .heap_live = _live,
+            .heap_peak = _peak,
+            .heap_free = 0,
+            .heap_top_free = 0,
+            .allocations = _allocations,
+            .state_allocations = _stateAllocations,
+            .state_peak = _statePeak - _stateBase,
+            .stack_used = 0,
+            .stack_size = 0,
+        };
+#if PICO_ON_DEVICE
+        // The top of the heap is the chunk malloc keeps at the end of its arena, plus whatever it did not claim yet.
+        const auto info = mallinfo();
+        const auto unclaimed = static_cast<uint32_t>(__HeapLimit - static_cast<char *>(sbrk(0)));
+        stats.heap_free = static_cast<uint32_t>(info.fordblks) + unclaimed;
+        stats.heap_top_free = static_cast<uint32_t>(info.keepcost) + unclaimed;
+        stats.stack_used = find_stack_used();
+        stats.stack_size = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(__StackTop) -
+                                                 reinterpret_cast<uintptr_t>(__StackBottom));
+#endif
+        return stats;
+    }
+
+    void reset_peak() {
+        _peak = _live;
+    }
+
+    void begin_state() {
+        _stateAllocations = 0;
+        _statePeak = _live;
+        _stateBase = _live;
+    }
+
+} // namespace memory
+
+void *operator new(size_t size) {
+    return memory::allocate(size);
+}
+
+void *operator new[](size_t size) {
+    return memory::allocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    memory::deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    memory::deallocate(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    memory::deallocate(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    memory::deallocate(ptr);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Heap and stack usage at runtime.
+ *
+ * All C++ allocations go through the counting `operator new` and `operator delete` defined here, which track the
+ * bytes in use and their peak. Besides the totals, the counts restart whenever the UI enters another state, so they
+ * tell what the current state allocates. The core0 stack is painted with a pattern at boot, and the deepest point
+ * reached is found by looking for where the pattern was overwritten.
+ */
+namespace memory
+{
+
+    struct __packed Stats {
+        uint32_t heap_live;         ///< Bytes allocated right now, as reported by the allocator.
+        uint32_t heap_peak;         ///< Most bytes allocated at once since `reset_peak()`.
+        uint32_t heap_free;         ///< Bytes the heap could still hand out, in any number of blocks.
+        uint32_t heap_top_free;     ///< Free space at the top of the heap, which one block of that size certainly fits
+                                    ///< in. Free blocks further down may be larger.
+        uint32_t allocations;       ///< Allocations since boot.
+        uint32_t state_allocations; ///< Allocations since the UI entered the current state.
+        uint32_t state_peak;        ///< Most bytes allocated at once on top of what was allocated when the UI
+                                    ///< entered the current state.
+        uint32_t stack_used;        ///< Deepest use of the core0 stack since boot.
+        uint32_t stack_size;
+    };
+
+    /// Paint the unused part of the stack. Called first thing by `main()`.
+    void init();
+
+    /// Current usage. Finding the stack's high-water mark scans the stack, so this is not meant for every allocation.
+    Stats get_stats();
+
+    /// Start measuring the heap's peak again from what is allocated right now.
+    void reset_peak();
+
+    /// Restart the counts for the current state. Called by the UI whenever the current state changes.
+    void begin_state();
+
+} // namespace memory
@@ -0,0 +1,153 @@
+#include "power.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <hardware/clocks.h>
+#include <hardware/uart.h>
+#include <pico/time.h>
+
+#include "buttons.hpp"
+#include "lcd.hpp"
+
+namespace power
+{
+
+    namespace
+    {
+        constexpr const char *LEVEL_NAMES[] = {"active", "idle", "asleep"};
+
+        Level _level = LEVEL_ACTIVE;
+        int _frame_interval_ms = 0;
+        uint32_t _active_clock_khz = 0;
+
+        /// When anything last kept the badge busy.
+        uint64_t _busy_us = 0;
+
+        /// When the main loop comes around next while asleep. No frames run then, so the time since the last one is
+        /// no use for that.
+        absolute_time_t _sleep_loop_time = {};
+
+        /// Set while the first frame after waking up runs, with the time of the button press that woke the badge.
+        bool _waking = false;
+        uint32_t _wake_press_us = 0;
+        uint32_t _wake_latency_us = 0;
+
+        void set_clock_khz(uint32_t khz) {
+            // The SPI and UART clocks are derived from the system clock. Let what they are sending finish first, and
+            // set their rates again for the new clock after.
+            lcd::wait_for_transfer();
+            uart_tx_wait_blocking(uart_default);
+            if (!set_sys_clock_khz(khz, false)) {
+                printf("! Power: Cannot run at %lu kHz\n", khz);
+                return;
+            }
+            lcd::set_spi_clock();
+            uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+        }
+
+        void set_level(Level level) {
+            if (level == _level)
+                return;
+            printf("> Power: %s\n", LEVEL_NAMES[level]);
+
+            if (_level == LEVEL_SLEEP) {
+                lcd::exit_sleep();
+                lcd::display_on();
+            }
+            if (level == LEVEL_ACTIVE) {
+                set_clock_khz(_active_clock_khz);
+                lcd::set_idle_mode(false);
+                lcd::backlight_on(BACKLIGHT_PCT);
+            }
+            else if (level == LEVEL_IDLE) {
+                set_clock_khz(IDLE_CLOCK_KHZ);
+                lcd::set_idle_mode(true);
+                lcd::backlight_on(IDLE_BACKLIGHT_PCT);
+            }
+            else {
+                lcd::backlight_off();
+                lcd::display_off();
+                lcd::enter_sleep();
+                _sleep_loop_time = make_timeout_time_ms(SLEEP_LOOP_INTERVAL_MS);
+            }
+            _level = level;
+        }
+
+        int get_interval_ms() {
+            return _level == LEVEL_ACTIVE ? _frame_interval_ms : IDLE_FRAME_INTERVAL_MS;
+        }
+
+        void wake() {
+            set_level(LEVEL_ACTIVE);
+            _busy_us = time_us_64();
+        }
+    } // namespace
+
+    void init(int frame_interval_ms) {
+        _frame_interval_ms = frame_interval_ms;
+        _active_clock_khz = clock_get_hz(clk_sys) / 1000;
+        _busy_us = time_us_64();
+    }
+
+    bool begin_frame(int64_t delta_ms, bool host_busy) {
+        if (_level != LEVEL_ACTIVE) {
+            if (const auto press_us = buttons::get_queued_time_us()) {
+                const auto level = _level;
+                wake();
+                _waking = true;
+                _wake_press_us = *press_us;
+
+                // Take the events now, so the UI does not see them.
+                if (level == LEVEL_SLEEP)
+                    buttons::update();
+                return true;
+            }
+            if (host_busy) {
+                wake();
+                return true;
+            }
+        }
+        return _level != LEVEL_SLEEP && delta_ms >= get_interval_ms();
+    }
+
+    void wait(int64_t delta_ms) {
+        if (_level == LEVEL_SLEEP) {
+            if (time_reached(_sleep_loop_time))
+                _sleep_loop_time = make_timeout_time_ms(SLEEP_LOOP_INTERVAL_MS);
+            best_effort_wfe_or_timeout(_sleep_loop_time);
+            return;
+        }
+        const auto remaining_ms = std::max<int64_t>(get_interval_ms() - delta_ms, 0);
+        best_effort_wfe_or_timeout(make_timeout_time_ms(remaining_ms));
+    }
+
+    void end_frame(bool busy) {
+        if (_waking) {
+            _wake_latency_us = time_us_32() - _wake_press_us;
+            _waking = false;
+            printf("> Power: Awake %lu us after the button press\n", _wake_latency_us);
+        }
+
+        const auto now_us = time_us_64();
+        if (busy || !buttons::get_events().empty() || buttons::get_current(buttons::ALL) != 0) {
+            _busy_us = now_us;
+            set_level(LEVEL_ACTIVE);
+        }
+        else if (_level == LEVEL_ACTIVE && now_us - _busy_us >= IDLE_AFTER_MS * 1000ull) {
+            set_level(LEVEL_IDLE);
+        }
+        else if (_level == LEVEL_IDLE && now_us - _busy_us >= SLEEP_AFTER_MS * 1000ull) {
+            set_level(LEVEL_SLEEP);
+        }
+    }
+
+    Level get_level() {
+        return _level;
+    }
+
+    uint32_t get_wake_latency_us() {
+        return _wake_latency_us;
+    }
+
+} // namespace power
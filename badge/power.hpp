@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Idle governor, to make the battery last.
+ *
+ * The badge idles when the screen is static (see `ui::State::is_static()`) and no button is used and nothing comes
+ * from the USB host. Frames then come less often, the system clock is lowered, and the LCD is put in idle mode with
+ * a dimmer backlight. Later the badge sleeps: the LCD and its backlight are off and no frames run at all.
+ *
+ * The main loop waits for frames with interrupts enabled, so a button press ends the wait and wakes the badge at
+ * once. The press that wakes the badge from sleep is not passed on to the UI, as the screen was dark. The USB host
+ * wakes the badge too, by sending it something or by stepping it remotely.
+ */
+namespace power
+{
+
+    enum Level : uint8_t {
+        LEVEL_ACTIVE,
+        LEVEL_IDLE,
+        LEVEL_SLEEP,
+    };
+
+    constexpr uint32_t IDLE_AFTER_MS = 10'000;
+    constexpr uint32_t SLEEP_AFTER_MS = 120'000;
+
+    constexpr int IDLE_FRAME_INTERVAL_MS = 250;
+
+    /// While asleep, the main loop still comes around this often, for USB and the filesystem.
+    constexpr int SLEEP_LOOP_INTERVAL_MS = 1'000;
+
+    constexpr uint32_t IDLE_CLOCK_KHZ = 48'000;
+
+    constexpr int BACKLIGHT_PCT = 20;
+    constexpr int IDLE_BACKLIGHT_PCT = 5;
+
+    /// Start out active, with a frame every `frame_interval_ms`.
+    void init(int frame_interval_ms);
+
+    /// Whether the next frame is due, `delta_ms` after the last one. Wakes the badge if a button was pressed, or if
+    /// `host_busy` tells that the USB host is using it.
+    bool begin_frame(int64_t delta_ms, bool host_busy);
+
+    /// Wait until the next frame is due, `delta_ms` after the last one, or until any interrupt.
+    void wait(int64_t delta_ms);
+
+    /// Called after each frame, with whether anything besides the buttons kept the badge busy during it.
+    void end_frame(bool busy);
+
+    Level get_level();
+
+    /// Time from the button press that last woke the badge until the end of the first frame after it.
+    uint32_t get_wake_latency_us();
+
+} // namespace power
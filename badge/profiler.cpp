@@ -0,0 +1,149 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace profiler
+{
+
+    namespace internal
+    {
+        bool running = false;
+    } // namespace internal
+
+    namespace
+    {
+        struct Open {
+            uint8_t path = ROOT_PATH;
+            uint32_t child_us = 0; ///< Time spent in the zones nested in this one so far.
+        };
+
+        uint8_t _users = 0;
+
+        Path _paths[MAX_PATHS];
+        int _path_count = 1;
+
+        /// The path of each zone when nested in each path. The root is nobody's child, so zero means not seen yet.
+        uint8_t _children[MAX_PATHS][ZONE_COUNT] = {};
+
+        /// Zones entered and not left yet, with the root at the bottom.
+        Open _open[MAX_DEPTH + 1];
+        int _depth = 0;
+
+        uint32_t _self_us[MAX_PATHS] = {};
+        uint32_t _frame_start_us = 0;
+        bool _frame_started = false;
+
+        Sample _history[HISTORY];
+        int _next = 0;
+        int _count = 0;
+        uint32_t _taken = 0;
+    } // namespace
+
+    namespace internal
+    {
+        uint8_t enter(Zone zone) {
+            if (_depth == MAX_DEPTH)
+                return NO_PATH;
+            auto &child = _children[_open[_depth].path][zone];
+            if (child == ROOT_PATH) {
+                if (_path_count == MAX_PATHS)
+                    return NO_PATH;
+                _paths[_path_count] = {_open[_depth].path, zone};
+                child = static_cast<uint8_t>(_path_count++);
+            }
+            _open[++_depth] = {child, 0};
+            return child;
+        }
+
+        void leave(uint8_t path, uint32_t start_us) {
+            const auto elapsed_us = time_us_32() - start_us;
+            _self_us[path] += elapsed_us - std::min(elapsed_us, _open[_depth].child_us);
+            _open[--_depth].child_us += elapsed_us;
+        }
+    } // namespace internal
+
+    void set_used(User user, bool used) {
+        _users = used ? _users | user : _users & ~user;
+        if (!internal::running && _users != 0)
+            _frame_started = false;
+        internal::running = _users != 0;
+    }
+
+    bool is_running() {
+        return internal::running;
+    }
+
+    void begin_frame() {
+        if (!internal::running)
+            return;
+
+        const auto now_us = time_us_32();
+        if (_frame_started) {
+            auto &sample = _history[_next];
+            sample.frame_us = now_us - _frame_start_us;
+            sample.busy_us = std::min(_open[0].child_us, sample.frame_us);
+            sample.self_us[ROOT_PATH] = 0;
+            for (int i = ROOT_PATH + 1; i < MAX_PATHS; i++)
+                sample.self_us[i] = static_cast<uint16_t>(std::min<uint32_t>(_self_us[i], 0xFFFF));
+            _next = (_next + 1) % HISTORY;
+            _count = std::min(_count + 1, HISTORY);
+            _taken++;
+        }
+
+        memset(_self_us, 0, sizeof(_self_us));
+        _open[0].child_us = 0;
+        _frame_start_us = now_us;
+        _frame_started = true;
+    }
+
+    void clear_history() {
+        _count = 0;
+    }
+
+    int get_sample_count() {
+        return _count;
+    }
+
+    const Sample &get_sample(int age) {
+        return _history[(_next - 1 - age + 2 * HISTORY) % HISTORY];
+    }
+
+    uint32_t get_samples_taken() {
+        return _taken;
+    }
+
+    int get_path_count() {
+        return _path_count;
+    }
+
+    Path get_path(int path) {
+        return _paths[path];
+    }
+
+    size_t get_path_name(int path, std::span<char> buffer, char separator) {
+        if (path == ROOT_PATH) {
+            const auto n = std::min(buffer.size(), strlen("frame"));
+            memcpy(buffer.data(), "frame", n);
+            return n;
+        }
+
+        // Collect the zones from the inside out, then write them the other way around.
+        Zone zones[MAX_PATHS];
+        int count = 0;
+        for (auto p = path; p != ROOT_PATH; p = _paths[p].parent)
+            zones[count++] = _paths[p].zone;
+
+        size_t size = 0;
+        for (int i = count - 1; i >= 0; i--) {
+            if (i != count - 1 && size < buffer.size())
+                buffer[size++] = separator;
+            const auto *name = ZONE_NAMES[zones[i]];
+            const auto n = std::min(buffer.size() - size, strlen(name));
+            memcpy(buffer.data() + size, name, n);
+            size += n;
+        }
+        return size;
+    }
+
+} // namespace profiler
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <pico/time.h>
+
+/**
+ * Frame profiler, timing named zones of code with the microsecond timer.
+ *
+ * A `Scope` times a zone from its construction to its destruction. Zones nest, and each distinct chain of nested
+ * zones (like "draw" > "font") is a path, timed separately and exclusive of the zones nested in it, so the paths of a
+ * frame add up to the frame time. The root path is whatever no zone covers, mostly the main loop sleeping between
+ * frames. The last `HISTORY` frames are kept, and cleared whenever the UI enters another state, so they always
+ * describe the current one.
+ *
+ * Scopes cost a single check while nothing uses the profiler, so they can stay in hot code like blits.
+ */
+namespace profiler
+{
+
+    enum Zone : uint8_t {
+        ZONE_USB,
+        ZONE_FS,
+        ZONE_SWAP,
+        ZONE_SPI_WAIT,
+        ZONE_UPDATE,
+        ZONE_DRAW,
+        ZONE_FONT,
+        ZONE_BLIT,
+        ZONE_OVERLAY,
+
+        ZONE_COUNT,
+    };
+
+    constexpr const char *ZONE_NAMES[ZONE_COUNT] = {
+        "usb", "fs", "swap", "spi_wait", "update", "draw", "font", "blit", "overlay",
+    };
+
+    /// Distinct paths kept track of, the root included. Zones on further paths are not timed.
+    constexpr int MAX_PATHS = 24;
+    /// Deepest nesting of zones that is timed.
+    constexpr int MAX_DEPTH = 8;
+    /// Frames kept in the history.
+    constexpr int HISTORY = 64;
+
+    constexpr uint8_t ROOT_PATH = 0;
+    constexpr uint8_t NO_PATH = 0xFF;
+
+    struct Path {
+        uint8_t parent = NO_PATH; ///< Path this one is nested in, or `NO_PATH` for the root.
+        Zone zone = ZONE_COUNT;   ///< Innermost zone of the path, unless it is the root.
+    };
+
+    struct Sample {
+        uint32_t frame_us = 0;            ///< Time from the start of this frame to the start of the next one.
+        uint32_t busy_us = 0;             ///< Time spent in any zone, so the root took the rest.
+        uint16_t self_us[MAX_PATHS] = {}; ///< Time spent in each path but the root, saturated at 65535.
+    };
+
+    /// What the profiler is running for. It runs while anything needs it.
+    enum User : uint8_t {
+        USER_OVERLAY = 1 << 0,
+        USER_REMOTE  = 1 << 1,
+    };
+
+    void set_used(User user, bool used);
+    [[nodiscard]] bool is_running();
+
+    /// Called by the main loop when a frame starts, which completes the sample of the previous frame.
+    void begin_frame();
+
+    /// Forget the frames sampled so far.
+    void clear_history();
+
+    /// Number of frames in the history.
+    [[nodiscard]] int get_sample_count();
+
+    /// A frame from the history, with 0 the most recent one. The most recent one stays available after
+    /// `clear_history()`.
+    [[nodiscard]] const Sample &get_sample(int age);
+
+    /// Number of frames sampled so far, which unlike the history is never cleared.
+    [[nodiscard]] uint32_t get_samples_taken();
+
+    [[nodiscard]] int get_path_count();
+    [[nodiscard]] Path get_path(int path);
+
+    /// Write the names of the zones on a path to `buffer`, outermost first and joined by `separator`, and return how
+    /// much of it was used. The root path is called "frame".
+    size_t get_path_name(int path, std::span<char> buffer, char separator);
+
+    namespace internal
+    {
+        extern bool running;
+
+        uint8_t enter(Zone zone);
+        void leave(uint8_t path, uint32_t start_us);
+    } // namespace internal
+
+    class Scope {
+    public:
+        explicit Scope(Zone zone) {
+            if (internal::running) {
+                path = internal::enter(zone);
+                start_us = time_us_32();
+            }
+        }
+
+        ~Scope() {
+            if (path != NO_PATH)
+                internal::leave(path, start_us);
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        uint8_t path = NO_PATH;
+        uint32_t start_us = 0;
+    };
+
+} // namespace profiler
@@ -0,0 +1,105 @@
+#include "replays.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <hardware/flash.h>
+#include <pico/flash.h>
+
+#include <badge/badge-2025.h>
+#include <badge/storage.hpp>
+#include <fs/volume.hpp>
+#include <utils/input_log.hpp>
+
+namespace replays
+{
+
+    namespace
+    {
+        /// The slots sit at the start of the reserved space, below the storage units in the last two sectors.
+        constexpr intptr_t BASE_OFFSET = BADGE_FLASH_SIZE - storage::RESERVED_SIZE;
+
+        static_assert(SLOT_COUNT * SLOT_SIZE <= storage::RESERVED_SIZE - 2 * FLASH_SECTOR_SIZE);
+        static_assert(SLOT_SIZE % FLASH_SECTOR_SIZE == 0);
+
+        /// The game being recorded. It can only be stored once it is over, so it is kept in RAM until then.
+        alignas(4) uint8_t _buffer[SLOT_SIZE];
+        utils::InputLogWriter _writer;
+        Slot _slot = SLOT_COUNT;
+
+        constexpr intptr_t get_offset(Slot slot) {
+            return BASE_OFFSET + static_cast<intptr_t>(slot * SLOT_SIZE);
+        }
+
+        int &highscore(Slot slot) {
+            return slot == SLOT_SNEK ? storage::ram_data->snek_highscore : storage::ram_data->blocks_highscore;
+        }
+
+        void store(Slot slot, std::span<const uint8_t> log) {
+            printf("> Storing replay of %zu bytes to slot %d\n", log.size(), slot);
+            struct Args {
+                intptr_t offset;
+                const uint8_t *data;
+                size_t size;
+            } args = {get_offset(slot), log.data(), log.size()};
+            fs::volume::wait_for_flash_idle();
+            const auto status = flash_safe_execute([](auto param) {
+                const auto *args = static_cast<const Args *>(param);
+                flash_range_erase(args->offset, SLOT_SIZE);
+                // FLASH is programmed in whole pages. Whatever follows the log in the last page is ignored.
+                const auto size = (args->size + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE;
+                flash_range_program(args->offset, args->data, size);
+            }, &args, 1000);
+            if (status != PICO_OK)
+                printf("! Replays: Failed to store slot %d (%d)\n", slot, status);
+        }
+
+    } // namespace
+
+    void start(Slot slot, uint8_t game, uint32_t seed, uint32_t buttons) {
+        _writer.start(_buffer, game, seed, buttons);
+        _slot = slot;
+    }
+
+    void record(uint32_t buttons, int delta_ms) {
+        if (_slot != SLOT_COUNT)
+            _writer.record(buttons, delta_ms);
+    }
+
+    bool finish(int score) {
+        const auto slot = _slot;
+        _slot = SLOT_COUNT;
+        if (slot == SLOT_COUNT || score <= highscore(slot))
+            return false;
+
+        // A high score without a log could not be verified, so a game too long for its log keeps the old best game.
+        const auto log = _writer.finish(score);
+        if (log.empty()) {
+            printf("! Replays: Log of %" PRIu32 " ticks did not fit\n", _writer.get_ticks());
+            return false;
+        }
+        store(slot, log);
+        highscore(slot) = score;
+        storage::save();
+        return true;
+    }
+
+    void cancel() {
+        _slot = SLOT_COUNT;
+    }
+
+    int get_highscore(Slot slot) {
+        return highscore(slot);
+    }
+
+    std::span<const uint8_t> load(Slot slot) {
+        const auto *data = reinterpret_cast<const uint8_t *>(XIP_BASE + get_offset(slot));
+        utils::input_log::Header header;
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != utils::input_log::MAGIC || header.size > SLOT_SIZE - sizeof(header))
+            return {};
+        return {data, sizeof(header) + header.size};
+    }
+
+} // namespace replays
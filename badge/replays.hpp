@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <hardware/flash.h>
+
+/**
+ * Recorded high score games.
+ *
+ * Games record their input log (see `utils/input_log.hpp`) while they are played, and the log of the best game is
+ * kept in FLASH next to its high score. Re-simulating that log has to end up with the same score, which is how a
+ * stored high score is verified.
+ */
+namespace replays
+{
+
+    enum Slot {
+        SLOT_SNEK,
+        SLOT_BLOCKS,
+
+        SLOT_COUNT,
+    };
+
+    /// FLASH space for the log of each slot's best game.
+    constexpr size_t SLOT_SIZE = 4 * FLASH_SECTOR_SIZE;
+
+    /// Start recording a game for `slot`: `game` identifies the game in the log, which was reset with `seed`, with
+    /// `buttons` held. Cancels any other recording.
+    void start(Slot slot, uint8_t game, uint32_t seed, uint32_t buttons);
+
+    /// Record a tick of the game being recorded, if any.
+    void record(uint32_t buttons, int delta_ms);
+
+    /// Stop recording, with the final score of the game. If it beats the slot's high score, the score and the log are
+    /// stored to FLASH. A game whose log did not fit is not, as its score could not be verified. Returns true for a
+    /// new high score.
+    bool finish(int score);
+
+    /// Stop recording without storing anything.
+    void cancel();
+
+    /// The stored high score of a slot.
+    int get_highscore(Slot slot);
+
+    /// The stored log of a slot's best game, or an empty span if there is none.
+    std::span<const uint8_t> load(Slot slot);
+
+} // namespace replays
@@ -1,5 +1,6 @@
 #include "storage.hpp"
 
+#include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <memory>
@@ -11,6 +12,7 @@
 
 #include <badge/badge-2025.h>
 #include <badge/lcd.hpp>
+#include <fs/volume.hpp>
 #include <utils/crc.hpp>
 
 #include "pico/time.h"
@@ -32,7 +34,7 @@ namespace storage
             uint8_t _padding[STORAGE_UNIT_SIZE - sizeof(StorageData) - 4] = {};
 
             [[nodiscard]] uint32_t compute_crc() const {
-                return utils::crc32({reinterpret_cast<const uint8_t*>(this) + 4, STORAGE_UNIT_SIZE - 4});
+                return utils::crc32_dma({reinterpret_cast<const uint8_t*>(this) + 4, STORAGE_UNIT_SIZE - 4});
             }
         };
 
@@ -87,6 +89,7 @@ namespace storage
     void erase() {
         printf("! Erasing all storage\n");
         // Erase all FLASH space allocated to storage.
+        fs::volume::wait_for_flash_idle();
         flash_safe_execute([](auto){
             flash_range_erase(STORAGE_BASE_OFFSET, STORAGE_SIZE);
         }, nullptr, 1000);
@@ -119,20 +122,21 @@ namespace storage
 
         printf("  New storage unit = %d\n", target_unit);
 
+        fs::volume::wait_for_flash_idle();
         const auto status = flash_safe_execute([](auto param) {
 
-            const auto unit = reinterpret_cast<intptr_t>(param);
+            const auto unit = static_cast<int>(reinterpret_cast<intptr_t>(param));
 
             // Make sure we do our actual FLASH modification in a safe state.
             const auto offset = get_offset(unit);
             if (!is_erased(unit)) {
-                printf("  Erase sector @ 0x%08x ...\n", offset);
+                printf("  Erase sector @ 0x%08" PRIxPTR " ...\n", offset);
                 // We have already made sure that if we need to erase, it's on a sector boundary.
                 assert((offset % FLASH_SECTOR_SIZE) == 0);
                 flash_range_erase(offset, FLASH_SECTOR_SIZE);
             }
             // Program data to FLASH.
-            printf("  Program unit %d @ 0x%08x ...\n", unit, offset);
+            printf("  Program unit %d @ 0x%08" PRIxPTR " ...\n", unit, offset);
             flash_range_program(offset, reinterpret_cast<const uint8_t *>(&_ramUnit), STORAGE_UNIT_SIZE);
             // Clear previous unit by overwriting with zeroes.
             const auto zero_data = std::unique_ptr<uint8_t[]>(new uint8_t[STORAGE_UNIT_SIZE]);
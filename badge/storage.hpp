@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <span>
 
@@ -15,7 +16,15 @@ namespace storage
 
     static_assert(FLASH_SECTOR_SIZE % STORAGE_UNIT_SIZE == 0);
 
-    constexpr auto FLAG_STORAGE_SIZE = 500;
+    /// Space at the end of FLASH kept free for persistent data: the storage units in the last sectors, and game
+    /// replays (see `badge/replays.cpp`) below them.
+    constexpr intptr_t RESERVED_SIZE = 64 * 1024;
+
+    /// Current layout version of `StorageData`. Version 0 is the original layout, where found flags were only
+    /// stored as plaintext and had to be re-validated at every boot.
+    constexpr uint32_t STORAGE_VERSION = 1;
+
+    constexpr auto FLAG_LOG_SIZE = 500;
 
     struct StorageData {
 
@@ -24,12 +33,26 @@ namespace storage
         int snek_highscore = 0;
         int blocks_highscore = 0;
 
-        int reserved[29] = {};
+        // The following fields used to be reserved (and thus zero), so data stored with the original layout is
+        // read back as version 0 with no found flags.
+        uint32_t version = STORAGE_VERSION;
+        uint32_t found_flags[2] = {};
+
+        // Identifies the built-in disk image the FLASH volume was provisioned from, and whether the host has written
+        // to the volume since then.
+        uint32_t volume_image_id = 0;
+        uint32_t volume_modified = 0;
 
-        char entered_flags[FLAG_STORAGE_SIZE] = {};
+        int reserved[24] = {};
+
+        // Write-once log of the plaintext of entered flags, each terminated by a zero. For version 0 data this is
+        // the only record of found flags.
+        char flag_log[FLAG_LOG_SIZE] = {};
 
     };
 
+    static_assert(offsetof(StorageData, flag_log) == 128, "Layout must stay compatible with version 0");
+
     static_assert(sizeof(StorageData) < STORAGE_UNIT_SIZE - 4);
 
     extern StorageData* ram_data;
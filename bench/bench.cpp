@@ -0,0 +1,114 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <pico/time.h>
+
+#if PICO_ON_DEVICE
+#include <hardware/clocks.h>
+#endif
+
+namespace bench
+{
+
+    namespace
+    {
+        /// Stops growing the iteration count of kernels too fast for the clock, e.g. optimized away on the host.
+        constexpr uint64_t MAX_ITERATIONS = 1'000'000'000;
+
+        /// Run a benchmark with more iterations each time, until it takes long enough to time. Like Google
+        /// Benchmark, it aims a bit past the minimum time, growing at most tenfold at once.
+        State measure(const Benchmark &benchmark) {
+            uint64_t iterations = 1;
+            while (true) {
+                State state(iterations);
+                benchmark.function(state);
+                if (state.get_elapsed_us() >= MIN_TIME_US || iterations >= MAX_ITERATIONS)
+                    return state;
+                const auto multiplier = state.get_elapsed_us() * 10 <= MIN_TIME_US
+                                            ? 10.0
+                                            : MIN_TIME_US * 1.4 / static_cast<double>(state.get_elapsed_us());
+                iterations = std::max(iterations + 1, static_cast<uint64_t>(iterations * multiplier));
+            }
+        }
+
+        void write_context(Write write) {
+            char text[256];
+#if PICO_ON_DEVICE
+            snprintf(text, sizeof(text), "    \"platform\": \"badge-2025\",\n    \"mhz_per_cpu\": %lu,\n",
+                     clock_get_hz(clk_sys) / 1'000'000);
+#else
+            snprintf(text, sizeof(text), "    \"platform\": \"host\",\n");
+#endif
+            write("{\n  \"context\": {\n");
+            write(text);
+#ifdef NDEBUG
+            write("    \"library_build_type\": \"release\"\n");
+#else
+            write("    \"library_build_type\": \"debug\"\n");
+#endif
+            write("  },\n  \"benchmarks\": [\n");
+        }
+
+        void write_result(Write write, const char *name, const State &state, bool last) {
+            const auto iterations = state.get_iterations();
+            const auto ns = state.get_elapsed_us() * 1000.0 / static_cast<double>(iterations);
+
+            char text[512];
+            int size = snprintf(text, sizeof(text),
+                                "    {\n"
+                                "      \"name\": \"%s\",\n"
+                                "      \"run_name\": \"%s\",\n"
+                                "      \"run_type\": \"iteration\",\n"
+                                "      \"repetitions\": 1,\n"
+                                "      \"repetition_index\": 0,\n"
+                                "      \"threads\": 1,\n"
+                                "      \"iterations\": %llu,\n"
+                                "      \"real_time\": %.1f,\n"
+                                "      \"cpu_time\": %.1f,\n"
+                                "      \"time_unit\": \"ns\"",
+                                name, name, static_cast<unsigned long long>(iterations), ns, ns);
+            if (state.get_bytes_processed() > 0 && state.get_elapsed_us() > 0) {
+                const auto seconds = static_cast<double>(state.get_elapsed_us()) / 1e6;
+                size += snprintf(text + size, sizeof(text) - size, ",\n      \"bytes_per_second\": %.0f",
+                                 static_cast<double>(state.get_bytes_processed()) / seconds);
+            }
+#if PICO_ON_DEVICE
+            size += snprintf(text + size, sizeof(text) - size, ",\n      \"cycles\": %.1f",
+                             static_cast<double>(state.get_cycles()) / static_cast<double>(iterations));
+#endif
+            snprintf(text + size, sizeof(text) - size, "\n    }%s\n", last ? "" : ",");
+            write(text);
+        }
+    } // namespace
+
+    State::Iterator State::begin() {
+#if PICO_ON_DEVICE
+        last_cycle_count = systick_hw->cvr;
+#endif
+        start_us = time_us_64();
+        return Iterator(this);
+    }
+
+    void State::stop() {
+        elapsed_us = time_us_64() - start_us;
+    }
+
+    void run(std::span<const Benchmark> benchmarks, Write write) {
+#if PICO_ON_DEVICE
+        // Count down from the top of SysTick's 24 bits, at the processor clock.
+        systick_hw->rvr = 0xFFFFFF;
+        systick_hw->cvr = 0;
+        systick_hw->csr = M0PLUS_SYST_CSR_ENABLE_BITS | M0PLUS_SYST_CSR_CLKSOURCE_BITS;
+#endif
+
+        write_context(write);
+        for (size_t i = 0; i < benchmarks.size(); i++) {
+            const auto state = measure(benchmarks[i]);
+            write_result(write, benchmarks[i].name, state, i + 1 == benchmarks.size());
+        }
+        write("  ]\n}\n");
+    }
+
+} // namespace bench
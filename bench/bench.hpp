@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#if PICO_ON_DEVICE
+#include <hardware/structs/systick.h>
+#endif
+
+/**
+ * Microbenchmarks of the badge's hot code, built into the firmware with the `BENCHMARKS` CMake option, and for the
+ * host by `tools/host-badge`. Benchmarks are written like Google Benchmark ones, and the results are reported in the
+ * same JSON format, so its `compare.py` can track them over time:
+ *
+ *     void fill_screen(bench::State &state) {
+ *         for (auto _ : state)
+ *             drawing::fill_rect(0, 0, lcd::WIDTH, lcd::HEIGHT, 0);
+ *     }
+ *
+ * Each benchmark runs with more and more iterations until it takes at least `MIN_TIME_US`. On the badge, every
+ * iteration is also counted in CPU cycles with the SysTick timer.
+ */
+namespace bench
+{
+
+    constexpr uint64_t MIN_TIME_US = 200'000;
+
+    /// Receives the report a line at a time.
+    using Write = void (*)(const char *text);
+
+    /// Keeps the compiler from optimizing away the computation of `value`.
+    template<typename T>
+    inline void do_not_optimize(const T &value) {
+        asm volatile("" : : "m"(value) : "memory");
+    }
+
+    class State;
+
+    struct Benchmark {
+        const char *name;
+        void (*function)(State &state);
+    };
+
+    class State {
+    public:
+        /// What `for (auto _ : state)` loops over. Variables of this type may go unused without a warning.
+        struct [[maybe_unused]] Value {};
+
+        class Iterator {
+        public:
+            explicit Iterator(State *state) : state(state) {}
+
+            Value operator*() const { return {}; }
+            void operator++() { state->remaining--; }
+
+            bool operator!=(const Iterator &) const {
+                state->count_cycles();
+                if (state->remaining > 0)
+                    return true;
+                state->stop();
+                return false;
+            }
+
+        private:
+            State *state;
+        };
+
+        explicit State(uint64_t iterations) : iterations(iterations), remaining(iterations) {}
+
+        Iterator begin();
+        Iterator end() { return Iterator(this); }
+
+        uint64_t get_iterations() const { return iterations; }
+        uint64_t get_elapsed_us() const { return elapsed_us; }
+        uint64_t get_bytes_processed() const { return bytes_processed; }
+        uint64_t get_cycles() const { return cycles; }
+
+        /// Report throughput, for kernels working through a buffer.
+        void set_bytes_processed(uint64_t bytes) { bytes_processed = bytes; }
+
+    private:
+        void stop();
+
+        /// Add the cycles since the last call. SysTick counts down and wraps at 24 bits, which is enough for one
+        /// iteration of any kernel here.
+        void count_cycles() {
+#if PICO_ON_DEVICE
+            const uint32_t now = systick_hw->cvr;
+            cycles += (last_cycle_count - now) & 0xFFFFFF;
+            last_cycle_count = now;
+#endif
+        }
+
+        uint64_t iterations;
+        uint64_t remaining;
+        uint64_t bytes_processed = 0;
+        uint64_t start_us = 0;
+        uint64_t elapsed_us = 0;
+        uint64_t cycles = 0;
+        uint32_t last_cycle_count = 0;
+    };
+
+    /// Run the benchmarks and write the results as Google Benchmark JSON.
+    void run(std::span<const Benchmark> benchmarks, Write write);
+
+    /// Run the benchmarks of the drawing, font, animation, QR code, CRC and SHA-1 code, see `kernels.cpp`.
+    void run_kernels(Write write);
+
+} // namespace bench
@@ -0,0 +1,137 @@
+#include "bench.hpp"
+
+#include <string_view>
+
+#include <assets.hpp>
+
+#include <badge/animation.hpp>
+#include <badge/drawing.hpp>
+#include <badge/font.hpp>
+#include <ui/qr_code.hpp>
+#include <ui/ui.hpp>
+#include <utils/crc.hpp>
+#include <utils/sha1.hpp>
+
+namespace bench
+{
+
+    namespace
+    {
+        constexpr std::string_view TEXT = "The quick brown fox jumps over the lazy dog";
+
+        /// Size of the sprite for `copy_alpha`.
+        constexpr int SPRITE_WIDTH = 64;
+        constexpr int SPRITE_HEIGHT = 32;
+
+        /// Borrow UI scratch memory for input data, filled with a fixed pattern. No state is running, so all of the
+        /// arena is free.
+        std::span<uint8_t> make_data(size_t size) {
+            const auto data = ui::borrow_scratch(size);
+            for (size_t i = 0; i < size; i++)
+                data[i] = static_cast<uint8_t>(i * 37 + 11);
+            return data;
+        }
+
+        void fill_rect_opaque(State &state) {
+            for (auto _ : state)
+                drawing::fill_rect(0, 0, lcd::WIDTH, lcd::HEIGHT, COLOR_RED);
+        }
+
+        void fill_rect_alpha(State &state) {
+            for (auto _ : state)
+                drawing::fill_rect(0, 0, lcd::WIDTH, lcd::HEIGHT, COLOR_RED, 128);
+        }
+
+        void copy_alpha(State &state) {
+            const auto data = make_data(SPRITE_WIDTH * SPRITE_HEIGHT * (sizeof(Pixel) + 1));
+            const auto *pixels = reinterpret_cast<const Pixel *>(data.data());
+            const auto *alpha = data.data() + SPRITE_WIDTH * SPRITE_HEIGHT * sizeof(Pixel);
+            for (auto _ : state)
+                drawing::copy_alpha(48, 48, SPRITE_WIDTH, SPRITE_HEIGHT, SPRITE_WIDTH, pixels, alpha);
+        }
+
+        void draw_line(State &state) {
+            for (auto _ : state)
+                drawing::draw_line(0, 0, lcd::WIDTH - 1, lcd::HEIGHT - 1, COLOR_RED);
+        }
+
+        template<const font::Font &FONT>
+        void font_measure(State &state) {
+            for (auto _ : state)
+                do_not_optimize(FONT.measure(TEXT));
+        }
+
+        template<const font::Font &FONT>
+        void font_render(State &state) {
+            for (auto _ : state)
+                do_not_optimize(FONT.render(TEXT).alpha);
+        }
+
+        /// Decode frames one after the other, like the gallery plays them, including the key frame at each loop.
+        template<anim::Animation &ANIMATION>
+        void read_frame(State &state) {
+            ANIMATION.initialize(ui::borrow_scratch(anim::Animation::MEMORY_SIZE));
+            for (auto _ : state)
+                ANIMATION.next_frame();
+            ANIMATION.reset();
+        }
+
+        void qr_generate(State &state) {
+            ui::qr::QrCode qr;
+            qr.ec = ui::qr::ErrorCorrection::MEDIUM;
+            qr.content = "https://hack.gbgay.com/";
+            for (auto _ : state)
+                qr.generate();
+        }
+
+        template<size_t SIZE>
+        void crc32(State &state) {
+            const auto data = make_data(SIZE);
+            for (auto _ : state)
+                do_not_optimize(utils::crc32(data));
+            state.set_bytes_processed(state.get_iterations() * SIZE);
+        }
+
+        template<size_t SIZE>
+        void sha1_digest(State &state) {
+            const auto data = make_data(SIZE);
+            for (auto _ : state)
+                do_not_optimize(utils::sha1_digest(data));
+            state.set_bytes_processed(state.get_iterations() * SIZE);
+        }
+
+        constexpr Benchmark KERNELS[] = {
+            {"fill_rect/opaque", fill_rect_opaque},
+            {"fill_rect/alpha", fill_rect_alpha},
+            {"copy_alpha", copy_alpha},
+            {"draw_line", draw_line},
+            {"font_measure/lucida", font_measure<font::lucida>},
+            {"font_measure/m5x7", font_measure<font::m5x7>},
+            {"font_measure/m6x11", font_measure<font::m6x11>},
+            {"font_measure/noto_sans", font_measure<font::noto_sans>},
+            {"font_measure/noto_sans_cm", font_measure<font::noto_sans_cm>},
+            {"font_render/lucida", font_render<font::lucida>},
+            {"font_render/m5x7", font_render<font::m5x7>},
+            {"font_render/m6x11", font_render<font::m6x11>},
+            {"font_render/noto_sans", font_render<font::noto_sans>},
+            {"font_render/noto_sans_cm", font_render<font::noto_sans_cm>},
+            {"read_frame/blahaj_spin", read_frame<anim::blahaj_spin>},
+            {"read_frame/dramatic", read_frame<anim::dramatic>},
+            {"read_frame/fire", read_frame<anim::fire>},
+            {"read_frame/hi_there", read_frame<anim::hi_there>},
+            {"read_frame/pedro", read_frame<anim::pedro>},
+            {"read_frame/rap_win", read_frame<anim::rap_win>},
+            {"read_frame/rick", read_frame<anim::rick>},
+            {"qr_generate", qr_generate},
+            {"crc32/64", crc32<64>},
+            {"crc32/4096", crc32<4096>},
+            {"sha1_digest/64", sha1_digest<64>},
+            {"sha1_digest/4096", sha1_digest<4096>},
+        };
+    } // namespace
+
+    void run_kernels(Write write) {
+        run(KERNELS, write);
+    }
+
+} // namespace bench
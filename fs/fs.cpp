@@ -1,46 +1,205 @@
 #include "fs.hpp"
 
-#include <cassert>
+#include <cstdio>
 #include <cstring>
+#include <strings.h>
 
 #include <assets.hpp>
 
+#include "volume.hpp"
+
 namespace fs
 {
 
-    struct __packed DirEntry {
-        char short_name[11];
-        uint8_t attributes;
-        uint8_t sfn_case;
-        uint8_t create_time_tenths;
-        uint16_t create_time;
-        uint16_t create_date;
-        uint16_t access_date;
-        uint16_t cluster_high;
-        uint16_t write_time;
-        uint16_t write_date;
-        uint16_t cluster_low;
-        uint32_t size;
-    };
-
-    static_assert(sizeof(DirEntry) == 32);
-
-    std::span<const uint8_t> get_file_span(std::string_view short_name) {
-        // The two bytes at offset 22 tells us how many sectors/blocks are taken up by the FAT.
-        // The sector with the root directory should be immediately after that.
-        auto n_fat_sectors = *reinterpret_cast<const uint16_t*>(DISK_IMAGE + 22);
-        auto *root_entries = reinterpret_cast<const DirEntry*>(DISK_IMAGE + 512 * (n_fat_sectors + 1));
-        // A block can fit 16 entries. Iterate over them and see if we find the requested short name.
-        for (int i = 0; i < 16; i++) {
-            const auto& entry = root_entries[i];
-            if (strncmp(short_name.data(), entry.short_name, 11) != 0)
-                continue; // This entry was not the one.
-            // We should never have a disk large enough to need the upper two bytes of the cluster number.
-            assert(entry.cluster_high == 0);
-            // Figure out the offset into the disk image, and return a span with the file data.
-            // This only works because we generate a read-only image with no fragmentation.
-            const auto offset = (entry.cluster_low + n_fat_sectors) * 512;
-            return { &DISK_IMAGE[offset], entry.size };
+    static_assert((DISK_FILE_INDEX_SIZE & (DISK_FILE_INDEX_SIZE - 1)) == 0, "Index size must be a power of two");
+    static_assert(DISK_FILE_INDEX_SIZE >= DISK_FILE_COUNT * 2, "Index must be at most half full");
+
+    namespace
+    {
+        struct __packed DirEntry {
+            char short_name[11];
+            uint8_t attributes;
+            uint8_t sfn_case;
+            uint8_t create_time_tenths;
+            uint16_t create_time;
+            uint16_t create_date;
+            uint16_t access_date;
+            uint16_t cluster_high;
+            uint16_t write_time;
+            uint16_t write_date;
+            uint16_t cluster_low;
+            uint32_t size;
+        };
+
+        static_assert(sizeof(DirEntry) == 32);
+
+        constexpr uint8_t ATTR_DIRECTORY = 0x10;
+        constexpr uint8_t ATTR_LONG_NAME = 0x0F;
+        constexpr uint16_t END_OF_CHAIN = 0xFF8;
+
+        /// Layout of a FAT12 volume, as read from its boot sector.
+        struct Volume {
+            const uint8_t *base;
+            uint32_t cluster_size;
+            uint32_t fat_offset;
+            uint32_t root_offset;
+            uint32_t root_entries;
+            uint32_t data_offset;
+
+            explicit Volume(const uint8_t *base) : base(base) {
+                const auto read16 = [base](int offset) { return base[offset] | base[offset + 1] << 8; };
+                const uint32_t sector_size = read16(11);
+                cluster_size = base[13] * sector_size;
+                fat_offset = read16(14) * sector_size;
+                root_offset = fat_offset + base[16] * read16(22) * sector_size;
+                root_entries = read16(17);
+                data_offset = root_offset + root_entries * sizeof(DirEntry);
+            }
+
+            [[nodiscard]] uint16_t next_cluster(uint16_t cluster) const {
+                const auto *ptr = base + fat_offset + cluster + cluster / 2;
+                const uint16_t value = ptr[0] | ptr[1] << 8;
+                return (cluster & 1) ? value >> 4 : value & 0xFFF;
+            }
+
+            [[nodiscard]] const uint8_t *cluster_ptr(uint16_t cluster) const {
+                return base + data_offset + (cluster - 2) * cluster_size;
+            }
+        };
+
+        /// Collects the long file name spread across the LFN entries preceding a short name entry.
+        /// Only ASCII is kept; anything else is replaced with a character that never matches a lookup.
+        struct LongName {
+            char text[256] = {};
+            bool valid = false;
+
+            void add(const uint8_t *entry) {
+                constexpr int CHAR_OFFSETS[13] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30};
+                const int sequence = (entry[0] & 0x1F) - 1;
+                if (entry[0] & 0x40) {
+                    memset(text, 0, sizeof(text));
+                    valid = true;
+                }
+                if (sequence < 0 || sequence >= 19)
+                    return;
+                for (int i = 0; i < 13; i++) {
+                    const uint16_t ch = entry[CHAR_OFFSETS[i]] | entry[CHAR_OFFSETS[i] + 1] << 8;
+                    if (ch == 0 || ch == 0xFFFF)
+                        break;
+                    text[sequence * 13 + i] = ch < 0x80 ? static_cast<char>(ch) : '\x7F';
+                }
+            }
+        };
+
+        bool short_name_matches(const DirEntry &entry, std::string_view name) {
+            char buffer[13];
+            int n = 0;
+            for (int i = 0; i < 8 && entry.short_name[i] != ' '; i++)
+                buffer[n++] = entry.short_name[i];
+            if (entry.short_name[8] != ' ') {
+                buffer[n++] = '.';
+                for (int i = 8; i < 11 && entry.short_name[i] != ' '; i++)
+                    buffer[n++] = entry.short_name[i];
+            }
+            return name.size() == static_cast<size_t>(n) && strncasecmp(buffer, name.data(), n) == 0;
+        }
+
+        /// Search a directory for an entry with the given name. The root directory has cluster zero.
+        const DirEntry *find_entry(const Volume &volume, uint16_t cluster, std::string_view name) {
+            LongName long_name;
+            const auto match = [&](const DirEntry *entries, uint32_t count) -> const DirEntry * {
+                for (uint32_t i = 0; i < count; i++) {
+                    const auto &entry = entries[i];
+                    const auto first = static_cast<uint8_t>(entry.short_name[0]);
+                    if (first == 0x00)
+                        return nullptr; // End of directory marker.
+                    if (first == 0xE5) {
+                        long_name.valid = false; // Deleted entry.
+                        continue;
+                    }
+                    if (entry.attributes == ATTR_LONG_NAME) {
+                        long_name.add(reinterpret_cast<const uint8_t *>(&entry));
+                        continue;
+                    }
+                    const bool found = long_name.valid ? (strlen(long_name.text) == name.size() &&
+                                                          strncasecmp(long_name.text, name.data(), name.size()) == 0)
+                                                       : short_name_matches(entry, name);
+                    long_name.valid = false;
+                    if (found)
+                        return &entry;
+                }
+                return nullptr;
+            };
+
+            if (cluster == 0) {
+                const auto *entries = reinterpret_cast<const DirEntry *>(volume.base + volume.root_offset);
+                return match(entries, volume.root_entries);
+            }
+
+            const auto entries_per_cluster = volume.cluster_size / sizeof(DirEntry);
+            while (cluster >= 2 && cluster < END_OF_CHAIN) {
+                const auto *entries = reinterpret_cast<const DirEntry *>(volume.cluster_ptr(cluster));
+                if (const auto *entry = match(entries, entries_per_cluster))
+                    return entry;
+                cluster = volume.next_cluster(cluster);
+            }
+            return nullptr;
+        }
+
+        /// Look up a file by walking the directory tree of a volume modified by the host.
+        std::span<const uint8_t> find_in_volume(std::string_view path) {
+            const Volume volume(volume::data());
+            uint16_t cluster = 0;
+            while (true) {
+                const auto separator = path.find('/');
+                const auto name = path.substr(0, separator);
+                const auto *entry = find_entry(volume, cluster, name);
+                if (entry == nullptr)
+                    return {};
+                if (separator != std::string_view::npos) {
+                    if (!(entry->attributes & ATTR_DIRECTORY))
+                        return {};
+                    cluster = entry->cluster_low;
+                    path = path.substr(separator + 1);
+                    continue;
+                }
+                if (entry->attributes & ATTR_DIRECTORY || entry->size == 0)
+                    return {};
+                // We hand out a single span, so only unfragmented files can be returned.
+                const auto first = entry->cluster_low;
+                const auto n_clusters = (entry->size + volume.cluster_size - 1) / volume.cluster_size;
+                for (uint32_t i = 0; i + 1 < n_clusters; i++) {
+                    if (volume.next_cluster(first + i) != first + i + 1) {
+                        printf("! fs: File is fragmented\n");
+                        return {};
+                    }
+                }
+                return {volume.cluster_ptr(first), entry->size};
+            }
+        }
+
+    } // namespace
+
+    std::span<const uint8_t> get_file_span(std::string_view path) {
+        // Once the host has written to the volume, the generated index can no longer be trusted, so fall back to
+        // reading the directories. Make sure any cached writes are visible in FLASH first.
+        if (volume::is_modified()) {
+            volume::flush();
+            return find_in_volume(path);
+        }
+        // The file index is an open addressing hash table built together with the disk image, so a lookup is
+        // normally a single slot, and never more than a short linear probe.
+        const auto hash = data::path_hash(path);
+        for (auto slot = hash;; slot++) {
+            const auto index = DISK_FILE_INDEX[slot & (DISK_FILE_INDEX_SIZE - 1)];
+            if (index == 0)
+                break; // Empty slot; the file is not in the index.
+            const auto &file = DISK_FILES[index - 1];
+            if (file.hash != hash || strlen(file.path) != path.size())
+                continue;
+            if (strncasecmp(file.path, path.data(), path.size()) != 0)
+                continue;
+            return {&DISK_IMAGE[file.offset], file.size};
         }
         // Did not find the file; just return an empty span.
         return {};
@@ -7,6 +7,8 @@
 namespace fs
 {
 
-    std::span<const uint8_t> get_file_span(std::string_view short_name);
+    /// Get the contents of a file in the disk image, given its full (long name) path from the root directory,
+    /// e.g. `"README.txt"` or `"docs/notes.txt"`. Case is ignored. Returns an empty span if there is no such file.
+    std::span<const uint8_t> get_file_span(std::string_view path);
 
 }
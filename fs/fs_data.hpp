@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace fs::data
+{
+
+    /// A file in the generated disk image. Files are never fragmented, so the data is a single contiguous range.
+    struct File {
+        const char* path;
+        uint32_t hash;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    /// 32-bit FNV-1a hash of a file path, ignoring ASCII case.
+    /// Must match `path_hash` in `assets/assets/filesystem.py`, which builds the file index.
+    constexpr uint32_t path_hash(std::string_view path) {
+        uint32_t value = 0x811C9DC5;
+        for (char ch : path) {
+            if (ch >= 'A' && ch <= 'Z')
+                ch = static_cast<char>(ch - 'A' + 'a');
+            value ^= static_cast<uint8_t>(ch);
+            value *= 0x01000193;
+        }
+        return value;
+    }
+
+}
@@ -1,17 +1,27 @@
 #include "../usb/usb.hpp"
 
+#include <cinttypes>
+#include <cstdio>
+
 #include <tusb.h>
 
 #if !FACTORY_TEST
-#include <assets.hpp>
+#include <fs/volume.hpp>
 #else
-static constexpr uint32_t DISK_IMAGE_BLOCK_COUNT = 0;
-static constexpr uint32_t DISK_IMAGE_SIZE = 0;
-static constexpr uint8_t *DISK_IMAGE = nullptr;
+namespace fs::volume
+{
+    constexpr uint32_t BLOCK_COUNT = 0;
+    inline void flush() {}
+    inline int32_t read_async(uint32_t, void *, uint32_t) { return -1; }
+    inline bool write(uint32_t, const void *, uint32_t) { return false; }
+}
 #endif
 
 static bool ejected = false;
 
+// Not named by TinyUSB, but sent by hosts that want cached writes committed (e.g. `sync` on Linux).
+static constexpr uint8_t SCSI_CMD_SYNCHRONIZE_CACHE_10 = 0x35;
+
 void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]) {
     (void)lun;
     memcpy(vendor_id, "HackGBG ", 8);
@@ -29,6 +39,7 @@ bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, boo
             ejected = false;
         } else {
             // unload disk storage
+            fs::volume::flush();
             ejected = true;
         }
     }
@@ -50,44 +61,53 @@ bool tud_msc_test_unit_ready_cb(uint8_t lun) {
 
 void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count, uint16_t *block_size) {
     (void)lun;
-    *block_count = DISK_IMAGE_BLOCK_COUNT;
+    *block_count = fs::volume::BLOCK_COUNT;
     *block_size  = USB_MSC_BLOCK_SIZE;
 }
 
 bool tud_msc_is_writable_cb(uint8_t lun) {
     (void)lun;
-    return false;
+    return !FACTORY_TEST;
 }
 
 int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
     (void)lun;
+    usb::note_host_activity();
+
+    // Reads are streamed from FLASH straight into the TinyUSB buffer with DMA. While the transfer is running we
+    // return zero, and TinyUSB will call us again with the same arguments later. The next chunk is then streamed
+    // while USB sends this one, so reading a file in order only waits for FLASH once.
+    const auto result = lba < fs::volume::BLOCK_COUNT
+                                ? fs::volume::read_async(lba * USB_MSC_BLOCK_SIZE + offset, buffer, bufsize)
+                                : -1;
+    if (result < 0)
+        printf("! MSC: Attempt to read out of bounds (%d, %" PRIu32 ", %" PRIu32 ", %" PRIu32 ")\n",
+               lun, lba, offset, bufsize);
+
+    return result;
+}
 
-    if (lba >= DISK_IMAGE_BLOCK_COUNT) {
-        printf("! MSC: Attempt to read out of bounds (%d, %ld, %ld, %ld)\n", lun, lba, offset, bufsize);
-        return -1;
-    }
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
+    (void)lun;
+    usb::note_host_activity();
 
-    const auto idx = lba * USB_MSC_BLOCK_SIZE + offset;
-    if ((idx + bufsize) > DISK_IMAGE_SIZE) {
-        printf("! MSC: Attempt to read out of bounds (%d, %ld, %ld, %ld)\n", lun, lba, offset, bufsize);
+    if (lba >= fs::volume::BLOCK_COUNT || !fs::volume::write(lba * USB_MSC_BLOCK_SIZE + offset, buffer, bufsize)) {
+        printf("! MSC: Attempt to write out of bounds (%d, %" PRIu32 ", %" PRIu32 ", %" PRIu32 ")\n",
+               lun, lba, offset, bufsize);
         return -1;
     }
 
-    memcpy(buffer, DISK_IMAGE + idx, bufsize);
     return static_cast<int32_t>(bufsize);
 }
 
-int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
-    printf("! MSC: Attempt to write (%d, %ld, %ld, %ld)\n", lun, lba, offset, bufsize);
-    (void)buffer;
-    return -1;
-}
-
 int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void *buffer, uint16_t bufsize) {
     (void)lun;
-    (void)scsi_cmd;
     (void)buffer;
     (void)bufsize;
+    if (scsi_cmd[0] == SCSI_CMD_SYNCHRONIZE_CACHE_10) {
+        fs::volume::flush();
+        return 0;
+    }
     // Set SCSI sense to indicate illegal/unsupported command.
     tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
     return -1;
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace fs
+{
+
+    /**
+     * Write-back cache that batches small block writes into whole FLASH erase sector updates.
+     *
+     * The backend provides access to the underlying FLASH region and must implement:
+     *
+     *  - `const uint8_t *data(uint32_t offset)` : Pointer to the current contents at the given offset.
+     *  - `void erase(uint32_t offset)`           : Erase one sector at the given (sector aligned) offset.
+     *  - `void program(uint32_t offset, const uint8_t *data, uint32_t size)` : Program whole pages.
+     *
+     * Keeping the FLASH access behind a backend lets the same cache run against a simulated device on the host.
+     */
+    template<typename Backend, int LINES>
+    class SectorCache {
+    public:
+        static constexpr uint32_t SECTOR_SIZE = 4096;
+        static constexpr uint32_t PAGE_SIZE = 256;
+
+        struct Stats {
+            uint32_t sector_erases = 0;   ///< Sectors erased and reprogrammed.
+            uint32_t sector_programs = 0; ///< Sectors updated by programming only, since no bit went from 0 to 1.
+            uint32_t page_programs = 0;   ///< Total number of pages programmed.
+            uint32_t clean_flushes = 0;   ///< Dirty sectors that turned out to match FLASH already.
+            uint32_t evictions = 0;       ///< Lines flushed to make room for another sector.
+        };
+
+        explicit SectorCache(Backend &backend) : backend(backend) {}
+
+        void read(uint32_t offset, void *buffer, uint32_t size) {
+            auto *dst = static_cast<uint8_t *>(buffer);
+            while (size > 0) {
+                const auto sector = offset / SECTOR_SIZE * SECTOR_SIZE;
+                const auto n = std::min(size, sector + SECTOR_SIZE - offset);
+                if (const auto *line = find(sector))
+                    memcpy(dst, &line->data[offset - sector], n);
+                else
+                    memcpy(dst, backend.data(offset), n);
+                dst += n;
+                offset += n;
+                size -= n;
+            }
+        }
+
+        void write(uint32_t offset, const void *buffer, uint32_t size, uint32_t now_ms) {
+            const auto *src = static_cast<const uint8_t *>(buffer);
+            while (size > 0) {
+                const auto sector = offset / SECTOR_SIZE * SECTOR_SIZE;
+                const auto n = std::min(size, sector + SECTOR_SIZE - offset);
+                auto &line = acquire(sector);
+                memcpy(&line.data[offset - sector], src, n);
+                line.dirty = true;
+                line.last_write_ms = now_ms;
+                src += n;
+                offset += n;
+                size -= n;
+            }
+        }
+
+        /// Write back all dirty lines.
+        void flush() {
+            for (auto &line : lines)
+                flush(line);
+        }
+
+        /// Write back lines that have not been written to in the last `idle_ms` milliseconds.
+        void flush_idle(uint32_t now_ms, uint32_t idle_ms) {
+            for (auto &line : lines) {
+                if (line.dirty && now_ms - line.last_write_ms >= idle_ms)
+                    flush(line);
+            }
+        }
+
+        /// Whether any part of the given range is held in the cache, and thus may differ from FLASH.
+        [[nodiscard]] bool is_cached(uint32_t offset, uint32_t size) const {
+            for (const auto &line : lines)
+                if (line.sector != NO_SECTOR && line.sector < offset + size && offset < line.sector + SECTOR_SIZE)
+                    return true;
+            return false;
+        }
+
+        [[nodiscard]] bool is_dirty() const {
+            for (const auto &line : lines)
+                if (line.dirty)
+                    return true;
+            return false;
+        }
+
+        [[nodiscard]] const Stats &get_stats() const { return stats; }
+
+    private:
+        static constexpr uint32_t NO_SECTOR = ~0u;
+
+        struct Line {
+            uint32_t sector = NO_SECTOR;
+            uint32_t last_use = 0;
+            uint32_t last_write_ms = 0;
+            bool dirty = false;
+            std::array<uint8_t, SECTOR_SIZE> data = {};
+        };
+
+        Backend &backend;
+        std::array<Line, LINES> lines = {};
+        uint32_t use_counter = 0;
+        Stats stats = {};
+
+        Line *find(uint32_t sector) {
+            for (auto &line : lines) {
+                if (line.sector == sector) {
+                    line.last_use = ++use_counter;
+                    return &line;
+                }
+            }
+            return nullptr;
+        }
+
+        Line &acquire(uint32_t sector) {
+            if (auto *line = find(sector))
+                return *line;
+            // Reuse the least recently used line, writing it back first if needed.
+            auto *victim = &lines[0];
+            for (auto &line : lines) {
+                if (line.sector == NO_SECTOR) {
+                    victim = &line;
+                    break;
+                }
+                if (line.last_use < victim->last_use)
+                    victim = &line;
+            }
+            if (victim->dirty)
+                stats.evictions++;
+            flush(*victim);
+            victim->sector = sector;
+            victim->last_use = ++use_counter;
+            memcpy(victim->data.data(), backend.data(sector), SECTOR_SIZE);
+            return *victim;
+        }
+
+        void flush(Line &line) {
+            if (!line.dirty)
+                return;
+            line.dirty = false;
+
+            const auto *current = backend.data(line.sector);
+            if (memcmp(current, line.data.data(), SECTOR_SIZE) == 0) {
+                stats.clean_flushes++;
+                return;
+            }
+
+            // NOR FLASH can only clear bits when programming. If no bit needs to go from 0 to 1, then we can skip
+            // the (slow, wearing) erase and just program the pages that changed.
+            bool need_erase = false;
+            for (uint32_t i = 0; i < SECTOR_SIZE && !need_erase; i++)
+                need_erase = (current[i] & line.data[i]) != line.data[i];
+
+            if (need_erase) {
+                backend.erase(line.sector);
+                stats.sector_erases++;
+            }
+            else {
+                stats.sector_programs++;
+            }
+
+            // After an erase, every page reads as all ones, so compare against that instead of the old contents.
+            for (uint32_t page = 0; page < SECTOR_SIZE; page += PAGE_SIZE) {
+                const auto *src = &line.data[page];
+                bool unchanged = true;
+                for (uint32_t i = 0; i < PAGE_SIZE && unchanged; i++)
+                    unchanged = src[i] == (need_erase ? 0xFF : current[page + i]);
+                if (unchanged)
+                    continue;
+                backend.program(line.sector + page, src, PAGE_SIZE);
+                stats.page_programs++;
+            }
+        }
+    };
+
+} // namespace fs
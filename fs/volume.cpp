@@ -0,0 +1,252 @@
+#include "volume.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <hardware/dma.h>
+#include <hardware/flash.h>
+#include <hardware/structs/xip_ctrl.h>
+#include <pico/flash.h>
+#include <pico/time.h>
+
+#include <assets.hpp>
+#include <badge/badge-2025.h>
+#include <badge/storage.hpp>
+
+#include "sector_cache.hpp"
+
+namespace fs::volume
+{
+
+    namespace
+    {
+        constexpr intptr_t VOLUME_BASE_OFFSET = BADGE_FLASH_SIZE - storage::RESERVED_SIZE - SIZE;
+
+        /// Number of 4 KiB sectors cached in RAM. The host typically interleaves FAT, directory and data writes, so we
+        /// want at least a few lines to avoid erasing the FAT sector once per data sector.
+        constexpr int CACHE_LINES = 4;
+
+        static_assert(VOLUME_BASE_OFFSET % FLASH_BLOCK_SIZE == 0);
+        static_assert(DISK_IMAGE_BLOCK_COUNT == BLOCK_COUNT);
+        static_assert(DISK_IMAGE_SIZE <= SIZE);
+
+        /// DMA channel used to stream reads from FLASH, bypassing the XIP cache.
+        int _streamDmaChannel = -1;
+
+        struct StreamRead {
+            uint32_t offset = 0;
+            void *buffer = nullptr;
+            uint32_t size = 0;
+            bool active = false;
+        } _streamRead;
+
+        /// The chunk after the last streamed one, read ahead while USB sends that one to the host. Hosts read files
+        /// in order, so the next request is usually for this chunk, and then only needs a copy from RAM.
+        constexpr uint32_t READ_AHEAD_SIZE = FLASH_SECTOR_SIZE;
+        alignas(4) uint8_t _readAhead[READ_AHEAD_SIZE];
+
+        struct ReadAhead {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+            bool valid = false;
+        } _readAheadRange;
+
+        const uint8_t *flash_ptr(uint32_t offset) {
+            return reinterpret_cast<const uint8_t *>(XIP_BASE + VOLUME_BASE_OFFSET + offset);
+        }
+
+        void start_stream_read(uint32_t offset, void *buffer, uint32_t size) {
+            // Drain anything left in the stream FIFO before starting a new transfer.
+            while (!(xip_ctrl_hw->stat & XIP_STAT_FIFO_EMPTY))
+                (void)xip_ctrl_hw->stream_fifo;
+            xip_ctrl_hw->stream_addr = reinterpret_cast<uintptr_t>(flash_ptr(offset));
+            xip_ctrl_hw->stream_ctr = size / 4;
+
+            auto cfg = dma_channel_get_default_config(_streamDmaChannel);
+            channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+            channel_config_set_read_increment(&cfg, false);
+            channel_config_set_write_increment(&cfg, true);
+            channel_config_set_dreq(&cfg, DREQ_XIP_STREAM);
+            dma_channel_configure(_streamDmaChannel, &cfg, buffer, reinterpret_cast<const void *>(XIP_AUX_BASE),
+                                  size / 4, true);
+
+            _streamRead = {offset, buffer, size, true};
+        }
+
+        void wait_for_stream_read() {
+            if (!_streamRead.active)
+                return;
+            dma_channel_wait_for_finish_blocking(_streamDmaChannel);
+            _streamRead.active = false;
+        }
+
+        struct FlashBackend {
+            const uint8_t *data(uint32_t offset) {
+                return flash_ptr(offset);
+            }
+
+            void erase(uint32_t offset) {
+                // The stream interface must be idle while FLASH is being modified.
+                wait_for_stream_read();
+                const auto status = flash_safe_execute([](auto param) {
+                    flash_range_erase(reinterpret_cast<intptr_t>(param), FLASH_SECTOR_SIZE);
+                }, reinterpret_cast<void *>(VOLUME_BASE_OFFSET + offset), 1000);
+                if (status != PICO_OK)
+                    printf("! Volume: Failed to erase sector @ 0x%08" PRIx32 " (%d)\n", offset, status);
+                mark_modified();
+            }
+
+            void program(uint32_t offset, const uint8_t *data, uint32_t size) {
+                struct Args {
+                    intptr_t offset;
+                    const uint8_t *data;
+                    uint32_t size;
+                } args = {VOLUME_BASE_OFFSET + offset, data, size};
+                wait_for_stream_read();
+                const auto status = flash_safe_execute([](auto param) {
+                    const auto *args = static_cast<const Args *>(param);
+                    flash_range_program(args->offset, args->data, args->size);
+                }, &args, 1000);
+                if (status != PICO_OK)
+                    printf("! Volume: Failed to program page @ 0x%08" PRIx32 " (%d)\n", offset, status);
+                mark_modified();
+            }
+
+            static void mark_modified() {
+                if (storage::ram_data->volume_modified)
+                    return;
+                storage::ram_data->volume_modified = 1;
+                storage::save();
+            }
+        };
+
+        FlashBackend _backend;
+        SectorCache<FlashBackend, CACHE_LINES> _cache{_backend};
+
+        uint32_t now_ms() {
+            return to_ms_since_boot(get_absolute_time());
+        }
+
+        void provision() {
+            printf("> Provisioning FLASH volume from disk image %08" PRIx32 " ...\n", DISK_IMAGE_ID);
+            // Only the part of the volume covered by the disk image needs to be written. Anything after that is
+            // unallocated space, which FAT does not care about the contents of.
+            constexpr auto n_bytes = (DISK_IMAGE_SIZE + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+            const auto status = flash_safe_execute([](auto) {
+                flash_range_erase(VOLUME_BASE_OFFSET, n_bytes);
+                // FLASH programming requires whole pages from RAM, so copy the image over one page at a time.
+                uint8_t page[FLASH_PAGE_SIZE];
+                for (uint32_t offset = 0; offset < DISK_IMAGE_SIZE; offset += FLASH_PAGE_SIZE) {
+                    const auto n = std::min<uint32_t>(FLASH_PAGE_SIZE, DISK_IMAGE_SIZE - offset);
+                    memset(page, 0, FLASH_PAGE_SIZE);
+                    memcpy(page, DISK_IMAGE + offset, n);
+                    flash_range_program(VOLUME_BASE_OFFSET + offset, page, FLASH_PAGE_SIZE);
+                }
+            }, nullptr, 10'000);
+            if (status != PICO_OK) {
+                printf("! Volume: Provisioning failed (%d)\n", status);
+                return;
+            }
+            storage::ram_data->volume_image_id = DISK_IMAGE_ID;
+            storage::ram_data->volume_modified = 0;
+            storage::save();
+        }
+
+        /// Start streaming the chunk that follows a read of `size` bytes at `offset`, unless it is cached.
+        void start_read_ahead(uint32_t offset, uint32_t size) {
+            const auto next = offset + size;
+            if (size > READ_AHEAD_SIZE || next > SIZE || size > SIZE - next || _cache.is_cached(next, size))
+                return;
+            _readAheadRange = {next, size, true};
+            start_stream_read(next, _readAhead, size);
+        }
+
+    } // namespace
+
+    void init() {
+        _streamDmaChannel = dma_claim_unused_channel(true);
+        if (storage::ram_data->volume_image_id != DISK_IMAGE_ID)
+            provision();
+        printf("> FLASH volume mounted (%s)\n", is_modified() ? "modified" : "pristine");
+    }
+
+    void task() {
+        _cache.flush_idle(now_ms(), IDLE_WRITE_BACK_MS);
+    }
+
+    void flush() {
+        if (!_cache.is_dirty())
+            return;
+        _cache.flush();
+        const auto &stats = _cache.get_stats();
+        printf("> Volume flushed (%" PRIu32 " erases, %" PRIu32 " program-only, %" PRIu32 " pages)\n",
+               stats.sector_erases,
+               stats.sector_programs,
+               stats.page_programs);
+    }
+
+    bool read(uint32_t offset, void *buffer, uint32_t size) {
+        if (offset > SIZE || size > SIZE - offset)
+            return false;
+        _cache.read(offset, buffer, size);
+        return true;
+    }
+
+    int32_t read_async(uint32_t offset, void *buffer, uint32_t size) {
+        if (offset > SIZE || size > SIZE - offset)
+            return -1;
+
+        if (_streamRead.active) {
+            const bool same = _streamRead.offset == offset && _streamRead.buffer == buffer && _streamRead.size == size;
+            if (same && dma_channel_is_busy(_streamDmaChannel))
+                return 0;
+            wait_for_stream_read();
+            if (same) {
+                start_read_ahead(offset, size);
+                return static_cast<int32_t>(size);
+            }
+        }
+
+        // Writes drop the chunk read ahead, so it is never behind the cache.
+        const auto &ahead = _readAheadRange;
+        if (ahead.valid && ahead.offset == offset && ahead.size == size) {
+            memcpy(buffer, _readAhead, size);
+            _readAheadRange.valid = false;
+            start_read_ahead(offset, size);
+            return static_cast<int32_t>(size);
+        }
+
+        // Cached sectors may hold writes that are not in FLASH yet, and the stream interface only moves whole
+        // words, so fall back to copying in those cases.
+        const bool aligned = (offset | size | reinterpret_cast<uintptr_t>(buffer)) % 4 == 0;
+        if (!aligned || _cache.is_cached(offset, size)) {
+            _cache.read(offset, buffer, size);
+            return static_cast<int32_t>(size);
+        }
+
+        start_stream_read(offset, buffer, size);
+        return 0;
+    }
+
+    bool write(uint32_t offset, const void *buffer, uint32_t size) {
+        if (offset > SIZE || size > SIZE - offset)
+            return false;
+        _readAheadRange.valid = false;
+        _cache.write(offset, buffer, size, now_ms());
+        return true;
+    }
+
+    void wait_for_flash_idle() {
+        wait_for_stream_read();
+    }
+
+    bool is_modified() {
+        return storage::ram_data->volume_modified != 0;
+    }
+
+    const uint8_t *data() {
+        return _backend.data(0);
+    }
+
+} // namespace fs::volume
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+namespace fs::volume
+{
+
+    /// Size of the FLASH region reserved for the USB drive volume.
+    constexpr uint32_t SIZE = 2 * 1024 * 1024;
+    constexpr uint32_t BLOCK_SIZE = 512;
+    constexpr uint32_t BLOCK_COUNT = SIZE / BLOCK_SIZE;
+
+    /// Milliseconds without host writes before cached sectors are written back to FLASH.
+    constexpr uint32_t IDLE_WRITE_BACK_MS = 500;
+
+    /// Mount the FLASH volume, provisioning it from the built-in disk image on first boot with a new image.
+    void init();
+
+    /// Write back dirty cached sectors that have been idle for a while. Call regularly from the main loop.
+    void task();
+
+    /// Write back all dirty cached sectors right away, e.g. when the host ejects the drive.
+    void flush();
+
+    bool read(uint32_t offset, void *buffer, uint32_t size);
+
+    /// Read without blocking, streaming directly from FLASH into the buffer with DMA when possible. Once a streamed
+    /// read is done, the chunk after it is streamed into RAM, ready for the next call.
+    /// Returns `size` when the data is in the buffer, zero while the transfer is still in progress (call again with
+    /// the same arguments), or -1 on error. This matches the contract of `tud_msc_read10_cb`.
+    int32_t read_async(uint32_t offset, void *buffer, uint32_t size);
+    bool write(uint32_t offset, const void *buffer, uint32_t size);
+
+    /// Wait for a streamed read from FLASH to finish. Anything that erases or programs FLASH must call this first, as
+    /// the stream interface must be idle while XIP is off.
+    void wait_for_flash_idle();
+
+    /// Whether the host has written anything to the volume since it was provisioned.
+    bool is_modified();
+
+    /// Memory mapped (XIP) contents of the volume. Does not include writes still in the cache.
+    const uint8_t *data();
+
+}
@@ -1,11 +1,11 @@
 #pragma once
 
-#include <array>
-#include <deque>
-
 #include <badge/pixel.hpp>
 #include <ui/state.hpp>
 
+#include "blocks_ai.hpp"
+#include "blocks_game.hpp"
+
 /**
  * Legally distinct implementation of Tetris.
  * Attempts to follow the Tetris Guidelines.
@@ -18,27 +18,6 @@ namespace blocks
     /// Tile size in pixels. 6 is the largest size that still fits a full field on the LCD.
     constexpr auto TILE_SIZE = 6;
 
-    /// Field width in tiles. 10 is the value from the guidelines.
-    constexpr auto FIELD_WIDTH = 10;
-
-    /// Field height in tiles. 40 is the value from the guidelines, for some reason.
-    constexpr auto FIELD_HEIGHT = 40;
-
-    /// Number of visible rows of tiles of the field. 20 is the value from the guidelines, with a
-    /// few additional rows of pixels visible for the 21st row.
-    constexpr auto FIELD_VISIBLE_HEIGHT = 21;
-
-    /// How many "next pieces" to show next to the field.
-    /// The guidelines request 1 to 6, and we have just enough space to comfortably show six.
-    constexpr auto NEXT_PIECE_COUNT = 6;
-
-    /// Initial number of milliseconds between "ticks" where the current piece falls one tile.
-    /// The actual value during play will go lower as the player levels up.
-    constexpr auto INITIAL_FALL_INTERVAL_MS = 800;
-
-    /// Milliseconds between ticks where the current piece falls one tile when the player holds (down).
-    constexpr auto SOFT_DROP_INTERVAL_MS = 200;
-
     /// Leftmost column of pixels of the playing field.
     /// Calculated to center the field on the LCD.
     constexpr auto FIELD_PX_LEFT = (160 - TILE_SIZE * FIELD_WIDTH) / 2;
@@ -54,24 +33,34 @@ namespace blocks
     constexpr auto HOLD_PX_LEFT = 123;          ///< Position of the left edge of the held piece display.
     constexpr auto HOLD_PX_TOP  = QUEUE_PX_TOP; ///< Position of the top edge of the held piece display.
 
-    enum EPiece {
-        PIECE_O = 0,
-        PIECE_I,
-        PIECE_L,
-        PIECE_J,
-        PIECE_S,
-        PIECE_Z,
-        PIECE_T,
-        PIECE_COUNT,
-
-        EMPTY = -1
-    };
+    /// Positions of the two fields in versus mode, at the edges of the LCD. The player's next and held pieces go in
+    /// between.
+    constexpr auto VERSUS_PX_LEFT          = 2;
+    constexpr auto VERSUS_OPPONENT_PX_LEFT = 160 - VERSUS_PX_LEFT - TILE_SIZE * FIELD_WIDTH;
+    constexpr auto VERSUS_QUEUE_PX_LEFT    = (160 - TILE_SIZE * 4) / 2;
+    constexpr auto VERSUS_HOLD_PX_TOP      = 72;
+
+    /// How many "next pieces" fit in between the fields in versus mode.
+    constexpr auto VERSUS_NEXT_PIECE_COUNT = 2;
+
+    /// Milliseconds per game tick. Shorter than a frame, so that every frame gets at least one tick.
+    constexpr auto TICK_MS = 10;
 
-    static_assert(PIECE_COUNT == 7);
+    /// Placements the AI evaluates per tick. With three ticks per frame, the same as it used to per frame.
+    constexpr auto AI_EVALUATIONS_PER_TICK = AI_EVALUATIONS_PER_UPDATE / 3;
+
+    /// Milliseconds between the moves of the AI playing the demo behind the start screen.
+    constexpr auto ATTRACT_MOVE_INTERVAL_MS = 60;
+
+    /// Milliseconds between the moves of the AI opponent in versus mode. Slow enough to be beaten.
+    constexpr auto VERSUS_MOVE_INTERVAL_MS = 200;
 
     class BlocksGame final : public ui::State {
     public:
+        BlocksGame();
+
         void update(int delta_ms) override;
+        void tick() override;
         void draw() override;
 
         void pause() override;
@@ -87,83 +76,48 @@ namespace blocks
 
         GameState state = WAITING_TO_START;
 
-        /// Playing field, addressed as field[row-from-bottom][column-from-left]
-        std::array<std::array<EPiece, FIELD_WIDTH>, FIELD_HEIGHT> field = {};
+        /// True when playing against the AI.
+        bool versus = false;
 
-        EPiece current_piece     = EMPTY; ///< Current falling piece.
-        int    current_piece_row = 0;     ///< Current piece row position.
-        int    current_piece_col = 0;     ///< Current piece column position.
-        int    current_rotation  = 0;     ///< Current piece rotation (0-3).
+        /// The player's game. While waiting to start, the AI plays it as a demo.
+        Game game;
 
-        int ghost_row = 0; ///< Row position of the current ghost piece. Column is the same as the current piece.
+        /// The AI's game in versus mode.
+        Game opponent;
 
-        EPiece held_piece = EMPTY; ///< Currently held piece, or `EMPTY`.
-        bool   hold_used  = false; ///< True iff the hold function has been used this piece.
+        /// The AI, playing either the demo or the opponent.
+        Ai ai;
 
-        /// Queue of pieces to appear next.
-        std::deque<EPiece> piece_queue = {};
+        /// Buttons held at the last tick, to tell presses from holds.
+        uint32_t tick_buttons = 0;
 
-        int fall_timer    = 0; ///< Timer counting up in milliseconds from when the current piece fell one tile.
-        int fall_interval = 0; ///< Current interval between falls.
+        /// Buttons pressed since the last tick. A tap can be over within a frame, so the next tick takes these as held
+        /// too. A button released and pressed again within a frame is still missed, as it looks held throughout.
+        uint32_t pending_presses = 0;
 
-        int soft_drop_count = 0; ///< Count how many spaces the current piece has been soft-dropped, for scoring.
-
-        bool last_move_was_spin = false; ///< Keep track of if the last successful move was a spin, for T-spin scoring.
-
-        /// Current game score.
-        int score = 0;
-
-        /// Current level.
-        int level = 0;
+        /// Best single player score, or zero if there is none or its replay does not match.
+        int best = 0;
 
         /// Reset everything to a new initial state.
         void reset();
 
-        /// Spawn the next piece to become the current piece.
-        void spawn_next();
-
-        /// Randomize pieces and add to the end of the queue.
-        void fill_queue();
-
-        /// Make the current piece fall one tile.
-        void fall();
-
-        /// Hard-drop the current piece. This function is responsible for doing the final
-        /// piece placement logic, and subsequent clearing of rows, updating score etc.
-        void hard_drop();
-
-        /// Try to move the current piece one tile left.
-        void shift_left();
+        /// Start a new game for the player, against the AI if `versus_mode` is set.
+        void start(bool versus_mode);
 
-        /// Try to move the current piece one tile right.
-        void shift_right();
+        /// Check the stored best game by replaying it, and set `best` to its score if it matches.
+        void verify_best();
 
-        /// Try to rotate the current piece clockwise.
-        void rotate_cw();
-
-        /// Try to rotate the current piece counter-clockwise.
-        void rotate_ccw();
-
-        /// Swap out the current piece for the held piece.
-        void hold();
-
-        /// Try to place a given piece at the given location.
-        /// Return true iff the piece fits.
-        /// This is a const function, i.e. no actual state is modified.
-        bool try_place_piece(int row, int col, EPiece piece, int rotation) const;
-
-        /// Figure out where the current piece will end up if hard-dropped, so we can display the ghost
-        /// piece and/or actually do the hard-drop.
-        void update_ghost_row();
-
-        /// Draw the playing field.
-        void draw_field() const;
+        /// Draw a playing field with its pieces.
+        void draw_field(const Game &field_game, int left) const;
 
         /// Draw the "next piece" queue display.
-        void draw_queue() const;
+        void draw_queue(int left, int count) const;
 
         /// Draw the "held piece" display.
-        void draw_held() const;
+        void draw_held(int left, int top) const;
+
+        /// Draw the prompt to start a game or exit.
+        void draw_prompt() const;
 
         /// Draw a piece somewhere on the screen.
         static void draw_piece(int left, int top, EPiece piece, int rotation, bool is_ghost);
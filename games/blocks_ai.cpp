@@ -0,0 +1,264 @@
+#include "blocks_ai.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+
+namespace blocks
+{
+
+    // El-Tetris weights, scaled to integers since the RP2040 has no FPU. The landing height is measured in half rows.
+    constexpr int WEIGHT_LANDING_HEIGHT      = -2250;
+    constexpr int WEIGHT_ERODED_CELLS        = 3418;
+    constexpr int WEIGHT_ROW_TRANSITIONS     = -3218;
+    constexpr int WEIGHT_COLUMN_TRANSITIONS  = -9349;
+    constexpr int WEIGHT_HOLES               = -7899;
+    constexpr int WEIGHT_WELLS               = -3386;
+
+    constexpr uint16_t ALL_COLUMNS = (1 << FIELD_WIDTH) - 1;
+
+    /// A row with the walls as extra occupied columns on either side, so column `c` is bit `c + 1`.
+    constexpr uint32_t with_walls(uint16_t row) {
+        return (row << 1) | 1 | (1 << (FIELD_WIDTH + 1));
+    }
+
+    int Ai::evaluate(Board &board, EPiece piece, int rotation, int row) {
+        const auto &masks = PIECE_MASKS[piece][rotation];
+
+        // Eroded piece cells: rows cleared, times how many of the piece's own tiles were cleared with them.
+        int top = -1;
+        int bottom = 0;
+        int n_cleared = 0;
+        int eroded_cells = 0;
+        for (int v = 0; v < 4; v++) {
+            if (masks[v] == 0)
+                continue;
+            if (top < 0)
+                top = v;
+            bottom = v;
+            if (board.get_row(row - v) == ALL_COLUMNS) {
+                n_cleared++;
+                eroded_cells += std::popcount(masks[v]);
+            }
+        }
+        eroded_cells *= n_cleared;
+        if (n_cleared > 0)
+            board.clear_full_rows();
+
+        // Twice the height of the middle of the piece.
+        const int landing_height = 2 * row - top - bottom;
+
+        // Transitions between occupied and empty tiles along each row and column, with the walls and floor counting
+        // as occupied. Empty rows above the stack only have the two at the walls.
+        const int height = board.get_height();
+        int row_transitions = 2 * (FIELD_HEIGHT - height);
+        int column_transitions = 0;
+        uint16_t below = ALL_COLUMNS;
+        for (int r = 0; r < height; r++) {
+            const auto bits = board.get_row(r);
+            const auto walled = with_walls(bits);
+            row_transitions += std::popcount((walled ^ (walled >> 1)) & ((1u << (FIELD_WIDTH + 1)) - 1));
+            column_transitions += std::popcount(static_cast<uint16_t>(bits ^ below));
+            below = bits;
+        }
+        column_transitions += std::popcount(below);
+
+        // Holes are empty tiles with an occupied tile anywhere above them. Wells are empty tiles with both neighbours
+        // occupied, counting 1 + 2 + ... + depth for each well so deep ones weigh more.
+        int holes = 0;
+        int wells = 0;
+        uint16_t covered = 0;
+        uint16_t previous_wells = 0;
+        std::array<int, FIELD_WIDTH> well_depths = {};
+        for (int r = height - 1; r >= 0; r--) {
+            const auto bits = board.get_row(r);
+            holes += std::popcount(static_cast<uint16_t>(covered & ~bits));
+            covered |= bits;
+
+            const auto walled = with_walls(bits);
+            const auto row_wells = static_cast<uint16_t>((~walled & (walled << 1) & (walled >> 1)) >> 1);
+            for (auto w = row_wells; w != 0; w &= w - 1) {
+                const int c = std::countr_zero(w);
+                well_depths[c] = ((previous_wells >> c) & 1) ? well_depths[c] + 1 : 1;
+                wells += well_depths[c];
+            }
+            previous_wells = row_wells;
+        }
+
+        return WEIGHT_LANDING_HEIGHT * landing_height + WEIGHT_ERODED_CELLS * eroded_cells +
+               WEIGHT_ROW_TRANSITIONS * row_transitions + WEIGHT_COLUMN_TRANSITIONS * column_transitions +
+               WEIGHT_HOLES * holes + WEIGHT_WELLS * wells;
+    }
+
+    void Ai::reset() {
+        state = IDLE;
+        move_timer = 0;
+    }
+
+    void Ai::update(Game &game, int delta_ms, int move_interval_ms, int budget) {
+        if (game.is_game_over()) {
+            state = IDLE;
+            return;
+        }
+
+        // Start over for each new piece, including when gravity dropped the last one before we got to it.
+        if (state == IDLE || game.get_pieces_placed() != pieces_placed)
+            start(game);
+
+        if (state == SEARCHING) {
+            think(budget);
+            return;
+        }
+
+        move_timer += delta_ms;
+        if (move_timer < move_interval_ms)
+            return;
+        move_timer = 0;
+        if (move(game))
+            state = IDLE;
+    }
+
+    void Ai::start(const Game &game) {
+        board = game.get_field();
+        pieces_placed = game.get_pieces_placed();
+
+        first_pieces[0] = game.get_current_piece();
+        second_pieces[0] = game.get_next_piece(0);
+        first_rows[0] = game.get_current_row();
+        first_cols[0] = game.get_current_col();
+        first_piece_count = 1;
+
+        // Holding swaps in the held piece, or the next one if nothing is held yet.
+        if (!game.is_hold_used()) {
+            const auto held_piece = game.get_held_piece();
+            first_pieces[1] = held_piece != EMPTY ? held_piece : game.get_next_piece(0);
+            second_pieces[1] = held_piece != EMPTY ? game.get_next_piece(0) : game.get_next_piece(1);
+            first_rows[1] = SPAWN_ROW;
+            first_cols[1] = SPAWN_COL;
+            first_piece_count = 2;
+        }
+
+        first_piece = 0;
+        first_candidate = 0;
+        second_candidate = CANDIDATE_COUNT;
+        best_score = std::numeric_limits<int>::min();
+
+        // Just drop the piece where it is if nothing better turns up.
+        plan = {false, game.get_current_rotation(), game.get_current_col()};
+        state = SEARCHING;
+        move_timer = 0;
+    }
+
+    bool Ai::think(int budget) {
+        while (state == SEARCHING && budget > 0) {
+            if (first_piece == first_piece_count) {
+                state = MOVING;
+                break;
+            }
+            const auto piece = first_pieces[first_piece];
+
+            // Done with the second piece, or not started yet: on to the next placement of the first piece.
+            if (second_candidate == CANDIDATE_COUNT) {
+                if (first_candidate == CANDIDATE_COUNT) {
+                    first_piece++;
+                    first_candidate = 0;
+                    continue;
+                }
+                const int candidate = first_candidate++;
+                if (candidate / COL_COUNT >= ROTATION_COUNTS[piece])
+                    continue;
+                budget--;
+                int row;
+                if (!try_candidate(board, piece, first_rows[first_piece], first_cols[first_piece], candidate,
+                                   first_board, row))
+                    continue;
+                evaluations++;
+                first_score = evaluate(first_board, piece, candidate / COL_COUNT, row);
+                best_second_score = GAME_OVER_SCORE;
+                second_candidate = 0;
+                continue;
+            }
+
+            const auto next_piece = second_pieces[first_piece];
+            const int candidate = second_candidate++;
+            if (candidate / COL_COUNT < ROTATION_COUNTS[next_piece]) {
+                budget--;
+                Board second_board;
+                int row;
+                if (try_candidate(first_board, next_piece, SPAWN_ROW, SPAWN_COL, candidate, second_board, row)) {
+                    evaluations++;
+                    const int score = evaluate(second_board, next_piece, candidate / COL_COUNT, row);
+                    best_second_score = std::max(best_second_score, score);
+                }
+            }
+            if (second_candidate == CANDIDATE_COUNT)
+                finish_first_candidate();
+        }
+        return state != SEARCHING;
+    }
+
+    void Ai::finish_first_candidate() {
+        const int score = first_score + best_second_score;
+        if (score > best_score) {
+            const int candidate = first_candidate - 1;
+            best_score = score;
+            plan = {first_piece == 1, candidate / COL_COUNT, candidate % COL_COUNT + MIN_COL};
+        }
+    }
+
+    bool Ai::try_candidate(const Board &board, EPiece piece, int start_row, int start_col, int candidate,
+                           Board &result, int &drop_row) {
+        const int rotation = candidate / COL_COUNT;
+        const int col = candidate % COL_COUNT + MIN_COL;
+
+        // Rotating to 3 takes one counter-clockwise turn, the others go clockwise through each rotation.
+        if (!board.fits(start_row, start_col, piece, 0))
+            return false;
+        for (int r = (rotation == 3 ? 3 : 1); r <= rotation; r++) {
+            if (!board.fits(start_row, start_col, piece, r))
+                return false;
+        }
+        const int step = col < start_col ? -1 : 1;
+        for (int c = start_col; c != col;) {
+            c += step;
+            if (!board.fits(start_row, c, piece, rotation))
+                return false;
+        }
+
+        drop_row = board.drop_row(start_row, col, piece, rotation);
+        result = board;
+        result.place(drop_row, col, piece, rotation);
+        return true;
+    }
+
+    bool Ai::move(Game &game) {
+        if (plan.use_hold && !game.is_hold_used()) {
+            game.hold();
+            return false;
+        }
+
+        // Rotate first, then shift, then drop. If a move does not get through, drop where the piece is.
+        const int rotation = game.get_current_rotation();
+        const int col = game.get_current_col();
+        if (rotation != plan.rotation) {
+            if ((plan.rotation - rotation + 4) % 4 == 3)
+                game.rotate_ccw();
+            else
+                game.rotate_cw();
+            if (game.get_current_rotation() != rotation)
+                return false;
+        }
+        else if (col != plan.col) {
+            if (col < plan.col)
+                game.shift_right();
+            else
+                game.shift_left();
+            if (game.get_current_col() != col)
+                return false;
+        }
+        game.hard_drop();
+        return true;
+    }
+
+} // namespace blocks
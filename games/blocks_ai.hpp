@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+
+#include "blocks_game.hpp"
+
+namespace blocks
+{
+
+    /// Placements the AI evaluates per update. A search evaluates around a thousand, so this spreads it over a handful
+    /// of frames and leaves most of each frame for the game itself.
+    constexpr auto AI_EVALUATIONS_PER_UPDATE = 150;
+
+    /**
+     * Computer player. For every new piece it searches all the places it can drop the current piece, or the one it
+     * would get from holding, each followed by every place to drop the next piece after that. Each resulting board is
+     * scored by the heuristic features of Pierre Dellacherie's player, with the weights tuned by El-Tetris.
+     *
+     * The search runs incrementally, a limited number of placements per update, and the AI then makes its moves at
+     * a chosen pace like a player would.
+     *
+     * See https://imake.ninja/el-tetris-an-improvement-on-pierre-dellacheries-algorithm/
+     */
+    class Ai {
+    public:
+        /// Where the AI decided to drop the current piece.
+        struct Plan {
+            bool use_hold = false;
+            int  rotation = 0;
+            int  col      = 0;
+        };
+
+        /// Forget about any search or moves in progress.
+        void reset();
+
+        /// Play `game` for one update: search for at most `budget` placements, then make a move if at least
+        /// `move_interval_ms` have passed since the last one.
+        void update(Game &game, int delta_ms, int move_interval_ms, int budget = AI_EVALUATIONS_PER_UPDATE);
+
+        /// Start a new search for the current piece of `game`.
+        void start(const Game &game);
+
+        /// Continue the search for at most `budget` placements. Returns true when the search is done.
+        bool think(int budget);
+
+        [[nodiscard]] const Plan &get_plan() const { return plan; }
+
+        /// Total number of placements evaluated, for benchmarking.
+        [[nodiscard]] uint64_t get_evaluations() const { return evaluations; }
+
+        /// Score a board after dropping `piece` into it, higher is better. The piece has just been placed at
+        /// `row`, and full rows not yet cleared. Clears them.
+        static int evaluate(Board &board, EPiece piece, int rotation, int row);
+
+    private:
+        /// Number of distinct rotations per piece, as far as where they can be dropped goes.
+        static constexpr int ROTATION_COUNTS[PIECE_COUNT] = {1, 2, 4, 4, 2, 2, 4};
+
+        /// Column positions to try, from the piece box sticking out on the left to sticking out on the right.
+        static constexpr int MIN_COL = -3;
+        static constexpr int COL_COUNT = FIELD_WIDTH - MIN_COL;
+
+        /// Candidate placements per piece, indexed as `rotation * COL_COUNT + col - MIN_COL`.
+        static constexpr int CANDIDATE_COUNT = 4 * COL_COUNT;
+
+        /// Score for a board that ends the game.
+        static constexpr int GAME_OVER_SCORE = -1000000000;
+
+        enum SearchState {
+            IDLE,
+            SEARCHING,
+            MOVING,
+        };
+
+        SearchState state = IDLE;
+        Plan plan = {};
+        int move_timer = 0;
+        uint64_t evaluations = 0;
+
+        /// Pieces placed in the game when the search started, to notice when gravity drops the piece first.
+        int pieces_placed = 0;
+
+        // The search goes through the first pieces, then their placements, then the next piece placements.
+        Board board = {};             ///< Board before the first placement.
+        EPiece first_pieces[2] = {};  ///< The current piece, and the piece to play when holding.
+        EPiece second_pieces[2] = {}; ///< The piece after each of those.
+        int first_rows[2] = {};       ///< Where each first piece starts.
+        int first_cols[2] = {};
+        int first_piece_count = 0;    ///< 2 if holding is an option, 1 otherwise.
+        int first_piece = 0;          ///< Index into `first_pieces` being searched.
+        int first_candidate = 0;      ///< Next candidate placement of the first piece.
+        int second_candidate = 0;     ///< Next candidate placement of the second piece.
+        Board first_board = {};       ///< Board after the first placement.
+        int first_score = 0;          ///< Score of the first placement.
+        int best_second_score = 0;    ///< Best score of the second placements so far.
+        int best_score = 0;           ///< Best score of the complete plans so far.
+
+        /// Try a candidate placement. Returns false if the piece cannot get there by rotating in place and then
+        /// shifting from its start position, the way `move()` does it. Otherwise drops it onto `result`.
+        static bool try_candidate(const Board &board, EPiece piece, int start_row, int start_col, int candidate,
+                                  Board &result, int &drop_row);
+
+        /// Done with the second placements of the current first placement.
+        void finish_first_candidate();
+
+        /// Make the next move towards the plan. Returns true when the piece has been dropped.
+        bool move(Game &game);
+    };
+
+} // namespace blocks
@@ -1,8 +1,28 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <utility>
+
 namespace blocks
 {
 
+    enum EPiece : int8_t {
+        PIECE_O = 0,
+        PIECE_I,
+        PIECE_L,
+        PIECE_J,
+        PIECE_S,
+        PIECE_Z,
+        PIECE_T,
+        PIECE_COUNT,
+
+        EMPTY = -1,
+        GARBAGE = -2, ///< Tiles added to the bottom of the field in versus mode.
+    };
+
+    static_assert(PIECE_COUNT == 7);
+
     // clang-format off
     /**
      * Descriptions of the various block shapes in constant string form.
@@ -208,6 +228,24 @@ namespace blocks
 
     constexpr blocks_t BLOCK_DATA = compute_block_data();
 
+    /// One bit mask per row of a rotation, top row first, with bit `u` set for an occupied tile in column `u`.
+    using piece_rows_t = std::array<uint16_t, 4>;
+    using piece_masks_t = std::array<std::array<piece_rows_t, 4>, PIECE_COUNT>;
+
+    consteval piece_masks_t compute_piece_masks() {
+        piece_masks_t result = {};
+        for (int i = 0; i < PIECE_COUNT; i++)
+            for (int r = 0; r < 4; r++)
+                for (int u = 0; u < 4; u++)
+                    for (int v = 0; v < 4; v++)
+                        if (BLOCK_DATA[i][r][u][v])
+                            result[i][r][v] |= 1 << u;
+        return result;
+    }
+
+    /// `BLOCK_DATA` as row masks, for testing and placing a piece a whole row at a time.
+    constexpr piece_masks_t PIECE_MASKS = compute_piece_masks();
+
     using kick_offset_t = std::pair<int, int>;
     using kick_tests_t = std::array<kick_offset_t, 4>;
 
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+
+#include "blocks_data.hpp"
+
+namespace blocks
+{
+
+    /// Field width in tiles. 10 is the value from the guidelines.
+    constexpr auto FIELD_WIDTH = 10;
+
+    /// Field height in tiles. 40 is the value from the guidelines, for some reason.
+    constexpr auto FIELD_HEIGHT = 40;
+
+    /**
+     * Occupied tiles of the playing field, kept as one bit mask per row so that collision tests, drops and line
+     * clears work on a whole row of tiles at once. Rows are addressed from the bottom, and piece positions are the
+     * top left of their 4x4 box in `BLOCK_DATA`, as everywhere else in the game.
+     *
+     * Column `c` is bit `c + WALL` of its row. The bits on either side are always set, acting as walls, so a piece
+     * that sticks out of the field collides the same way as one that overlaps another piece, and a full row is
+     * simply all ones. At 80 bytes a board is cheap to copy, which is what the AI does to try out placements.
+     */
+    class Board {
+    public:
+        /// Number of wall bits to the right of column 0. Enough for a 4 wide piece box to stick out entirely.
+        static constexpr int WALL = 3;
+
+        static constexpr uint16_t FULL_ROW = 0xFFFF;
+        static constexpr uint16_t EMPTY_ROW = ~(((1 << FIELD_WIDTH) - 1) << WALL) & 0xFFFF;
+
+        static_assert(FIELD_WIDTH + 2 * WALL <= 16);
+
+        constexpr Board() { clear(); }
+
+        constexpr void clear() { rows.fill(EMPTY_ROW); }
+
+        /// Bit mask of the occupied tiles of a row, with bit `c` set for column `c`.
+        [[nodiscard]] constexpr uint16_t get_row(int row) const {
+            return (rows[row] >> WALL) & ((1 << FIELD_WIDTH) - 1);
+        }
+
+        /// Number of rows up to and including the highest occupied tile.
+        [[nodiscard]] constexpr int get_height() const {
+            int height = FIELD_HEIGHT;
+            while (height > 0 && rows[height - 1] == EMPTY_ROW)
+                height--;
+            return height;
+        }
+
+        /// True if the tile is occupied or outside the field.
+        [[nodiscard]] constexpr bool is_blocked(int row, int col) const {
+            if (row < 0 || row >= FIELD_HEIGHT || col < 0 || col >= FIELD_WIDTH)
+                return true;
+            return (rows[row] >> (col + WALL)) & 1;
+        }
+
+        /// True iff the piece fits at the given location, i.e. is inside the field and overlaps no other tiles.
+        [[nodiscard]] constexpr bool fits(int row, int col, EPiece piece, int rotation) const {
+            if (col <= -4 || col >= FIELD_WIDTH)
+                return false;
+            const auto &masks = PIECE_MASKS[piece][rotation];
+            for (int v = 0; v < 4; v++) {
+                if (masks[v] == 0)
+                    continue;
+                const int r = row - v;
+                if (r < 0 || r >= FIELD_HEIGHT)
+                    return false;
+                if ((masks[v] << (col + WALL)) & rows[r])
+                    return false;
+            }
+            return true;
+        }
+
+        /// Lowest row the piece can fall to from the given (fitting) location.
+        [[nodiscard]] constexpr int drop_row(int row, int col, EPiece piece, int rotation) const {
+            while (fits(row - 1, col, piece, rotation))
+                row--;
+            return row;
+        }
+
+        /**
+         * Try the SRS rotation of a piece at the given location: first in place, then with each of the wall kicks.
+         * Returns the offset (dx, dy) the rotated piece has to move by, or nothing if no test fits.
+         */
+        [[nodiscard]] constexpr std::optional<kick_offset_t> try_rotate(int row, int col, EPiece piece, int rotation,
+                                                                        bool clockwise) const {
+            const int new_rotation = (rotation + (clockwise ? 1 : 3)) % 4;
+            if (fits(row, col, piece, new_rotation))
+                return kick_offset_t{0, 0};
+            const auto &kick_data = (piece == PIECE_I) ? I_KICK_DATA : JLTSZ_KICK_DATA;
+            for (const auto &[dx, dy] : (clockwise ? kick_data.cw_kicks : kick_data.ccw_kicks)[rotation]) {
+                if (fits(row + dy, col + dx, piece, new_rotation))
+                    return kick_offset_t{dx, dy};
+            }
+            return std::nullopt;
+        }
+
+        /// Add a piece to the board. It must fit.
+        constexpr void place(int row, int col, EPiece piece, int rotation) {
+            assert(fits(row, col, piece, rotation));
+            const auto &masks = PIECE_MASKS[piece][rotation];
+            for (int v = 0; v < 4; v++) {
+                if (masks[v] != 0)
+                    rows[row - v] |= masks[v] << (col + WALL);
+            }
+        }
+
+        /// Remove all full rows, moving the rows above down. Returns the number of rows removed.
+        constexpr int clear_full_rows() {
+            int dst = 0;
+            for (int src = 0; src < FIELD_HEIGHT; src++) {
+                if (rows[src] != FULL_ROW)
+                    rows[dst++] = rows[src];
+            }
+            const int n_cleared = FIELD_HEIGHT - dst;
+            for (; dst < FIELD_HEIGHT; dst++)
+                rows[dst] = EMPTY_ROW;
+            return n_cleared;
+        }
+
+        /// Push everything up by `count` rows and fill the bottom with rows that are full except for column `hole`.
+        /// Tiles pushed out of the top are lost.
+        constexpr void add_garbage(int count, int hole) {
+            count = std::min(count, FIELD_HEIGHT);
+            for (int r = FIELD_HEIGHT - 1; r >= count; r--)
+                rows[r] = rows[r - count];
+            for (int r = 0; r < count; r++)
+                rows[r] = FULL_ROW & ~(1 << (hole + WALL));
+        }
+
+    protected:
+        std::array<uint16_t, FIELD_HEIGHT> rows = {};
+    };
+
+    /// The board along with which piece each tile came from, which is only needed for drawing.
+    class Field : public Board {
+    public:
+        constexpr Field() { clear(); }
+
+        constexpr void clear() {
+            Board::clear();
+            for (auto &row : pieces)
+                row.fill(EMPTY);
+        }
+
+        /// The piece a tile belongs to, `GARBAGE`, or `EMPTY`.
+        [[nodiscard]] constexpr EPiece get(int row, int col) const { return pieces[row][col]; }
+
+        constexpr void place(int row, int col, EPiece piece, int rotation) {
+            Board::place(row, col, piece, rotation);
+            const auto &masks = PIECE_MASKS[piece][rotation];
+            for (int v = 0; v < 4; v++) {
+                for (int u = 0; u < 4; u++) {
+                    if ((masks[v] >> u) & 1)
+                        pieces[row - v][col + u] = piece;
+                }
+            }
+        }
+
+        constexpr int clear_full_rows() {
+            int dst = 0;
+            for (int src = 0; src < FIELD_HEIGHT; src++) {
+                if (rows[src] != FULL_ROW)
+                    pieces[dst++] = pieces[src];
+            }
+            for (; dst < FIELD_HEIGHT; dst++)
+                pieces[dst].fill(EMPTY);
+            return Board::clear_full_rows();
+        }
+
+        constexpr void add_garbage(int count, int hole) {
+            Board::add_garbage(count, hole);
+            count = std::min(count, FIELD_HEIGHT);
+            for (int r = FIELD_HEIGHT - 1; r >= count; r--)
+                pieces[r] = pieces[r - count];
+            for (int r = 0; r < count; r++) {
+                pieces[r].fill(GARBAGE);
+                pieces[r][hole] = EMPTY;
+            }
+        }
+
+    private:
+        std::array<std::array<EPiece, FIELD_WIDTH>, FIELD_HEIGHT> pieces = {};
+    };
+
+} // namespace blocks
@@ -0,0 +1,300 @@
+#include "blocks_game.hpp"
+
+#include <utility>
+
+#include <badge/badge-2025.h>
+#include <utils/input_log.hpp>
+
+namespace blocks
+{
+
+    void Game::reset(uint32_t seed) {
+        // Completely clear the field.
+        field.clear();
+
+        // Remove any current, held, or queueing pieces.
+        current_piece = EMPTY;
+        held_piece = EMPTY;
+        queue_start = 0;
+        queue_size = 0;
+
+        // Reset overall game state.
+        game_over = false;
+        random.seed(seed);
+        fall_interval = INITIAL_FALL_INTERVAL_MS;
+        score = 0;
+        level = 1;
+        rows_cleared = 0;
+        pieces_placed = 0;
+        garbage_sent = 0;
+        garbage_pending = 0;
+        soft_drop_count = 0;
+
+        // Spawn in the first piece. This will also reset current piece and queue.
+        spawn_next();
+    }
+
+    void Game::update(int delta_ms) {
+        if (game_over)
+            return;
+        fall_timer += delta_ms;
+        if (fall_timer >= fall_interval)
+            fall();
+    }
+
+    void Game::soft_drop() {
+        if (!game_over && fall_timer >= SOFT_DROP_INTERVAL_MS)
+            fall();
+    }
+
+    void Game::release_soft_drop() {
+        soft_drop_count = 0;
+    }
+
+    int Game::take_garbage_sent() {
+        return std::exchange(garbage_sent, 0);
+    }
+
+    void Game::receive_garbage(int count) {
+        garbage_pending += count;
+    }
+
+    void Game::spawn_next() {
+        // Make sure we have enough pieces in the queue.
+        while (queue_size <= NEXT_PIECE_COUNT)
+            fill_queue();
+
+        // Pick out the next piece from the queue.
+        current_piece = piece_queue[queue_start];
+        queue_start = (queue_start + 1) % QUEUE_CAPACITY;
+        queue_size--;
+
+        // Reset misc state for our new piece.
+        current_piece_col = SPAWN_COL;
+        current_piece_row = SPAWN_ROW;
+        current_rotation = 0;
+        hold_used = false;
+        fall_timer = 0;
+        last_move_was_spin = false;
+
+        update_ghost_row();
+
+        // Check if the game is over.
+        if (!field.fits(current_piece_row, current_piece_col, current_piece, current_rotation)) {
+            game_over = true;
+        }
+    }
+
+    void Game::fill_queue() {
+        // Put one of each piece in a bag.
+        std::array<EPiece, PIECE_COUNT> bag = {};
+        for (int i = 0; i < PIECE_COUNT; i++)
+            bag[i] = static_cast<EPiece>(i);
+
+        // Shake up the bag.
+        for (int reps = 0; reps < 2; reps++) {
+            for (int i = 0; i < PIECE_COUNT; i++) {
+                int j = random.below(PIECE_COUNT);
+                if (i != j)
+                    std::swap(bag[i], bag[j]);
+            }
+        }
+
+        // Add the now random bag of pieces to the queue.
+        for (auto piece : bag)
+            piece_queue[(queue_start + queue_size++) % QUEUE_CAPACITY] = piece;
+    }
+
+    void Game::fall() {
+        if (field.fits(current_piece_row - 1, current_piece_col, current_piece, current_rotation)) {
+            current_piece_row--;
+            last_move_was_spin = false;
+            update_ghost_row();
+        }
+        else {
+            hard_drop();
+        }
+        fall_timer = 0;
+        soft_drop_count++;
+    }
+
+    void Game::hard_drop() {
+        if (game_over)
+            return;
+
+        update_ghost_row();
+
+        int bonus_score = 0;
+
+        // Add hard drop bonus score.
+        if (current_piece_row > ghost_row)
+            bonus_score += 2 * (current_piece_row - ghost_row);
+
+        // Add soft drop bonus score.
+        bonus_score += soft_drop_count;
+
+        // Place piece onto the field.
+        field.place(ghost_row, current_piece_col, current_piece, current_rotation);
+        pieces_placed++;
+
+        // If we dropped a T piece, figure out if this was a valid T-spin.
+        bool t_spin = false;
+        if (current_piece == PIECE_T && last_move_was_spin) {
+            int t_spin_count = 0;
+            std::array coords = {
+                    std::pair{ghost_row, current_piece_col},
+                    std::pair{ghost_row, current_piece_col + 2},
+                    std::pair{ghost_row + 2, current_piece_col},
+                    std::pair{ghost_row + 2, current_piece_col + 2},
+            };
+            for (const auto &[r, c] : coords) {
+                if (field.is_blocked(r, c))
+                    t_spin_count++;
+            }
+            if (t_spin_count >= 3)
+                t_spin = true;
+        }
+
+        // Count and remove cleared rows.
+        const int n_cleared = field.clear_full_rows();
+        rows_cleared += n_cleared;
+
+        // Add score.
+        if (n_cleared > 0)
+            score += bonus_score;
+        if (t_spin) {
+            if (n_cleared == 0)
+                score += 100 * level;
+            else if (n_cleared == 1)
+                score += 200 * level;
+            else if (n_cleared == 2)
+                score += 400 * level;
+            else if (n_cleared == 3)
+                score += 800 * level;
+        }
+        else {
+            if (n_cleared == 1)
+                score += 100 * level;
+            else if (n_cleared == 2)
+                score += 300 * level;
+            else if (n_cleared == 3)
+                score += 500 * level;
+            else if (n_cleared == 4)
+                score += 800 * level;
+        }
+
+        // Cleared rows cancel out pending garbage first, and the rest goes to the opponent. If nothing was cleared,
+        // the pending garbage rises up from the bottom instead.
+        if (n_cleared > 0) {
+            const int attack = t_spin ? 2 * n_cleared : GARBAGE_BY_ROWS_CLEARED[n_cleared];
+            const int cancelled = std::min(attack, garbage_pending);
+            garbage_pending -= cancelled;
+            garbage_sent += attack - cancelled;
+        }
+        else if (garbage_pending > 0) {
+            field.add_garbage(garbage_pending, static_cast<int>(random.below(FIELD_WIDTH)));
+            garbage_pending = 0;
+        }
+
+        // Spawn the next piece.
+        spawn_next();
+    }
+
+    void Game::shift_left() {
+        if (game_over)
+            return;
+        if (field.fits(current_piece_row, current_piece_col - 1, current_piece, current_rotation)) {
+            current_piece_col--;
+            last_move_was_spin = false;
+            update_ghost_row();
+        }
+    }
+
+    void Game::shift_right() {
+        if (game_over)
+            return;
+        if (field.fits(current_piece_row, current_piece_col + 1, current_piece, current_rotation)) {
+            current_piece_col++;
+            last_move_was_spin = false;
+            update_ghost_row();
+        }
+    }
+
+    void Game::rotate_cw() {
+        rotate(true);
+    }
+
+    void Game::rotate_ccw() {
+        rotate(false);
+    }
+
+    void Game::rotate(bool clockwise) {
+        if (game_over || current_piece == PIECE_O)
+            return;
+        if (const auto kick = field.try_rotate(current_piece_row, current_piece_col, current_piece, current_rotation,
+                                               clockwise)) {
+            current_rotation = (current_rotation + (clockwise ? 1 : 3)) % 4;
+            current_piece_col += kick->first;
+            current_piece_row += kick->second;
+            last_move_was_spin = true;
+        }
+        update_ghost_row();
+    }
+
+    void Game::hold() {
+        if (game_over || hold_used)
+            return;
+        if (held_piece != EMPTY) {
+            queue_start = (queue_start + QUEUE_CAPACITY - 1) % QUEUE_CAPACITY;
+            piece_queue[queue_start] = held_piece;
+            queue_size++;
+        }
+        held_piece = current_piece;
+        spawn_next();
+        hold_used = true;
+    }
+
+    void Game::update_ghost_row() {
+        ghost_row = field.drop_row(current_piece_row, current_piece_col, current_piece, current_rotation);
+    }
+
+    void play_tick(Game &game, uint32_t held, uint32_t pressed, int delta_ms) {
+        game.update(delta_ms);
+
+        if (pressed & (1 << BTN_LEFT))
+            game.shift_left();
+        else if (pressed & (1 << BTN_RIGHT))
+            game.shift_right();
+        else if (pressed & (1 << BTN_UP | 1 << BTN_D))
+            game.hard_drop();
+        else if (held & (1 << BTN_DOWN))
+            game.soft_drop();
+        else if (pressed & (1 << BTN_PUSH | 1 << BTN_A))
+            game.rotate_cw();
+        else if (pressed & (1 << BTN_B))
+            game.hold();
+        else if (pressed & (1 << BTN_C))
+            game.rotate_ccw();
+
+        if (!(held & (1 << BTN_DOWN)))
+            game.release_soft_drop();
+    }
+
+    int replay(std::span<const uint8_t> log) {
+        utils::InputLogReader reader(log);
+        if (!reader.is_valid() || reader.get_header().game != REPLAY_ID)
+            return -1;
+
+        Game game;
+        game.reset(reader.get_header().seed);
+        auto previous = reader.get_header().buttons;
+        uint32_t held;
+        int delta_ms;
+        while (!game.is_game_over() && reader.next(held, delta_ms)) {
+            play_tick(game, held, held & ~previous, delta_ms);
+            previous = held;
+        }
+        return reader.is_valid() ? game.get_score() : -1;
+    }
+
+} // namespace blocks
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <utils/random.hpp>
+
+#include "blocks_field.hpp"
+
+namespace blocks
+{
+
+    /// Number of visible rows of tiles of the field. 20 is the value from the guidelines, with a
+    /// few additional rows of pixels visible for the 21st row.
+    constexpr auto FIELD_VISIBLE_HEIGHT = 21;
+
+    /// Where new pieces appear: just above the visible part of the field, in the middle.
+    constexpr auto SPAWN_ROW = FIELD_VISIBLE_HEIGHT;
+    constexpr auto SPAWN_COL = FIELD_WIDTH / 2 - 2;
+
+    /// How many "next pieces" to show next to the field.
+    /// The guidelines request 1 to 6, and we have just enough space to comfortably show six.
+    constexpr auto NEXT_PIECE_COUNT = 6;
+
+    /// Initial number of milliseconds between "ticks" where the current piece falls one tile.
+    /// The actual value during play will go lower as the player levels up.
+    constexpr auto INITIAL_FALL_INTERVAL_MS = 800;
+
+    /// Milliseconds between ticks where the current piece falls one tile when the player holds (down).
+    constexpr auto SOFT_DROP_INTERVAL_MS = 200;
+
+    /// Garbage rows sent to the opponent in versus mode, by number of rows cleared at once.
+    constexpr std::array<int, 5> GARBAGE_BY_ROWS_CLEARED = {0, 0, 1, 2, 4};
+
+    /**
+     * The rules of the game, without any drawing or input handling, so that the same game can be played by a
+     * person, by the AI, or headless on the host.
+     *
+     * All randomness comes from a small generator seeded by `reset()`, so a seed always deals the same pieces.
+     */
+    class Game {
+    public:
+        /// Reset everything to a new game, and spawn the first piece.
+        void reset(uint32_t seed);
+
+        /// Advance the game clock, making the current piece fall when it is time.
+        void update(int delta_ms);
+
+        /// Make the current piece fall faster. Call on every update while the player holds (down).
+        void soft_drop();
+
+        /// Stop counting soft drop bonus. Call on every update while the player does not hold (down).
+        void release_soft_drop();
+
+        /// Hard-drop the current piece. This function is responsible for doing the final
+        /// piece placement logic, and subsequent clearing of rows, updating score etc.
+        void hard_drop();
+
+        /// Try to move the current piece one tile left.
+        void shift_left();
+
+        /// Try to move the current piece one tile right.
+        void shift_right();
+
+        /// Try to rotate the current piece clockwise.
+        void rotate_cw();
+
+        /// Try to rotate the current piece counter-clockwise.
+        void rotate_ccw();
+
+        /// Swap out the current piece for the held piece.
+        void hold();
+
+        /// Garbage rows this game has sent since the last call, for the opponent to receive.
+        int take_garbage_sent();
+
+        /// Queue garbage rows to be added below the field when the next piece is placed without clearing rows.
+        void receive_garbage(int count);
+
+        [[nodiscard]] bool is_game_over() const { return game_over; }
+        [[nodiscard]] const Field &get_field() const { return field; }
+
+        [[nodiscard]] EPiece get_current_piece() const { return current_piece; }
+        [[nodiscard]] int get_current_row() const { return current_piece_row; }
+        [[nodiscard]] int get_current_col() const { return current_piece_col; }
+        [[nodiscard]] int get_current_rotation() const { return current_rotation; }
+        [[nodiscard]] int get_ghost_row() const { return ghost_row; }
+
+        [[nodiscard]] EPiece get_held_piece() const { return held_piece; }
+        [[nodiscard]] bool is_hold_used() const { return hold_used; }
+
+        /// The `i`th piece in the queue, up to `NEXT_PIECE_COUNT - 1`.
+        [[nodiscard]] EPiece get_next_piece(int i) const { return piece_queue[(queue_start + i) % QUEUE_CAPACITY]; }
+
+        [[nodiscard]] int get_score() const { return score; }
+        [[nodiscard]] int get_level() const { return level; }
+        [[nodiscard]] int get_rows_cleared() const { return rows_cleared; }
+        [[nodiscard]] int get_pieces_placed() const { return pieces_placed; }
+
+    private:
+        /// Room for a full bag on top of the visible queue, plus a piece put back by `hold()`.
+        static constexpr int QUEUE_CAPACITY = 16;
+        static_assert(QUEUE_CAPACITY >= NEXT_PIECE_COUNT + PIECE_COUNT + 1);
+
+        Field field;
+
+        bool game_over = false;
+
+        EPiece current_piece     = EMPTY; ///< Current falling piece.
+        int    current_piece_row = 0;     ///< Current piece row position.
+        int    current_piece_col = 0;     ///< Current piece column position.
+        int    current_rotation  = 0;     ///< Current piece rotation (0-3).
+
+        int ghost_row = 0; ///< Row position of the current ghost piece. Column is the same as the current piece.
+
+        EPiece held_piece = EMPTY; ///< Currently held piece, or `EMPTY`.
+        bool   hold_used  = false; ///< True iff the hold function has been used this piece.
+
+        /// Queue of pieces to appear next, as a ring buffer starting at `queue_start`.
+        std::array<EPiece, QUEUE_CAPACITY> piece_queue = {};
+        int queue_start = 0;
+        int queue_size  = 0;
+
+        int fall_timer    = 0; ///< Timer counting up in milliseconds from when the current piece fell one tile.
+        int fall_interval = 0; ///< Current interval between falls.
+
+        int soft_drop_count = 0; ///< Count how many spaces the current piece has been soft-dropped, for scoring.
+
+        bool last_move_was_spin = false; ///< Keep track of if the last successful move was a spin, for T-spin scoring.
+
+        int score         = 0; ///< Current game score.
+        int level         = 0; ///< Current level.
+        int rows_cleared  = 0; ///< Total rows cleared this game.
+        int pieces_placed = 0; ///< Total pieces dropped this game.
+
+        int garbage_sent    = 0; ///< Garbage rows not yet taken by the opponent.
+        int garbage_pending = 0; ///< Garbage rows received but not yet added to the field.
+
+        utils::Random random;
+
+        /// Spawn the next piece to become the current piece.
+        void spawn_next();
+
+        /// Randomize pieces and add to the end of the queue.
+        void fill_queue();
+
+        /// Make the current piece fall one tile.
+        void fall();
+
+        /// Try to rotate the current piece either way, using the SRS wall kicks.
+        void rotate(bool clockwise);
+
+        /// Figure out where the current piece will end up if hard-dropped, so we can display the ghost
+        /// piece and/or actually do the hard-drop.
+        void update_ghost_row();
+    };
+
+    /// Identifies blocks games in input logs.
+    constexpr uint8_t REPLAY_ID = 2;
+
+    /// Play one tick of the player's game: advance the clock, then act on the buttons (masks of `1 << BTN_*`) `held`
+    /// now and `pressed` since the previous tick. Both the UI and replays play through here, so that a log always
+    /// plays out the same way.
+    void play_tick(Game &game, uint32_t held, uint32_t pressed, int delta_ms);
+
+    /// Re-simulate a recorded game from its input log, as fast as it goes. Returns the final score, or -1 if the log
+    /// is not a valid blocks log.
+    int replay(std::span<const uint8_t> log);
+
+} // namespace blocks
@@ -1,16 +1,18 @@
 #include "othello.hpp"
 
-#include <cassert>
+#include <bit>
+#include <cstdio>
+#include <string_view>
 
-#include <pico.h>
+#include <pico/time.h>
 
 #include <assets.hpp>
 #include <badge/buttons.hpp>
 #include <badge/drawing.hpp>
+#include <badge/font.hpp>
 #include <badge/pixel.hpp>
 #include <ui/ui.hpp>
 
-
 namespace othello
 {
 
@@ -27,6 +29,7 @@ namespace othello
 
     constexpr auto FLIP_ANIMATION_INTERVAL = 100;
     constexpr auto CURSOR_ANIMATION_INTERVAL = 200;
+    constexpr auto PASS_MESSAGE_MS = 1000;
 
     const image::Image *get_tile_image(TileState tile) {
         switch (tile) {
@@ -67,102 +70,59 @@ namespace othello
         result.board[3][4] = result.board[4][3] = TS_BLACK;
 
         // Set initial info.
+        result.position = Position::initial();
         result.black_plays_next = true;
-        result.black_pieces = 2;
-        result.white_pieces = 2;
-
-        result.update_move_flips();
+        result.update_moves();
 
         return result;
     }
 
-    void BoardState::update_move_flips() {
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                move_flips[r][c] = count_flips(r, c);
-            }
-        }
-    }
-
-    int BoardState::count_flips(int r, int c) const {
-        if (board[r][c] != TS_EMPTY)
-            return 0;
-        int sum = 0;
-        sum += count_flips(r, c, 1, 0);
-        sum += count_flips(r, c, -1, 0);
-        sum += count_flips(r, c, 0, 1);
-        sum += count_flips(r, c, 0, -1);
-        sum += count_flips(r, c, 1, 1);
-        sum += count_flips(r, c, -1, 1);
-        sum += count_flips(r, c, -1, -1);
-        sum += count_flips(r, c, 1, -1);
-        return sum;
-    }
-
-    bool BoardState::make_play(int r, int c) {
-        if (board[r][c] != TS_EMPTY)
-            return false;
-        int sum = 0;
-        sum += start_flips(r, c, 1, 0);
-        sum += start_flips(r, c, -1, 0);
-        sum += start_flips(r, c, 0, 1);
-        sum += start_flips(r, c, 0, -1);
-        sum += start_flips(r, c, 1, 1);
-        sum += start_flips(r, c, -1, 1);
-        sum += start_flips(r, c, -1, -1);
-        sum += start_flips(r, c, 1, -1);
-        if (sum == 0)
+    bool BoardState::make_play(int square) {
+        if (!(moves & get_bit(square)))
             return false;
-        if (black_plays_next) {
-            board[r][c] = TS_BLACK;
-            black_pieces += sum + 1;
-            white_pieces -= sum;
-            black_plays_next = false;
-        }
-        else {
-            board[r][c] = TS_WHITE;
-            white_pieces += sum + 1;
-            black_plays_next -= sum;
-            black_plays_next = true;
+
+        // The order of the state enumeration values is set up so that adding one to the black or white state will
+        // put it in the start of the flip animation.
+        for (auto flips = position.get_flips(square); flips != 0; flips &= flips - 1) {
+            const int flipped = std::countr_zero(flips);
+            auto &tile = board[flipped / 8][flipped % 8];
+            tile = static_cast<TileState>(tile + 1);
         }
+        board[square / 8][square % 8] = black_plays_next ? TS_BLACK : TS_WHITE;
+
+        position = position.play(square);
+        black_plays_next = !black_plays_next;
+        update_moves();
         return true;
     }
 
-    int BoardState::count_flips(int r0, int c0, int dr, int dc) const {
-        const auto player = black_plays_next ? TS_BLACK : TS_WHITE;
-        const auto opponent = black_plays_next ? TS_WHITE : TS_BLACK;
-        int r = r0;
-        int c = c0;
-        for (int i = 1; i < 8; i++) {
-            r += dr;
-            c += dc;
-            if (r < 0 || r >= 8 || c < 0 || c >= 8)
-                return 0;
-            if (board[r][c] == player)
-                return i - 1;
-            else if (board[r][c] == opponent)
-                continue;
-            else
-                return 0;
-        }
-        panic("Logic error in othello::BoardState::count_flips");
+    void BoardState::pass() {
+        position = position.pass();
+        black_plays_next = !black_plays_next;
+        update_moves();
     }
 
-    int BoardState::start_flips(int r0, int c0, int dr, int dc) {
-        const int n = count_flips(r0, c0, dr, dc);
-        for (int i = 1; i <= n; i++) {
-            const int r = r0 + dr * i;
-            const int c = c0 + dc * i;
-            // The order of the state enumeration values is set up so that adding one
-            // to the black or white state will put it in the start of the flip animation.
-            board[r][c] = static_cast<TileState>(board[r][c] + 1);
-        }
-        return n;
+    void BoardState::update_moves() {
+        moves = position.get_moves();
+        const auto black = black_plays_next ? position.player : position.opponent;
+        const auto white = black_plays_next ? position.opponent : position.player;
+        black_pieces = std::popcount(black);
+        white_pieces = std::popcount(white);
     }
 
     void OthelloGame::update(int delta_ms) {
         State::update(delta_ms);
 
+        if (state == GS_WAITING_TO_START || state == GS_GAME_OVER) {
+            if (buttons::a())
+                start(false);
+            else if (buttons::c())
+                start(true);
+            else if (buttons::b())
+                ui::pop_state();
+            return;
+        }
+
         if (buttons::b()) {
             ui::pop_state();
             return;
@@ -193,6 +153,10 @@ namespace othello
                 attempt_play();
         }
 
+        else if (state == GS_CPU_THINKING) {
+            update_cpu(delta_ms);
+        }
+
         else if (state == GS_ILLEGAL_MOVE) {
             animation_timer += delta_ms;
             if (animation_timer >= 500) {
@@ -200,6 +164,27 @@ namespace othello
                 animation_timer = animation_counter = 0;
             }
         }
+
+        else if (state == GS_PASSING) {
+            animation_timer += delta_ms;
+            if (animation_timer >= PASS_MESSAGE_MS)
+                next_turn();
+        }
+    }
+
+    void OthelloGame::update_cpu(int delta_ms) {
+        // Search for a slice of the frame, then move once the search is done or has had enough time.
+        animation_timer += delta_ms;
+        const auto start_us = time_us_32();
+        const bool done = search.think([start_us] { return time_us_32() - start_us >= CPU_THINK_US_PER_FRAME; });
+        if ((done && animation_timer >= CPU_MIN_THINK_MS) || animation_timer >= CPU_THINK_MS) {
+            const int move = search.get_best_move();
+            board.make_play(move);
+            cursor_row = move / 8;
+            cursor_col = move % 8;
+            state = GS_ANIMATING_FLIPS;
+            animation_timer = animation_counter = 0;
+        }
     }
 
     void OthelloGame::draw() {
@@ -223,7 +208,7 @@ namespace othello
                     drawing::draw_image(BOARD_LEFT + col * TILE_SIZE + PIECE_OFFSET,
                                         BOARD_TOP + row * TILE_SIZE + PIECE_OFFSET,
                                         *image);
-                if (state == GS_WAITING_ON_PLAYER && board.move_flips[row][col] > 0)
+                if (state == GS_WAITING_ON_PLAYER && (board.moves & get_bit(get_square(row, col))))
                     drawing::draw_ellipse(BOARD_LEFT + col * TILE_SIZE + PIECE_OFFSET,
                                           BOARD_TOP + row * TILE_SIZE + PIECE_OFFSET,
                                           TILE_SIZE - PIECE_OFFSET * 2 - 1,
@@ -232,12 +217,54 @@ namespace othello
             }
         }
 
-        // Draw the cursor.
-        const auto &cursor_image =
-            state == GS_ILLEGAL_MOVE ? image::red_x : (animation_counter == 0 ? image::cursor_anim1 : image::cursor_anim2);
-        drawing::draw_image(BOARD_LEFT + cursor_col * TILE_SIZE + PIECE_OFFSET,
-                            BOARD_TOP + cursor_row * TILE_SIZE + PIECE_OFFSET,
-                            cursor_image);
+        // Draw the cursor, only while it is the player's turn.
+        if (state == GS_WAITING_ON_PLAYER || state == GS_ILLEGAL_MOVE) {
+            const auto &cursor_image =
+                state == GS_ILLEGAL_MOVE ? image::red_x : (animation_counter == 0 ? image::cursor_anim1 : image::cursor_anim2);
+            drawing::draw_image(BOARD_LEFT + cursor_col * TILE_SIZE + PIECE_OFFSET,
+                                BOARD_TOP + cursor_row * TILE_SIZE + PIECE_OFFSET,
+                                cursor_image);
+        }
+
+        // The player who just passed is the one not playing next.
+        if (state == GS_PASSING) {
+            drawing::fill_rect(40, 55, 80, 18, COLOR_BLACK, 220);
+            drawing::draw_rect(40, 55, 80, 18, COLOR_WHITE);
+            drawing::draw_text_centered(80, 68, board.black_plays_next ? "White passes" : "Black passes",
+                                        COLOR_WHITE, font::m6x11);
+        }
+
+        if (state == GS_WAITING_TO_START || state == GS_GAME_OVER)
+            draw_prompt();
+    }
+
+    void OthelloGame::draw_prompt() const {
+        drawing::fill_rect(10, 42, 140, 66, COLOR_BLACK, 220);
+        drawing::draw_rect(10, 42, 140, 66, COLOR_WHITE);
+
+        char title[32] = "Othello";
+        if (state == GS_GAME_OVER) {
+            const char *winner = "Draw";
+            if (board.black_pieces != board.white_pieces) {
+                const bool black_wins = board.black_pieces > board.white_pieces;
+                if (vs_cpu)
+                    winner = black_wins ? "You win" : "You lose";
+                else
+                    winner = black_wins ? "Black wins" : "White wins";
+            }
+            snprintf(title, sizeof(title), "%s %d-%d", winner, board.black_pieces, board.white_pieces);
+        }
+        drawing::draw_text_centered(80, 56, title, COLOR_WHITE, font::m6x11);
+
+        const auto press = font::m6x11.render("Press ");
+        auto draw_line = [&](int y, const image::Image &button, std::string_view action) {
+            drawing::draw_text(20, y, 0, 0, COLOR_WHITE, press);
+            drawing::draw_image(20 + press.width, y + press.dy + (press.height - button.height) / 2, button);
+            drawing::draw_text(20 + press.width + button.width, y, 0, 0, COLOR_WHITE, font::m6x11.render(action));
+        };
+        draw_line(72, image::button_a, " for 2 players");
+        draw_line(86, image::button_c, " to play the CPU");
+        draw_line(100, image::button_b, " to exit");
     }
 
     void OthelloGame::pause() {}
@@ -245,13 +272,22 @@ namespace othello
     void OthelloGame::resume() { reset(); }
 
     void OthelloGame::reset() {
-        state = GS_WAITING_ON_PLAYER;
+        state = GS_WAITING_TO_START;
         board = BoardState::initial_state();
         cursor_row = cursor_col = 2;
     }
 
+    void OthelloGame::start(bool vs_cpu_mode) {
+        // The player always plays black, so moves first.
+        vs_cpu = vs_cpu_mode;
+        board = BoardState::initial_state();
+        cursor_row = cursor_col = 2;
+        state = GS_WAITING_ON_PLAYER;
+        animation_timer = animation_counter = 0;
+    }
+
     void OthelloGame::attempt_play() {
-        if (board.make_play(cursor_row, cursor_col)) {
+        if (board.make_play(get_square(cursor_row, cursor_col))) {
             state = GS_ANIMATING_FLIPS;
         }
         else {
@@ -269,10 +305,30 @@ namespace othello
         }
         animation_timer = 0;
         animation_counter++;
-        if (animation_counter >= 4) {
+        if (animation_counter >= 4)
+            next_turn();
+    }
+
+    void OthelloGame::next_turn() {
+        animation_timer = animation_counter = 0;
+
+        if (board.moves == 0) {
+            if (board.position.pass().get_moves() == 0) {
+                state = GS_GAME_OVER;
+            }
+            else {
+                board.pass();
+                state = GS_PASSING;
+            }
+            return;
+        }
+
+        if (vs_cpu && !board.black_plays_next) {
+            search.start(board.position);
+            state = GS_CPU_THINKING;
+        }
+        else {
             state = GS_WAITING_ON_PLAYER;
-            animation_counter = 0;
-            board.update_move_flips();
         }
     }
 
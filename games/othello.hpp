@@ -1,10 +1,13 @@
 #pragma once
 
 #include <array>
-#include <optional>
+#include <cstdint>
 
 #include <ui/state.hpp>
 
+#include "othello_board.hpp"
+#include "othello_search.hpp"
+
 namespace othello
 {
 
@@ -23,30 +26,48 @@ namespace othello
     };
 
     enum GameState {
+        GS_WAITING_TO_START,
         GS_WAITING_ON_PLAYER,
+        GS_CPU_THINKING,
         GS_ANIMATING_FLIPS,
         GS_ILLEGAL_MOVE,
+        GS_PASSING,
         GS_GAME_OVER,
     };
 
+    /// Microseconds per frame the computer player spends searching, leaving the rest of the frame for drawing.
+    constexpr auto CPU_THINK_US_PER_FRAME = 10000;
+
+    /// The computer player moves once it has thought for this long, or earlier if it has searched to the end.
+    constexpr auto CPU_THINK_MS = 1500;
+
+    /// The computer player never moves faster than this, so the player can see what is going on.
+    constexpr auto CPU_MIN_THINK_MS = 400;
+
     struct BoardState {
+        /// The tiles as drawn, including flip animations.
         std::array<std::array<TileState, 8>, 8> board = {};
         bool black_plays_next = true;
         int black_pieces = 0;
         int white_pieces = 0;
 
-        std::array<std::array<int, 8>, 8> move_flips = {};
+        /// The actual position, from the side of the player to move next.
+        Position position = {};
+
+        /// Legal moves of the player to move next.
+        uint64_t moves = 0;
 
         static BoardState initial_state();
 
-        void update_move_flips();
-        int count_flips(int r, int c) const;
-        bool make_play(int r, int c);
+        /// Play `square` for the player to move, starting the animation of the flipped pieces. Returns false if it
+        /// is not a legal move.
+        bool make_play(int square);
 
-    private:
-        int count_flips(int r0, int c0, int dr, int dc) const;
-        int start_flips(int r0, int c0, int dr, int dc);
+        /// Pass the turn to the other player.
+        void pass();
 
+    private:
+        void update_moves();
     };
 
     class OthelloGame final : public ui::State {
@@ -58,16 +79,27 @@ namespace othello
         void resume() override;
 
     private:
-        GameState state = GS_WAITING_ON_PLAYER;
+        GameState state = GS_WAITING_TO_START;
         BoardState board = {};
         int animation_timer = 0;
         int animation_counter = 0;
         int cursor_row = 0;
         int cursor_col = 0;
 
+        /// True when playing against the computer, which plays white.
+        bool vs_cpu = false;
+        Search search;
+
         void reset();
+        void start(bool vs_cpu_mode);
         void attempt_play();
         void animate_board();
+
+        /// Hand the turn over after a move: to the player, to the computer, by passing, or to the game over screen.
+        void next_turn();
+        void update_cpu(int delta_ms);
+
+        void draw_prompt() const;
     };
 
 } // namespace othello
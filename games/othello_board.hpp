@@ -0,0 +1,136 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+namespace othello
+{
+
+    /// Square `row * 8 + col` is bit `row * 8 + col` of a bitboard.
+    constexpr int get_square(int row, int col) { return row * 8 + col; }
+
+    constexpr uint64_t get_bit(int square) { return uint64_t(1) << square; }
+
+    namespace internal
+    {
+        constexpr uint64_t NOT_COL_0 = 0xFEFEFEFEFEFEFEFE;
+        constexpr uint64_t NOT_COL_7 = 0x7F7F7F7F7F7F7F7F;
+
+        /// Shift every piece one square in direction `D`, dropping whatever would wrap around to the other side of
+        /// the board. Directions are right, left, down, up, down right, down left, up right and up left.
+        template<int D>
+        constexpr uint64_t shift(uint64_t b) {
+            if constexpr (D == 0) return (b << 1) & NOT_COL_0;
+            if constexpr (D == 1) return (b >> 1) & NOT_COL_7;
+            if constexpr (D == 2) return b << 8;
+            if constexpr (D == 3) return b >> 8;
+            if constexpr (D == 4) return (b << 9) & NOT_COL_0;
+            if constexpr (D == 5) return (b << 7) & NOT_COL_7;
+            if constexpr (D == 6) return (b >> 7) & NOT_COL_0;
+            if constexpr (D == 7) return (b >> 9) & NOT_COL_7;
+        }
+
+        /// Call `f` with each of the eight directions as a compile time constant.
+        template<typename F>
+        constexpr void for_each_direction(F &&f) {
+            [&]<int... D>(std::integer_sequence<int, D...>) {
+                (f(std::integral_constant<int, D>()), ...);
+            }(std::make_integer_sequence<int, 8>());
+        }
+    } // namespace internal
+
+    /**
+     * Othello position as two bitboards, seen from the side to move: `player` has the pieces of the player to move
+     * next and `opponent` those of the other. Playing a move swaps them around.
+     */
+    struct Position {
+        uint64_t player = 0;
+        uint64_t opponent = 0;
+
+        /// The standard starting position, with black to move.
+        static constexpr Position initial() {
+            return {get_bit(get_square(3, 4)) | get_bit(get_square(4, 3)),
+                    get_bit(get_square(3, 3)) | get_bit(get_square(4, 4))};
+        }
+
+        [[nodiscard]] constexpr uint64_t get_empty() const { return ~(player | opponent); }
+
+        /**
+         * Squares the player to move can play. For each direction, flood fill from the player's pieces across
+         * adjacent opponent pieces; any empty square right after such a run is a move. Runs are at most 6 long.
+         */
+        [[nodiscard]] constexpr uint64_t get_moves() const {
+            uint64_t moves = 0;
+            internal::for_each_direction([&](auto d) {
+                constexpr auto shift = internal::shift<d>;
+                uint64_t run = shift(player) & opponent;
+                for (int i = 0; i < 5; i++)
+                    run |= shift(run) & opponent;
+                moves |= shift(run);
+            });
+            return moves & get_empty();
+        }
+
+        /// Opponent pieces flipped by playing `square`, which must be empty. Zero if it is not a legal move.
+        [[nodiscard]] constexpr uint64_t get_flips(int square) const {
+            uint64_t flips = 0;
+            internal::for_each_direction([&](auto d) {
+                constexpr auto shift = internal::shift<d>;
+                uint64_t run = 0;
+                uint64_t next = shift(get_bit(square));
+                while (next & opponent) {
+                    run |= next;
+                    next = shift(next);
+                }
+                if (next & player)
+                    flips |= run;
+            });
+            return flips;
+        }
+
+        /// The position after playing the legal move `square`.
+        [[nodiscard]] constexpr Position play(int square) const {
+            const auto flips = get_flips(square);
+            return {opponent ^ flips, player | flips | get_bit(square)};
+        }
+
+        /// The position after the player to move passes.
+        [[nodiscard]] constexpr Position pass() const { return {opponent, player}; }
+
+        /// True if neither side can move.
+        [[nodiscard]] constexpr bool is_game_over() const { return get_moves() == 0 && pass().get_moves() == 0; }
+
+        constexpr bool operator==(const Position &) const = default;
+    };
+
+    /**
+     * Count the leaves of the game tree `depth` moves deep, where a forced pass counts as a move and a finished
+     * game as a leaf. Comparing against known counts checks the move generator.
+     */
+    constexpr uint64_t perft(const Position &position, int depth) {
+        if (depth == 0)
+            return 1;
+        auto moves = position.get_moves();
+        if (moves == 0) {
+            if (position.pass().get_moves() == 0)
+                return 1;
+            return perft(position.pass(), depth - 1);
+        }
+        uint64_t count = 0;
+        for (; moves != 0; moves &= moves - 1)
+            count += perft(position.play(std::countr_zero(moves)), depth - 1);
+        return count;
+    }
+
+    namespace board_test
+    {
+        static_assert(std::popcount(Position::initial().get_moves()) == 4);
+        static_assert(perft(Position::initial(), 1) == 4);
+        static_assert(perft(Position::initial(), 2) == 12);
+        static_assert(perft(Position::initial(), 3) == 56);
+        static_assert(perft(Position::initial(), 4) == 244);
+        static_assert(perft(Position::initial(), 5) == 1396);
+    } // namespace board_test
+
+} // namespace othello
@@ -0,0 +1,165 @@
+#include "othello_search.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace othello
+{
+
+    constexpr uint64_t CORNERS = 0x8100000000000081;
+
+    /// Squares diagonally next to the corners, which tend to give the corner away to the opponent.
+    constexpr uint64_t X_SQUARES = 0x0042000000004200;
+
+    constexpr int WEIGHT_MOBILITY = 10;
+    constexpr int WEIGHT_CORNERS = 100;
+    constexpr int WEIGHT_X_SQUARES = -30;
+
+    int Search::evaluate(const Position &position) {
+        const auto player_moves = position.get_moves();
+        const auto opponent_moves = position.pass().get_moves();
+        if (player_moves == 0 && opponent_moves == 0)
+            return (std::popcount(position.player) - std::popcount(position.opponent)) * WIN_SCORE;
+
+        // X-squares only count against a player while the corner next to them is still up for grabs.
+        const auto empty_corners = CORNERS & position.get_empty();
+        const auto open_x_squares = ((empty_corners & get_bit(0)) << 9) | ((empty_corners & get_bit(7)) << 7) |
+                                    ((empty_corners & get_bit(56)) >> 7) | ((empty_corners & get_bit(63)) >> 9);
+
+        return WEIGHT_MOBILITY * (std::popcount(player_moves) - std::popcount(opponent_moves)) +
+               WEIGHT_CORNERS * (std::popcount(position.player & CORNERS) -
+                                 std::popcount(position.opponent & CORNERS)) +
+               WEIGHT_X_SQUARES * (std::popcount(position.player & open_x_squares) -
+                                   std::popcount(position.opponent & open_x_squares));
+    }
+
+    void Search::start(const Position &position) {
+        root = position;
+        depth = 1;
+        completed_depth = 0;
+        best_move = std::countr_zero(position.get_moves());
+        best_score = 0;
+        done = false;
+        stack_size = 0;
+        has_result = false;
+        push(root, depth, -INFINITE_SCORE, INFINITE_SCORE);
+    }
+
+    uint64_t Search::get_hash(const Position &position) {
+        return (position.player * 0x9E3779B97F4A7C15) ^ std::rotl(position.opponent * 0xC2B2AE3D27D4EB4F, 31);
+    }
+
+    void Search::push(const Position &position, int node_depth, int alpha, int beta) {
+        nodes++;
+        if (node_depth == 0) {
+            has_result = true;
+            result = evaluate(position);
+            return;
+        }
+
+        const auto moves = position.get_moves();
+        if (moves == 0 && position.pass().get_moves() == 0) {
+            has_result = true;
+            result = (std::popcount(position.player) - std::popcount(position.opponent)) * WIN_SCORE;
+            return;
+        }
+
+        // Narrow the window from what an earlier search found, or even skip this node, except at the root where we
+        // need to know the move.
+        int table_move = PASS;
+        const auto hash = get_hash(position);
+        const auto &entry = get_entry(hash);
+        const int original_alpha = alpha;
+        if (entry.hash == hash) {
+            table_move = entry.move;
+            if (entry.depth >= node_depth && stack_size > 0) {
+                if (entry.bound == BOUND_EXACT) {
+                    has_result = true;
+                    result = entry.score;
+                    return;
+                }
+                if (entry.bound == BOUND_LOWER)
+                    alpha = std::max(alpha, entry.score);
+                else
+                    beta = std::min(beta, entry.score);
+                if (alpha >= beta) {
+                    has_result = true;
+                    result = entry.score;
+                    return;
+                }
+            }
+        }
+
+        auto &frame = stack[stack_size++];
+        frame = {position, moves, node_depth, alpha, beta, original_alpha, -INFINITE_SCORE, PASS, PASS, table_move};
+
+        // Passing leaves the position to the opponent without using up any depth.
+        if (moves == 0)
+            push(position.pass(), node_depth, -beta, -alpha);
+    }
+
+    void Search::pop(int score) {
+        const auto &frame = stack[--stack_size];
+        const auto hash = get_hash(frame.position);
+        auto &entry = get_entry(hash);
+        entry.hash = hash;
+        entry.score = score;
+        entry.depth = static_cast<int8_t>(frame.depth);
+        entry.bound = score <= frame.original_alpha ? BOUND_UPPER : score >= frame.beta ? BOUND_LOWER : BOUND_EXACT;
+        entry.move = static_cast<int8_t>(frame.move);
+
+        if (stack_size > 0) {
+            has_result = true;
+            result = score;
+            return;
+        }
+
+        // Finished an iteration. Searching as deep as there are empty squares reaches the end of every game, and
+        // with a single move there is nothing to choose.
+        best_move = frame.move;
+        best_score = score;
+        completed_depth = depth;
+        if (depth >= std::popcount(root.get_empty()) || std::has_single_bit(root.get_moves())) {
+            done = true;
+            return;
+        }
+        push(root, ++depth, -INFINITE_SCORE, INFINITE_SCORE);
+    }
+
+    void Search::step() {
+        auto &frame = stack[stack_size - 1];
+
+        if (has_result) {
+            has_result = false;
+            const int score = -result;
+            if (score > frame.score) {
+                frame.score = score;
+                frame.move = frame.current_move;
+            }
+            frame.alpha = std::max(frame.alpha, score);
+            if (frame.alpha >= frame.beta) {
+                pop(frame.score);
+                return;
+            }
+        }
+
+        if (frame.moves_left == 0) {
+            pop(frame.score);
+            return;
+        }
+
+        // Try the best move from earlier searches first, then corners, and X-squares last.
+        uint64_t candidates = frame.moves_left;
+        if (frame.table_move != PASS && (candidates & get_bit(frame.table_move)))
+            candidates = get_bit(frame.table_move);
+        else if (candidates & CORNERS)
+            candidates &= CORNERS;
+        else if (candidates & ~X_SQUARES)
+            candidates &= ~X_SQUARES;
+        const int move = std::countr_zero(candidates);
+        frame.moves_left &= ~get_bit(move);
+        frame.current_move = move;
+        push(frame.position.play(move), frame.depth - 1, -frame.beta, -frame.alpha);
+    }
+
+} // namespace othello
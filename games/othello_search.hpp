@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "othello_board.hpp"
+
+namespace othello
+{
+
+    /**
+     * Alpha-beta (negamax) search for the computer player, deepening one move at a time.
+     *
+     * The search keeps its own stack instead of recursing, so it can stop whenever the frame's time is up and carry
+     * on in the next frame exactly where it left off. A transposition table remembers scores and best moves across
+     * iterations, so each deeper iteration tries the best move from the previous one first.
+     */
+    class Search {
+    public:
+        /// Score of a won game, per piece of difference. Larger than any heuristic score.
+        static constexpr int WIN_SCORE = 10000;
+
+        /// A move value for passing.
+        static constexpr int PASS = -1;
+
+        /// Start searching for the best move for the player to move in `position`, which must have a move.
+        void start(const Position &position);
+
+        /**
+         * Continue the search until it is done or `out_of_time()` returns true, which is checked every few nodes.
+         * Returns true once every depth up to the end of the game has been searched.
+         */
+        template<typename F>
+        bool think(F &&out_of_time) {
+            for (int steps = 1; !done; steps++) {
+                if (steps % 64 == 0 && out_of_time())
+                    return false;
+                step();
+            }
+            return true;
+        }
+
+        /// Best move found by the deepest complete iteration so far.
+        [[nodiscard]] int get_best_move() const { return best_move; }
+
+        /// Score of the best move, from the point of view of the player to move.
+        [[nodiscard]] int get_best_score() const { return best_score; }
+
+        /// Depth of the deepest complete iteration so far.
+        [[nodiscard]] int get_depth() const { return completed_depth; }
+
+        /// Nodes visited in total, for benchmarking.
+        [[nodiscard]] uint64_t get_nodes() const { return nodes; }
+
+        /// Heuristic score of a position, from the point of view of the player to move.
+        static int evaluate(const Position &position);
+
+    private:
+        static constexpr int INFINITE_SCORE = 1000000;
+
+        /// The transposition table has `1 << TABLE_BITS` entries of 16 bytes each.
+        static constexpr int TABLE_BITS = 10;
+
+        /// Game trees are at most 60 moves deep, plus a pass before each of them in the worst case.
+        static constexpr int MAX_PLY = 128;
+
+        enum Bound : uint8_t {
+            BOUND_EXACT,
+            BOUND_LOWER, ///< The score is at least this, the search stopped at a beta cutoff.
+            BOUND_UPPER, ///< The score is at most this, no move raised alpha.
+        };
+
+        struct Entry {
+            uint64_t hash = 0;
+            int32_t score = 0;
+            int8_t depth = -1;
+            Bound bound = BOUND_EXACT;
+            int8_t move = PASS;
+        };
+
+        /// A node being searched.
+        struct Frame {
+            Position position;
+            uint64_t moves_left; ///< Moves not searched yet.
+            int depth;
+            int alpha;
+            int beta;
+            int original_alpha;
+            int score;           ///< Best score so far.
+            int move;            ///< Best move so far.
+            int current_move;    ///< Move being searched by the child node.
+            int table_move;      ///< Best move according to the transposition table, to search first.
+        };
+
+        std::array<Entry, 1 << TABLE_BITS> table = {};
+        std::array<Frame, MAX_PLY> stack = {};
+        int stack_size = 0;
+
+        Position root = {};
+        int depth = 0;            ///< Depth of the current iteration.
+        int completed_depth = 0;
+        int best_move = PASS;
+        int best_score = 0;
+        bool done = true;
+
+        bool has_result = false;  ///< A child has just finished, with `result` from its point of view.
+        int result = 0;
+        uint64_t nodes = 0;
+
+        static uint64_t get_hash(const Position &position);
+
+        Entry &get_entry(uint64_t hash) { return table[hash >> (64 - TABLE_BITS)]; }
+
+        /// Enter a node, searching `depth` moves deep within the window `alpha` to `beta`.
+        void push(const Position &position, int depth, int alpha, int beta);
+
+        /// Leave the current node with its score, and pass it up to the parent.
+        void pop(int score);
+
+        /// Do one unit of work: enter a node, or handle a child's result and move on to the next child.
+        void step();
+    };
+
+} // namespace othello
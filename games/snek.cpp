@@ -1,7 +1,7 @@
 #include "snek.hpp"
 
-#include <cassert>
-#include <cstring>
+#include <cstdio>
+#include <string_view>
 
 #include <pico/rand.h>
 
@@ -9,14 +9,14 @@
 #include <badge/buttons.hpp>
 #include <badge/drawing.hpp>
 #include <badge/font.hpp>
+#include <badge/lcd.hpp>
+#include <badge/replays.hpp>
 #include <ui/ui.hpp>
 
 namespace snek
 {
 
-    constexpr int CELL_SIZE   = 8;
-    constexpr int GRID_WIDTH  = 19;
-    constexpr int GRID_HEIGHT = 13;
+    constexpr int CELL_SIZE = 8;
 
     constexpr int GRID_PX_LEFT   = 4;
     constexpr int GRID_PX_TOP    = 20;
@@ -27,48 +27,29 @@ namespace snek
     constexpr auto BORDER_COLOR = COLOR_WHITE;
     constexpr auto SNEK_COLOR   = rgb888(50, 255, 0);
 
-    constexpr auto INITIAL_SNEK_U      = GRID_WIDTH / 3;
-    constexpr auto INITIAL_SNEK_V      = GRID_HEIGHT / 2;
-    constexpr auto INITIAL_SNEK_LENGTH = 5;
-
-    constexpr auto INITIAL_MOVE_INTERVAL   = 500;
-    constexpr auto MOVE_INTERVAL_DECREMENT = 10;
-    constexpr auto MIN_MOVE_INTERVAL       = 100;
-
-    constexpr std::pair<int, int> direction_to_du_dv(CellState dir) {
-        switch (dir) {
-            case CellState::UP:
-                return {0, -1};
-            case CellState::DOWN:
-                return {0, 1};
-            case CellState::LEFT:
-                return {-1, 0};
-            case CellState::RIGHT:
-                return {1, 0};
-            default:
-                panic("Invalid direction");
-        }
-    }
+    constexpr uint32_t STEER_BUTTONS = 1 << BTN_UP | 1 << BTN_DOWN | 1 << BTN_LEFT | 1 << BTN_RIGHT;
+
+    SnekGame::SnekGame() : State(TICK_MS) {}
 
     void SnekGame::update(int delta_ms) {
+        pending_presses |= buttons::get(buttons::ALL);
         State::update(delta_ms);
-        if (game_state == GameState::PLAYING) {
-            move_timer -= delta_ms;
-            if (move_timer <= 0) {
-                advance();
-                move_timer += move_interval;
-                if (move_timer <= 0)
-                    move_timer = move_interval;
-                changed_direction = false;
-                if (queued_direction != CellState::EMPTY) {
-                    direction        = queued_direction;
-                    queued_direction = CellState::EMPTY;
-                }
+
+        if (game_state == GameState::WAITING_TO_START) {
+            // The game starts as soon as a direction is pressed, and is recorded from its first tick. That tick takes
+            // the direction, even if it was only tapped.
+            const auto held = buttons::get_current(buttons::ALL) | pending_presses;
+            if (held & STEER_BUTTONS) {
+                game_state = GameState::PLAYING;
+                replays::start(replays::SLOT_SNEK, REPLAY_ID, seed, held);
+            }
+            else if (buttons::b()) {
+                ui::pop_state();
             }
         }
         else if (game_state == GameState::DEAD) {
-            move_timer -= delta_ms;
-            if (move_timer <= 0)
+            dead_timer -= delta_ms;
+            if (dead_timer <= 0)
                 game_state = GameState::AFTERLIFE;
         }
         else if (game_state == GameState::AFTERLIFE) {
@@ -79,21 +60,89 @@ namespace snek
                 ui::pop_state();
             }
         }
-        else if (game_state == GameState::WAITING_TO_START) {
-            if (buttons::b())
-                ui::pop_state();
+
+        // Only a game being played takes presses.
+        if (game_state != GameState::PLAYING)
+            pending_presses = 0;
+    }
+
+    void SnekGame::tick() {
+        if (game_state != GameState::PLAYING)
+            return;
+
+        const auto head = game.get_head();
+        const auto tail = game.get_tail();
+        const auto fruit = game.get_fruit();
+        const auto direction = game.get_direction();
+
+        const auto held = buttons::get_current(buttons::ALL) | pending_presses;
+        pending_presses = 0;
+        replays::record(held, TICK_MS);
+        play_tick(game, held, TICK_MS);
+        if (game.is_dead()) {
+            game_state = GameState::DEAD;
+            dead_timer = 1000;
+            if (replays::finish(game.get_score()))
+                verify_best();
+        }
+
+        // A move only changes the cells at either end of the snake, and the fruit. Turning changes the head.
+        if (game.get_head() != head) {
+            mark_dirty(head);
+            mark_dirty(game.get_head());
+        }
+        if (game.get_tail() != tail) {
+            mark_dirty(tail);
+            mark_dirty(game.get_tail());
+        }
+        if (game.get_fruit() != fruit) {
+            if (fruit != NO_FRUIT)
+                mark_dirty(fruit);
+            if (game.get_fruit() != NO_FRUIT)
+                mark_dirty(game.get_fruit());
+        }
+        if (game.get_direction() != direction)
+            mark_dirty(game.get_head());
+    }
+
+    void SnekGame::mark_dirty(int cell) {
+        for (int i = 0; i < 2; i++) {
+            if (redraw_all[i])
+                continue;
+            if (dirty_counts[i] == MAX_DIRTY_CELLS)
+                redraw_all[i] = true;
+            else
+                dirty_cells[i][dirty_counts[i]++] = static_cast<cell_t>(cell);
         }
-        if (buttons::up_current())
-            steer(CellState::UP);
-        if (buttons::down_current())
-            steer(CellState::DOWN);
-        if (buttons::left_current())
-            steer(CellState::LEFT);
-        if (buttons::right_current())
-            steer(CellState::RIGHT);
     }
 
     void SnekGame::draw() {
+        // While playing, the frame buffer we draw into still has the frame from two frames ago, so only the cells
+        // that changed since need drawing. Anything else redraws the whole screen, and so will the next frames.
+        const int buffer = static_cast<int>(lcd::get_frame_count() % 2);
+        if (game_state == GameState::PLAYING && !redraw_all[buffer]) {
+            draw_score();
+            for (int i = 0; i < dirty_counts[buffer]; i++)
+                redraw_cell(dirty_cells[buffer][i]);
+            dirty_counts[buffer] = 0;
+            return;
+        }
+
+        draw_everything();
+        if (game_state == GameState::PLAYING) {
+            redraw_all[buffer] = false;
+            dirty_counts[buffer] = 0;
+        }
+        else {
+            redraw_all = {true, true};
+        }
+    }
+
+    void SnekGame::invalidate() {
+        redraw_all = {true, true};
+    }
+
+    void SnekGame::draw_everything() {
         // First, clear to black.
         drawing::clear(COLOR_BLACK);
 
@@ -104,11 +153,7 @@ namespace snek
             drawing::draw_image(lcd::WIDTH / 2 - image::nav_4way.width / 2, GRID_PX_TOP + 20, image::nav_4way);
         }
         else {
-            // Write the score top and center.
-            char       buffer[32];
-            const auto n      = snprintf(buffer, sizeof(buffer), "Score: %d", score);
-            const auto render = font::m6x11.render(std::string_view(buffer, n));
-            drawing::draw_text(lcd::WIDTH / 2 - render.dx - render.width / 2, 2 - render.dy, 0, 0, COLOR_WHITE, render);
+            draw_score();
         }
 
         if (game_state == GameState::AFTERLIFE) {
@@ -130,192 +175,121 @@ namespace snek
         drawing::draw_rect(GRID_PX_LEFT - 2, GRID_PX_TOP - 2, GRID_PX_WIDTH + 4, GRID_PX_HEIGHT + 4, COLOR_WHITE);
 
         // Go over the grid and draw all the content.
-        for (int u = 0; u < GRID_WIDTH; u++) {
-            for (int v = 0; v < GRID_HEIGHT; v++) {
-                const auto state = at(u, v);
-                if (state == CellState::EMPTY)
-                    continue;
-                const auto left = GRID_PX_LEFT + u * CELL_SIZE;
-                const auto top  = GRID_PX_TOP + v * CELL_SIZE;
-                if (state == CellState::FRUIT)
-                    drawing::draw_image(left, top, image::snek_fruit);
-                else if (state == CellState::UP)
-                    drawing::fill_rect(left + 1, top - 1, CELL_SIZE - 2, CELL_SIZE, SNEK_COLOR);
-                else if (state == CellState::DOWN)
-                    drawing::fill_rect(left + 1, top + 1, CELL_SIZE - 2, CELL_SIZE, SNEK_COLOR);
-                else if (state == CellState::LEFT)
-                    drawing::fill_rect(left - 1, top + 1, CELL_SIZE, CELL_SIZE - 2, SNEK_COLOR);
-                else if (state == CellState::RIGHT)
-                    drawing::fill_rect(left + 1, top + 1, CELL_SIZE, CELL_SIZE - 2, SNEK_COLOR);
-                else if (state == CellState::HEAD) {
-                    drawing::fill_rect(left + 1, top + 1, CELL_SIZE - 2, CELL_SIZE - 2, SNEK_COLOR);
-                    int x, y, dx, dy;
-                    if (direction == CellState::UP) {
-                        x  = left + 2;
-                        y  = top + 2;
-                        dx = 1;
-                        dy = 0;
-                    }
-                    else if (direction == CellState::DOWN) {
-                        x  = left + CELL_SIZE - 3;
-                        y  = top + CELL_SIZE - 3;
-                        dx = -1;
-                        dy = 0;
-                    }
-                    else if (direction == CellState::LEFT) {
-                        x  = left + 2;
-                        y  = top + CELL_SIZE - 3;
-                        dx = 0;
-                        dy = -1;
-                    }
-                    else if (direction == CellState::RIGHT) {
-                        x  = left + CELL_SIZE - 3;
-                        y  = top + 2;
-                        dx = 0;
-                        dy = 1;
-                    }
-                    else {
-                        panic("Logic error in Snek");
-                    }
-                    // Draw eyes.
-                    drawing::draw_pixel(x, y, COLOR_BLACK);
-                    drawing::draw_pixel(x + dx * 3, y + dy * 3, COLOR_BLACK);
-                    drawing::draw_pixel(x - dy, y + dx, COLOR_BLACK);
-                    drawing::draw_pixel(x + dx * 3 - dy, y + dy * 3 + dx, COLOR_BLACK);
-                    // Draw snout.
-                    drawing::draw_line(x + dy * 2, y - dx * 2, x + dx * 3 + dy * 2, y + dy * 3 - dx * 2, SNEK_COLOR);
-                }
+        for (int cell = 0; cell < GRID_CELLS; cell++)
+            draw_cell(cell);
+    }
+
+    void SnekGame::draw_score() {
+        // Write the score top and center, over whatever score was there before.
+        drawing::fill_rect(0, 0, lcd::WIDTH, GRID_PX_TOP - 2, BG_COLOR);
+        char       buffer[32];
+        const auto n      = best > 0 ? snprintf(buffer, sizeof(buffer), "Score: %d  Best: %d", game.get_score(), best)
+                                     : snprintf(buffer, sizeof(buffer), "Score: %d", game.get_score());
+        const auto render = font::m6x11.render(std::string_view(buffer, n));
+        drawing::draw_text(lcd::WIDTH / 2 - render.dx - render.width / 2, 2 - render.dy, 0, 0, COLOR_WHITE, render);
+    }
+
+    void SnekGame::redraw_cell(int cell) {
+        const int u = get_u(cell);
+        const int v = get_v(cell);
+
+        // Body cells at the edges draw a pixel past the grid when they wrap around, so clear that too.
+        const int left = GRID_PX_LEFT + u * CELL_SIZE - (u == 0);
+        const int top  = GRID_PX_TOP + v * CELL_SIZE - (v == 0);
+        const int width  = CELL_SIZE + (u == 0) + (u == GRID_WIDTH - 1);
+        const int height = CELL_SIZE + (v == 0) + (v == GRID_HEIGHT - 1);
+        drawing::fill_rect(left, top, width, height, BG_COLOR);
+        draw_cell(cell);
+
+        // Body cells also draw a pixel into the next cell, to join up. Those are plain fills, so just draw them again.
+        if (u > 0 && game.get(cell - 1) == CellState::RIGHT)
+            draw_cell(cell - 1);
+        if (u < GRID_WIDTH - 1 && game.get(cell + 1) == CellState::LEFT)
+            draw_cell(cell + 1);
+        if (v > 0 && game.get(cell - GRID_WIDTH) == CellState::DOWN)
+            draw_cell(cell - GRID_WIDTH);
+        if (v < GRID_HEIGHT - 1 && game.get(cell + GRID_WIDTH) == CellState::UP)
+            draw_cell(cell + GRID_WIDTH);
+    }
+
+    void SnekGame::draw_cell(int cell) {
+        const auto state = game.get(cell);
+        if (state == CellState::EMPTY)
+            return;
+        const auto left = GRID_PX_LEFT + get_u(cell) * CELL_SIZE;
+        const auto top  = GRID_PX_TOP + get_v(cell) * CELL_SIZE;
+        if (state == CellState::FRUIT)
+            drawing::draw_image(left, top, image::snek_fruit);
+        else if (state == CellState::UP)
+            drawing::fill_rect(left + 1, top - 1, CELL_SIZE - 2, CELL_SIZE, SNEK_COLOR);
+        else if (state == CellState::DOWN)
+            drawing::fill_rect(left + 1, top + 1, CELL_SIZE - 2, CELL_SIZE, SNEK_COLOR);
+        else if (state == CellState::LEFT)
+            drawing::fill_rect(left - 1, top + 1, CELL_SIZE, CELL_SIZE - 2, SNEK_COLOR);
+        else if (state == CellState::RIGHT)
+            drawing::fill_rect(left + 1, top + 1, CELL_SIZE, CELL_SIZE - 2, SNEK_COLOR);
+        else if (state == CellState::HEAD) {
+            drawing::fill_rect(left + 1, top + 1, CELL_SIZE - 2, CELL_SIZE - 2, SNEK_COLOR);
+            const auto direction = game.get_direction();
+            int x, y, dx, dy;
+            if (direction == CellState::UP) {
+                x  = left + 2;
+                y  = top + 2;
+                dx = 1;
+                dy = 0;
             }
+            else if (direction == CellState::DOWN) {
+                x  = left + CELL_SIZE - 3;
+                y  = top + CELL_SIZE - 3;
+                dx = -1;
+                dy = 0;
+            }
+            else if (direction == CellState::LEFT) {
+                x  = left + 2;
+                y  = top + CELL_SIZE - 3;
+                dx = 0;
+                dy = -1;
+            }
+            else if (direction == CellState::RIGHT) {
+                x  = left + CELL_SIZE - 3;
+                y  = top + 2;
+                dx = 0;
+                dy = 1;
+            }
+            else {
+                panic("Logic error in Snek");
+            }
+            // Draw eyes.
+            drawing::draw_pixel(x, y, COLOR_BLACK);
+            drawing::draw_pixel(x + dx * 3, y + dy * 3, COLOR_BLACK);
+            drawing::draw_pixel(x - dy, y + dx, COLOR_BLACK);
+            drawing::draw_pixel(x + dx * 3 - dy, y + dy * 3 + dx, COLOR_BLACK);
+            // Draw snout.
+            drawing::draw_line(x + dy * 2, y - dx * 2, x + dx * 3 + dy * 2, y + dy * 3 - dx * 2, SNEK_COLOR);
         }
     }
 
     void SnekGame::pause() {
-        delete[] grid;
-        grid = nullptr;
+        replays::cancel();
     }
 
     void SnekGame::resume() {
-        assert(grid == nullptr);
-        grid = new CellState[GRID_WIDTH * GRID_HEIGHT];
-
+        verify_best();
         reset();
     }
 
-    CellState &SnekGame::at(int u, int v) {
-        assert(u >= 0 && u < GRID_WIDTH && v >= 0 && v < GRID_HEIGHT);
-        return grid[v * GRID_WIDTH + u];
+    void SnekGame::verify_best() {
+        // Re-simulate the stored best game, which only takes a moment, and only show its score if it adds up.
+        const auto highscore = replays::get_highscore(replays::SLOT_SNEK);
+        best = highscore > 0 && replay(replays::load(replays::SLOT_SNEK)) == highscore ? highscore : 0;
     }
 
     void SnekGame::reset() {
-        memset(grid, 0, sizeof(CellState) * GRID_WIDTH * GRID_HEIGHT);
-
-        head_u    = INITIAL_SNEK_U;
-        head_v    = INITIAL_SNEK_V;
-        tail_u    = head_u - INITIAL_SNEK_LENGTH + 1;
-        tail_v    = head_v;
-        length    = INITIAL_SNEK_LENGTH;
-        fruit_u   = GRID_WIDTH * 3 / 4;
-        fruit_v   = GRID_HEIGHT * 3 / 4;
-        direction = CellState::RIGHT;
-
-        at(head_u, head_v) = CellState::HEAD;
-        for (int i = 1; i < length; i++) {
-            at(head_u - i, head_v) = CellState::RIGHT;
-        }
-
-        at(fruit_u, fruit_v) = CellState::FRUIT;
-
-        move_timer    = INITIAL_MOVE_INTERVAL + 100;
-        move_interval = INITIAL_MOVE_INTERVAL;
-
-        changed_direction = false;
-        queued_direction  = CellState::EMPTY;
-
-        score = 0;
-
+        seed = get_rand_32();
+        game.reset(seed);
+        dead_timer = 0;
+        redraw_all = {true, true};
         game_state = GameState::WAITING_TO_START;
     }
 
-
-    void SnekGame::advance() {
-        auto &tail_state = at(tail_u, tail_v);
-
-        const auto [head_du, head_dv] = direction_to_du_dv(direction);
-        const auto [tail_du, tail_dv] = direction_to_du_dv(tail_state);
-
-        const int new_head_u = (head_u + GRID_WIDTH + head_du) % GRID_WIDTH;
-        const int new_head_v = (head_v + GRID_HEIGHT + head_dv) % GRID_HEIGHT;
-
-        auto &new_head = at(new_head_u, new_head_v);
-
-        bool ate_fruit = false;
-        if (new_head == CellState::FRUIT) {
-            new_head  = CellState::EMPTY;
-            ate_fruit = true;
-        }
-        else {
-            tail_state = CellState::EMPTY;
-            tail_u     = (tail_u + GRID_WIDTH + tail_du) % GRID_WIDTH;
-            tail_v     = (tail_v + GRID_HEIGHT + tail_dv) % GRID_HEIGHT;
-        }
-
-        if (new_head == CellState::EMPTY) {
-            at(head_u, head_v) = direction;
-            new_head           = CellState::HEAD;
-            head_u             = new_head_u;
-            head_v             = new_head_v;
-        }
-        else {
-            game_state           = GameState::DEAD;
-            at(fruit_u, fruit_v) = CellState::EMPTY;
-            move_timer           = 1000;
-        }
-
-        if (ate_fruit) {
-            length++;
-            score += INITIAL_MOVE_INTERVAL + 100 - move_interval;
-            if (move_interval > MIN_MOVE_INTERVAL)
-                move_interval -= MOVE_INTERVAL_DECREMENT;
-            place_fruit();
-        }
-    }
-
-    void SnekGame::steer(CellState dir) {
-        if (game_state == GameState::WAITING_TO_START)
-            game_state = GameState::PLAYING;
-        if (game_state != GameState::PLAYING)
-            return;
-        if (dir == direction)
-            return;
-        if ((direction == CellState::UP && dir == CellState::DOWN) ||
-            (direction == CellState::DOWN && dir == CellState::UP) ||
-            (direction == CellState::LEFT && dir == CellState::RIGHT) ||
-            (direction == CellState::RIGHT && dir == CellState::LEFT))
-            return;
-        if (!changed_direction) {
-            direction         = dir;
-            changed_direction = true;
-        }
-        else {
-            queued_direction = direction;
-        }
-    }
-
-    void SnekGame::place_fruit() {
-        int n = 0;
-        for (int u = 0; u < GRID_WIDTH; u++) {
-            for (int v = 0; v < GRID_HEIGHT; v++) {
-                if (at(u, v) != CellState::EMPTY)
-                    continue;
-                n++;
-                if (get_rand_32() % n == 0) {
-                    fruit_u = u;
-                    fruit_v = v;
-                }
-            }
-        }
-        at(fruit_u, fruit_v) = CellState::FRUIT;
-    }
-
-
 } // namespace snek
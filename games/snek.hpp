@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
+
 #include <ui/state.hpp>
 
+#include "snek_game.hpp"
+
 namespace snek
 {
 
@@ -12,54 +16,61 @@ namespace snek
         AFTERLIFE,
     };
 
-    enum class CellState : uint8_t {
-        EMPTY = 0,
-        HEAD,
-        FRUIT,
-        LEFT,
-        RIGHT,
-        UP,
-        DOWN,
-    };
+    /// Milliseconds per game tick. Shorter than a frame, so that every frame gets at least one tick.
+    constexpr auto TICK_MS = 10;
 
     class SnekGame final : public ui::State {
     public:
+        SnekGame();
+
         void update(int delta_ms) override;
+        void tick() override;
         void draw() override;
+        void invalidate() override;
 
         void pause() override;
         void resume() override;
 
     private:
+        /// Cells to redraw per frame before giving up and redrawing everything.
+        static constexpr int MAX_DIRTY_CELLS = 16;
+
         GameState game_state = {};
+        Game game;
+
+        /// Seed of the current game, for its recording.
+        uint32_t seed = 0;
 
-        CellState *grid = nullptr;
+        /// Best score, or zero if there is none or its replay does not match.
+        int best = 0;
 
-        int head_u  = 0;
-        int head_v  = 0;
-        int tail_u  = 0;
-        int tail_v  = 0;
-        int length  = 0;
-        int fruit_u = 0;
-        int fruit_v = 0;
+        /// Milliseconds left to show the dead snake.
+        int dead_timer = 0;
 
-        CellState direction = {};
+        /// Buttons pressed since the last tick. A tap can be over within a frame, so the next tick takes these as held
+        /// too.
+        uint32_t pending_presses = 0;
 
-        int move_timer = 0;
-        int move_interval = 1000;
+        // The LCD has two frame buffers that take turns, so each keeps its own list of cells changed since it was
+        // last drawn. Only those are drawn again while playing.
+        std::array<std::array<cell_t, MAX_DIRTY_CELLS>, 2> dirty_cells = {};
+        std::array<int, 2> dirty_counts = {};
+        std::array<bool, 2> redraw_all = {};
 
-        int score = 0;
+        void reset();
 
-        bool changed_direction = false;
-        CellState queued_direction = {};
+        /// Check the stored best game by replaying it, and set `best` to its score if it matches.
+        void verify_best();
 
-        CellState &at(int u, int v);
+        /// Remember a changed cell for both frame buffers.
+        void mark_dirty(int cell);
 
-        void reset();
-        void advance();
-        void steer(CellState dir);
-        void place_fruit();
+        void draw_everything();
+        void draw_score();
 
+        /// Clear a cell and draw it again, including the bits neighboring body cells draw into it.
+        void redraw_cell(int cell);
+        void draw_cell(int cell);
     };
 
 } // namespace snek
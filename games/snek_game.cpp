@@ -0,0 +1,186 @@
+#include "snek_game.hpp"
+
+#include <utility>
+
+#include <badge/badge-2025.h>
+#include <utils/input_log.hpp>
+
+namespace snek
+{
+
+    constexpr std::pair<int, int> direction_to_du_dv(CellState dir) {
+        switch (dir) {
+            case CellState::UP:
+                return {0, -1};
+            case CellState::DOWN:
+                return {0, 1};
+            case CellState::LEFT:
+                return {-1, 0};
+            case CellState::RIGHT:
+                return {1, 0};
+            default:
+                return {0, 0};
+        }
+    }
+
+    void Game::reset(uint32_t seed) {
+        // Every cell starts out empty.
+        grid = {};
+        free_count = 0;
+        for (int cell = 0; cell < GRID_CELLS; cell++)
+            add_free(static_cast<cell_t>(cell));
+
+        // Lay out the snake from its tail up to its head, heading right.
+        tail_index = 0;
+        length     = INITIAL_SNEK_LENGTH;
+        direction  = CellState::RIGHT;
+        for (int i = 0; i < length; i++) {
+            const auto cell = get_cell(INITIAL_SNEK_U - length + 1 + i, INITIAL_SNEK_V);
+            body[i] = cell;
+            grid[cell] = i == length - 1 ? CellState::HEAD : CellState::RIGHT;
+            remove_free(cell);
+        }
+
+        // The first fruit is always in the same place, right ahead of the snake.
+        fruit = get_cell(GRID_WIDTH * 3 / 4, GRID_HEIGHT * 3 / 4);
+        grid[fruit] = CellState::FRUIT;
+        remove_free(fruit);
+
+        random.seed(seed);
+        dead = false;
+        move_timer    = INITIAL_MOVE_INTERVAL + 100;
+        move_interval = INITIAL_MOVE_INTERVAL;
+        changed_direction = false;
+        queued_direction  = CellState::EMPTY;
+        score = 0;
+    }
+
+    void Game::update(int delta_ms) {
+        if (dead)
+            return;
+        move_timer -= delta_ms;
+        if (move_timer > 0)
+            return;
+
+        advance();
+        move_timer += move_interval;
+        if (move_timer <= 0)
+            move_timer = move_interval;
+        changed_direction = false;
+        if (queued_direction != CellState::EMPTY) {
+            direction        = queued_direction;
+            queued_direction = CellState::EMPTY;
+        }
+    }
+
+    void Game::steer(CellState dir) {
+        if (dead || dir == direction)
+            return;
+        if ((direction == CellState::UP && dir == CellState::DOWN) ||
+            (direction == CellState::DOWN && dir == CellState::UP) ||
+            (direction == CellState::LEFT && dir == CellState::RIGHT) ||
+            (direction == CellState::RIGHT && dir == CellState::LEFT))
+            return;
+        if (!changed_direction) {
+            direction         = dir;
+            changed_direction = true;
+        }
+        else {
+            queued_direction = dir;
+        }
+    }
+
+    void Game::advance() {
+        if (dead)
+            return;
+
+        const auto head = get_head();
+        const auto [du, dv] = direction_to_du_dv(direction);
+        const auto new_head = get_cell((get_u(head) + GRID_WIDTH + du) % GRID_WIDTH,
+                                       (get_v(head) + GRID_HEIGHT + dv) % GRID_HEIGHT);
+
+        // The tail moves out of the way first, unless the snake grows, so the head may follow right behind it.
+        const bool ate_fruit = new_head == fruit;
+        if (ate_fruit) {
+            grid[new_head] = CellState::EMPTY;
+            fruit = NO_FRUIT;
+        }
+        else {
+            const auto tail = get_tail();
+            grid[tail] = CellState::EMPTY;
+            add_free(tail);
+            tail_index = (tail_index + 1) % GRID_CELLS;
+            length--;
+        }
+
+        if (grid[new_head] != CellState::EMPTY) {
+            dead = true;
+            if (fruit != NO_FRUIT)
+                grid[fruit] = CellState::EMPTY;
+            return;
+        }
+
+        grid[head] = direction;
+        grid[new_head] = CellState::HEAD;
+        if (!ate_fruit)
+            remove_free(new_head);
+        body[(tail_index + length) % GRID_CELLS] = new_head;
+        length++;
+
+        if (ate_fruit) {
+            score += INITIAL_MOVE_INTERVAL + 100 - move_interval;
+            if (move_interval > MIN_MOVE_INTERVAL)
+                move_interval -= MOVE_INTERVAL_DECREMENT;
+            place_fruit();
+        }
+    }
+
+    void Game::add_free(cell_t cell) {
+        free_slots[cell] = static_cast<cell_t>(free_count);
+        free_cells[free_count++] = cell;
+    }
+
+    void Game::remove_free(cell_t cell) {
+        // Move the last free cell into the removed one's slot.
+        const auto slot = free_slots[cell];
+        const auto last = free_cells[--free_count];
+        free_cells[slot] = last;
+        free_slots[last] = slot;
+        free_slots[cell] = NOT_FREE;
+    }
+
+    void Game::place_fruit() {
+        if (free_count == 0)
+            return;
+        fruit = free_cells[random.below(free_count)];
+        grid[fruit] = CellState::FRUIT;
+        remove_free(static_cast<cell_t>(fruit));
+    }
+
+    void play_tick(Game &game, uint32_t held, int delta_ms) {
+        game.update(delta_ms);
+        if (held & (1 << BTN_UP))
+            game.steer(CellState::UP);
+        if (held & (1 << BTN_DOWN))
+            game.steer(CellState::DOWN);
+        if (held & (1 << BTN_LEFT))
+            game.steer(CellState::LEFT);
+        if (held & (1 << BTN_RIGHT))
+            game.steer(CellState::RIGHT);
+    }
+
+    int replay(std::span<const uint8_t> log) {
+        utils::InputLogReader reader(log);
+        if (!reader.is_valid() || reader.get_header().game != REPLAY_ID)
+            return -1;
+
+        Game game;
+        game.reset(reader.get_header().seed);
+        uint32_t held;
+        int delta_ms;
+        while (!game.is_dead() && reader.next(held, delta_ms))
+            play_tick(game, held, delta_ms);
+        return reader.is_valid() ? game.get_score() : -1;
+    }
+
+} // namespace snek
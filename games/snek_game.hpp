@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <utils/random.hpp>
+
+namespace snek
+{
+
+    constexpr int GRID_WIDTH  = 19;
+    constexpr int GRID_HEIGHT = 13;
+    constexpr int GRID_CELLS  = GRID_WIDTH * GRID_HEIGHT;
+
+    /// Cells are numbered `v * GRID_WIDTH + u`, which fits a byte.
+    using cell_t = uint8_t;
+    static_assert(GRID_CELLS <= 256);
+
+    constexpr auto INITIAL_SNEK_U      = GRID_WIDTH / 3;
+    constexpr auto INITIAL_SNEK_V      = GRID_HEIGHT / 2;
+    constexpr auto INITIAL_SNEK_LENGTH = 5;
+
+    constexpr auto INITIAL_MOVE_INTERVAL   = 500;
+    constexpr auto MOVE_INTERVAL_DECREMENT = 10;
+    constexpr auto MIN_MOVE_INTERVAL       = 100;
+
+    /// No fruit, once the snake fills the whole grid.
+    constexpr int NO_FRUIT = -1;
+
+    enum class CellState : uint8_t {
+        EMPTY = 0,
+        HEAD,
+        FRUIT,
+        LEFT,
+        RIGHT,
+        UP,
+        DOWN,
+    };
+
+    constexpr cell_t get_cell(int u, int v) { return static_cast<cell_t>(v * GRID_WIDTH + u); }
+    constexpr int get_u(int cell) { return cell % GRID_WIDTH; }
+    constexpr int get_v(int cell) { return cell / GRID_WIDTH; }
+
+    /**
+     * The rules of the game, without any drawing or input handling, so it can be played headless on the host.
+     *
+     * The snake's body is a ring buffer of cells from tail to head, so moving only touches the two ends. The empty
+     * cells are kept in a set that can add and remove cells by swapping with the last one, so a new fruit is one
+     * random pick. Everything is fixed size, with no allocations.
+     */
+    class Game {
+    public:
+        /// Reset everything to a new game. All randomness comes from `seed`.
+        void reset(uint32_t seed);
+
+        /// Advance the game clock, moving the snake when it is time.
+        void update(int delta_ms);
+
+        /// Turn towards `dir` on the next move. Turning around is ignored, and a second turn before the snake moves
+        /// is queued for the move after.
+        void steer(CellState dir);
+
+        /// Move the snake one cell, eating the fruit or dying on the way.
+        void advance();
+
+        [[nodiscard]] bool is_dead() const { return dead; }
+        [[nodiscard]] int get_score() const { return score; }
+        [[nodiscard]] int get_move_interval() const { return move_interval; }
+        [[nodiscard]] CellState get_direction() const { return direction; }
+
+        /// What is in a cell. Body cells hold the direction to the next cell towards the head.
+        [[nodiscard]] CellState get(int cell) const { return grid[cell]; }
+
+        [[nodiscard]] int get_length() const { return length; }
+
+        /// The `i`th cell of the snake, counting from the tail.
+        [[nodiscard]] cell_t get_body(int i) const { return body[(tail_index + i) % GRID_CELLS]; }
+        [[nodiscard]] cell_t get_head() const { return get_body(length - 1); }
+        [[nodiscard]] cell_t get_tail() const { return get_body(0); }
+
+        /// The fruit's cell, or `NO_FRUIT`.
+        [[nodiscard]] int get_fruit() const { return fruit; }
+
+        /// Number of empty cells, where a fruit can appear.
+        [[nodiscard]] int get_free_count() const { return free_count; }
+
+    private:
+        /// Marks a cell that is not in `free_cells`.
+        static constexpr cell_t NOT_FREE = 0xFF;
+        static_assert(GRID_CELLS <= NOT_FREE);
+
+        std::array<CellState, GRID_CELLS> grid = {};
+
+        /// The snake's cells from tail to head, as a ring buffer starting at `tail_index`.
+        std::array<cell_t, GRID_CELLS> body = {};
+        int tail_index = 0;
+        int length     = 0;
+
+        /// Empty cells in no particular order, and where each cell is in that list or `NOT_FREE`.
+        std::array<cell_t, GRID_CELLS> free_cells = {};
+        std::array<cell_t, GRID_CELLS> free_slots = {};
+        int free_count = 0;
+
+        int fruit = NO_FRUIT;
+        bool dead = false;
+
+        CellState direction = {};
+        bool changed_direction = false;
+        CellState queued_direction = {};
+
+        int move_timer    = 0;
+        int move_interval = 0;
+        int score         = 0;
+
+        utils::Random random;
+
+        void add_free(cell_t cell);
+        void remove_free(cell_t cell);
+
+        /// Put a fruit on a random empty cell, if there is one left.
+        void place_fruit();
+    };
+
+    /// Identifies snek games in input logs.
+    constexpr uint8_t REPLAY_ID = 1;
+
+    /// Play one tick: advance the clock, then steer towards whichever directions are `held` (a mask of
+    /// `1 << BTN_*`). Both the UI and replays play through here, so that a log always plays out the same way.
+    void play_tick(Game &game, uint32_t held, int delta_ms);
+
+    /// Re-simulate a recorded game from its input log, as fast as it goes. Returns the final score, or -1 if the log
+    /// is not a valid snek log.
+    int replay(std::span<const uint8_t> log);
+
+} // namespace snek
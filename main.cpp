@@ -2,31 +2,26 @@
 #include <cmath>
 #include <cstdio>
 
-#include <pico/bootrom.h>
 #include <pico/stdlib.h>
 #include <pico/time.h>
 
 #include <tusb.h>
 
-#include <assets.hpp>
-
 #include <badge/buttons.hpp>
-#include <badge/drawing.hpp>
 #include <badge/factory_test.hpp>
-#include <badge/font.hpp>
+#include <badge/flags.hpp>
+#include <badge/lcd.hpp>
+#include <badge/memory.hpp>
+#include <badge/power.hpp>
+#include <badge/profiler.hpp>
 #include <badge/storage.hpp>
-#include <games/blocks.hpp>
-#include <games/flappy.hpp>
-#include <games/othello.hpp>
-#include <games/snek.hpp>
-#include <ui/animation.hpp>
-#include <ui/code_entry.hpp>
-#include <ui/flag_view.hpp>
-#include <ui/menu.hpp>
-#include <ui/qr_code.hpp>
-#include <ui/readme.hpp>
+#include <bench/bench.hpp>
+#include <fs/volume.hpp>
+#include <ui/main_menu.hpp>
+#include <ui/profiler_overlay.hpp>
 #include <ui/splash.hpp>
 #include <ui/ui.hpp>
+#include <usb/remote.hpp>
 #include <usb/usb.hpp>
 
 
@@ -36,6 +31,14 @@ extern "C" void launch_doom(void);
 void enable_stdio_to_usb();
 
 
+constexpr int FRAME_INTERVAL_MS = 30;
+
+#if BENCHMARKS
+/// How long the benchmark report waits for a terminal, which takes a moment to connect after boot.
+constexpr uint32_t BENCHMARK_FLUSH_TIMEOUT_MS = 5'000;
+#endif
+
+
 void enable_pwr_leds() {
     gpio_set_function(PWR_LED_PIN, GPIO_FUNC_SIO);
     gpio_set_dir(PWR_LED_PIN, true);
@@ -50,110 +53,16 @@ void disable_pwr_leds() {
 }
 
 
-class Website final : public ui::State {
-public:
-    ui::qr::QrCode code;
-
-    Website() {
-        code.version = ui::qr::Version::V2_25x25;
-        code.ec = ui::qr::ErrorCorrection::MEDIUM;
-        code.content = "https://hack.gbgay.com/";
-    }
-
-    void update(int delta_ms) override {
-        State::update(delta_ms);
-        if (buttons::b())
-            ui::pop_state();
-    }
-
-    void draw() override {
-        drawing::clear(COLOR_WHITE);
-
-        code.draw((lcd::WIDTH - code.get_image_size()) / 2, (lcd::HEIGHT - code.get_image_size()) / 2);
-    }
-
-    void pause() override {
-        code.reset();
-    }
-
-    void resume() override {
-        code.generate();
-        code.render(4);
-    }
-};
-
-
-class FontTest final : public ui::State {
-public:
-    void update(int delta_ms) override {
-        State::update(delta_ms);
-        if (buttons::b())
-            ui::pop_state();
-    }
-
-    void draw() override {
-        drawing::clear(COLOR_BLACK);
-
-        auto x = 2;
-        auto y = 2;
-        font::TextDraw render = {};
-
-        auto do_render = [&](auto font, auto text) {
-            render = font.render(text);
-            drawing::draw_text(x - render.dx, y - render.dy, COLOR_BLACK, 150, COLOR_WHITE, render);
-            y += render.height + 2;
-        };
-
-        do_render(font::lucida, "\"lucida\" Hello world!");
-        do_render(font::m5x7, "\"m5x7\" Hello world!");
-        do_render(font::m6x11, "\"m6x11\" Hello world!");
-        do_render(font::noto_sans, "\"Noto Sans\" Hello world!");
-        do_render(font::noto_sans_cm, "\"Noto Sans Condensed Medium\" Hello world!");
-    }
-};
-
-ui::StatePtr create_gallery_menu() {
-    auto menu = ui::make_state<ui::Menu>();
-    menu->add_item("Blahaj", ui::make_state<ui::Animation>(&anim::blahaj_spin));
-    menu->add_item("Dramatic", ui::make_state<ui::Animation>(&anim::dramatic));
-    menu->add_item("Fire", ui::make_state<ui::Animation>(&anim::fire));
-    menu->add_item("Hi There", ui::make_state<ui::Animation>(&anim::hi_there));
-    menu->add_item("Pedro", ui::make_state<ui::Animation>(&anim::pedro));
-    menu->add_item("Rap Win", ui::make_state<ui::Animation>(&anim::rap_win));
-    menu->add_item("gbgay{", ui::make_state<ui::Animation>(&anim::rick));
-    return menu;
-}
-
-ui::StatePtr create_main_menu() {
-
-    auto menu = ui::make_state<ui::Menu>();
-    menu->is_main = true;
-    menu->add_item("README", ui::make_state<ui::Readme>());
-    menu->add_item("Website", ui::make_state<Website>());
-    menu->add_item("Code Entry", ui::make_state<ui::CodeEntry>());
-    menu->add_item("Found Flags", ui::make_state<ui::FlagView>());
-    menu->add_item("Snek", ui::make_state<snek::SnekGame>());
-    menu->add_item("Blocks", ui::make_state<blocks::BlocksGame>());
-    menu->add_item("Othello", ui::make_state<othello::OthelloGame>());
-    // menu->add_item("Flappy", ui::make_state<flappy::FlappyGame>());
-    menu->add_item("Gallery", create_gallery_menu());
-    // menu->add_item("GPIO Control", nullptr);
-    // menu->add_item("SAO Control", nullptr);
-    // menu->add_item("Font Test", ui::make_state<FontTest>());
-    menu->add_item("Bootloader", [] { rom_reset_usb_boot_extra(-1, 0, false); });
-
-    return menu;
-
-}
-
 [[noreturn]] int main() {
 
+    memory::init();
     enable_pwr_leds();
 
     stdio_init_all();
     printf("\n===== HackGBGay 2025 =====\n");
 
     usb::init();
+    enable_stdio_to_usb();
     buttons::init();
     storage::init();
     flags::init();
@@ -161,7 +70,21 @@ ui::StatePtr create_main_menu() {
 
 #if !FACTORY_TEST
 
-    const auto menu = create_main_menu();
+    fs::volume::init();
+
+#if BENCHMARKS
+    // Before any state is pushed, so the benchmarks can borrow all of the UI arena. The report is larger than the
+    // USB log buffer, so each part is sent before the next benchmark runs. Without a terminal, e.g. on battery, the
+    // rest of the report is only buffered after the first wait times out, so the badge still boots.
+    bench::run_kernels([](const char *text) {
+        static bool sending = true;
+        printf("%s", text);
+        if (sending)
+            sending = usb::flush(BENCHMARK_FLUSH_TIMEOUT_MS);
+    });
+#endif
+
+    const auto menu = ui::create_main_menu();
     ui::push_state(menu);
     ui::push_new_state<ui::SplashScreen>();
 
@@ -173,40 +96,82 @@ ui::StatePtr create_main_menu() {
 
 #endif
 
-    /*
-    enable_stdio_to_usb();
-    auto start = get_absolute_time();
-    while (absolute_time_diff_us(start, get_absolute_time()) < 5'000'000) {
-        tud_task();
-    }
-    */
-
     stdio_flush();
 
     // launch_doom();
 
+    power::init(FRAME_INTERVAL_MS);
+
     printf("> Main loop...\n");
     auto last_frame_time = get_absolute_time();
     while (true) {
 
-        while (tud_task_event_ready())
-            tud_task();
+        {
+            profiler::Scope scope(profiler::ZONE_USB);
+            while (tud_task_event_ready())
+                tud_task();
+            usb::task();
+        }
+
+#if !FACTORY_TEST
+        {
+            profiler::Scope scope(profiler::ZONE_FS);
+            fs::volume::task();
+        }
+#endif
 
         const auto now = get_absolute_time();
         const auto delta_time_ms = absolute_time_diff_us(last_frame_time, now) / 1000;
 
-        if (delta_time_ms < 30) {
-            sleep_ms(30 - delta_time_ms);
+        // Frames come less often while idle, and not at all while asleep. Any interrupt ends the wait early, so a
+        // button press or the USB host wakes the badge at once.
+        const bool host_busy = usb::has_host_activity() || usb::remote::is_stepping();
+        if (!power::begin_frame(delta_time_ms, host_busy)) {
+            power::wait(delta_time_ms);
             continue;
         }
 
         last_frame_time = now;
 
-        lcd::swap();
+        // A remote script may hold the main loop until it asks for the next frame.
+        if (!usb::remote::begin_frame())
+            continue;
+        profiler::begin_frame();
+
+        const auto swap_start_us = time_us_32();
+        {
+            profiler::Scope scope(profiler::ZONE_SWAP);
+            lcd::swap();
+        }
 
         buttons::update();
+#if !FACTORY_TEST
+        ui::profiler_overlay::update();
+#endif
+
+        // Stepped frames use a fixed frame time, so scripted runs are reproducible.
+        const auto update_start_us = time_us_32();
+        {
+            profiler::Scope scope(profiler::ZONE_UPDATE);
+            ui::update(usb::remote::is_stepping() ? FRAME_INTERVAL_MS : delta_time_ms);
+        }
+        const auto draw_start_us = time_us_32();
+        {
+            profiler::Scope scope(profiler::ZONE_DRAW);
+            ui::draw();
+        }
+        const auto draw_end_us = time_us_32();
+#if !FACTORY_TEST
+        ui::profiler_overlay::draw();
+#endif
+
+        usb::remote::end_frame(update_start_us - swap_start_us,
+                               draw_start_us - update_start_us,
+                               draw_end_us - draw_start_us);
 
-        ui::update(delta_time_ms);
-        ui::draw();
+        // Scripted and profiled runs keep the badge active, so they measure it the way it is used.
+        const bool busy = !ui::is_static() || usb::take_host_activity() || usb::remote::is_stepping() ||
+                          profiler::is_running();
+        power::end_frame(busy);
     }
 }
@@ -0,0 +1,522 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <games/blocks_ai.hpp>
+#include <games/blocks_field.hpp>
+#include <games/blocks_game.hpp>
+#include <tools/common/tool.hpp>
+
+using namespace blocks;
+
+
+// The playing field as `BlocksGame` kept it before the bitboard, one `EPiece` per tile, with the same loops. This is
+// the baseline that `Field` has to match exactly.
+struct CellField {
+    std::array<std::array<EPiece, FIELD_WIDTH>, FIELD_HEIGHT> field = {};
+
+    CellField() {
+        for (auto &row : field)
+            for (auto &tile : row)
+                tile = EMPTY;
+    }
+
+    [[nodiscard]] bool try_place_piece(int row, int col, EPiece piece, int rotation) const {
+        for (int u = 0; u < 4; u++) {
+            for (int v = 0; v < 4; v++) {
+                if (!BLOCK_DATA[piece][rotation][u][v])
+                    continue;
+                const int r = row - v;
+                const int c = col + u;
+                if (r < 0 || r >= FIELD_HEIGHT || c < 0 || c >= FIELD_WIDTH)
+                    return false;
+                if (field[r][c] != EMPTY)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] int ghost_row(int row, int col, EPiece piece, int rotation) const {
+        while (try_place_piece(row - 1, col, piece, rotation))
+            row--;
+        return row;
+    }
+
+    void place(int row, int col, EPiece piece, int rotation) {
+        for (int u = 0; u < 4; u++)
+            for (int v = 0; v < 4; v++)
+                if (BLOCK_DATA[piece][rotation][u][v])
+                    field[row - v][col + u] = piece;
+    }
+
+    [[nodiscard]] bool is_blocked(int r, int c) const {
+        return r < 0 || r >= FIELD_HEIGHT || c < 0 || c >= FIELD_WIDTH || field[r][c] != EMPTY;
+    }
+
+    int clear_rows() {
+        int n_cleared = 0;
+        for (int r = 0; r < FIELD_HEIGHT; r++) {
+            bool filled = true;
+            for (int c = 0; c < FIELD_WIDTH; c++) {
+                if (field[r][c] == EMPTY) {
+                    filled = false;
+                    break;
+                }
+            }
+            if (!filled)
+                continue;
+            for (int r2 = r; r2 < FIELD_HEIGHT - 1; r2++) {
+                for (int c = 0; c < FIELD_WIDTH; c++)
+                    field[r2][c] = field[r2 + 1][c];
+            }
+            n_cleared++;
+            r--;
+        }
+        return n_cleared;
+    }
+
+    /// The old `rotate_cw()`/`rotate_ccw()`. Returns which test succeeded: 0 in place, 1-4 a kick, 5 none.
+    int rotate(int &row, int &col, int &rotation, EPiece piece, bool clockwise) const {
+        const int new_rotation = (rotation + (clockwise ? 1 : 3)) % 4;
+        if (try_place_piece(row, col, piece, new_rotation)) {
+            rotation = new_rotation;
+            return 0;
+        }
+        const auto &[cw_kicks, ccw_kicks] = (piece == PIECE_I) ? I_KICK_DATA : JLTSZ_KICK_DATA;
+        int test = 1;
+        for (const auto &[dx, dy] : (clockwise ? cw_kicks : ccw_kicks)[rotation]) {
+            if (try_place_piece(row + dy, col + dx, piece, new_rotation)) {
+                rotation = new_rotation;
+                col += dx;
+                row += dy;
+                return test;
+            }
+            test++;
+        }
+        return test;
+    }
+};
+
+
+struct Position {
+    int row;
+    int col;
+    int rotation;
+
+    bool operator==(const Position &) const = default;
+};
+
+enum Move {
+    MOVE_LEFT,
+    MOVE_RIGHT,
+    MOVE_FALL,
+    MOVE_CW,
+    MOVE_CCW,
+    MOVE_COUNT,
+};
+
+
+/// Both representations, always updated together and compared after every step.
+struct Pair {
+    CellField cells;
+    Field bits;
+};
+
+std::array<std::array<uint64_t, 6>, 2> _kick_tests = {}; // [I or JLTSZ][test], how often each rotation test won.
+uint64_t _rows_cleared = 0;
+uint64_t _fits_compared = 0;
+std::vector<Pair> _full_boards; // Boards with full rows, just before they were cleared.
+
+
+void compare_fields(const Pair &pair) {
+    for (int r = 0; r < FIELD_HEIGHT; r++) {
+        for (int c = 0; c < FIELD_WIDTH; c++) {
+            const auto expected = pair.cells.field[r][c];
+            CHECK(pair.bits.get(r, c) == expected, "Tile (%d, %d) is %d, expected %d", r, c, pair.bits.get(r, c),
+                  expected);
+            CHECK(((pair.bits.get_row(r) >> c) & 1) == (expected != EMPTY), "Row bit (%d, %d) is wrong", r, c);
+        }
+    }
+    for (int r = -2; r <= FIELD_HEIGHT + 1; r++)
+        for (int c = -2; c <= FIELD_WIDTH + 1; c++)
+            CHECK(pair.bits.is_blocked(r, c) == pair.cells.is_blocked(r, c), "is_blocked(%d, %d) differs", r, c);
+}
+
+/// Every piece in every rotation at every position near the field, including well outside it.
+void compare_all_fits(const Pair &pair) {
+    for (int piece = 0; piece < PIECE_COUNT; piece++) {
+        for (int rotation = 0; rotation < 4; rotation++) {
+            for (int row = -3; row <= FIELD_HEIGHT + 3; row++) {
+                for (int col = -6; col <= FIELD_WIDTH + 2; col++) {
+                    const auto p = EPiece(piece);
+                    const bool expected = pair.cells.try_place_piece(row, col, p, rotation);
+                    CHECK(pair.bits.fits(row, col, p, rotation) == expected, "fits(%d, %d, %d, %d) differs", row, col,
+                          piece, rotation);
+                    if (expected) {
+                        CHECK(pair.bits.drop_row(row, col, p, rotation) == pair.cells.ghost_row(row, col, p, rotation),
+                              "drop_row(%d, %d, %d, %d) differs", row, col, piece, rotation);
+                    }
+                    _fits_compared++;
+                }
+            }
+        }
+    }
+}
+
+/// Apply a move to both fields, the old way and through `Field`, and check they agree.
+void apply_move(const Pair &pair, EPiece piece, Position &position, Move move) {
+    auto expected = position;
+    auto &[row, col, rotation] = expected;
+    if (move == MOVE_LEFT) {
+        if (pair.cells.try_place_piece(row, col - 1, piece, rotation))
+            col--;
+    }
+    else if (move == MOVE_RIGHT) {
+        if (pair.cells.try_place_piece(row, col + 1, piece, rotation))
+            col++;
+    }
+    else if (move == MOVE_FALL) {
+        if (pair.cells.try_place_piece(row - 1, col, piece, rotation))
+            row--;
+    }
+    else if (piece != PIECE_O) {
+        const int test = pair.cells.rotate(row, col, rotation, piece, move == MOVE_CW);
+        _kick_tests[piece == PIECE_I ? 0 : 1][test]++;
+    }
+
+    auto actual = position;
+    if (move == MOVE_LEFT) {
+        if (pair.bits.fits(actual.row, actual.col - 1, piece, actual.rotation))
+            actual.col--;
+    }
+    else if (move == MOVE_RIGHT) {
+        if (pair.bits.fits(actual.row, actual.col + 1, piece, actual.rotation))
+            actual.col++;
+    }
+    else if (move == MOVE_FALL) {
+        if (pair.bits.fits(actual.row - 1, actual.col, piece, actual.rotation))
+            actual.row--;
+    }
+    else if (piece != PIECE_O) {
+        const bool clockwise = move == MOVE_CW;
+        if (const auto kick = pair.bits.try_rotate(actual.row, actual.col, piece, actual.rotation, clockwise)) {
+            actual.rotation = (actual.rotation + (clockwise ? 1 : 3)) % 4;
+            actual.col += kick->first;
+            actual.row += kick->second;
+        }
+    }
+
+    CHECK(actual == expected, "Move %d of piece %d from (%d, %d, %d) went to (%d, %d, %d), expected (%d, %d, %d)",
+          move, piece, position.row, position.col, position.rotation, actual.row, actual.col, actual.rotation,
+          expected.row, expected.col, expected.rotation);
+    position = expected;
+}
+
+/// Drop a piece on both fields and clear rows. Returns the number of rows cleared.
+int drop(Pair &pair, EPiece piece, Position position) {
+    const int ghost_row = pair.cells.ghost_row(position.row, position.col, piece, position.rotation);
+    CHECK(pair.bits.drop_row(position.row, position.col, piece, position.rotation) == ghost_row, "Ghost row differs");
+    pair.cells.place(ghost_row, position.col, piece, position.rotation);
+    pair.bits.place(ghost_row, position.col, piece, position.rotation);
+    for (int r = std::max(ghost_row - 3, 0); r <= ghost_row && _full_boards.size() < 1000; r++) {
+        if (pair.bits.get_row(r) == (1 << FIELD_WIDTH) - 1) {
+            _full_boards.push_back(pair);
+            break;
+        }
+    }
+    const int n_cleared = pair.cells.clear_rows();
+    CHECK(pair.bits.clear_full_rows() == n_cleared, "Number of cleared rows differs");
+    _rows_cleared += n_cleared;
+    compare_fields(pair);
+    return n_cleared;
+}
+
+/// Pick the placement that clears the most rows while leaving few holes and landing low, so games last and clear
+/// plenty of rows.
+Position pick_greedy(const CellField &cells, EPiece piece, std::mt19937 &rng) {
+    Position best = {};
+    int best_score = -1000;
+    for (int rotation = 0; rotation < 4; rotation++) {
+        for (int col = -3; col < FIELD_WIDTH; col++) {
+            if (!cells.try_place_piece(20, col, piece, rotation))
+                continue;
+            auto copy = cells;
+            const int row = copy.ghost_row(20, col, piece, rotation);
+            copy.place(row, col, piece, rotation);
+            int holes = 0;
+            for (int c = 0; c < FIELD_WIDTH; c++) {
+                bool covered = false;
+                for (int r = FIELD_HEIGHT - 1; r >= 0; r--) {
+                    covered = covered || copy.field[r][c] != EMPTY;
+                    holes += covered && copy.field[r][c] == EMPTY;
+                }
+            }
+            const int score = copy.clear_rows() * 100 - holes * 30 - row * 4 + int(rng() % 4);
+            if (score > best_score) {
+                best_score = score;
+                best = {row, col, rotation};
+            }
+        }
+    }
+    return best;
+}
+
+/// Play random games on both fields in lockstep, with a mix of sensible and random moves.
+void play(int games, std::mt19937 &rng, std::vector<Pair> &snapshots) {
+    for (int game = 0; game < games; game++) {
+        Pair pair;
+        for (int n = 0; n < 1000; n++) {
+            const auto piece = EPiece(rng() % PIECE_COUNT);
+            Position position = {21, FIELD_WIDTH / 2 - 2, 0};
+            const bool spawned = pair.cells.try_place_piece(position.row, position.col, piece, 0);
+            CHECK(pair.bits.fits(position.row, position.col, piece, 0) == spawned, "Spawn check differs");
+            if (!spawned)
+                break;
+
+            // Steer towards the greedy target most of the time, and wander around at random otherwise.
+            const auto target = pick_greedy(pair.cells, piece, rng);
+            const bool wander = rng() % 16 == 0;
+            for (int step = 0; step < 40; step++) {
+                Move move;
+                if (wander)
+                    move = Move(rng() % MOVE_COUNT);
+                else if (position.rotation != target.rotation)
+                    move = MOVE_CW;
+                else if (position.col != target.col)
+                    move = position.col < target.col ? MOVE_RIGHT : MOVE_LEFT;
+                else
+                    break;
+                apply_move(pair, piece, position, move);
+            }
+
+            // Sometimes settle on the stack and twist around there, where the wall kicks do the most.
+            if (rng() % 2 == 0) {
+                while (pair.cells.try_place_piece(position.row - 1, position.col, piece, position.rotation))
+                    apply_move(pair, piece, position, MOVE_FALL);
+                for (int i = rng() % 6; i > 0; i--) {
+                    constexpr Move TWISTS[] = {MOVE_CW, MOVE_CCW, MOVE_CW, MOVE_CCW, MOVE_LEFT, MOVE_RIGHT, MOVE_FALL};
+                    apply_move(pair, piece, position, TWISTS[rng() % std::size(TWISTS)]);
+                }
+            }
+
+            drop(pair, piece, position);
+            if (n % 25 == 0)
+                snapshots.push_back(pair);
+        }
+    }
+}
+
+
+/// The piece bits and colors of a field must always agree.
+void check_colors(const Field &field) {
+    for (int r = 0; r < FIELD_HEIGHT; r++)
+        for (int c = 0; c < FIELD_WIDTH; c++)
+            CHECK(((field.get_row(r) >> c) & 1) == (field.get(r, c) != EMPTY), "Color of (%d, %d) is wrong", r, c);
+}
+
+/// Mash buttons at random until the game is over. Returns the number of pieces placed.
+int play_random(Game &game, std::mt19937 &rng) {
+    while (!game.is_game_over()) {
+        switch (rng() % 8) {
+            case 0: game.shift_left(); break;
+            case 1: game.shift_right(); break;
+            case 2: game.rotate_cw(); break;
+            case 3: game.rotate_ccw(); break;
+            case 4: game.hold(); break;
+            case 5: game.hard_drop(); break;
+            default: game.update(100); break;
+        }
+    }
+    return game.get_pieces_placed();
+}
+
+/// Let the AI play a game, searching each piece completely and moving without delay, for up to `max_pieces`.
+void play_ai(Game &game, Ai &ai, int max_pieces) {
+    ai.reset();
+    while (!game.is_game_over() && game.get_pieces_placed() < max_pieces)
+        ai.update(game, 0, 0, std::numeric_limits<int>::max());
+}
+
+int main() {
+    std::mt19937 rng(0x5EED);
+
+    std::vector<Pair> snapshots;
+    play(300, rng, snapshots);
+    for (const auto &pair : snapshots)
+        compare_all_fits(pair);
+
+    printf("Compared %zu boards and %llu placements, %llu rows cleared\n", snapshots.size(),
+           (unsigned long long) _fits_compared, (unsigned long long) _rows_cleared);
+    printf("%8s %10s %10s %10s %10s %10s %10s\n", "kicks", "in place", "test 1", "test 2", "test 3", "test 4", "none");
+    for (int i = 0; i < 2; i++) {
+        printf("%8s", i == 0 ? "I" : "JLTSZ");
+        for (const auto count : _kick_tests[i])
+            printf(" %10llu", (unsigned long long) count);
+        printf("\n");
+    }
+    if (tool::get_failures() > 0) {
+        printf("! %d differences\n", tool::get_failures());
+        return 1;
+    }
+    printf("\n");
+
+    // Time the operations over all the boards seen above, for every piece and rotation.
+    size_t next = 0;
+    auto next_board = [&]() -> const Pair & { return snapshots[next++ % snapshots.size()]; };
+
+    const auto fits_cells = tool::measure_us([&] {
+        const auto &cells = next_board().cells;
+        int count = 0;
+        for (int piece = 0; piece < PIECE_COUNT; piece++)
+            for (int rotation = 0; rotation < 4; rotation++)
+                for (int col = -3; col < FIELD_WIDTH; col++)
+                    for (int row = 0; row < 24; row++)
+                        count += cells.try_place_piece(row, col, EPiece(piece), rotation);
+        return count;
+    }, 16);
+    const auto fits_bits = tool::measure_us([&] {
+        const auto &bits = next_board().bits;
+        int count = 0;
+        for (int piece = 0; piece < PIECE_COUNT; piece++)
+            for (int rotation = 0; rotation < 4; rotation++)
+                for (int col = -3; col < FIELD_WIDTH; col++)
+                    for (int row = 0; row < 24; row++)
+                        count += bits.fits(row, col, EPiece(piece), rotation);
+        return count;
+    }, 16);
+
+    const auto drop_cells = tool::measure_us([&] {
+        const auto &cells = next_board().cells;
+        int sum = 0;
+        for (int piece = 0; piece < PIECE_COUNT; piece++)
+            for (int rotation = 0; rotation < 4; rotation++)
+                for (int col = -3; col < FIELD_WIDTH; col++)
+                    if (cells.try_place_piece(21, col, EPiece(piece), rotation))
+                        sum += cells.ghost_row(21, col, EPiece(piece), rotation);
+        return sum;
+    }, 16);
+    const auto drop_bits = tool::measure_us([&] {
+        const auto &bits = next_board().bits;
+        int sum = 0;
+        for (int piece = 0; piece < PIECE_COUNT; piece++)
+            for (int rotation = 0; rotation < 4; rotation++)
+                for (int col = -3; col < FIELD_WIDTH; col++)
+                    if (bits.fits(21, col, EPiece(piece), rotation))
+                        sum += bits.drop_row(21, col, EPiece(piece), rotation);
+        return sum;
+    }, 16);
+
+    // Line clears on a copy of a board that has just had rows filled, copy included.
+    next = 0;
+    const auto clear_cells = tool::measure_us([&] {
+        auto cells = _full_boards[next++ % _full_boards.size()].cells;
+        return cells.clear_rows();
+    }, 16);
+    const auto clear_bits = tool::measure_us([&] {
+        auto bits = _full_boards[next++ % _full_boards.size()].bits;
+        return bits.clear_full_rows();
+    }, 16);
+
+    printf("%-38s %10s %10s %8s\n", "operation", "cells", "bitboard", "speedup");
+    printf("%-38s %7.2f us %7.2f us %7.1fx\n", "fits, 8736 positions", fits_cells, fits_bits, fits_cells / fits_bits);
+    printf("%-38s %7.2f us %7.2f us %7.1fx\n", "ghost row, every piece/rotation/column", drop_cells, drop_bits,
+           drop_cells / drop_bits);
+    printf("%-38s %7.2f us %7.2f us %7.1fx\n", "copy and clear full rows", clear_cells, clear_bits,
+           clear_cells / clear_bits);
+    printf("\n");
+
+    using clock = std::chrono::steady_clock;
+    const auto allocations = tool::get_allocations();
+
+    // Whole headless games with random input, to exercise the game rules and measure their speed.
+    {
+        Game game;
+        int games = 0;
+        uint64_t pieces = 0;
+        const auto start = clock::now();
+        while (clock::now() - start < std::chrono::seconds(1)) {
+            game.reset(rng());
+            pieces += play_random(game, rng);
+            check_colors(game.get_field());
+            games++;
+        }
+        const std::chrono::duration<double> elapsed = clock::now() - start;
+        printf("Random input: %.0f games/s, %.0f pieces/s\n", games / elapsed.count(), pieces / elapsed.count());
+    }
+
+    // Versus games between two AIs, passing garbage both ways, as a check that garbage keeps the fields consistent.
+    {
+        Game games[2];
+        Ai ais[2];
+        int garbage = 0;
+        for (int round = 0; round < 20; round++) {
+            const auto seed = rng();
+            for (int i = 0; i < 2; i++) {
+                games[i].reset(seed);
+                ais[i].reset();
+            }
+            while (!games[0].is_game_over() && !games[1].is_game_over() && games[0].get_pieces_placed() < 300) {
+                for (int i = 0; i < 2; i++) {
+                    ais[i].update(games[i], 0, 0, std::numeric_limits<int>::max());
+                    const int sent = games[i].take_garbage_sent();
+                    games[1 - i].receive_garbage(sent);
+                    garbage += sent;
+                }
+            }
+            check_colors(games[0].get_field());
+            check_colors(games[1].get_field());
+        }
+        printf("AI versus AI: %d garbage rows sent in 20 games\n", garbage);
+    }
+
+    // The AI playing complete games, searching every piece to the end in one go.
+    {
+        Game game;
+        Ai ai;
+        constexpr int GAMES = 20;
+        constexpr int MAX_PIECES = 1000;
+        uint64_t pieces = 0;
+        uint64_t rows = 0;
+        int survived = 0;
+        const auto start = clock::now();
+        for (int i = 0; i < GAMES; i++) {
+            game.reset(rng());
+            play_ai(game, ai, MAX_PIECES);
+            check_colors(game.get_field());
+            pieces += game.get_pieces_placed();
+            rows += game.get_rows_cleared();
+            survived += !game.is_game_over();
+        }
+        const std::chrono::duration<double> elapsed = clock::now() - start;
+        printf("AI: %d/%d games survived %d pieces, %.1f rows cleared per 100 pieces\n", survived, GAMES, MAX_PIECES,
+               100.0 * rows / pieces);
+        printf("AI: %.0f placements evaluated/s, %.0f per piece, %.0f pieces/s\n",
+               ai.get_evaluations() / elapsed.count(), double(ai.get_evaluations()) / pieces,
+               pieces / elapsed.count());
+
+        // The longest single update with the on-device budget, i.e. the most the AI adds to a frame.
+        game.reset(rng());
+        ai.reset();
+        double longest_us = 0;
+        while (!game.is_game_over() && game.get_pieces_placed() < 200) {
+            const auto update_start = clock::now();
+            ai.update(game, 30, 0);
+            const std::chrono::duration<double, std::micro> update_time = clock::now() - update_start;
+            longest_us = std::max(longest_us, update_time.count());
+        }
+        printf("AI: longest update with a budget of %d placements: %.1f us\n", AI_EVALUATIONS_PER_UPDATE, longest_us);
+    }
+
+    printf("Allocations: %zu\n", tool::get_allocations() - allocations);
+    if (tool::get_failures() > 0 || tool::get_allocations() != allocations) {
+        printf("! %d differences\n", tool::get_failures());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include "tool.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace tool
+{
+
+    namespace
+    {
+        constexpr int MAX_FAILURES = 20;
+
+        size_t _allocations = 0;
+        int _failures = 0;
+    } // namespace
+
+    volatile uint64_t sink = 0;
+
+    size_t get_allocations() {
+        return _allocations;
+    }
+
+    int get_failures() {
+        return _failures;
+    }
+
+    void fail() {
+        if (++_failures > MAX_FAILURES)
+            exit(1);
+    }
+
+} // namespace tool
+
+void *operator new(size_t size) {
+    tool::_allocations++;
+    if (void *ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
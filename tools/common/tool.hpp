@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * What the host-side checks and benchmarks in `tools/` have in common: counting heap allocations, to check that code
+ * meant for the badge does not allocate, failing checks, and timing calls.
+ */
+namespace tool
+{
+
+    /// Heap allocations so far, counted by the `operator new` in `tool.cpp`.
+    size_t get_allocations();
+
+    /// Checks failed so far, see `CHECK()`.
+    int get_failures();
+
+    /// Count a failed check. Exits after too many, so a broken build does not print forever.
+    void fail();
+
+    /// Keeps the compiler from optimizing the benchmarked calls away.
+    extern volatile uint64_t sink;
+
+    /// Microseconds per call of `f`, which returns something to keep. Calls run in batches of `batch`, so that fast
+    /// calls are not measured as mostly the clock.
+    template<typename F>
+    double measure_us(F &&f, int batch = 1) {
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        uint64_t calls = 0;
+        while (clock::now() - start < std::chrono::milliseconds(200)) {
+            for (int i = 0; i < batch; i++)
+                sink = f();
+            calls += batch;
+        }
+        const std::chrono::duration<double, std::micro> elapsed = clock::now() - start;
+        return elapsed.count() / calls;
+    }
+
+} // namespace tool
+
+/// Print the message and count a failure if the condition does not hold.
+#define CHECK(condition, ...)                                                                                          \
+    do {                                                                                                               \
+        if (!(condition)) {                                                                                            \
+            printf("! " __VA_ARGS__);                                                                                  \
+            printf("\n");                                                                                              \
+            tool::fail();                                                                                              \
+        }                                                                                                              \
+    } while (0)
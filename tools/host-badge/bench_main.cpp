@@ -0,0 +1,35 @@
+/**
+ * The kernel benchmarks of `bench/` on the host, reported as Google Benchmark JSON, to stdout or to a file. Results
+ * of two runs can be compared with Google Benchmark's `tools/compare.py`. Example:
+ *
+ *     host_bench results.json
+ *
+ * The same benchmarks run on a badge with the firmware built with `-DBENCHMARKS=ON`, which also reports the cycles
+ * per iteration.
+ */
+#include <cstdio>
+
+#include <badge/lcd.hpp>
+#include <badge/memory.hpp>
+#include <bench/bench.hpp>
+
+
+FILE *_output = stdout;
+
+
+int main(int argc, char **argv) {
+    if (argc > 2) {
+        printf("Usage: %s [FILE]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && (_output = fopen(argv[1], "w")) == nullptr) {
+        printf("! Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    memory::init();
+    lcd::init();
+
+    bench::run_kernels([](const char *text) { fputs(text, _output); });
+    return fclose(_output) == 0 ? 0 : 1;
+}
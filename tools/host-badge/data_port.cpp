@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <usb/data_port.hpp>
+
+#include "host.hpp"
+
+// The data port with the runner on the other end: it reads what the runner feeds it, and hands sent packets to it.
+namespace usb::data_port
+{
+
+    namespace
+    {
+        std::string _input;
+        size_t _inputRead = 0;
+        host::PacketHandler _packetHandler = nullptr;
+    } // namespace
+
+    bool is_connected() {
+        return true;
+    }
+
+    bool send(PacketType type, uint8_t flags, uint32_t number, std::span<const uint8_t> payload) {
+        if (_packetHandler != nullptr)
+            _packetHandler(type, flags, number, payload);
+        return true;
+    }
+
+    bool send_buffer(std::span<const uint8_t> packet) {
+        if (packet.size() < sizeof(PacketHeader))
+            return false;
+        PacketHeader header;
+        memcpy(&header, packet.data(), sizeof(header));
+        return send(static_cast<PacketType>(header.type), header.flags, header.number,
+                    packet.subspan(sizeof(header)));
+    }
+
+    bool is_sending_buffer() {
+        return false;
+    }
+
+    uint32_t read(void *buffer, uint32_t size) {
+        const auto n = std::min<size_t>(size, _input.size() - _inputRead);
+        memcpy(buffer, _input.data() + _inputRead, n);
+        _inputRead += n;
+        return n;
+    }
+
+    void task() {}
+
+} // namespace usb::data_port
+
+namespace host
+{
+
+    void feed(std::string_view input) {
+        usb::data_port::_input.erase(0, usb::data_port::_inputRead);
+        usb::data_port::_inputRead = 0;
+        usb::data_port::_input += input;
+    }
+
+    bool is_input_drained() {
+        return usb::data_port::_inputRead == usb::data_port::_input.size();
+    }
+
+    void set_packet_handler(PacketHandler handler) {
+        usb::data_port::_packetHandler = handler;
+    }
+
+} // namespace host
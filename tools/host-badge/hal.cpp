@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+
+#include <badge/badge-2025.h>
+#include <hardware/dma.h>
+#include <hardware/flash.h>
+#include <hardware/structs/xip_ctrl.h>
+#include <pico.h>
+
+
+void panic(const char *fmt, ...) {
+    fprintf(stderr, "\n*** PANIC ***\n");
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    abort();
+}
+
+
+namespace hal
+{
+
+    uint8_t *get_flash() {
+        // Allocated with malloc, so it does not count as heap use of the badge.
+        static auto *flash = static_cast<uint8_t *>(memset(malloc(BADGE_FLASH_SIZE), 0xFF, BADGE_FLASH_SIZE));
+        return flash;
+    }
+
+} // namespace hal
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE != 0 || count % FLASH_SECTOR_SIZE != 0 || flash_offs + count > BADGE_FLASH_SIZE)
+        panic("FLASH erase of %zu bytes @ 0x%08x is not whole sectors", count, flash_offs);
+    memset(hal::get_flash() + flash_offs, 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE != 0 || count % FLASH_PAGE_SIZE != 0 || flash_offs + count > BADGE_FLASH_SIZE)
+        panic("FLASH program of %zu bytes @ 0x%08x is not whole pages", count, flash_offs);
+    auto *flash = hal::get_flash() + flash_offs;
+    for (size_t i = 0; i < count; i++)
+        flash[i] &= data[i];
+}
+
+
+namespace
+{
+    uint32_t _claimed = 0;
+
+    struct Sniffer {
+        int channel = -1;
+        unsigned mode = 0;
+        bool reverse = false;
+        bool invert = false;
+        uint32_t accumulator = 0;
+    } _sniffer;
+
+    uint32_t reverse_bits(uint32_t value, int bits) {
+        uint32_t result = 0;
+        for (int i = 0; i < bits; i++)
+            result |= (value >> i & 1) << (bits - 1 - i);
+        return result;
+    }
+
+    void sniff(uint32_t value, int size) {
+        // Only mode 1 is used: CRC-32 (polynomial 0x04C11DB7, MSB first) of the bit reversed data, a byte at a time.
+        if (_sniffer.mode != 0x1)
+            panic("DMA sniffer mode %u is not supported on the host", _sniffer.mode);
+        for (int byte = 0; byte < size; byte++) {
+            _sniffer.accumulator ^= reverse_bits(value >> (8 * byte) & 0xFF, 8) << 24;
+            for (int bit = 0; bit < 8; bit++)
+                _sniffer.accumulator = _sniffer.accumulator << 1 ^ (_sniffer.accumulator & 0x80000000 ? 0x04C11DB7 : 0);
+        }
+    }
+} // namespace
+
+int dma_claim_unused_channel(bool required) {
+    for (unsigned channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (!(_claimed & 1u << channel)) {
+            _claimed |= 1u << channel;
+            return static_cast<int>(channel);
+        }
+    }
+    if (required)
+        panic("No DMA channels are available");
+    return -1;
+}
+
+void dma_channel_unclaim(unsigned channel) {
+    _claimed &= ~(1u << channel);
+}
+
+void dma_channel_configure(unsigned channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint32_t transfer_count, bool trigger) {
+    if (!trigger)
+        return;
+
+    const auto size = 1 << config->size;
+    auto *write = static_cast<uint8_t *>(const_cast<void *>(write_addr));
+    const auto *read = static_cast<const uint8_t *>(const_cast<const void *>(read_addr));
+
+    // The XIP stream interface hands out words read from FLASH, for as many as its counter says.
+    const bool from_stream = reinterpret_cast<uintptr_t>(read_addr) == XIP_AUX_BASE;
+    if (from_stream) {
+        transfer_count = std::min(transfer_count, xip_ctrl_hw->stream_ctr);
+        read = reinterpret_cast<const uint8_t *>(xip_ctrl_hw->stream_addr);
+    }
+
+    for (uint32_t i = 0; i < transfer_count; i++) {
+        uint32_t value = 0;
+        memcpy(&value, read, size);
+        memcpy(write, &value, size);
+        if (config->sniff && _sniffer.channel == static_cast<int>(channel))
+            sniff(value, size);
+        if (config->read_increment || from_stream)
+            read += size;
+        if (config->write_increment)
+            write += size;
+    }
+
+    if (from_stream) {
+        xip_ctrl_hw->stream_addr += transfer_count * 4;
+        xip_ctrl_hw->stream_ctr -= transfer_count;
+    }
+}
+
+void dma_sniffer_enable(unsigned channel, unsigned mode, bool /*force_channel_enable*/) {
+    _sniffer.channel = static_cast<int>(channel);
+    _sniffer.mode = mode;
+}
+
+void dma_sniffer_set_output_reverse_enabled(bool enable) {
+    _sniffer.reverse = enable;
+}
+
+void dma_sniffer_set_output_invert_enabled(bool enable) {
+    _sniffer.invert = enable;
+}
+
+void dma_sniffer_set_data_accumulator(uint32_t seed_value) {
+    _sniffer.accumulator = seed_value;
+}
+
+uint32_t dma_sniffer_get_data_accumulator() {
+    auto result = _sniffer.reverse ? reverse_bits(_sniffer.accumulator, 32) : _sniffer.accumulator;
+    return _sniffer.invert ? ~result : result;
+}
+
+void dma_sniffer_disable() {
+    _sniffer = {};
+}
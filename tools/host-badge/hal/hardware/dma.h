@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#include <pico.h>
+
+/**
+ * DMA channels that do the whole transfer when triggered, so they are never busy afterwards. Reads from
+ * `XIP_AUX_BASE` come from the XIP stream interface, and the sniffer computes the CRC-32 of mode 1 bit for bit like
+ * the hardware, so `utils::crc32_dma()` passes its self test and runs the same code as on the badge.
+ */
+
+#define NUM_DMA_CHANNELS 12u
+#define DREQ_XIP_STREAM 37u
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+struct dma_channel_config {
+    dma_channel_transfer_size size = DMA_SIZE_32;
+    bool read_increment = true;
+    bool write_increment = false;
+    bool sniff = false;
+    unsigned dreq = 0x3F;
+};
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(unsigned channel);
+
+inline dma_channel_config dma_channel_get_default_config(unsigned /*channel*/) { return {}; }
+
+inline void channel_config_set_transfer_data_size(dma_channel_config *c, dma_channel_transfer_size size) {
+    c->size = size;
+}
+inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { c->read_increment = incr; }
+inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { c->write_increment = incr; }
+inline void channel_config_set_dreq(dma_channel_config *c, unsigned dreq) { c->dreq = dreq; }
+inline void channel_config_set_sniff_enable(dma_channel_config *c, bool sniff) { c->sniff = sniff; }
+
+void dma_channel_configure(unsigned channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint32_t transfer_count, bool trigger);
+
+inline bool dma_channel_is_busy(unsigned /*channel*/) { return false; }
+inline void dma_channel_wait_for_finish_blocking(unsigned /*channel*/) {}
+
+void dma_sniffer_enable(unsigned channel, unsigned mode, bool force_channel_enable);
+void dma_sniffer_set_output_reverse_enabled(bool enable);
+void dma_sniffer_set_output_invert_enabled(bool enable);
+void dma_sniffer_set_data_accumulator(uint32_t seed_value);
+uint32_t dma_sniffer_get_data_accumulator();
+void dma_sniffer_disable();
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <pico.h>
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define FLASH_BLOCK_SIZE (1u << 16)
+
+/// The FLASH is an array in RAM, erased when the runner starts. `XIP_BASE` is its address, so code reading FLASH
+/// through the XIP window reads the array.
+namespace hal
+{
+    uint8_t *get_flash();
+} // namespace hal
+
+#define XIP_BASE (reinterpret_cast<uintptr_t>(hal::get_flash()))
+
+/// Like the real thing, erase sets whole sectors to 0xFF, and programming can only clear bits.
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
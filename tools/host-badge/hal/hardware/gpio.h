@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+#include <pico.h>
+
+/// Level of every GPIO pin. Buttons pull their pin low while pressed, so all high means nothing is pressed. The
+/// runner presses buttons through `buttons::set_override()` instead, the same way remote scripts do on the badge.
+namespace hal
+{
+    inline uint32_t gpio_levels = ~0u;
+} // namespace hal
+
+enum gpio_function { GPIO_FUNC_SIO = 5, GPIO_FUNC_PWM = 4 };
+enum gpio_irq_level { GPIO_IRQ_EDGE_FALL = 0x4, GPIO_IRQ_EDGE_RISE = 0x8 };
+
+inline void gpio_set_function(unsigned /*gpio*/, gpio_function /*fn*/) {}
+inline void gpio_set_dir(unsigned /*gpio*/, bool /*out*/) {}
+inline void gpio_set_input_enabled(unsigned /*gpio*/, bool /*enabled*/) {}
+inline void gpio_pull_up(unsigned /*gpio*/) {}
+inline void gpio_put(unsigned gpio, bool value) {
+    hal::gpio_levels = value ? hal::gpio_levels | 1u << gpio : hal::gpio_levels & ~(1u << gpio);
+}
+inline bool gpio_get(unsigned gpio) { return hal::gpio_levels >> gpio & 1; }
+inline uint32_t gpio_get_all() { return hal::gpio_levels; }
+
+// The levels only change through `gpio_put()`, so no edge interrupt ever comes.
+inline void gpio_add_raw_irq_handler_masked(uint32_t /*gpio_mask*/, void (* /*handler*/)()) {}
+inline void gpio_set_irq_enabled(unsigned /*gpio*/, uint32_t /*events*/, bool /*enabled*/) {}
+inline uint32_t gpio_get_irq_event_mask(unsigned /*gpio*/) { return 0; }
+inline void gpio_acknowledge_irq(unsigned /*gpio*/, uint32_t /*events*/) {}
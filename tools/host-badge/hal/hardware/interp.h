@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+#include <pico.h>
+
+/**
+ * Interpolator 0, computing its results when they are read like the hardware does when they are needed. Only what
+ * the badge uses is there: lane results with shift, mask and sign extension, and blend mode, where lane 1 gives
+ * `base0 + ((base1 - base0) * alpha) >> 8` with alpha the low byte of the lane 1 value, bit for bit like the RP2040.
+ */
+
+struct interp_config {
+    uint32_t ctrl = 0;
+};
+
+constexpr uint32_t INTERP_CTRL_SHIFT_LSB = 0;
+constexpr uint32_t INTERP_CTRL_MASK_LSB_LSB = 5;
+constexpr uint32_t INTERP_CTRL_MASK_MSB_LSB = 10;
+constexpr uint32_t INTERP_CTRL_SIGNED_BIT = 1u << 15;
+constexpr uint32_t INTERP_CTRL_BLEND_BIT = 1u << 21;
+
+inline interp_config interp_default_config() {
+    return {31u << INTERP_CTRL_MASK_MSB_LSB};
+}
+
+inline void interp_config_set_shift(interp_config *c, unsigned shift) {
+    c->ctrl = (c->ctrl & ~(0x1Fu << INTERP_CTRL_SHIFT_LSB)) | shift << INTERP_CTRL_SHIFT_LSB;
+}
+
+inline void interp_config_set_mask(interp_config *c, unsigned mask_lsb, unsigned mask_msb) {
+    c->ctrl = (c->ctrl & ~(0x3FFu << INTERP_CTRL_MASK_LSB_LSB)) | mask_lsb << INTERP_CTRL_MASK_LSB_LSB |
+              mask_msb << INTERP_CTRL_MASK_MSB_LSB;
+}
+
+inline void interp_config_set_signed(interp_config *c, bool is_signed) {
+    c->ctrl = is_signed ? c->ctrl | INTERP_CTRL_SIGNED_BIT : c->ctrl & ~INTERP_CTRL_SIGNED_BIT;
+}
+
+inline void interp_config_set_blend(interp_config *c, bool blend) {
+    c->ctrl = blend ? c->ctrl | INTERP_CTRL_BLEND_BIT : c->ctrl & ~INTERP_CTRL_BLEND_BIT;
+}
+
+struct interp_hw_t {
+    uint32_t accum[2] = {};
+    uint32_t base[3] = {};
+    uint32_t ctrl[2] = {interp_default_config().ctrl, interp_default_config().ctrl};
+
+    struct Peek {
+        const interp_hw_t *hw;
+        uint32_t operator[](int lane) const { return hw->result(lane); }
+    } peek{this};
+
+    interp_hw_t() = default;
+    interp_hw_t(const interp_hw_t &) = delete;
+    interp_hw_t &operator=(const interp_hw_t &) = delete;
+
+    [[nodiscard]] uint32_t lane_value(int lane) const {
+        const auto shift = ctrl[lane] >> INTERP_CTRL_SHIFT_LSB & 0x1F;
+        const auto mask_lsb = ctrl[lane] >> INTERP_CTRL_MASK_LSB_LSB & 0x1F;
+        const auto mask_msb = ctrl[lane] >> INTERP_CTRL_MASK_MSB_LSB & 0x1F;
+        const auto mask = static_cast<uint32_t>((2ull << mask_msb) - (1ull << mask_lsb));
+        auto value = (accum[lane] >> shift) & mask;
+        // Sign extend from the top bit of the mask.
+        if (ctrl[lane] & INTERP_CTRL_SIGNED_BIT && value >> mask_msb & 1)
+            value |= ~static_cast<uint32_t>((2ull << mask_msb) - 1);
+        return value;
+    }
+
+    [[nodiscard]] uint32_t result(int lane) const {
+        const bool blend = ctrl[0] & INTERP_CTRL_BLEND_BIT;
+        if (blend && lane == 0)
+            return base[0] + lane_value(0);
+        if (blend && lane == 1) {
+            // Blend interpolates between the bases, as signed or unsigned values depending on lane 1.
+            const auto alpha = static_cast<int64_t>(lane_value(1) & 0xFF);
+            const bool is_signed = ctrl[1] & INTERP_CTRL_SIGNED_BIT;
+            const int64_t base0 = is_signed ? static_cast<int32_t>(base[0]) : static_cast<int64_t>(base[0]);
+            const int64_t base1 = is_signed ? static_cast<int32_t>(base[1]) : static_cast<int64_t>(base[1]);
+            return static_cast<uint32_t>(base0 + ((base1 - base0) * alpha >> 8));
+        }
+        return base[lane] + lane_value(lane);
+    }
+};
+
+namespace hal
+{
+    inline interp_hw_t interp0;
+} // namespace hal
+
+#define interp0 (&hal::interp0)
+
+inline void interp_set_config(interp_hw_t *interp, unsigned lane, const interp_config *config) {
+    interp->ctrl[lane] = config->ctrl;
+}
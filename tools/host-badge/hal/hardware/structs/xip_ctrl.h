@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+#include <pico.h>
+
+/// The XIP stream interface, which the fake DMA reads FLASH through when its source is `XIP_AUX_BASE`. Transfers
+/// finish as soon as they start, so the FIFO is always empty.
+struct xip_ctrl_hw_t {
+    uint32_t ctrl = 0;
+    uint32_t flush = 0;
+    uint32_t stat = 0;
+    uint32_t ctr_hit = 0;
+    uint32_t ctr_acc = 0;
+    uintptr_t stream_addr = 0;
+    uint32_t stream_ctr = 0;
+    uint32_t stream_fifo = 0;
+};
+
+#define XIP_STAT_FIFO_EMPTY 0x2u
+
+namespace hal
+{
+    inline xip_ctrl_hw_t xip_ctrl = {.stat = XIP_STAT_FIFO_EMPTY};
+    inline uint32_t xip_aux_fifo = 0;
+} // namespace hal
+
+#define xip_ctrl_hw (&hal::xip_ctrl)
+#define XIP_AUX_BASE (reinterpret_cast<uintptr_t>(&hal::xip_aux_fifo))
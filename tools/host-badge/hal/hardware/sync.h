@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+#include <pico.h>
+
+inline uint32_t save_and_disable_interrupts() { return 0; }
+inline void restore_interrupts(uint32_t /*status*/) {}
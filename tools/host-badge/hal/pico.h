@@ -0,0 +1,17 @@
+#pragma once
+
+/**
+ * Stand-ins for the parts of the Pico SDK that the badge code uses, so it builds and runs on the host. Only what the
+ * compiled sources need is here, and each part behaves the way the code relies on, not like the whole SDK would.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+#define PICO_OK 0
+#define PICO_ERROR_TIMEOUT (-1)
+
+[[noreturn]] void panic(const char *fmt, ...);
+
+inline void tight_loop_contents() {}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+#include <pico.h>
+
+inline void rom_reset_usb_boot_extra(int /*usb_activity_gpio_pin*/, uint32_t /*disable_interface_mask*/,
+                                     bool /*usb_activity_gpio_pin_active_low*/) {
+    printf("> Reset to BOOTSEL ignored on the host\n");
+}
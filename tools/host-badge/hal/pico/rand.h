@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+#include <pico.h>
+
+/// Random numbers from a fixed seed, so games start out the same on every run.
+namespace hal
+{
+    inline uint64_t rand_state = 0x9E3779B97F4A7C15ull;
+} // namespace hal
+
+inline uint64_t get_rand_64() {
+    // splitmix64
+    auto z = hal::rand_state += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline uint32_t get_rand_32() { return static_cast<uint32_t>(get_rand_64()); }
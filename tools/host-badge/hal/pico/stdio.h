@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdio>
+
+#include <pico.h>
+
+inline void stdio_flush() { fflush(stdout); }
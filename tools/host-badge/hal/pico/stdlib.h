@@ -0,0 +1,6 @@
+#pragma once
+
+#include <hardware/gpio.h>
+#include <pico.h>
+#include <pico/stdio.h>
+#include <pico/time.h>
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <pico.h>
+
+/// Time since the process started, from the host's steady clock, so the profiler and frame timings measure the host.
+namespace hal
+{
+    inline uint64_t now_us() {
+        static const auto start = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+} // namespace hal
+
+using absolute_time_t = uint64_t;
+
+inline uint64_t time_us_64() { return hal::now_us(); }
+inline uint32_t time_us_32() { return static_cast<uint32_t>(hal::now_us()); }
+
+inline absolute_time_t get_absolute_time() { return hal::now_us(); }
+inline uint32_t to_ms_since_boot(absolute_time_t t) { return static_cast<uint32_t>(t / 1000); }
+inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return static_cast<int64_t>(to - from);
+}
+
+inline void sleep_us(uint64_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+inline void sleep_ms(uint32_t ms) { sleep_us(ms * 1000ull); }
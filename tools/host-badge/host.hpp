@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <badge/pixel.hpp>
+#include <usb/data_port.hpp>
+
+/// What the host versions of the LCD and the data port give the runner, in place of a screen and a USB host.
+namespace host
+{
+
+    /// The frame the LCD shows, i.e. the one most recently passed to `lcd::swap()`.
+    const Pixel *get_screen();
+
+    /// Queue bytes for the badge to read from the data port, as if a host had written them.
+    void feed(std::string_view input);
+
+    /// Whether the badge has read everything queued by `feed()`.
+    [[nodiscard]] bool is_input_drained();
+
+    /// Called for every packet the badge sends on the data port.
+    using PacketHandler = void (*)(usb::data_port::PacketType type, uint8_t flags, uint32_t number,
+                                   std::span<const uint8_t> payload);
+
+    void set_packet_handler(PacketHandler handler);
+
+    /// Allocates from malloc directly, for the runner's own bookkeeping, so it does not count as heap use of the badge.
+    template <typename T>
+    struct UncountedAllocator {
+        using value_type = T;
+
+        UncountedAllocator() = default;
+        template <typename U>
+        explicit UncountedAllocator(const UncountedAllocator<U> &) {}
+
+        T *allocate(size_t n) {
+            if (auto *ptr = static_cast<T *>(malloc(n * sizeof(T))))
+                return ptr;
+            throw std::bad_alloc();
+        }
+
+        void deallocate(T *ptr, size_t) { free(ptr); }
+
+        bool operator==(const UncountedAllocator &) const = default;
+    };
+
+    template <typename T>
+    using UncountedVector = std::vector<T, UncountedAllocator<T>>;
+
+} // namespace host
@@ -0,0 +1,73 @@
+#include <cstring>
+#include <utility>
+
+#include <badge/lcd.hpp>
+
+#include "host.hpp"
+
+// The LCD as two frame buffers in RAM. Swapping is instant, and the frame swapped in is what the screen shows.
+namespace lcd
+{
+
+    namespace
+    {
+        Pixel _frames[2][WIDTH * HEIGHT] = {};
+        Pixel *_onScreenFrame = _frames[0];
+        Pixel *_offScreenFrame = _frames[1];
+        SwapCallback _swapCallback = nullptr;
+        uint32_t _frameCount = 0;
+    } // namespace
+
+    void init() {
+        memset(_frames, 0, sizeof(_frames));
+        swap();
+    }
+
+    void reset() {}
+
+    DisplayID read_id() { return {}; }
+    DisplayStatus read_status() { return {}; }
+
+    void enter_sleep() {}
+    void exit_sleep() {}
+
+    void display_on() {}
+    void display_off() {}
+
+    void set_idle_mode(bool) {}
+    void set_inversion(bool) {}
+    void set_gamma(int) {}
+
+    void backlight_on(int) {}
+    void backlight_off() {}
+
+    void wait_for_transfer() {}
+    void set_spi_clock() {}
+
+    Pixel *get_offscreen_ptr_unsafe() { return _offScreenFrame; }
+
+    void swap() {
+        std::swap(_onScreenFrame, _offScreenFrame);
+        _frameCount++;
+        if (_swapCallback != nullptr)
+            _swapCallback(_onScreenFrame, _offScreenFrame);
+    }
+
+    uint32_t get_frame_count() {
+        return _frameCount;
+    }
+
+    void set_swap_callback(SwapCallback callback) {
+        _swapCallback = callback;
+    }
+
+} // namespace lcd
+
+namespace host
+{
+
+    const Pixel *get_screen() {
+        return lcd::_onScreenFrame;
+    }
+
+} // namespace host
@@ -0,0 +1,405 @@
+/**
+ * The badge firmware running on the host, for benchmarks and screenshots without hardware.
+ *
+ * The badge, UI, games and filesystem code is compiled as is against the stand-ins for the Pico SDK in `hal/`, and
+ * runs the same main loop as `main.cpp`, stepped by a script of remote commands (see `usb/remote.hpp`) like the ones
+ * `tools/ui-script.py` sends to a badge. Frames can be written as PNG files, and the frame timings of each section of
+ * the script are printed the same way `tools/ui-script.py` prints them. Example:
+ *
+ *     host_badge --script tools/ui-scripts/menu-tour.txt --png frames --every 10
+ *
+ * The splash screen runs first, in a section of its own, so scripts start at the main menu. Without a script, it then
+ * runs `--frames` frames with no buttons held.
+ *
+ * The most heap each UI state allocated on top of what was allocated when it was entered (`memory::Stats::state_peak`)
+ * is printed too. With `--heap-budget`, a file of lines with a state's class name and the most bytes it may allocate,
+ * with "*" for any other state, the run fails if a state goes over its budget:
+ *
+ *     host_badge --script tools/ui-scripts/menu-tour.txt --heap-budget tools/ui-scripts/heap-budget.txt
+ */
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+#include <cxxabi.h>
+
+#include <badge/buttons.hpp>
+#include <badge/flags.hpp>
+#include <badge/lcd.hpp>
+#include <badge/memory.hpp>
+#include <badge/profiler.hpp>
+#include <badge/storage.hpp>
+#include <fs/volume.hpp>
+#include <ui/main_menu.hpp>
+#include <ui/profiler_overlay.hpp>
+#include <ui/splash.hpp>
+#include <ui/ui.hpp>
+#include <usb/remote.hpp>
+
+#include "host.hpp"
+#include "png.hpp"
+
+
+/// Same as the firmware's main loop.
+constexpr int FRAME_INTERVAL_MS = 30;
+
+/// Frames until the splash screen is gone, so scripts start at the main menu like on a badge that finished booting.
+constexpr int BOOT_FRAMES = ui::SplashScreen::DURATION_MS / FRAME_INTERVAL_MS + 2;
+
+/// Loop iterations without a frame or an acknowledgment before a command is considered stuck.
+constexpr int MAX_IDLE_ITERATIONS = 1000;
+
+struct Options {
+    const char *script = nullptr;
+    const char *png_dir = nullptr;
+    const char *heap_budget = nullptr;
+    uint32_t png_every = 1;
+    int frames = 300;
+};
+
+/// Results of a part of the script. Names are kept short, so they fit in the string and do not allocate.
+struct Section {
+    char name[32] = {};
+    host::UncountedVector<usb::remote::FrameTiming> frames;
+    uint32_t heap_peak = 0;
+};
+
+/// Most heap a type of state allocated on top of what was allocated when it was entered, and its budget if it has one.
+struct StateHeap {
+    const std::type_info *type = nullptr;
+    uint32_t peak = 0;
+};
+
+struct HeapBudget {
+    char state[64] = {};
+    uint32_t bytes = 0;
+};
+
+Options _options;
+host::UncountedVector<Section> _sections;
+host::UncountedVector<StateHeap> _stateHeaps;
+host::UncountedVector<HeapBudget> _heapBudgets;
+uint32_t _acks = 0;
+uint8_t _lastAckStatus = 0;
+uint32_t _pngsWritten = 0;
+
+
+void on_packet(usb::data_port::PacketType type, uint8_t, uint32_t, std::span<const uint8_t> payload) {
+    if (type == usb::data_port::PACKET_ACK) {
+        _acks++;
+        _lastAckStatus = payload.empty() ? 0xFF : payload[0];
+    }
+    else if (type == usb::data_port::PACKET_TIMING && payload.size() == sizeof(usb::remote::FrameTiming)) {
+        usb::remote::FrameTiming timing;
+        memcpy(&timing, payload.data(), sizeof(timing));
+        _sections.back().frames.push_back(timing);
+    }
+    else if (type == usb::data_port::PACKET_MEMORY && payload.size() == sizeof(memory::Stats)) {
+        memory::Stats stats;
+        memcpy(&stats, payload.data(), sizeof(stats));
+        _sections.back().heap_peak = std::max(_sections.back().heap_peak, stats.heap_peak);
+    }
+}
+
+
+void write_png() {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame-%05lu.png", _options.png_dir,
+             static_cast<unsigned long>(lcd::get_frame_count()));
+    if (!png::write(path, host::get_screen(), lcd::WIDTH, lcd::HEIGHT)) {
+        printf("! Failed to write %s\n", path);
+        exit(1);
+    }
+    _pngsWritten++;
+}
+
+
+/// Take the current state's heap peak into that of its type. The peak restarts when a state is entered, so taking it
+/// after every frame catches all of a state's frames but the one it is left in.
+void record_state_heap() {
+    const auto *state = ui::get_current_state();
+    if (state == nullptr)
+        return;
+    const auto &type = typeid(*state);
+    const auto peak = memory::get_stats().state_peak;
+    for (auto &entry : _stateHeaps) {
+        if (*entry.type == type) {
+            entry.peak = std::max(entry.peak, peak);
+            return;
+        }
+    }
+    _stateHeaps.push_back({&type, peak});
+}
+
+
+/// One pass of the firmware's main loop, without the sleeping. Returns whether a frame ran.
+bool run_frame() {
+    usb::remote::task();
+    fs::volume::task();
+
+    if (!usb::remote::begin_frame())
+        return false;
+    profiler::begin_frame();
+
+    const auto swap_start_us = time_us_32();
+    {
+        profiler::Scope scope(profiler::ZONE_SWAP);
+        lcd::swap();
+    }
+
+    buttons::update();
+    ui::profiler_overlay::update();
+
+    const auto update_start_us = time_us_32();
+    {
+        profiler::Scope scope(profiler::ZONE_UPDATE);
+        ui::update(FRAME_INTERVAL_MS);
+    }
+    const auto draw_start_us = time_us_32();
+    {
+        profiler::Scope scope(profiler::ZONE_DRAW);
+        ui::draw();
+    }
+    const auto draw_end_us = time_us_32();
+    ui::profiler_overlay::draw();
+    record_state_heap();
+
+    usb::remote::end_frame(update_start_us - swap_start_us, draw_start_us - update_start_us,
+                           draw_end_us - draw_start_us);
+
+    // The frame swapped in at the start of this one is still on the screen.
+    if (_options.png_dir != nullptr && lcd::get_frame_count() % _options.png_every == 0)
+        write_png();
+    return true;
+}
+
+
+/// Send a command line to the data port, and run the main loop until the badge acknowledges it.
+bool run_command(std::string_view line) {
+    host::feed(line);
+    host::feed("\n");
+    const auto acks = _acks;
+    int idle = 0;
+    while (_acks == acks) {
+        idle = run_frame() ? 0 : idle + 1;
+        if (idle > MAX_IDLE_ITERATIONS) {
+            printf("! No acknowledgment for: %.*s\n", static_cast<int>(line.size()), line.data());
+            return false;
+        }
+    }
+    return _lastAckStatus == 0;
+}
+
+
+/// Finish the current section of the results with its heap peak, and start measuring another one.
+void begin_section(std::string_view name) {
+    if (!_sections.empty())
+        run_command("memory");
+    auto &section = _sections.emplace_back();
+    snprintf(section.name, sizeof(section.name), "%.*s", static_cast<int>(name.size()), name.data());
+    run_command("memory reset");
+}
+
+
+bool run_script(const char *path) {
+    auto *file = fopen(path, "r");
+    if (file == nullptr) {
+        printf("! Failed to open %s\n", path);
+        return false;
+    }
+
+    char buffer[256];
+    bool ok = true;
+    for (int line_number = 1; ok && fgets(buffer, sizeof(buffer), file) != nullptr; line_number++) {
+        std::string_view line = buffer;
+        line = line.substr(0, line.find('#'));
+        const auto start = line.find_first_not_of(" \t\r\n");
+        if (start == std::string_view::npos)
+            continue;
+        line = line.substr(start, line.find_last_not_of(" \t\r\n") + 1 - start);
+
+        // Marks start a new section of the results, like in `tools/ui-script.py`.
+        if (line.starts_with("mark ")) {
+            begin_section(line.substr(5));
+            continue;
+        }
+
+        ok = run_command(line);
+        if (!ok)
+            printf("! %s:%d: Command failed: %.*s\n", path, line_number, static_cast<int>(line.size()), line.data());
+    }
+    fclose(file);
+    return ok;
+}
+
+
+uint32_t percentile(std::vector<uint32_t> values, int p) {
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, values.size() * p / 100)];
+}
+
+
+void print_results() {
+    constexpr const char *FIELDS[] = {"interval", "swap", "update", "draw"};
+    printf("%-16s %6s", "section", "frames");
+    for (const auto *field : FIELDS)
+        printf("  %24s", (std::string(field) + " mean/p95/max").c_str());
+    printf("  %10s\n", "heap peak");
+
+    for (const auto &section : _sections) {
+        if (section.frames.empty())
+            continue;
+        printf("%-16s %6zu", section.name, section.frames.size());
+        for (auto member : {&usb::remote::FrameTiming::interval_us, &usb::remote::FrameTiming::swap_us,
+                            &usb::remote::FrameTiming::update_us, &usb::remote::FrameTiming::draw_us}) {
+            std::vector<uint32_t> values;
+            uint64_t sum = 0;
+            for (const auto &frame : section.frames) {
+                values.push_back(frame.*member);
+                sum += frame.*member;
+            }
+            char cell[32];
+            snprintf(cell, sizeof(cell), "%8.0f/%6u/%6u", static_cast<double>(sum) / values.size(),
+                     percentile(values, 95), *std::max_element(values.begin(), values.end()));
+            printf("  %24s", cell);
+        }
+        printf("  %10u\n", section.heap_peak);
+    }
+}
+
+
+/// Read the heap budget file, with one `<state> <bytes>` line per state. Everything from a '#' on is a comment. The
+/// number of bytes comes last, as the names of states in anonymous namespaces contain a space.
+bool read_heap_budget(const char *path) {
+    auto *file = fopen(path, "r");
+    if (file == nullptr) {
+        printf("! Failed to open %s\n", path);
+        return false;
+    }
+
+    char buffer[256];
+    bool ok = true;
+    for (int line_number = 1; ok && fgets(buffer, sizeof(buffer), file) != nullptr; line_number++) {
+        std::string_view line(buffer, strcspn(buffer, "#\r\n"));
+        while (!line.empty() && line.back() == ' ')
+            line.remove_suffix(1);
+        if (line.empty())
+            continue;
+
+        HeapBudget budget;
+        const auto space = line.rfind(' ');
+        auto name = line.substr(0, space == std::string_view::npos ? 0 : space);
+        while (!name.empty() && name.back() == ' ')
+            name.remove_suffix(1);
+        const auto bytes = line.substr(space + 1);
+        const auto [end, error] = std::from_chars(bytes.data(), bytes.data() + bytes.size(), budget.bytes);
+        if (name.empty() || name.size() >= sizeof(budget.state) || error != std::errc() ||
+            end != bytes.data() + bytes.size()) {
+            printf("! %s:%d: Expected a state and a number of bytes\n", path, line_number);
+            ok = false;
+            continue;
+        }
+        name.copy(budget.state, name.size());
+        _heapBudgets.push_back(budget);
+    }
+    fclose(file);
+    return ok;
+}
+
+
+/// Print the heap peak of every state that ran, and check them against the budget. Returns whether all fit.
+bool check_heap_budget() {
+    const HeapBudget *fallback = nullptr;
+    for (const auto &budget : _heapBudgets)
+        if (strcmp(budget.state, "*") == 0)
+            fallback = &budget;
+
+    printf("\n%-36s %10s %10s\n", "state", "heap peak", "budget");
+    bool ok = true;
+    for (const auto &entry : _stateHeaps) {
+        auto *demangled = abi::__cxa_demangle(entry.type->name(), nullptr, nullptr, nullptr);
+        const auto *name = demangled != nullptr ? demangled : entry.type->name();
+        const auto *budget = fallback;
+        for (const auto &candidate : _heapBudgets)
+            if (strcmp(candidate.state, name) == 0)
+                budget = &candidate;
+
+        if (budget != nullptr)
+            printf("%-36s %10u %10u\n", name, entry.peak, budget->bytes);
+        else
+            printf("%-36s %10u %10s\n", name, entry.peak, "-");
+        if (budget != nullptr && entry.peak > budget->bytes) {
+            printf("! %s: Heap peak of %u bytes is over the budget of %u bytes\n", name, entry.peak, budget->bytes);
+            ok = false;
+        }
+        free(demangled);
+    }
+    return ok;
+}
+
+
+bool parse_options(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--script" && has_value)
+            _options.script = argv[++i];
+        else if (arg == "--png" && has_value)
+            _options.png_dir = argv[++i];
+        else if (arg == "--every" && has_value)
+            _options.png_every = std::max(1, atoi(argv[++i]));
+        else if (arg == "--heap-budget" && has_value)
+            _options.heap_budget = argv[++i];
+        else if (arg == "--frames" && has_value)
+            _options.frames = atoi(argv[++i]);
+        else
+            return false;
+    }
+    return true;
+}
+
+
+int main(int argc, char **argv) {
+    if (!parse_options(argc, argv)) {
+        printf("Usage: %s [--script FILE] [--png DIR] [--every N] [--heap-budget FILE] [--frames N]\n", argv[0]);
+        return 2;
+    }
+
+    if (_options.heap_budget != nullptr && !read_heap_budget(_options.heap_budget))
+        return 1;
+
+    // Boot like the firmware does.
+    memory::init();
+    buttons::init();
+    storage::init();
+    flags::init();
+    lcd::init();
+    fs::volume::init();
+
+    const auto menu = ui::create_main_menu();
+    ui::push_state(menu);
+    ui::push_new_state<ui::SplashScreen>();
+
+    host::set_packet_handler(on_packet);
+    bool ok = run_command("pause") && run_command("timing on");
+    begin_section("boot");
+    ok = ok && run_command("wait " + std::to_string(BOOT_FRAMES));
+    begin_section("default");
+    if (ok && _options.script != nullptr)
+        ok = run_script(_options.script);
+    else if (ok)
+        ok = run_command("wait " + std::to_string(_options.frames));
+    ok = ok && run_command("memory");
+    fs::volume::flush();
+
+    print_results();
+    ok = check_heap_budget() && ok;
+    if (_options.png_dir != nullptr)
+        printf("> Wrote %lu frames to %s\n", static_cast<unsigned long>(_pngsWritten), _options.png_dir);
+    return ok ? 0 : 1;
+}
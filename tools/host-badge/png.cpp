@@ -0,0 +1,153 @@
+#include "png.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <span>
+
+#include <utils/crc.hpp>
+
+namespace png
+{
+
+    namespace
+    {
+        /// Largest stored deflate block.
+        constexpr uint32_t MAX_BLOCK_SIZE = 0xFFFF;
+
+        /// Writes a file through a small fixed buffer, keeping the CRC-32 of a chunk. Nothing is allocated, so
+        /// writing screenshots does not show up in the badge's heap statistics.
+        class Writer {
+        public:
+            explicit Writer(FILE *file) : file(file) {}
+
+            void put(std::span<const uint8_t> data) {
+                crc = utils::crc32(data, crc);
+                for (const auto byte : data) {
+                    if (size == sizeof(buffer))
+                        flush();
+                    buffer[size++] = byte;
+                }
+            }
+
+            void put32(uint32_t value) {
+                const uint8_t bytes[] = {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                                         static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+                put(bytes);
+            }
+
+            void begin_chunk(const char *type, uint32_t length) {
+                put32(length);
+                crc = 0;
+                put({reinterpret_cast<const uint8_t *>(type), 4});
+            }
+
+            void end_chunk() {
+                put32(crc);
+            }
+
+            bool flush() {
+                ok = ok && fwrite(buffer, 1, size, file) == size;
+                size = 0;
+                return ok;
+            }
+
+        private:
+            FILE *file;
+            uint8_t buffer[4096] = {};
+            size_t size = 0;
+            uint32_t crc = 0;
+            bool ok = true;
+        };
+
+        /// Writes image data as a zlib stream of stored deflate blocks, so no compressor is needed.
+        class StoredStream {
+        public:
+            StoredStream(Writer &writer, uint32_t total) : writer(writer), remaining(total) {
+                const uint8_t header[] = {0x78, 0x01};
+                writer.put(header);
+            }
+
+            /// Size of the stream for `total` bytes of data.
+            static uint32_t get_size(uint32_t total) {
+                return 2 + total + 5 * ((total + MAX_BLOCK_SIZE - 1) / MAX_BLOCK_SIZE) + 4;
+            }
+
+            void put(std::span<const uint8_t> data) {
+                while (!data.empty()) {
+                    if (block_left == 0)
+                        begin_block();
+                    const auto n = std::min<size_t>(block_left, data.size());
+                    for (const auto byte : data.first(n)) {
+                        a = (a + byte) % 65521;
+                        b = (b + a) % 65521;
+                    }
+                    writer.put(data.first(n));
+                    block_left -= n;
+                    remaining -= n;
+                    data = data.subspan(n);
+                }
+                if (remaining == 0)
+                    writer.put32(b << 16 | a);
+            }
+
+        private:
+            void begin_block() {
+                const auto size = std::min(MAX_BLOCK_SIZE, remaining);
+                const uint8_t header[] = {static_cast<uint8_t>(size == remaining), static_cast<uint8_t>(size),
+                                          static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(~size),
+                                          static_cast<uint8_t>(~size >> 8)};
+                writer.put(header);
+                block_left = size;
+            }
+
+            Writer &writer;
+            uint32_t remaining;
+            uint32_t block_left = 0;
+            uint32_t a = 1; ///< Adler-32 of the data so far.
+            uint32_t b = 0;
+        };
+    } // namespace
+
+    bool write(const char *path, const Pixel *pixels, int width, int height) {
+        auto *file = fopen(path, "wb");
+        if (file == nullptr)
+            return false;
+
+        Writer writer(file);
+        const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        writer.put(signature);
+
+        writer.begin_chunk("IHDR", 13);
+        writer.put32(width);
+        writer.put32(height);
+        const uint8_t format[] = {8, 2, 0, 0, 0}; // 8-bit RGB, no interlacing
+        writer.put(format);
+        writer.end_chunk();
+
+        // Scanlines of filter type 0 followed by the pixels, widened from 5-6-5 by repeating the top bits.
+        const auto total = static_cast<uint32_t>(height * (1 + width * 3));
+        writer.begin_chunk("IDAT", StoredStream::get_size(total));
+        StoredStream stream(writer, total);
+        for (int y = 0; y < height; y++) {
+            const uint8_t filter[] = {0};
+            stream.put(filter);
+            for (int x = 0; x < width; x++) {
+                const auto pixel = pixels[y * width + x];
+                const uint8_t r = pixel >> 11 & 0x1F;
+                const uint8_t g = pixel >> 5 & 0x3F;
+                const uint8_t b = pixel & 0x1F;
+                const uint8_t rgb[] = {static_cast<uint8_t>(r << 3 | r >> 2), static_cast<uint8_t>(g << 2 | g >> 4),
+                                       static_cast<uint8_t>(b << 3 | b >> 2)};
+                stream.put(rgb);
+            }
+        }
+        writer.end_chunk();
+
+        writer.begin_chunk("IEND", 0);
+        writer.end_chunk();
+
+        const bool ok = writer.flush();
+        return fclose(file) == 0 && ok;
+    }
+
+} // namespace png
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <badge/pixel.hpp>
+
+namespace png
+{
+
+    /// Write an RGB565 image as an 8-bit RGB PNG, uncompressed, so it needs no zlib. Returns false on I/O errors.
+    bool write(const char *path, const Pixel *pixels, int width, int height);
+
+} // namespace png
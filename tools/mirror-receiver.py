@@ -0,0 +1,202 @@
+"""
+Receive the screen mirroring stream from the badge data port and save it as PNG files or a Y4M video.
+
+The data port is the second CDC interface of the badge (see usb/data_port.hpp and usb/mirror.hpp for the protocol). Examples:
+
+    python3 tools/mirror-receiver.py /dev/ttyACM1 frames/frame-%05d.png
+    python3 tools/mirror-receiver.py /dev/ttyACM1 capture.y4m --frames 300
+    python3 tools/mirror-receiver.py recorded-stream.bin capture.y4m
+
+Reading from a serial port needs pyserial; a file recorded from the port can be decoded without it.
+"""
+import argparse
+import struct
+import sys
+import zlib
+from pathlib import Path
+
+PACKET_MAGIC = b'BM'
+PACKET_FRAME = 1
+FRAME_COMPLETE = 1 << 0
+HEADER = struct.Struct('<2sBBII')
+FRAME_HEADER = struct.Struct('<HH')
+
+RUN_SKIP = 0x00
+RUN_COPY = 0x40
+RUN_FILL = 0x80
+END_OF_ROWS = 0xFF
+
+FRAME_RATE = 33
+
+
+class Stream:
+
+    def __init__(self, source):
+        self.source = source
+        self.buffer = bytearray()
+
+    def fill(self, n):
+        while len(self.buffer) < n:
+            data = self.source.read(max(n - len(self.buffer), 4096))
+            if not data:
+                raise EOFError()
+            self.buffer += data
+
+    def read(self, n):
+        self.fill(n)
+        data = bytes(self.buffer[:n])
+        del self.buffer[:n]
+        return data
+
+    def sync(self):
+        """Skip ahead to the next packet header; there may be stale data when the port was opened."""
+        skipped = 0
+        while True:
+            self.fill(len(PACKET_MAGIC))
+            if self.buffer.startswith(PACKET_MAGIC):
+                break
+            del self.buffer[:1]
+            skipped += 1
+        if skipped:
+            print(f'Skipped {skipped} bytes', file=sys.stderr)
+        return self.read(HEADER.size)
+
+
+def rgb565_to_rgb888(pixel):
+    r = (pixel >> 11) & 0x1F
+    g = (pixel >> 5) & 0x3F
+    b = pixel & 0x1F
+    return (r << 3 | r >> 2), (g << 2 | g >> 4), (b << 3 | b >> 2)
+
+
+class Decoder:
+
+    def __init__(self):
+        self.width = 0
+        self.height = 0
+        self.pixels = []
+
+    def apply(self, payload):
+        width, height = FRAME_HEADER.unpack_from(payload)
+        if (width, height) != (self.width, self.height):
+            self.width, self.height = width, height
+            self.pixels = [0] * (width * height)
+
+        pos = FRAME_HEADER.size
+        while True:
+            y = payload[pos]
+            pos += 1
+            if y == END_OF_ROWS:
+                break
+            x = 0
+            while x < self.width:
+                control = payload[pos]
+                pos += 1
+                kind, n = control & 0xC0, (control & 0x3F) + 1
+                base = y * self.width + x
+                if kind == RUN_COPY:
+                    self.pixels[base:base + n] = struct.unpack_from(f'<{n}H', payload, pos)
+                    pos += 2 * n
+                elif kind == RUN_FILL:
+                    self.pixels[base:base + n] = [struct.unpack_from('<H', payload, pos)[0]] * n
+                    pos += 2
+                elif kind != RUN_SKIP:
+                    raise ValueError(f'Invalid run type {kind:#x}')
+                x += n
+
+    def rgb(self):
+        return [rgb565_to_rgb888(p) for p in self.pixels]
+
+
+def write_png(path, width, height, rgb):
+    rows = b''.join(b'\0' + bytes(c for p in rgb[y * width:(y + 1) * width] for c in p) for y in range(height))
+
+    def chunk(kind, data):
+        return struct.pack('>I', len(data)) + kind + data + struct.pack('>I', zlib.crc32(kind + data))
+
+    with open(path, 'wb') as f:
+        f.write(b'\x89PNG\r\n\x1a\n')
+        f.write(chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 2, 0, 0, 0)))
+        f.write(chunk(b'IDAT', zlib.compress(rows)))
+        f.write(chunk(b'IEND', b''))
+
+
+class Y4mWriter:
+
+    def __init__(self, path):
+        self.file = open(path, 'wb')
+        self.header_written = False
+
+    def write(self, width, height, rgb):
+        if not self.header_written:
+            self.file.write(f'YUV4MPEG2 W{width} H{height} F{FRAME_RATE}:1 Ip A1:1 C444\n'.encode())
+            self.header_written = True
+        # Full range BT.601, which is close enough for screen captures.
+        planes = [bytearray(), bytearray(), bytearray()]
+        for r, g, b in rgb:
+            planes[0].append(round(0.299 * r + 0.587 * g + 0.114 * b))
+            planes[1].append(max(0, min(255, round(128 - 0.168736 * r - 0.331264 * g + 0.5 * b))))
+            planes[2].append(max(0, min(255, round(128 + 0.5 * r - 0.418688 * g - 0.081312 * b))))
+        self.file.write(b'FRAME\n')
+        for plane in planes:
+            self.file.write(plane)
+
+    def close(self):
+        self.file.close()
+
+
+def open_source(name):
+    if Path(name).is_file():
+        return open(name, 'rb')
+    import serial
+    return serial.Serial(name, timeout=5)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('source', help='Serial port of the badge data port, or a file recorded from it')
+    parser.add_argument('output', help='PNG file name pattern (e.g. frame-%%05d.png), or a .y4m file')
+    parser.add_argument('--frames', type=int, default=0, help='Stop after this many frames')
+    parser.add_argument('--all', action='store_true', help='Also save frames that are still catching up')
+    args = parser.parse_args()
+
+    decoder = Decoder()
+    y4m = Y4mWriter(args.output) if args.output.endswith('.y4m') else None
+    stream = Stream(open_source(args.source))
+
+    saved = 0
+    last_number = None
+    try:
+        while not args.frames or saved < args.frames:
+            header = HEADER.unpack(stream.sync())
+            _, kind, flags, number, size = header
+            payload = stream.read(size)
+            if kind != PACKET_FRAME:
+                continue
+            if last_number is not None and number != last_number + 1:
+                print(f'Dropped {number - last_number - 1} frames before frame {number}', file=sys.stderr)
+            last_number = number
+
+            decoder.apply(payload)
+            if not flags & FRAME_COMPLETE and not args.all:
+                continue
+
+            rgb = decoder.rgb()
+            if y4m:
+                y4m.write(decoder.width, decoder.height, rgb)
+            else:
+                path = Path(args.output % saved)
+                path.parent.mkdir(parents=True, exist_ok=True)
+                write_png(path, decoder.width, decoder.height, rgb)
+            saved += 1
+    except (EOFError, KeyboardInterrupt):
+        pass
+    finally:
+        if y4m:
+            y4m.close()
+
+    print(f'Saved {saved} frames')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,63 @@
+"""
+Measure the sequential read throughput of the badge USB drive.
+
+Reads the whole raw block device twice and checks both passes return the same data, which also catches corruption
+from the DMA read path. Run with enough privileges to open the raw device, e.g.
+
+    sudo python3 tools/msc-read-bench.py /dev/sdX
+    python tools/msc-read-bench.py \\\\.\\E:
+"""
+import argparse
+import hashlib
+import os
+import time
+
+BLOCK_SIZE = 512
+VOLUME_SIZE = 2 * 1024 * 1024
+
+
+def read_device(path, chunk_size):
+    digest = hashlib.sha1()
+    total = 0
+
+    fd = os.open(path, os.O_RDONLY | getattr(os, 'O_BINARY', 0))
+    try:
+        # Make sure we measure the device and not the page cache of the host.
+        if hasattr(os, 'posix_fadvise'):
+            os.posix_fadvise(fd, 0, 0, os.POSIX_FADV_DONTNEED)
+
+        start = time.perf_counter()
+        while total < VOLUME_SIZE:
+            data = os.read(fd, min(chunk_size, VOLUME_SIZE - total))
+            if not data:
+                break
+            digest.update(data)
+            total += len(data)
+        elapsed = time.perf_counter() - start
+    finally:
+        os.close(fd)
+
+    return total, elapsed, digest.hexdigest()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('device', help='Raw block device of the badge drive')
+    parser.add_argument('--chunk-size', type=int, default=64 * 1024, help='Size of each read request in bytes')
+    args = parser.parse_args()
+
+    assert args.chunk_size % BLOCK_SIZE == 0, 'Chunk size must be a multiple of the block size'
+
+    digests = set()
+    for n in range(2):
+        total, elapsed, digest = read_device(args.device, args.chunk_size)
+        digests.add(digest)
+        print(f'Pass {n + 1}: {total} bytes in {elapsed:.3f} s, {total / elapsed / 1024:.1f} KiB/s ({digest})')
+
+    if len(digests) != 1:
+        print('! Passes returned different data')
+        exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fs/sector_cache.hpp>
+#include <fs/volume.hpp>
+#include <usb/tusb_config.h>
+
+
+// Geometry matching the generated disk image (see `assets/assets/filesystem.py`).
+constexpr uint32_t BLOCK_SIZE = fs::volume::BLOCK_SIZE;
+constexpr uint32_t BLOCK_COUNT = fs::volume::BLOCK_COUNT;
+constexpr uint32_t VOLUME_SIZE = fs::volume::SIZE;
+constexpr uint32_t FAT_OFFSET = BLOCK_SIZE;
+constexpr uint32_t ROOT_OFFSET = FAT_OFFSET + 12 * BLOCK_SIZE;
+constexpr uint32_t DATA_OFFSET = ROOT_OFFSET + 4 * BLOCK_SIZE;
+
+// Size of each write callback from TinyUSB, the same as on the badge.
+constexpr uint32_t WRITE_CHUNK_SIZE = CFG_TUD_MSC_EP_BUFSIZE;
+
+// Rough time for the host to transfer one write chunk over full speed USB, at about 1 KiB per millisecond.
+constexpr uint32_t CHUNK_TIME_MS = (WRITE_CHUNK_SIZE + 1023) / 1024;
+
+constexpr uint32_t IDLE_WRITE_BACK_MS = fs::volume::IDLE_WRITE_BACK_MS;
+
+
+struct SimulatedFlash {
+    std::vector<uint8_t> memory = std::vector<uint8_t>(VOLUME_SIZE, 0xFF);
+    uint32_t erases = 0;
+    uint32_t programs = 0;
+
+    const uint8_t *data(uint32_t offset) { return &memory[offset]; }
+
+    void erase(uint32_t offset) {
+        memset(&memory[offset], 0xFF, 4096);
+        erases++;
+    }
+
+    void program(uint32_t offset, const uint8_t *src, uint32_t size) {
+        // Programming can only clear bits, just like the real thing.
+        for (uint32_t i = 0; i < size; i++)
+            memory[offset + i] &= src[i];
+        programs++;
+    }
+};
+
+
+template<int LINES>
+struct Host {
+    SimulatedFlash &flash;
+    fs::SectorCache<SimulatedFlash, LINES> cache;
+    uint32_t time_ms = 0;
+    uint32_t block_writes = 0;
+
+    explicit Host(SimulatedFlash &flash) : flash(flash), cache(flash) {}
+
+    void write(uint32_t offset, const uint8_t *data, uint32_t size) {
+        for (uint32_t i = 0; i < size; i += WRITE_CHUNK_SIZE) {
+            cache.write(offset + i, data + i, std::min(WRITE_CHUNK_SIZE, size - i), time_ms);
+            block_writes += (std::min(WRITE_CHUNK_SIZE, size - i) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            time_ms += CHUNK_TIME_MS;
+            cache.flush_idle(time_ms, IDLE_WRITE_BACK_MS);
+        }
+    }
+
+    void idle(uint32_t ms) {
+        time_ms += ms;
+        cache.flush_idle(time_ms, IDLE_WRITE_BACK_MS);
+    }
+
+    void set_fat_entries(uint32_t first_cluster, uint32_t n_clusters, bool last) {
+        // Read-modify-write of the FAT sectors holding the 12-bit entries, like a host driver would do.
+        constexpr uint32_t FAT_SIZE = ROOT_OFFSET - FAT_OFFSET;
+        std::vector<uint8_t> fat(FAT_SIZE);
+        cache.read(FAT_OFFSET, fat.data(), FAT_SIZE);
+        const auto original = fat;
+        for (uint32_t i = 0; i < n_clusters; i++) {
+            const auto cluster = first_cluster + i;
+            const uint16_t value = (last && i + 1 == n_clusters) ? 0xFFF : cluster + 1;
+            auto *ptr = &fat[cluster + cluster / 2];
+            if (cluster & 1) {
+                ptr[0] = (ptr[0] & 0x0F) | (value << 4);
+                ptr[1] = value >> 4;
+            }
+            else {
+                ptr[0] = value;
+                ptr[1] = (ptr[1] & 0xF0) | (value >> 8);
+            }
+        }
+        for (uint32_t sector = 0; sector < FAT_SIZE; sector += BLOCK_SIZE) {
+            if (memcmp(&fat[sector], &original[sector], BLOCK_SIZE) != 0)
+                write(FAT_OFFSET + sector, &fat[sector], BLOCK_SIZE);
+        }
+    }
+
+    /// Copy a file the way a typical host driver does: directory entry first, then data in large transfers with
+    /// the FAT updated after each transfer, and finally the directory entry again with the final size.
+    void copy_file(uint32_t first_cluster, uint32_t size, uint8_t fill) {
+        uint8_t dir[BLOCK_SIZE] = {};
+        cache.read(ROOT_OFFSET, dir, BLOCK_SIZE);
+        memcpy(&dir[64], "BIGFILE BIN", 11);
+        write(ROOT_OFFSET, dir, BLOCK_SIZE);
+
+        constexpr uint32_t TRANSFER_SIZE = 64 * 1024;
+        std::vector<uint8_t> data(TRANSFER_SIZE, fill);
+        const auto n_clusters = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        for (uint32_t cluster = 0; cluster < n_clusters; cluster += TRANSFER_SIZE / BLOCK_SIZE) {
+            const auto n = std::min(TRANSFER_SIZE / BLOCK_SIZE, n_clusters - cluster);
+            write(DATA_OFFSET + (first_cluster + cluster - 2) * BLOCK_SIZE, data.data(), n * BLOCK_SIZE);
+            set_fat_entries(first_cluster + cluster, n, cluster + n == n_clusters);
+        }
+
+        memcpy(&dir[64 + 28], &size, 4);
+        write(ROOT_OFFSET, dir, BLOCK_SIZE);
+    }
+};
+
+
+template<int LINES>
+void run(const char *scenario, bool stale_free_space) {
+    SimulatedFlash flash;
+    // A freshly provisioned volume has erased free space. After files have been deleted, the free space instead
+    // holds old data, and writing to it needs erases.
+    if (stale_free_space)
+        memset(flash.memory.data() + DATA_OFFSET, 0x5A, VOLUME_SIZE - DATA_OFFSET);
+    memset(flash.memory.data(), 0, DATA_OFFSET);
+
+    Host<LINES> host(flash);
+    host.copy_file(100, 1024 * 1024, 0xA5);
+    host.idle(IDLE_WRITE_BACK_MS);
+    host.cache.flush();
+
+    const auto &stats = host.cache.get_stats();
+    printf("| %-16s | %5d | %12u | %9u | %12u | %9u |\n",
+           scenario,
+           LINES,
+           host.block_writes,
+           flash.erases,
+           stats.sector_programs,
+           flash.programs);
+}
+
+
+int main() {
+    printf("Copy of a 1 MiB file to the FLASH volume:\n\n");
+    printf("| Free space       | Lines | Block writes | Erases    | Program-only | Pages     |\n");
+    printf("|------------------|-------|--------------|-----------|--------------|-----------|\n");
+    run<1>("erased", false);
+    run<2>("erased", false);
+    run<4>("erased", false);
+    run<8>("erased", false);
+    run<1>("stale", true);
+    run<2>("stale", true);
+    run<4>("stale", true);
+    run<8>("stale", true);
+    printf("\nWithout a cache, every block write would need its own sector erase.\n");
+    return 0;
+}
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include <games/othello_board.hpp>
+#include <games/othello_search.hpp>
+#include <tools/common/tool.hpp>
+
+using namespace othello;
+
+
+// The board as `BoardState` kept it before the bitboard, one tile per square, with the same walk along each direction.
+// This is the baseline that `Position` has to match exactly.
+struct ArrayBoard {
+    enum Tile { EMPTY, PLAYER, OPPONENT };
+
+    std::array<std::array<Tile, 8>, 8> board = {};
+
+    static ArrayBoard from(const Position &position) {
+        ArrayBoard result;
+        for (int r = 0; r < 8; r++) {
+            for (int c = 0; c < 8; c++) {
+                const auto bit = get_bit(get_square(r, c));
+                result.board[r][c] = (position.player & bit) ? PLAYER : (position.opponent & bit) ? OPPONENT : EMPTY;
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] int count_flips(int r0, int c0, int dr, int dc) const {
+        int r = r0;
+        int c = c0;
+        for (int i = 1; i < 8; i++) {
+            r += dr;
+            c += dc;
+            if (r < 0 || r >= 8 || c < 0 || c >= 8)
+                return 0;
+            if (board[r][c] == PLAYER)
+                return i - 1;
+            else if (board[r][c] == OPPONENT)
+                continue;
+            else
+                return 0;
+        }
+        return 0;
+    }
+
+    [[nodiscard]] int count_flips(int r, int c) const {
+        if (board[r][c] != EMPTY)
+            return 0;
+        int sum = 0;
+        for (int dr = -1; dr <= 1; dr++)
+            for (int dc = -1; dc <= 1; dc++)
+                if (dr != 0 || dc != 0)
+                    sum += count_flips(r, c, dr, dc);
+        return sum;
+    }
+
+    /// Play a move and swap sides, like `Position::play()`.
+    [[nodiscard]] ArrayBoard play(int r0, int c0) const {
+        ArrayBoard result = *this;
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dc = -1; dc <= 1; dc++) {
+                if (dr == 0 && dc == 0)
+                    continue;
+                const int n = count_flips(r0, c0, dr, dc);
+                for (int i = 1; i <= n; i++)
+                    result.board[r0 + dr * i][c0 + dc * i] = PLAYER;
+            }
+        }
+        result.board[r0][c0] = PLAYER;
+        return result.pass();
+    }
+
+    [[nodiscard]] ArrayBoard pass() const {
+        ArrayBoard result = *this;
+        for (auto &row : result.board)
+            for (auto &tile : row)
+                tile = tile == PLAYER ? OPPONENT : tile == OPPONENT ? PLAYER : EMPTY;
+        return result;
+    }
+
+    [[nodiscard]] bool has_moves() const {
+        for (int r = 0; r < 8; r++)
+            for (int c = 0; c < 8; c++)
+                if (count_flips(r, c) > 0)
+                    return true;
+        return false;
+    }
+};
+
+uint64_t perft(const ArrayBoard &board, int depth) {
+    if (depth == 0)
+        return 1;
+    uint64_t count = 0;
+    bool moved = false;
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            if (board.count_flips(r, c) > 0) {
+                moved = true;
+                count += perft(board.play(r, c), depth - 1);
+            }
+        }
+    }
+    if (moved)
+        return count;
+    const auto passed = board.pass();
+    return passed.has_moves() ? perft(passed, depth - 1) : 1;
+}
+
+/// Compare the moves and flips of a position with the baseline.
+void compare(const Position &position) {
+    const auto array = ArrayBoard::from(position);
+    const auto moves = position.get_moves();
+    for (int square = 0; square < 64; square++) {
+        const int expected = array.count_flips(square / 8, square % 8);
+        CHECK(((moves >> square) & 1) == (expected > 0), "Move %d is wrong", square);
+        if ((position.get_empty() >> square) & 1)
+            CHECK(std::popcount(position.get_flips(square)) == expected, "Flips of move %d are wrong", square);
+    }
+}
+
+/// Score of a position with perfect play, by plain negamax without any pruning.
+int solve(const Position &position) {
+    const auto moves = position.get_moves();
+    if (moves == 0) {
+        if (position.pass().get_moves() == 0)
+            return (std::popcount(position.player) - std::popcount(position.opponent)) * Search::WIN_SCORE;
+        return -solve(position.pass());
+    }
+    int best = -1000000;
+    for (auto m = moves; m != 0; m &= m - 1)
+        best = std::max(best, -solve(position.play(std::countr_zero(m))));
+    return best;
+}
+
+/// Play `count` random moves from the start, passing when needed. Stops early at the end of the game.
+Position play_random(std::mt19937 &rng, int count) {
+    auto position = Position::initial();
+    for (int i = 0; i < count && !position.is_game_over(); i++) {
+        auto moves = position.get_moves();
+        if (moves == 0) {
+            position = position.pass();
+            continue;
+        }
+        for (int skip = rng() % std::popcount(moves); skip > 0; skip--)
+            moves &= moves - 1;
+        position = position.play(std::countr_zero(moves));
+    }
+    return position;
+}
+
+
+int main() {
+    using clock = std::chrono::steady_clock;
+    std::mt19937 rng(0x5EED);
+
+    // Known leaf counts from the starting position, with passes counted as moves.
+    constexpr uint64_t PERFT[] = {1, 4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284};
+    for (int depth = 1; depth <= 10; depth++)
+        CHECK(perft(Position::initial(), depth) == PERFT[depth], "perft(%d) is wrong", depth);
+    for (int depth = 1; depth <= 7; depth++)
+        CHECK(perft(ArrayBoard::from(Position::initial()), depth) == PERFT[depth], "Baseline perft(%d) is wrong",
+              depth);
+
+    // Moves and flips of positions from random games, all the way to the end.
+    int positions = 0;
+    for (int game = 0; game < 2000; game++) {
+        auto position = Position::initial();
+        while (!position.is_game_over()) {
+            compare(position);
+            positions++;
+            auto moves = position.get_moves();
+            if (moves == 0) {
+                position = position.pass();
+                continue;
+            }
+            for (int skip = rng() % std::popcount(moves); skip > 0; skip--)
+                moves &= moves - 1;
+            const int move = std::countr_zero(moves);
+            const auto played = position.play(move);
+            const auto expected = ArrayBoard::from(position).play(move / 8, move % 8);
+            CHECK(ArrayBoard::from(played).board == expected.board, "Playing %d is wrong", move);
+            position = played;
+        }
+    }
+    printf("Compared moves and flips of %d positions\n", positions);
+
+    const auto allocations = tool::get_allocations();
+
+    // The search must find the exact score of endgames it solves, and the same when it is stopped every few steps
+    // and resumed, like it is on the device.
+    {
+        Search search;
+        Search interrupted;
+        int solved = 0;
+        for (int i = 0; i < 200; i++) {
+            const auto position = play_random(rng, 50 + i % 6);
+            if (position.get_moves() == 0)
+                continue;
+            search.start(position);
+            search.think([] { return false; });
+            // With a single move there is nothing to search, so the score stays a guess.
+            const int expected = solve(position);
+            const bool single_move = std::has_single_bit(position.get_moves());
+            CHECK(single_move || search.get_best_score() == expected, "Endgame %d scores %d, expected %d", i,
+                  search.get_best_score(), expected);
+            CHECK(-solve(position.play(search.get_best_move())) == expected, "Endgame %d best move is wrong", i);
+
+            interrupted.start(position);
+            int calls = 0;
+            while (!interrupted.think([&] { return ++calls % 2 == 0; })) {}
+            CHECK(single_move || interrupted.get_best_score() == expected, "Interrupted endgame %d scores %d, expected %d", i,
+                  interrupted.get_best_score(), expected);
+            solved++;
+        }
+        printf("Solved %d endgames\n", solved);
+    }
+
+    // Move generation speed, against the baseline.
+    printf("\n%-28s %12s %12s %8s\n", "operation", "array", "bitboard", "speedup");
+    {
+        // Both are constexpr, so keep the compiler from working out the bitboard count at compile time.
+        volatile int depth = 6;
+        const auto array_us = tool::measure_us([&] { return perft(ArrayBoard::from(Position::initial()), depth); });
+        const auto bits_us = tool::measure_us([&] { return perft(Position::initial(), depth); });
+        printf("%-28s %9.0f us %9.0f us %7.1fx\n", "perft(6), 8200 leaves", array_us, bits_us, array_us / bits_us);
+
+        std::array<Position, 64> midgames;
+        for (auto &position : midgames)
+            position = play_random(rng, 20);
+        const auto array_moves_us = tool::measure_us([&] {
+            uint64_t count = 0;
+            for (const auto &position : midgames) {
+                const auto array = ArrayBoard::from(position);
+                for (int square = 0; square < 64; square++)
+                    count += array.count_flips(square / 8, square % 8) > 0;
+            }
+            return count;
+        });
+        const auto bits_moves_us = tool::measure_us([&] {
+            uint64_t count = 0;
+            for (const auto &position : midgames)
+                count += std::popcount(position.get_moves());
+            return count;
+        });
+        printf("%-28s %9.2f us %9.2f us %7.1fx\n", "moves of 64 midgames", array_moves_us, bits_moves_us,
+               array_moves_us / bits_moves_us);
+    }
+
+    // Search speed on midgame positions, and how deep it gets on a budget of nodes like a move on the device gets.
+    {
+        Search search;
+        constexpr uint64_t NODES_PER_MOVE = 20000;
+        uint64_t nodes = 0;
+        int depths = 0;
+        constexpr int POSITIONS = 50;
+        const auto start = clock::now();
+        for (int i = 0; i < POSITIONS; i++) {
+            const auto position = play_random(rng, 20);
+            if (position.get_moves() == 0)
+                continue;
+            const auto first = search.get_nodes();
+            search.start(position);
+            search.think([&] { return search.get_nodes() - first >= NODES_PER_MOVE; });
+            nodes += search.get_nodes() - first;
+            depths += search.get_depth();
+        }
+        const std::chrono::duration<double> elapsed = clock::now() - start;
+        printf("\nSearch: %.0f nodes/s, depth %.1f on average with %llu nodes per move\n", nodes / elapsed.count(),
+               double(depths) / POSITIONS, (unsigned long long) NODES_PER_MOVE);
+    }
+
+    // The search against a random player, as a sanity check of its play.
+    {
+        Search search;
+        int wins = 0;
+        int losses = 0;
+        constexpr int GAMES = 40;
+        for (int game = 0; game < GAMES; game++) {
+            auto position = Position::initial();
+            bool search_to_move = game % 2 == 0;
+            while (!position.is_game_over()) {
+                auto moves = position.get_moves();
+                if (moves == 0) {
+                    position = position.pass();
+                }
+                else if (search_to_move) {
+                    const auto first = search.get_nodes();
+                    search.start(position);
+                    search.think([&] { return search.get_nodes() - first >= 5000; });
+                    position = position.play(search.get_best_move());
+                }
+                else {
+                    for (int skip = rng() % std::popcount(moves); skip > 0; skip--)
+                        moves &= moves - 1;
+                    position = position.play(std::countr_zero(moves));
+                }
+                search_to_move = !search_to_move;
+            }
+            // The side to move at the end is the search if `search_to_move`.
+            const int difference = std::popcount(position.player) - std::popcount(position.opponent);
+            const int search_difference = search_to_move ? difference : -difference;
+            wins += search_difference > 0;
+            losses += search_difference < 0;
+        }
+        printf("Search: %d wins, %d losses out of %d games against random moves\n", wins, losses, GAMES);
+        CHECK(wins > losses * 4, "Search plays too weakly");
+    }
+
+    printf("Allocations: %zu\n", tool::get_allocations() - allocations);
+    if (tool::get_failures() > 0 || tool::get_allocations() != allocations) {
+        printf("! %d differences\n", tool::get_failures());
+        return 1;
+    }
+    return 0;
+}
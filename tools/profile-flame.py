@@ -0,0 +1,122 @@
+"""
+Profile the badge through its data port and write the result as folded stacks, for a flame chart.
+
+Runs the profiler (see badge/profiler.hpp and the `profile` command in usb/remote.hpp) for a number of frames while
+the badge is used as usual, then writes one line per path of zones with the microseconds spent in it, like
+`frame;draw;font 123456`. The root, `frame`, holds the time outside of any zone, mostly sleeping between frames.
+The output can be opened in https://www.speedscope.app or drawn with flamegraph.pl. Example:
+
+    python3 tools/profile-flame.py /dev/ttyACM1 profile.folded --frames 300
+
+Needs pyserial.
+"""
+import argparse
+import struct
+
+import serial
+
+PACKET_MAGIC = b'BM'
+PACKET_ACK = 3
+PACKET_PROFILE = 4
+PROFILE_PATH = 0
+PROFILE_SAMPLE = 1
+HEADER = struct.Struct('<2sBBII')
+PROFILE_PATH_HEADER = struct.Struct('<BB')
+PROFILE_SAMPLE_HEADER = struct.Struct('<II')
+
+
+class Port:
+
+    def __init__(self, name):
+        self.serial = serial.Serial(name, timeout=10)
+        self.serial.reset_input_buffer()
+        self.buffer = bytearray()
+
+    def read(self, n):
+        while len(self.buffer) < n:
+            data = self.serial.read(max(n - len(self.buffer), 1))
+            if not data:
+                raise TimeoutError('No reply from the badge')
+            self.buffer += data
+        data = bytes(self.buffer[:n])
+        del self.buffer[:n]
+        return data
+
+    def read_packet(self):
+        # Skip anything before the next packet header, e.g. screen mirroring data from before the port was opened.
+        while True:
+            while len(self.buffer) < len(PACKET_MAGIC):
+                self.buffer += self.read(1)
+            if self.buffer.startswith(PACKET_MAGIC):
+                break
+            del self.buffer[:1]
+        _, kind, flags, number, size = HEADER.unpack(self.read(HEADER.size))
+        return kind, flags, number, self.read(size)
+
+
+class Profile:
+
+    def __init__(self):
+        self.paths = {0: (None, 'frame')}
+        self.totals = {}
+        self.frames = 0
+        self.frame_us = 0
+
+    def add_path(self, payload):
+        path, parent = PROFILE_PATH_HEADER.unpack_from(payload)
+        self.paths[path] = (parent, payload[PROFILE_PATH_HEADER.size:].decode())
+
+    def add_sample(self, payload):
+        frame_us, busy_us = PROFILE_SAMPLE_HEADER.unpack_from(payload)
+        times = payload[PROFILE_SAMPLE_HEADER.size:]
+        self.totals[0] = self.totals.get(0, 0) + frame_us - busy_us
+        for i, (us,) in enumerate(struct.iter_unpack('<H', times)):
+            self.totals[i + 1] = self.totals.get(i + 1, 0) + us
+        self.frames += 1
+        self.frame_us += frame_us
+
+    def stack(self, path):
+        names = []
+        while path is not None:
+            path, name = self.paths[path]
+            names.append(name)
+        return ';'.join(reversed(names))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', help='Serial port of the badge data port')
+    parser.add_argument('output', help='File to write the folded stacks to')
+    parser.add_argument('--frames', type=int, default=300, help='Number of frames to profile')
+    args = parser.parse_args()
+
+    port = Port(args.port)
+    profile = Profile()
+    port.serial.write(b'profile on\n')
+    try:
+        while profile.frames < args.frames:
+            kind, flags, _, payload = port.read_packet()
+            if kind == PACKET_ACK and payload[0] != 0:
+                raise SystemExit('Badge rejected the profile command')
+            if kind != PACKET_PROFILE:
+                continue
+            if flags == PROFILE_PATH:
+                profile.add_path(payload)
+            elif flags == PROFILE_SAMPLE:
+                profile.add_sample(payload)
+    finally:
+        port.serial.write(b'profile off\n')
+
+    with open(args.output, 'w') as f:
+        for path, total in sorted(profile.totals.items()):
+            if total > 0:
+                f.write(f'{profile.stack(path)} {total}\n')
+
+    print(f'{profile.frames} frames, {profile.frame_us / profile.frames / 1000:.1f} ms each')
+    for path, total in sorted(profile.totals.items(), key=lambda item: -item[1]):
+        if total > 0:
+            print(f'{profile.stack(path):<32} {total / profile.frames / 1000:>8.2f} ms/frame')
+
+
+if __name__ == '__main__':
+    main()
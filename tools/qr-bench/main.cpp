@@ -0,0 +1,171 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <ui/qr_code_encoder.hpp>
+#include <tools/common/tool.hpp>
+
+using namespace ui::qr;
+
+
+// The penalty rules evaluated one module at a time, straight from the standard, as a baseline.
+int get_penalty_by_module(const Matrix &modules) {
+    const int size = modules.size;
+    int penalty = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        auto get = [&](int line, int i) {
+            if (i < 0 || i >= size)
+                return false;
+            return pass == 0 ? modules.get(i, line) : modules.get(line, i);
+        };
+        for (int line = 0; line < size; line++) {
+            int run = 1;
+            for (int i = 1; i <= size; i++) {
+                if (i < size && get(line, i) == get(line, i - 1)) {
+                    run++;
+                    continue;
+                }
+                if (run >= 5)
+                    penalty += 3 + (run - 5);
+                run = 1;
+            }
+
+            for (int i = 0; i + 7 <= size; i++) {
+                constexpr bool FINDER[] = {true, false, true, true, true, false, true};
+                bool match = true;
+                for (int j = 0; j < 7; j++)
+                    match = match && get(line, i + j) == FINDER[j];
+                if (!match)
+                    continue;
+                bool light_before = true;
+                bool light_after = true;
+                for (int j = 1; j <= 4; j++) {
+                    light_before = light_before && !get(line, i - j);
+                    light_after = light_after && !get(line, i + 6 + j);
+                }
+                penalty += 40 * (light_before + light_after);
+            }
+        }
+    }
+
+    for (int y = 0; y + 1 < size; y++) {
+        for (int x = 0; x + 1 < size; x++) {
+            const auto color = modules.get(x, y);
+            if (modules.get(x + 1, y) == color && modules.get(x, y + 1) == color && modules.get(x + 1, y + 1) == color)
+                penalty += 3;
+        }
+    }
+
+    int dark = 0;
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+            dark += modules.get(x, y);
+    penalty += 10 * (std::abs(dark * 20 - size * size * 10) / (size * size));
+    return penalty;
+}
+
+
+constexpr const char *EC_NAMES = "LMQH";
+
+
+// Read `<version> <ec> <mask> <content>` lines and print the size and rows of each encoded matrix, for
+// tools/qr-check.py. Version 0 and mask -1 pick them automatically.
+int encode_lines() {
+    char line[1024];
+    while (fgets(line, sizeof(line), stdin)) {
+        int version;
+        char ec;
+        int mask;
+        int offset;
+        if (sscanf(line, "%d %c %d%n", &version, &ec, &mask, &offset) != 3 || !strchr(EC_NAMES, ec))
+            return 1;
+        std::string_view content = line + offset + 1;
+        if (content.ends_with('\n'))
+            content.remove_suffix(1);
+
+        const auto modules = encode(Version(version), ErrorCorrection(strchr(EC_NAMES, ec) - EC_NAMES), content, mask);
+        printf("%d\n", modules.size);
+        for (int y = 0; y < modules.size; y++) {
+            for (int x = 0; x < modules.size; x++)
+                putchar(modules.get(x, y) ? '1' : '0');
+            putchar('\n');
+        }
+    }
+    return 0;
+}
+
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--encode") == 0)
+        return encode_lines();
+
+    constexpr std::string_view CONTENTS[] = {
+            "https://hack.gbgay.com/",
+            "HELLO WORLD",
+            "3141592653589793238462643383279502884197169399375105820974944592",
+            "The quick brown fox jumps over the lazy dog",
+    };
+
+    // Check the word-wide penalty against the baseline for every mask, and that the best mask is picked.
+    int checked = 0;
+    for (int version = 1; version <= ui::qr::data::MAX_VERSION; version++) {
+        for (int ec = 0; ec < 4; ec++) {
+            for (const auto content : CONTENTS) {
+                const auto auto_masked = encode(Version(version), ErrorCorrection(ec), content);
+                if (auto_masked.size == 0)
+                    continue;
+                int best = -1;
+                for (int mask = 0; mask < 8; mask++) {
+                    const auto modules = encode(Version(version), ErrorCorrection(ec), content, mask);
+                    const auto expected = get_penalty_by_module(modules);
+                    if (internal::get_penalty(modules) != expected || get_mask(modules) != mask) {
+                        printf("! Penalty differs for V%d-%c mask %d\n", version, EC_NAMES[ec], mask);
+                        return 1;
+                    }
+                    if (best < 0 || expected < best)
+                        best = expected;
+                    checked++;
+                }
+                if (get_penalty_by_module(auto_masked) != best) {
+                    printf("! Mask with the lowest penalty not picked for V%d-%c\n", version, EC_NAMES[ec]);
+                    return 1;
+                }
+            }
+        }
+    }
+    std::string long_text;
+    while (long_text.size() < 400)
+        long_text += CONTENTS[3];
+
+    printf("Penalty scores match the baseline for %d matrices\n\n", checked);
+
+    printf("%8s %14s %14s %8s %12s %12s %12s\n", "version", "score/module", "score/word", "speedup", "fixed mask",
+           "auto mask", "allocations");
+    for (int version = 1; version <= ui::qr::data::MAX_VERSION; version++) {
+        // Fill the version up to its capacity.
+        auto content = std::string_view(long_text);
+        while (!fits(Version(version), ErrorCorrection::LOW, content))
+            content.remove_suffix(1);
+        const auto modules = encode(Version(version), ErrorCorrection::LOW, content);
+
+        const auto by_module = tool::measure_us([&] { return get_penalty_by_module(modules); }, 16);
+        const auto by_word = tool::measure_us([&] { return internal::get_penalty(modules); }, 16);
+
+        const auto allocations = tool::get_allocations();
+        const auto fixed_mask = tool::measure_us([&] {
+            return encode(Version(version), ErrorCorrection::LOW, content, 0).size;
+        }, 16);
+        const auto auto_mask = tool::measure_us([&] {
+            return encode(Version(version), ErrorCorrection::LOW, content).size;
+        }, 16);
+
+        printf("%6d-L %11.2f us %11.2f us %7.1fx %9.1f us %9.1f us %12zu\n", version, by_module, by_word,
+               by_module / by_word, fixed_mask, auto_mask, tool::get_allocations() - allocations);
+        if (tool::get_allocations() != allocations)
+            return 1;
+    }
+    return 0;
+}
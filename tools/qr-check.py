@@ -0,0 +1,366 @@
+"""
+Check the QR code encoder in ui/ by decoding its output with an independent implementation of the standard, and by
+comparing it module for module against the segno encoder if that is installed.
+
+The encoder runs on the host through the `--encode` mode of tools/qr-bench:
+
+    cmake -S tools/qr-bench -B build/qr-bench && cmake --build build/qr-bench
+    python3 tools/qr-check.py build/qr-bench/qr_bench
+"""
+import argparse
+import random
+import string
+import subprocess
+import sys
+
+MAX_VERSION = 10
+EC_LEVELS = 'LMQH'
+FORMAT_EC_BITS = {'L': 1, 'M': 0, 'Q': 3, 'H': 2}
+
+ALPHANUMERIC = '0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:'
+MODE_INDICATORS = {1: 'numeric', 2: 'alphanumeric', 4: 'byte'}
+COUNT_BITS = {'numeric': (10, 12), 'alphanumeric': (9, 11), 'byte': (8, 16)}
+
+# ISO/IEC 18004 table 9, versions 1 to 10.
+TOTAL_CODEWORDS = [26, 44, 70, 100, 134, 172, 196, 242, 292, 346]
+DATA_CODEWORDS = {
+    'L': [19, 34, 55, 80, 108, 136, 156, 194, 232, 274],
+    'M': [16, 28, 44, 64, 86, 108, 124, 154, 182, 216],
+    'Q': [13, 22, 34, 48, 62, 76, 88, 110, 132, 154],
+    'H': [9, 16, 26, 36, 46, 60, 66, 86, 100, 122],
+}
+BLOCKS = {
+    'L': [1, 1, 1, 1, 1, 2, 2, 2, 2, 4],
+    'M': [1, 1, 1, 2, 2, 4, 4, 4, 5, 5],
+    'Q': [1, 1, 2, 2, 4, 4, 6, 6, 8, 8],
+    'H': [1, 1, 2, 4, 4, 4, 5, 6, 8, 8],
+}
+
+MASKS = [
+    lambda i, j: (i + j) % 2 == 0,
+    lambda i, j: i % 2 == 0,
+    lambda i, j: j % 3 == 0,
+    lambda i, j: (i + j) % 3 == 0,
+    lambda i, j: (i // 2 + j // 3) % 2 == 0,
+    lambda i, j: (i * j) % 2 + (i * j) % 3 == 0,
+    lambda i, j: ((i * j) % 2 + (i * j) % 3) % 2 == 0,
+    lambda i, j: ((i + j) % 2 + (i * j) % 3) % 2 == 0,
+]
+
+
+# GF(256) with the QR polynomial x^8 + x^4 + x^3 + x^2 + 1.
+EXP = [0] * 512
+LOG = [0] * 256
+_x = 1
+for _i in range(255):
+    EXP[_i] = EXP[_i + 255] = _x
+    LOG[_x] = _i
+    _x <<= 1
+    if _x & 0x100:
+        _x ^= 0x11D
+
+
+def gf_mul(a, b):
+    return 0 if a == 0 or b == 0 else EXP[LOG[a] + LOG[b]]
+
+
+def rs_remainder(data, degree):
+    generator = [1]
+    for i in range(degree):
+        generator = [a ^ gf_mul(b, EXP[i]) for a, b in zip(generator + [0], [0] + generator)]
+    message = list(data) + [0] * degree
+    for i in range(len(data)):
+        factor = message[i]
+        for j, coefficient in enumerate(generator):
+            message[i + j] ^= gf_mul(coefficient, factor)
+    return message[len(data):]
+
+
+def bch(data, data_bits, generator, generator_bits):
+    value = data << (generator_bits - 1)
+    for bit in range(data_bits + generator_bits - 2, generator_bits - 2, -1):
+        if value >> bit & 1:
+            value ^= generator << (bit - generator_bits + 1)
+    return data << (generator_bits - 1) | value
+
+
+def format_bits(ec, mask):
+    return bch(FORMAT_EC_BITS[ec] << 3 | mask, 5, 0x537, 11) ^ 0x5412
+
+
+def version_bits(version):
+    return bch(version, 6, 0x1F25, 13)
+
+
+def alignment_positions(version):
+    if version == 1:
+        return []
+    size = 17 + 4 * version
+    n = version // 7 + 2
+    step = (version * 8 + n * 3 + 5) // (n * 4 - 4) * 2
+    return [6] + sorted(size - 7 - i * step for i in range(n - 1))
+
+
+def get_mode(content):
+    if all(c in string.digits for c in content):
+        return 'numeric'
+    if all(c in ALPHANUMERIC for c in content):
+        return 'alphanumeric'
+    return 'byte'
+
+
+def count_bits(version, mode):
+    return COUNT_BITS[mode][0 if version < 10 else 1]
+
+
+def required_bits(version, content):
+    mode = get_mode(content)
+    n = len(content)
+    if mode == 'numeric':
+        payload = 10 * (n // 3) + [0, 4, 7][n % 3]
+    elif mode == 'alphanumeric':
+        payload = 11 * (n // 2) + 6 * (n % 2)
+    else:
+        payload = 8 * len(content.encode())
+    return 4 + count_bits(version, mode) + payload
+
+
+def fits(version, ec, content):
+    return (len(content) < 1 << count_bits(version, get_mode(content))
+            and required_bits(version, content) <= DATA_CODEWORDS[ec][version - 1] * 8)
+
+
+class DecodeError(Exception):
+    pass
+
+
+def expect(condition, message):
+    if not condition:
+        raise DecodeError(message)
+
+
+def decode(matrix):
+    """Decode a matrix of 0/1 rows. Returns (version, ec, mask, mode, content)."""
+    size = len(matrix)
+    version = (size - 17) // 4
+    expect(size == 17 + 4 * version and 1 <= version <= MAX_VERSION, f'invalid size {size}')
+
+    def module(x, y):
+        return matrix[y][x]
+
+    function = [[False] * size for _ in range(size)]
+
+    def check_area(x0, y0, pattern):
+        for dy, row in enumerate(pattern):
+            for dx, dark in enumerate(row):
+                expect(module(x0 + dx, y0 + dy) == dark, f'function pattern at ({x0 + dx}, {y0 + dy})')
+
+    def reserve(x0, y0, width, height):
+        for y in range(y0, y0 + height):
+            for x in range(x0, x0 + width):
+                function[y][x] = True
+
+    finder = [[int(max(abs(x - 3), abs(y - 3)) != 2) for x in range(7)] for y in range(7)]
+    check_area(0, 0, finder)
+    check_area(size - 7, 0, finder)
+    check_area(0, size - 7, finder)
+    check_area(7, 0, [[0]] * 8)
+    check_area(0, 7, [[0] * 8])
+    check_area(size - 8, 0, [[0]] * 8)
+    check_area(size - 8, 7, [[0] * 8])
+    check_area(7, size - 8, [[0]] * 8)
+    check_area(0, size - 8, [[0] * 8])
+    reserve(0, 0, 9, 9)
+    reserve(size - 8, 0, 8, 9)
+    reserve(0, size - 8, 9, 8)
+
+    for i in range(8, size - 8):
+        expect(module(i, 6) == (i % 2 == 0), f'timing pattern at ({i}, 6)')
+        expect(module(6, i) == (i % 2 == 0), f'timing pattern at (6, {i})')
+        function[6][i] = function[i][6] = True
+
+    alignment = [[int(max(abs(x - 2), abs(y - 2)) != 1) for x in range(5)] for y in range(5)]
+    positions = alignment_positions(version)
+    for cy in positions:
+        for cx in positions:
+            if (cx, cy) in ((6, 6), (6, size - 7), (size - 7, 6)):
+                continue
+            check_area(cx - 2, cy - 2, alignment)
+            reserve(cx - 2, cy - 2, 5, 5)
+
+    expect(module(8, size - 8) == 1, 'dark module')
+
+    if version >= 7:
+        bits = version_bits(version)
+        for i in range(18):
+            expect(module(size - 11 + i % 3, i // 3) == bits >> i & 1, 'version information (top right)')
+            expect(module(i // 3, size - 11 + i % 3) == bits >> i & 1, 'version information (bottom left)')
+        reserve(size - 11, 0, 3, 6)
+        reserve(0, size - 11, 6, 3)
+
+    first = [(8, i) for i in range(6)] + [(8, 7), (8, 8), (7, 8)] + [(i, 8) for i in range(5, -1, -1)]
+    second = [(size - 1 - i, 8) for i in range(8)] + [(8, size - 7 + i) for i in range(7)]
+    first_bits = sum(module(x, y) << i for i, (x, y) in enumerate(first))
+    second_bits = sum(module(x, y) << i for i, (x, y) in enumerate(second))
+    expect(first_bits == second_bits, 'format information copies differ')
+    matches = [(ec, mask) for ec in EC_LEVELS for mask in range(8) if format_bits(ec, mask) == first_bits]
+    expect(len(matches) == 1, f'invalid format information {first_bits:015b}')
+    ec, mask = matches[0]
+
+    bits = []
+    for right in range(size - 1, 0, -2):
+        if right <= 6:
+            right -= 1
+        upwards = ((right + 1) & 2) == 0
+        for step in range(size):
+            y = size - 1 - step if upwards else step
+            for x in (right, right - 1):
+                if not function[y][x]:
+                    bits.append(module(x, y) ^ MASKS[mask](y, x))
+
+    total = TOTAL_CODEWORDS[version - 1]
+    codewords = [int(''.join(map(str, bits[i * 8:i * 8 + 8])), 2) for i in range(total)]
+    expect(not any(bits[total * 8:]), 'remainder bits are not zero')
+
+    n_blocks = BLOCKS[ec][version - 1]
+    n_data = DATA_CODEWORDS[ec][version - 1]
+    n_ec = (total - n_data) // n_blocks
+    expect(n_ec * n_blocks == total - n_data, 'inconsistent block table')
+    n_short = n_blocks - n_data % n_blocks
+    lengths = [n_data // n_blocks + (b >= n_short) for b in range(n_blocks)]
+    blocks = [[] for _ in range(n_blocks)]
+    pos = 0
+    for i in range(max(lengths)):
+        for b in range(n_blocks):
+            if i < lengths[b]:
+                blocks[b].append(codewords[pos])
+                pos += 1
+    ec_blocks = [[] for _ in range(n_blocks)]
+    for i in range(n_ec):
+        for b in range(n_blocks):
+            ec_blocks[b].append(codewords[pos])
+            pos += 1
+    for b in range(n_blocks):
+        expect(rs_remainder(blocks[b], n_ec) == ec_blocks[b], f'error correction of block {b} is wrong')
+
+    data = [bit for word in sum(blocks, []) for bit in f'{word:08b}']
+    pos = 0
+
+    def read(n):
+        nonlocal pos
+        expect(pos + n <= len(data), 'data ends early')
+        pos += n
+        return int(''.join(data[pos - n:pos]) or '0', 2)
+
+    mode = MODE_INDICATORS.get(read(4))
+    expect(mode is not None, 'unknown mode')
+    length = read(count_bits(version, mode))
+    if mode == 'numeric':
+        content = ''
+        while len(content) < length:
+            n = min(3, length - len(content))
+            content += str(read(n * 3 + 1)).zfill(n)
+    elif mode == 'alphanumeric':
+        content = ''
+        while len(content) < length:
+            if length - len(content) >= 2:
+                value = read(11)
+                content += ALPHANUMERIC[value // 45] + ALPHANUMERIC[value % 45]
+            else:
+                content += ALPHANUMERIC[read(6)]
+    else:
+        content = bytes(read(8) for _ in range(length)).decode()
+
+    terminator = min(4, len(data) - pos)
+    expect(read(terminator) == 0, 'missing terminator')
+    pos = (pos + 7) // 8 * 8
+    for i, pad in enumerate(range(pos, len(data), 8)):
+        expect(int(''.join(data[pad:pad + 8]), 2) == (236, 17)[i % 2], 'invalid padding')
+
+    return version, ec, mask, mode, content
+
+
+def make_cases(rng):
+    fixed = [
+        'https://hack.gbgay.com/',
+        'HTTPS://HACK.GBGAY.COM/',
+        'HELLO WORLD',
+        '01234567',
+        '0', '12', '123', '1234',
+        'A', 'AB', 'ABC',
+        'BEGIN:VCARD\nVERSION:3.0\nN:Badge;Hacker\nTEL:+46700000000\nEMAIL:hacker@example.com\nEND:VCARD'
+        .replace('\n', ';'),
+        'https://hack.gbgay.com/flag?value=0123456789abcdef0123456789abcdef',
+    ]
+    cases = []
+    for content in fixed:
+        for ec in EC_LEVELS:
+            cases.append((0, ec, -1, content))
+            for version in range(1, MAX_VERSION + 1):
+                if fits(version, ec, content):
+                    cases.append((version, ec, rng.randrange(8), content))
+    alphabets = [string.digits, ALPHANUMERIC, string.ascii_letters + string.digits + string.punctuation + ' ']
+    for _ in range(400):
+        alphabet = rng.choice(alphabets)
+        length = rng.randrange(0, 300)
+        content = ''.join(rng.choice(alphabet) for _ in range(length)).strip()
+        cases.append((0, rng.choice(EC_LEVELS), rng.choice([-1, rng.randrange(8)]), content))
+    return cases
+
+
+def run_encoder(encoder, cases):
+    lines = ''.join(f'{version} {ec} {mask} {content}\n' for version, ec, mask, content in cases)
+    output = subprocess.run([encoder, '--encode'], input=lines, capture_output=True, text=True, check=True).stdout
+    output = output.splitlines()
+    matrices = []
+    pos = 0
+    for _ in cases:
+        size = int(output[pos])
+        matrices.append([[int(c) for c in row] for row in output[pos + 1:pos + 1 + size]])
+        pos += 1 + size
+    return matrices
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('encoder', help='qr_bench executable')
+    parser.add_argument('--seed', type=int, default=1, help='Seed for the random test cases')
+    args = parser.parse_args()
+
+    cases = make_cases(random.Random(args.seed))
+    matrices = run_encoder(args.encoder, cases)
+
+    try:
+        import segno
+    except ImportError:
+        segno = None
+        print('segno is not installed, only checking with the decoder')
+
+    failures = 0
+    for (version, ec, mask, content), matrix in zip(cases, matrices):
+        name = f'V{version or "auto"}-{ec} mask {mask} {content!r}'
+        expected_version = version or next((v for v in range(1, MAX_VERSION + 1) if fits(v, ec, content)), None)
+        try:
+            if expected_version is None or not fits(expected_version, ec, content):
+                expect(not matrix, 'content does not fit, but a code was generated')
+                continue
+            decoded = decode(matrix)
+            expect(decoded[0] == expected_version, f'version {decoded[0]}, expected {expected_version}')
+            expect(decoded[1] == ec, f'error correction level {decoded[1]}')
+            expect(mask < 0 or decoded[2] == mask, f'mask {decoded[2]}')
+            expect(decoded[3] == get_mode(content), f'{decoded[3]} mode, expected {get_mode(content)}')
+            expect(decoded[4] == content, f'decoded {decoded[4]!r}')
+            if segno:
+                reference = segno.make_qr(content, version=decoded[0], error=ec.lower(), mode=decoded[3],
+                                          mask=decoded[2], boost_error=False)
+                expect([list(row) for row in reference.matrix] == matrix, 'differs from segno')
+        except DecodeError as e:
+            print(f'! {name}: {e}')
+            failures += 1
+
+    print(f'{len(cases) - failures} of {len(cases)} codes OK')
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include <badge/badge-2025.h>
+#include <games/blocks_game.hpp>
+#include <games/snek_game.hpp>
+#include <utils/input_log.hpp>
+#include <tools/common/tool.hpp>
+
+
+/// Same size as a replay slot on the badge.
+constexpr size_t LOG_SIZE = 16 * 1024;
+
+constexpr int FRAME_INTERVAL_MS = 30;
+
+/// Stops a game that goes on for too long, at an hour of play.
+constexpr int MAX_TICKS = 60 * 60 * 1000 / FRAME_INTERVAL_MS;
+
+constexpr uint32_t BUTTONS[] = {
+    1 << BTN_UP, 1 << BTN_DOWN, 1 << BTN_LEFT, 1 << BTN_RIGHT, 1 << BTN_PUSH,
+    1 << BTN_A, 1 << BTN_B, 1 << BTN_C, 1 << BTN_D,
+};
+
+/// A player that holds one button at a time, for a few ticks, and lets go for a while in between. With `jitter`, the
+/// frame time wobbles like it does on the badge.
+struct Player {
+    std::mt19937 rng;
+    int directions_only;
+    bool jitter;
+    uint32_t held = 0;
+
+    uint32_t buttons() {
+        if (rng() % 6 == 0)
+            held = held == 0 ? BUTTONS[rng() % (directions_only ? 4 : std::size(BUTTONS))] : 0;
+        return held;
+    }
+
+    int delta_ms() { return jitter ? FRAME_INTERVAL_MS + static_cast<int>(rng() % 3) - 1 : FRAME_INTERVAL_MS; }
+};
+
+struct Result {
+    std::span<const uint8_t> log;
+    uint32_t ticks = 0;
+};
+
+/// Play a blocks game as the UI does, recording it. Leaves the final game in `game`.
+Result record_blocks(blocks::Game &game, Player &player, std::span<uint8_t> buffer, uint32_t seed) {
+    utils::InputLogWriter writer;
+    uint32_t previous = player.buttons();
+    writer.start(buffer, blocks::REPLAY_ID, seed, previous);
+    game.reset(seed);
+    while (!game.is_game_over() && writer.get_ticks() < MAX_TICKS) {
+        const auto held = player.buttons();
+        const auto delta_ms = player.delta_ms();
+        writer.record(held, delta_ms);
+        blocks::play_tick(game, held, held & ~previous, delta_ms);
+        previous = held;
+    }
+    return {writer.finish(game.get_score()), writer.get_ticks()};
+}
+
+Result record_snek(snek::Game &game, Player &player, std::span<uint8_t> buffer, uint32_t seed) {
+    utils::InputLogWriter writer;
+    writer.start(buffer, snek::REPLAY_ID, seed, 0);
+    game.reset(seed);
+    while (!game.is_dead() && writer.get_ticks() < MAX_TICKS) {
+        const auto held = player.buttons();
+        const auto delta_ms = player.delta_ms();
+        writer.record(held, delta_ms);
+        snek::play_tick(game, held, delta_ms);
+    }
+    return {writer.finish(game.get_score()), writer.get_ticks()};
+}
+
+/// Replay a blocks log by hand, to compare the whole game rather than just the score.
+blocks::Game replay_blocks(std::span<const uint8_t> log, uint32_t &ticks) {
+    utils::InputLogReader reader(log);
+    blocks::Game game;
+    game.reset(reader.get_header().seed);
+    auto previous = reader.get_header().buttons;
+    uint32_t held;
+    int delta_ms;
+    for (ticks = 0; reader.next(held, delta_ms); ticks++) {
+        blocks::play_tick(game, held, held & ~previous, delta_ms);
+        previous = held;
+    }
+    return game;
+}
+
+snek::Game replay_snek(std::span<const uint8_t> log, uint32_t &ticks) {
+    utils::InputLogReader reader(log);
+    snek::Game game;
+    game.reset(reader.get_header().seed);
+    uint32_t held;
+    int delta_ms;
+    for (ticks = 0; reader.next(held, delta_ms); ticks++)
+        snek::play_tick(game, held, delta_ms);
+    return game;
+}
+
+void compare(const blocks::Game &game, const blocks::Game &replayed) {
+    for (int r = 0; r < blocks::FIELD_HEIGHT; r++)
+        CHECK(game.get_field().get_row(r) == replayed.get_field().get_row(r), "Blocks row %d differs", r);
+    CHECK(game.get_score() == replayed.get_score(), "Blocks score is %d, expected %d", replayed.get_score(),
+          game.get_score());
+    CHECK(game.get_pieces_placed() == replayed.get_pieces_placed(), "Blocks pieces placed differ");
+    CHECK(game.get_current_piece() == replayed.get_current_piece() &&
+              game.get_current_row() == replayed.get_current_row() &&
+              game.get_current_col() == replayed.get_current_col() &&
+              game.get_current_rotation() == replayed.get_current_rotation(),
+          "Blocks current piece differs");
+    CHECK(game.is_game_over() == replayed.is_game_over(), "Blocks game over differs");
+}
+
+void compare(const snek::Game &game, const snek::Game &replayed) {
+    for (int cell = 0; cell < snek::GRID_CELLS; cell++)
+        CHECK(game.get(cell) == replayed.get(cell), "Snek cell %d differs", cell);
+    CHECK(game.get_score() == replayed.get_score(), "Snek score is %d, expected %d", replayed.get_score(),
+          game.get_score());
+    CHECK(game.get_length() == replayed.get_length(), "Snek length differs");
+    CHECK(game.is_dead() == replayed.is_dead(), "Snek dead differs");
+}
+
+/// Damaged logs must be rejected or replay to something, but never crash or read out of bounds.
+template<typename F>
+void check_damage(std::span<const uint8_t> log, std::mt19937 &rng, F &&replay) {
+    CHECK(replay(log.first(log.size() / 2)) == -1, "Truncated log was accepted");
+    CHECK(replay(log.first(10)) == -1, "Log without a header was accepted");
+    static std::array<uint8_t, LOG_SIZE> copy;
+    std::copy(log.begin(), log.end(), copy.begin());
+    constexpr auto HEADER_SIZE = sizeof(utils::input_log::Header);
+    for (int i = 0; i < 20; i++) {
+        copy[HEADER_SIZE + rng() % (log.size() - HEADER_SIZE)] ^= 1 << rng() % 8;
+        (void)replay(std::span(copy).first(log.size()));
+    }
+}
+
+
+struct Totals {
+    int games = 0;
+    int overflows = 0;
+    uint64_t ticks = 0;
+    uint64_t bytes = 0;
+    uint32_t longest = 0;
+    std::span<const uint8_t> longest_log;
+};
+
+template<typename G, typename Record, typename ReplayByHand, typename Replay>
+void check_game(const char *name, bool jitter, std::mt19937 &rng, Record &&record, ReplayByHand &&replay_by_hand,
+                Replay &&replay) {
+    static std::array<uint8_t, LOG_SIZE> buffer;
+    static std::array<uint8_t, LOG_SIZE> longest_buffer;
+    const auto allocations = tool::get_allocations();
+
+    Totals totals;
+    for (int i = 0; i < 300; i++) {
+        Player player{std::mt19937(rng()), std::is_same_v<G, snek::Game>, jitter};
+        G game;
+        const auto seed = rng();
+        const auto [log, ticks] = record(game, player, buffer, seed);
+        totals.games++;
+        if (log.empty()) {
+            totals.overflows++;
+            continue;
+        }
+        totals.ticks += ticks;
+        totals.bytes += log.size();
+
+        uint32_t replayed_ticks;
+        const auto replayed = replay_by_hand(log, replayed_ticks);
+        CHECK(replayed_ticks == ticks, "%s replayed %u ticks, expected %u", name, replayed_ticks, ticks);
+        compare(game, replayed);
+        CHECK(replay(log) == game.get_score(), "%s replay() does not match", name);
+
+        if (ticks > totals.longest) {
+            totals.longest = ticks;
+            std::copy(log.begin(), log.end(), longest_buffer.begin());
+            totals.longest_log = {longest_buffer.data(), log.size()};
+        }
+    }
+    check_damage(totals.longest_log, rng, replay);
+
+    const double minutes = totals.ticks * FRAME_INTERVAL_MS / 60000.0;
+    const auto replay_us = tool::measure_us([&] { return replay(totals.longest_log); });
+    const double realtime_us = totals.longest * FRAME_INTERVAL_MS * 1000.0;
+    printf("%-6s %-9s %5d %9.1f %9.0f %11.2f %9u %11.0f %9.0fx\n", name, jitter ? "jitter" : "steady", totals.games,
+           minutes, totals.bytes / minutes, replay_us / 1000, totals.longest, totals.longest / replay_us * 1e6,
+           realtime_us / replay_us);
+    CHECK(totals.overflows == 0, "%s: %d of %d logs did not fit", name, totals.overflows, totals.games);
+    CHECK(tool::get_allocations() == allocations, "%s allocated %zu times", name, tool::get_allocations() - allocations);
+}
+
+int main() {
+    std::mt19937 rng(0x5EED);
+
+    // Basic round trip of the format: no records at all, and large values.
+    {
+        uint8_t buffer[64];
+        utils::InputLogWriter writer;
+        writer.start(buffer, 7, 1234, 0);
+        const auto empty = writer.finish(0);
+        utils::InputLogReader reader(empty);
+        uint32_t held;
+        int delta_ms;
+        CHECK(reader.is_valid() && !reader.next(held, delta_ms), "Empty log round trip");
+
+        writer.start(buffer, 7, 1234, 0);
+        for (int i = 0; i < 300; i++)
+            writer.record(i < 200 ? 0 : 1u << 30, i < 100 ? 0 : 100000);
+        const auto log = writer.finish(42);
+        utils::InputLogReader large(log);
+        CHECK(large.is_valid() && large.get_header().ticks == 300 && large.get_header().score == 42, "Large header");
+        for (int i = 0; large.next(held, delta_ms); i++)
+            CHECK(held == (i < 200 ? 0 : 1u << 30) && delta_ms == (i < 100 ? 0 : 100000), "Large tick %d", i);
+
+        writer.start({buffer, 30}, 7, 1234, 0);
+        bool fits = true;
+        for (int i = 0; i < 100; i++)
+            fits = writer.record(i, 30) && fits;
+        CHECK(!fits && writer.finish(0).empty(), "Overflow was not reported");
+    }
+
+    // A whole game that outgrows its log leaves nothing to store, and `replays::finish()` then keeps the slot's old
+    // game and high score. The game itself plays on to its end.
+    {
+        static std::array<uint8_t, 512> buffer;
+        Player player{std::mt19937(rng()), false, true};
+        blocks::Game game;
+        const auto [log, ticks] = record_blocks(game, player, buffer, rng());
+        CHECK(log.empty() && game.is_game_over(), "Game of %u ticks overflowing its log was not reported", ticks);
+    }
+
+    printf("%-6s %-9s %5s %9s %9s %11s %9s %11s %10s\n", "game", "frames", "games", "minutes", "B/min", "replay ms",
+           "ticks", "ticks/s", "realtime");
+    for (const bool jitter : {false, true}) {
+        check_game<blocks::Game>("blocks", jitter, rng, record_blocks, replay_blocks, blocks::replay);
+        check_game<snek::Game>("snek", jitter, rng, record_snek, replay_snek, snek::replay);
+    }
+    CHECK(blocks::replay(std::span<const uint8_t>()) == -1, "Empty blocks log was accepted");
+
+    printf("Game sizes: blocks %zu, snek %zu bytes\n", sizeof(blocks::Game), sizeof(snek::Game));
+    if (tool::get_failures() > 0) {
+        printf("! %d failures\n", tool::get_failures());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include <games/snek_game.hpp>
+#include <tools/common/tool.hpp>
+
+using namespace snek;
+
+
+// The game as `SnekGame` played it before the ring buffer: the tail follows the directions in the grid, and fruit
+// placement scans the grid with reservoir sampling, drawing a random number per empty cell. This is the baseline
+// that `Game` has to match, given the same fruit.
+struct GridSnek {
+    std::array<CellState, GRID_CELLS> grid = {};
+    int head_u = 0;
+    int head_v = 0;
+    int tail_u = 0;
+    int tail_v = 0;
+    int length = 0;
+    int fruit_u = 0;
+    int fruit_v = 0;
+    CellState direction = {};
+    bool dead = false;
+
+    CellState &at(int u, int v) { return grid[v * GRID_WIDTH + u]; }
+
+    static std::pair<int, int> direction_to_du_dv(CellState dir) {
+        switch (dir) {
+            case CellState::UP: return {0, -1};
+            case CellState::DOWN: return {0, 1};
+            case CellState::LEFT: return {-1, 0};
+            case CellState::RIGHT: return {1, 0};
+            default: abort();
+        }
+    }
+
+    void reset() {
+        grid = {};
+        head_u = INITIAL_SNEK_U;
+        head_v = INITIAL_SNEK_V;
+        tail_u = head_u - INITIAL_SNEK_LENGTH + 1;
+        tail_v = head_v;
+        length = INITIAL_SNEK_LENGTH;
+        fruit_u = GRID_WIDTH * 3 / 4;
+        fruit_v = GRID_HEIGHT * 3 / 4;
+        direction = CellState::RIGHT;
+        dead = false;
+        at(head_u, head_v) = CellState::HEAD;
+        for (int i = 1; i < length; i++)
+            at(head_u - i, head_v) = CellState::RIGHT;
+        at(fruit_u, fruit_v) = CellState::FRUIT;
+    }
+
+    /// Returns true if the snake ate the fruit, leaving the caller to place the next one.
+    bool advance() {
+        auto &tail_state = at(tail_u, tail_v);
+        const auto [head_du, head_dv] = direction_to_du_dv(direction);
+        const auto [tail_du, tail_dv] = direction_to_du_dv(tail_state);
+        const int new_head_u = (head_u + GRID_WIDTH + head_du) % GRID_WIDTH;
+        const int new_head_v = (head_v + GRID_HEIGHT + head_dv) % GRID_HEIGHT;
+        auto &new_head = at(new_head_u, new_head_v);
+
+        bool ate_fruit = false;
+        if (new_head == CellState::FRUIT) {
+            new_head = CellState::EMPTY;
+            ate_fruit = true;
+        }
+        else {
+            tail_state = CellState::EMPTY;
+            tail_u = (tail_u + GRID_WIDTH + tail_du) % GRID_WIDTH;
+            tail_v = (tail_v + GRID_HEIGHT + tail_dv) % GRID_HEIGHT;
+        }
+
+        if (new_head == CellState::EMPTY) {
+            at(head_u, head_v) = direction;
+            new_head = CellState::HEAD;
+            head_u = new_head_u;
+            head_v = new_head_v;
+        }
+        else {
+            dead = true;
+            at(fruit_u, fruit_v) = CellState::EMPTY;
+            return false;
+        }
+        if (ate_fruit)
+            length++;
+        return ate_fruit;
+    }
+
+    void place_fruit(std::mt19937 &rng) {
+        int n = 0;
+        for (int u = 0; u < GRID_WIDTH; u++) {
+            for (int v = 0; v < GRID_HEIGHT; v++) {
+                if (at(u, v) != CellState::EMPTY)
+                    continue;
+                n++;
+                if (rng() % n == 0) {
+                    fruit_u = u;
+                    fruit_v = v;
+                }
+            }
+        }
+        at(fruit_u, fruit_v) = CellState::FRUIT;
+    }
+};
+
+/// Direction for move `i` of a sweep that runs along each row and then steps down to the next, which a snake can
+/// follow without running into itself until it is over 200 cells long.
+CellState sweep(int i) {
+    return i % GRID_WIDTH == GRID_WIDTH - 1 ? CellState::DOWN : CellState::RIGHT;
+}
+
+/// Steer and make exactly one move.
+void step(Game &game, CellState dir) {
+    game.steer(dir);
+    game.update(INITIAL_MOVE_INTERVAL + 100);
+}
+
+/// Play the sweep until the snake is `length` long. Returns the number of moves, to carry on the sweep from.
+int grow(Game &game, int length) {
+    int i = 0;
+    for (; game.get_length() < length && !game.is_dead(); i++)
+        step(game, sweep(i));
+    return i;
+}
+
+/// The new game must keep the same grid as the baseline, and the empty cells and the body in sync with it.
+void compare(const Game &game, const GridSnek &base) {
+    int empty = 0;
+    for (int cell = 0; cell < GRID_CELLS; cell++) {
+        CHECK(game.get(cell) == base.grid[cell], "Cell %d is %d, expected %d", cell, int(game.get(cell)),
+              int(base.grid[cell]));
+        empty += base.grid[cell] == CellState::EMPTY;
+    }
+    CHECK(game.is_dead() == base.dead, "Dead is wrong");
+    if (game.is_dead())
+        return;
+    CHECK(game.get_free_count() == empty, "Free count is %d, expected %d", game.get_free_count(), empty);
+    CHECK(game.get_length() == base.length, "Length is %d, expected %d", game.get_length(), base.length);
+    CHECK(game.get_head() == get_cell(base.head_u, base.head_v), "Head is wrong");
+    CHECK(game.get_tail() == get_cell(base.tail_u, base.tail_v), "Tail is wrong");
+}
+
+/// Play a game and the baseline side by side, with `choose(i)` picking the direction of move `i`.
+template<typename F>
+int play_lockstep(uint32_t seed, F &&choose) {
+    Game game;
+    GridSnek base;
+    game.reset(seed);
+    base.reset();
+    compare(game, base);
+    int moves = 0;
+    while (!game.is_dead() && moves < 100000) {
+        game.steer(choose(moves));
+        base.direction = game.get_direction();
+        game.update(INITIAL_MOVE_INTERVAL + 100);
+        if (base.advance()) {
+            base.fruit_u = get_u(game.get_fruit());
+            base.fruit_v = get_v(game.get_fruit());
+            base.at(base.fruit_u, base.fruit_v) = CellState::FRUIT;
+        }
+        compare(game, base);
+        moves++;
+    }
+    return moves;
+}
+
+
+int main() {
+    std::mt19937 rng(0x5EED);
+
+    // Random steering, dying early and often, and the sweep, growing long.
+    uint64_t moves = 0;
+    for (int i = 0; i < 2000; i++) {
+        moves += play_lockstep(rng(), [&](int) {
+            constexpr CellState DIRECTIONS[] = {CellState::UP, CellState::DOWN, CellState::LEFT, CellState::RIGHT};
+            return DIRECTIONS[rng() % 4];
+        });
+    }
+    int longest = 0;
+    for (int i = 0; i < 20; i++) {
+        const auto seed = rng();
+        moves += play_lockstep(seed, sweep);
+        Game game;
+        game.reset(seed);
+        grow(game, GRID_CELLS);
+        longest = std::max(longest, game.get_length());
+    }
+    printf("Compared %llu moves, the sweep grew up to %d long\n", (unsigned long long) moves, longest);
+
+    const auto allocations = tool::get_allocations();
+
+    // Late game ticks: a long snake sweeping the grid and eating every so often. Each call copies the game, so the
+    // baseline copies a grid of the same size to match.
+    printf("\n%-34s %10s %10s %8s\n", "operation", "baseline", "ring", "speedup");
+    for (const int length : {50, 150, 200}) {
+        Game game;
+        game.reset(rng());
+        const int game_moves = grow(game, length);
+        GridSnek base;
+        base.reset();
+        std::mt19937 base_rng(1);
+        int base_moves = 0;
+        for (; base.length < length && !base.dead; base_moves++) {
+            base.direction = sweep(base_moves);
+            if (base.advance())
+                base.place_fruit(base_rng);
+        }
+
+        constexpr int TICKS = 247;
+        const auto base_us = tool::measure_us([&] {
+            auto copy = base;
+            for (int i = 0; i < TICKS && !copy.dead; i++) {
+                copy.direction = sweep(base_moves + i);
+                if (copy.advance())
+                    copy.place_fruit(base_rng);
+            }
+            return copy.length;
+        });
+        const auto ring_us = tool::measure_us([&] {
+            auto copy = game;
+            for (int i = 0; i < TICKS; i++)
+                step(copy, sweep(game_moves + i));
+            return copy.get_length();
+        });
+        CHECK(!game.is_dead() && !base.dead, "The sweep died before growing %d long", length);
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d ticks, %d long", TICKS, length);
+        printf("%-34s %7.2f us %7.2f us %7.1fx\n", label, base_us, ring_us, base_us / ring_us);
+
+        auto filled = base;
+        const auto place_us = tool::measure_us([&] {
+            filled.at(filled.fruit_u, filled.fruit_v) = CellState::EMPTY;
+            filled.place_fruit(base_rng);
+            return filled.fruit_u;
+        });
+        snprintf(label, sizeof(label), "baseline fruit placement, %d long", length);
+        printf("%-34s %7.2f us\n", label, place_us);
+    }
+
+    printf("Allocations: %zu\n", tool::get_allocations() - allocations);
+    if (tool::get_failures() > 0 || tool::get_allocations() != allocations) {
+        printf("! %d differences\n", tool::get_failures());
+        return 1;
+    }
+    return 0;
+}
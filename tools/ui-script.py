@@ -0,0 +1,153 @@
+"""
+Run a UI script on the badge through its data port and report frame timing.
+
+A script is a list of remote commands (see usb/remote.hpp), one per line. In addition, `mark <name>` starts a new
+section in the report, so the timing of e.g. a menu and a game can be told apart. The badge is paused while the
+script runs, so every run sees exactly the same frames. Example:
+
+    python3 tools/ui-script.py /dev/ttyACM1 tools/ui-scripts/menu-tour.txt --json timing.json
+
+The peak heap use of every section is reported too. The heap budget of each UI state is checked on the host, by
+`host_badge --heap-budget` (see tools/host-badge/main.cpp).
+
+Needs pyserial.
+"""
+import argparse
+import json
+import struct
+import sys
+
+import serial
+
+PACKET_MAGIC = b'BM'
+PACKET_TIMING = 2
+PACKET_ACK = 3
+PACKET_MEMORY = 5
+HEADER = struct.Struct('<2sBBII')
+TIMING = struct.Struct('<IIIII')
+TIMING_FIELDS = ('interval_us', 'swap_us', 'update_us', 'draw_us')
+MEMORY = struct.Struct('<9I')
+MEMORY_FIELDS = ('heap_live', 'heap_peak', 'heap_free', 'heap_top_free', 'allocations', 'state_allocations',
+                 'state_peak', 'stack_used', 'stack_size')
+
+
+class Port:
+
+    def __init__(self, name):
+        self.serial = serial.Serial(name, timeout=10)
+        self.serial.reset_input_buffer()
+        self.buffer = bytearray()
+
+    def read(self, n):
+        while len(self.buffer) < n:
+            data = self.serial.read(max(n - len(self.buffer), 1))
+            if not data:
+                raise TimeoutError('No reply from the badge')
+            self.buffer += data
+        data = bytes(self.buffer[:n])
+        del self.buffer[:n]
+        return data
+
+    def read_packet(self):
+        # Skip anything before the next packet header, e.g. screen mirroring data from before the port was opened.
+        while True:
+            while len(self.buffer) < len(PACKET_MAGIC):
+                self.buffer += self.read(1)
+            if self.buffer.startswith(PACKET_MAGIC):
+                break
+            del self.buffer[:1]
+        _, kind, _, number, size = HEADER.unpack(self.read(HEADER.size))
+        return kind, number, self.read(size)
+
+    def command(self, line, on_timing, on_memory=None):
+        """Send one command and wait until it has been acknowledged."""
+        self.serial.write(line.encode() + b'\n')
+        while True:
+            kind, number, payload = self.read_packet()
+            if kind == PACKET_TIMING:
+                on_timing(number, TIMING.unpack(payload))
+            elif kind == PACKET_MEMORY and on_memory:
+                on_memory(dict(zip(MEMORY_FIELDS, MEMORY.unpack(payload))))
+            elif kind == PACKET_ACK:
+                if payload[0] != 0:
+                    raise ValueError(f'Badge rejected command: {line}')
+                return
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def summarize(frames):
+    summary = {'frames': len(frames)}
+    for i, field in enumerate(TIMING_FIELDS):
+        values = [frame[i] for frame in frames]
+        summary[field] = {
+            'mean': round(sum(values) / len(values), 1),
+            'p95': percentile(values, 95),
+            'max': max(values),
+        }
+    return summary
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', help='Serial port of the badge data port')
+    parser.add_argument('script', help='Script file to run')
+    parser.add_argument('--json', help='Also write the results to this JSON file')
+    args = parser.parse_args()
+
+    sections = {}
+    heap_peaks = {}
+    section = 'default'
+
+    def on_timing(number, timing):
+        sections.setdefault(section, []).append(timing)
+
+    def on_memory(stats):
+        # A section may come up more than once, so keep its worst visit.
+        heap_peaks[section] = max(heap_peaks.get(section, 0), stats['heap_peak'])
+
+    port = Port(args.port)
+    port.command('pause', on_timing)
+    port.command('timing on', on_timing)
+    port.command('memory reset', on_timing)
+    try:
+        with open(args.script) as f:
+            for line_number, line in enumerate(f, 1):
+                line = line.split('#', 1)[0].strip()
+                if not line:
+                    continue
+                if line.startswith('mark '):
+                    port.command('memory', on_timing, on_memory)
+                    section = line[5:].strip()
+                    port.command('memory reset', on_timing)
+                    continue
+                try:
+                    port.command(line, on_timing)
+                except ValueError as e:
+                    sys.exit(f'{args.script}:{line_number}: {e}')
+        port.command('memory', on_timing, on_memory)
+    finally:
+        port.command('timing off', on_timing)
+        port.command('resume', on_timing)
+
+    results = {name: summarize(frames) for name, frames in sections.items() if frames}
+    for name, summary in results.items():
+        summary['heap_peak'] = heap_peaks.get(name, 0)
+
+    header = '  '.join(f'{field[:-3] + " mean/p95/max":>24}' for field in TIMING_FIELDS)
+    print(f'{"section":<16} {"frames":>6}  {header}  {"heap peak":>10}')
+    for name, summary in results.items():
+        cells = [f'{s["mean"]:>8.0f}/{s["p95"]:>6}/{s["max"]:>6}' for s in (summary[f] for f in TIMING_FIELDS)]
+        print(f'{name:<16} {summary["frames"]:>6}  ' + '  '.join(f'{c:>24}' for c in cells)
+              + f'  {summary["heap_peak"]:>10}')
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(results, f, indent=2)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,81 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <utils/crc.hpp>
+#include <utils/sha1.hpp>
+#include <tools/common/tool.hpp>
+
+
+// The byte-at-a-time loop that `utils::crc32` used before slice-by-8, as a baseline.
+uint32_t crc32_bytewise(std::span<const uint8_t> data) {
+    static const auto table = [] {
+        std::vector<uint32_t> result(256);
+        for (uint32_t idx = 0; idx < 256; idx++) {
+            uint32_t crc = idx;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320 : 0);
+            result[idx] = crc;
+        }
+        return result;
+    }();
+    uint32_t crc = ~0u;
+    for (auto byte : data)
+        crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+
+template<typename F>
+double measure_mib_per_s(const std::vector<uint8_t> &data, F &&crc) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    uint64_t bytes = 0;
+    while (clock::now() - start < std::chrono::milliseconds(200)) {
+        for (int i = 0; i < 64; i++)
+            tool::sink = crc(std::span(data));
+        bytes += data.size() * 64;
+    }
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    return bytes / elapsed.count() / (1024 * 1024);
+}
+
+
+std::vector<uint8_t> make_data(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = i * 37 + 11;
+    return data;
+}
+
+
+int main() {
+    constexpr size_t SIZES[] = {16, 64, 1020, 4096, 65536};
+
+    printf("CRC-32\n");
+    printf("%8s %12s %12s %8s\n", "size", "bytewise", "slice-by-8", "speedup");
+    for (const auto size : SIZES) {
+        const auto data = make_data(size);
+        if (crc32_bytewise(data) != utils::crc32(data)) {
+            printf("! Results differ for size %zu\n", size);
+            return 1;
+        }
+
+        const auto bytewise = measure_mib_per_s(data, crc32_bytewise);
+        const auto slice8 = measure_mib_per_s(data, [](auto d) { return utils::crc32(d); });
+        printf("%8zu %8.0f MiB/s %6.0f MiB/s %7.2fx\n", size, bytewise, slice8, slice8 / bytewise);
+    }
+
+    printf("\nSHA-1\n");
+    printf("%8s %12s %12s\n", "size", "throughput", "allocations");
+    for (const auto size : SIZES) {
+        const auto data = make_data(size);
+        const auto allocations = tool::get_allocations();
+        const auto throughput = measure_mib_per_s(data, [](auto d) { return utils::sha1_digest(d)[0]; });
+        printf("%8zu %6.0f MiB/s %12zu\n", size, throughput, tool::get_allocations() - allocations);
+        if (tool::get_allocations() != allocations)
+            return 1;
+    }
+    return 0;
+}
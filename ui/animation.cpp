@@ -24,7 +24,7 @@ namespace ui
     }
 
     void Animation::resume() {
-        anim->initialize();
+        anim->initialize(borrow_scratch(anim::Animation::MEMORY_SIZE));
     }
 
 }
@@ -54,8 +54,11 @@ namespace ui
     void FlagView::resume() {
         int x = X0;
         int y = SPACING;
-        for (auto flag : flags::get_found_flags()) {
-            const Item item{&flags::get_flag_image(flag), x, y};
+        const auto found = flags::get_found_flags();
+        for (int i = 0; i < flags::FLAG_COUNT; i++) {
+            if ((found & (flags::FlagSet{1} << i)) == 0)
+                continue;
+            const Item item{&flags::get_flag_image(static_cast<flags::Flag>(i)), x, y};
             items.push_back(item);
             x += STRIDE;
             if (x + STRIDE >= lcd::WIDTH) {
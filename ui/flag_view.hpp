@@ -14,6 +14,7 @@ namespace ui
 
         void update(int delta_ms) override;
         void draw() override;
+        [[nodiscard]] bool is_static() const override { return true; }
 
         void pause() override;
         void resume() override;
@@ -0,0 +1,116 @@
+#include "main_menu.hpp"
+
+#include <pico/bootrom.h>
+
+#include <assets.hpp>
+#include <badge/buttons.hpp>
+#include <badge/drawing.hpp>
+#include <badge/font.hpp>
+#include <games/blocks.hpp>
+#include <games/flappy.hpp>
+#include <games/othello.hpp>
+#include <games/snek.hpp>
+#include <ui/animation.hpp>
+#include <ui/code_entry.hpp>
+#include <ui/flag_view.hpp>
+#include <ui/menu.hpp>
+#include <ui/qr_code.hpp>
+#include <ui/readme.hpp>
+#include <ui/ui.hpp>
+
+namespace ui
+{
+
+    namespace
+    {
+        // Constant content, so encode it at compile time and keep just the module matrix in FLASH.
+        constexpr auto WEBSITE_QR_CODE =
+                qr::encode(qr::Version::AUTO, qr::ErrorCorrection::MEDIUM, "https://hack.gbgay.com/");
+        static_assert(WEBSITE_QR_CODE.size > 0);
+
+        class Website final : public State {
+        public:
+            static constexpr int SCALE = 4;
+
+            void update(int delta_ms) override {
+                State::update(delta_ms);
+                if (buttons::b())
+                    pop_state();
+            }
+
+            void draw() override {
+                drawing::clear(COLOR_WHITE);
+
+                const auto image_size = WEBSITE_QR_CODE.size * SCALE;
+                qr::draw(WEBSITE_QR_CODE, (lcd::WIDTH - image_size) / 2, (lcd::HEIGHT - image_size) / 2, SCALE);
+            }
+
+            [[nodiscard]] bool is_static() const override { return true; }
+        };
+
+        class FontTest final : public State {
+        public:
+            void update(int delta_ms) override {
+                State::update(delta_ms);
+                if (buttons::b())
+                    pop_state();
+            }
+
+            void draw() override {
+                drawing::clear(COLOR_BLACK);
+
+                auto x = 2;
+                auto y = 2;
+                font::TextDraw render = {};
+
+                auto do_render = [&](auto font, auto text) {
+                    render = font.render(text);
+                    drawing::draw_text(x - render.dx, y - render.dy, COLOR_BLACK, 150, COLOR_WHITE, render);
+                    y += render.height + 2;
+                };
+
+                do_render(font::lucida, "\"lucida\" Hello world!");
+                do_render(font::m5x7, "\"m5x7\" Hello world!");
+                do_render(font::m6x11, "\"m6x11\" Hello world!");
+                do_render(font::noto_sans, "\"Noto Sans\" Hello world!");
+                do_render(font::noto_sans_cm, "\"Noto Sans Condensed Medium\" Hello world!");
+            }
+
+            [[nodiscard]] bool is_static() const override { return true; }
+        };
+
+        // Menus stay around for the whole run. The states they lead to are only created when entered.
+        State *create_gallery_menu() {
+            static Menu menu;
+            menu.add_item("Blahaj", [] { push_new_state<Animation>(&anim::blahaj_spin); });
+            menu.add_item("Dramatic", [] { push_new_state<Animation>(&anim::dramatic); });
+            menu.add_item("Fire", [] { push_new_state<Animation>(&anim::fire); });
+            menu.add_item("Hi There", [] { push_new_state<Animation>(&anim::hi_there); });
+            menu.add_item("Pedro", [] { push_new_state<Animation>(&anim::pedro); });
+            menu.add_item("Rap Win", [] { push_new_state<Animation>(&anim::rap_win); });
+            menu.add_item("gbgay{", [] { push_new_state<Animation>(&anim::rick); });
+            return &menu;
+        }
+    } // namespace
+
+    State *create_main_menu() {
+        static Menu menu;
+        menu.is_main = true;
+        menu.add_state<Readme>("README");
+        menu.add_state<Website>("Website");
+        menu.add_state<CodeEntry>("Code Entry");
+        menu.add_state<FlagView>("Found Flags");
+        menu.add_state<snek::SnekGame>("Snek");
+        menu.add_state<blocks::BlocksGame>("Blocks");
+        menu.add_state<othello::OthelloGame>("Othello");
+        // menu.add_state<flappy::FlappyGame>("Flappy");
+        menu.add_item("Gallery", create_gallery_menu());
+        // menu.add_item("GPIO Control", nullptr);
+        // menu.add_item("SAO Control", nullptr);
+        // menu.add_state<FontTest>("Font Test");
+        menu.add_item("Bootloader", [] { rom_reset_usb_boot_extra(-1, 0, false); });
+
+        return &menu;
+    }
+
+} // namespace ui
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "state.hpp"
+
+namespace ui
+{
+
+    /// The menu the badge starts in, with everything it can do. It stays around for the whole run.
+    State *create_main_menu();
+
+} // namespace ui
@@ -10,7 +10,7 @@
 namespace ui
 {
 
-    void Menu::add_item(std::string_view label, const StatePtr &target_state) {
+    void Menu::add_item(std::string_view label, State *target_state) {
         items.emplace_back(label, target_state);
     }
 
@@ -41,10 +41,10 @@ namespace ui
             else if (item.callback)
                 item.callback();
         }
-        else if (buttons::down()) {
+        else if (buttons::down() || buttons::down_repeat()) {
             selected_item = (selected_item + 1) % items.size();
         }
-        else if (buttons::up()) {
+        else if (buttons::up() || buttons::up_repeat()) {
             selected_item = (selected_item + items.size() - 1) % items.size();
         }
         else if (buttons::b() && !is_main) {
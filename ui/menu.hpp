@@ -2,9 +2,11 @@
 
 #include "state.hpp"
 
-#include <string>
+#include <string_view>
 #include <vector>
 
+#include "ui.hpp"
+
 namespace ui
 {
 
@@ -12,11 +14,19 @@ namespace ui
     public:
         typedef void (*Callback)();
 
-        void add_item(std::string_view label, const StatePtr &target_state);
+        /// Labels are not copied, so they must outlive the menu, like string literals do.
+        void add_item(std::string_view label, State *target_state);
         void add_item(std::string_view label, Callback callback);
 
+        /// Add an item that enters a new `T`, created in the state arena when selected and destroyed when left.
+        template<typename T>
+        void add_state(std::string_view label) {
+            add_item(label, [] { push_new_state<T>(); });
+        }
+
         void update(int delta_ms) override;
         void draw() override;
+        [[nodiscard]] bool is_static() const override { return target_offset == 0; }
 
         bool is_main = false;
 
@@ -30,12 +40,12 @@ namespace ui
             Item &operator=(const Item &) = delete;
             Item &operator=(Item &&)      = default;
 
-            Item(std::string_view label, const StatePtr &target_state) : label(label), target_state(target_state) {}
+            Item(std::string_view label, State *target_state) : label(label), target_state(target_state) {}
             Item(std::string_view label, Callback callback) : label(label), callback(callback) {}
 
-            std::string label        = {};
-            StatePtr    target_state = nullptr;
-            Callback    callback     = nullptr;
+            std::string_view label        = {};
+            State           *target_state = nullptr;
+            Callback         callback     = nullptr;
         };
 
         std::vector<Item> items;
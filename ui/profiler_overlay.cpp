@@ -0,0 +1,127 @@
+#include "profiler_overlay.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <string_view>
+
+#include <badge/buttons.hpp>
+#include <badge/drawing.hpp>
+#include <badge/font.hpp>
+#include <badge/memory.hpp>
+#include <badge/profiler.hpp>
+#include <ui/ui.hpp>
+
+namespace ui::profiler_overlay
+{
+
+    namespace
+    {
+        /// The main loop's frame interval, which busy frames should stay well below.
+        constexpr uint32_t BUDGET_US = 30'000;
+
+        constexpr int BAR_WIDTH = 2;
+        constexpr int GRAPH_HEIGHT = 34;
+        constexpr uint32_t US_PER_PIXEL = 1000;
+
+        constexpr int TOP_PATHS = 3;
+        constexpr int MEMORY_LINES = 3;
+        constexpr int LINE_HEIGHT = 9;
+        constexpr int PANEL_HEIGHT = GRAPH_HEIGHT + (MEMORY_LINES + 1 + TOP_PATHS) * LINE_HEIGHT + 2;
+
+        bool _shown = false;
+
+        void draw_graph() {
+            const auto budget_y = GRAPH_HEIGHT - static_cast<int>(BUDGET_US / US_PER_PIXEL);
+            drawing::draw_line(0, budget_y, profiler::HISTORY * BAR_WIDTH - 1, budget_y, COLOR_YELLOW);
+
+            // The most recent frame is on the right.
+            for (int age = 0; age < profiler::get_sample_count(); age++) {
+                const auto busy_us = profiler::get_sample(age).busy_us;
+                const auto height = static_cast<int>(std::min<uint32_t>(busy_us / US_PER_PIXEL, GRAPH_HEIGHT));
+                const auto x = (profiler::HISTORY - 1 - age) * BAR_WIDTH;
+                const auto color = busy_us > BUDGET_US ? COLOR_RED : COLOR_GREEN;
+                drawing::fill_rect(x, GRAPH_HEIGHT - height, BAR_WIDTH, height, color);
+            }
+        }
+
+        void draw_text_line(int line, std::string_view text) {
+            drawing::draw_text(2, GRAPH_HEIGHT + (line + 1) * LINE_HEIGHT - 1, text, COLOR_WHITE, font::m5x7);
+        }
+
+        void draw_memory() {
+            const auto stats = memory::get_stats();
+            char text[48];
+            auto n = snprintf(text, sizeof(text), "heap %" PRIu32 "/%" PRIu32 " B, stack %" PRIu32 " B",
+                              stats.heap_live, stats.heap_peak, stats.stack_used);
+            draw_text_line(0, {text, static_cast<size_t>(n)});
+            n = snprintf(text, sizeof(text), "state: %" PRIu32 " allocs, peak %" PRIu32 " B",
+                         stats.state_allocations, stats.state_peak);
+            draw_text_line(1, {text, static_cast<size_t>(n)});
+            n = snprintf(text, sizeof(text), "arena %zu B, peak %zu B", ui::get_arena_used(), ui::get_arena_peak());
+            draw_text_line(2, {text, static_cast<size_t>(n)});
+        }
+    } // namespace
+
+    void update() {
+        if (buttons::get(CHORD) != 0 && buttons::get_current(CHORD) == CHORD) {
+            _shown = !_shown;
+            profiler::set_used(profiler::USER_OVERLAY, _shown);
+            ui::request_full_redraw();
+        }
+        else if (_shown) {
+            ui::request_full_redraw();
+        }
+    }
+
+    void draw() {
+        if (!_shown)
+            return;
+        profiler::Scope scope(profiler::ZONE_OVERLAY);
+
+        drawing::fill_rect(0, 0, lcd::WIDTH, PANEL_HEIGHT, COLOR_BLACK, 200);
+        draw_graph();
+        draw_memory();
+
+        const auto count = profiler::get_sample_count();
+        if (count == 0)
+            return;
+
+        // Sum up the history, then rank the paths by their average time per frame.
+        uint32_t busy_total_us = 0;
+        uint32_t busy_max_us = 0;
+        uint32_t path_total_us[profiler::MAX_PATHS] = {};
+        for (int age = 0; age < count; age++) {
+            const auto &sample = profiler::get_sample(age);
+            busy_total_us += sample.busy_us;
+            busy_max_us = std::max(busy_max_us, sample.busy_us);
+            for (int path = 0; path < profiler::MAX_PATHS; path++)
+                path_total_us[path] += sample.self_us[path];
+        }
+
+        char text[48];
+        auto n = snprintf(text, sizeof(text), "busy %" PRIu32 ".%" PRIu32 " ms, max %" PRIu32 ".%" PRIu32 " ms",
+                          busy_total_us / count / 1000, busy_total_us / count / 100 % 10,
+                          busy_max_us / 1000, busy_max_us / 100 % 10);
+        draw_text_line(MEMORY_LINES, {text, static_cast<size_t>(n)});
+
+        uint8_t top[profiler::MAX_PATHS];
+        const auto path_count = profiler::get_path_count();
+        for (int path = 0; path < path_count; path++)
+            top[path] = static_cast<uint8_t>(path);
+        const auto top_count = std::min(TOP_PATHS, path_count - 1);
+        std::partial_sort(top + 1, top + 1 + top_count, top + path_count, [&](uint8_t a, uint8_t b) {
+            return path_total_us[a] > path_total_us[b];
+        });
+
+        for (int i = 0; i < top_count; i++) {
+            const auto path = top[1 + i];
+            const auto average_us = path_total_us[path] / count;
+            n = static_cast<int>(profiler::get_path_name(path, {text, 32}, '/'));
+            n += snprintf(text + n, sizeof(text) - n, " %" PRIu32 ".%" PRIu32 " ms",
+                          average_us / 1000, average_us / 100 % 10);
+            draw_text_line(MEMORY_LINES + 1 + i, {text, static_cast<size_t>(n)});
+        }
+    }
+
+} // namespace ui::profiler_overlay
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+#include <badge/badge-2025.h>
+
+/**
+ * Performance overlay on top of the UI, with a graph of how busy the last frames were, heap and stack usage (see
+ * `badge/memory.hpp`), and the paths of zones (see `badge/profiler.hpp`) that took the most time. Time the main loop
+ * spends sleeping does not count as busy.
+ *
+ * The overlay is drawn over whatever the current state drew. While it is shown, and when it is hidden, the current
+ * state is asked to redraw everything (see `ui::request_full_redraw()`), so states that only redraw what changed, like
+ * snek, neither pile it up nor keep parts of it.
+ */
+namespace ui::profiler_overlay
+{
+
+    /// Buttons that show or hide the overlay when held together.
+    constexpr uint32_t CHORD = (1 << BTN_C) | (1 << BTN_D);
+
+    /// Show or hide the overlay when the chord is pressed. Called by the main loop after `buttons::update()`.
+    void update();
+
+    /// Draw the overlay into the frame, if it is shown. Called by the main loop after `ui::draw()`.
+    void draw();
+
+} // namespace ui::profiler_overlay
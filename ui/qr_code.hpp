@@ -1,63 +1,36 @@
 #pragma once
 
 #include <string>
-#include <vector>
 
-#include <badge/pixel.hpp>
-
-#include "qr_code_galois.hpp"
+#include "qr_code_encoder.hpp"
 
 namespace ui::qr
 {
 
-    enum class Version {
-        V1_21x21 = 1,
-        V2_25x25,
-        V3_29x29,
-        V4_33x33,
-    };
-
-    enum class ErrorCorrection {
-        LOW = 0,
-        MEDIUM,
-        QUARTER,
-        HIGH,
-    };
+    /**
+     * Draw a QR code straight into the frame buffer, with every module a square of `scale` pixels. Dark modules are
+     * filled as horizontal runs, so no scaled image needs to be kept around.
+     *
+     * Codes for constant content can be encoded at compile time with `encode()`. Only their module matrix is then
+     * stored, in FLASH.
+     */
+    void draw(const Matrix &modules, int left, int top, int scale);
 
     struct QrCode {
         Version version = {};
         ErrorCorrection ec = {};
         std::string content = {};
+        int scale = 1;
 
         void reset();
         void generate();
-        void render(int scale);
-        void draw(int left, int top) const;
+        void draw(int left, int top) const { qr::draw(modules, left, top, scale); }
         void print() const;
 
-        int get_image_size() const { return image_size; }
+        int get_image_size() const { return modules.size * scale; }
 
     private:
-        int size = {};
-        std::vector<bool> data = {};
-        std::vector<bool> reserved = {};
-        int mask_index = {};
-
-        int image_size = {};
-        std::vector<Pixel> image = {};
-
-        void set(int x, int y) { data[y * size + x] = true; }
-
-        void add_finder(int x0, int y0);
-        void add_alignment(int cx, int cy);
-        void add_timing();
-        void add_reserved_areas();
-        void add_codewords(const std::vector<codeword_t>& data);
-        void apply_mask();
-        void add_info();
-
-        std::vector<codeword_t> get_data_codewords() const;
-        std::array<bool, 15> get_format_bits() const;
+        Matrix modules = {};
     };
 
 } // namespace ui::qr
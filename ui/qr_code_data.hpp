@@ -1,23 +1,16 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 namespace ui::qr::data
 {
 
 
-    constexpr auto LENGTH_BITS = 8;
+    constexpr int MAX_VERSION = 10;
 
-    // See https://www.thonky.com/qr-code-tutorial/character-capacities
-    // clang-format off
-    constexpr std::array DATA_CAPACITY_TABLE = {
-    //   L   M   Q   H
-        17, 14, 11,  7, // V1
-        32, 26, 20, 14, // V2
-        53, 42, 32, 24, // V3
-        78, 62, 46, 34, // V4
-    };
-    // clang-format on
+    // See https://www.thonky.com/qr-code-tutorial/error-correction-table
+    constexpr std::array<int, MAX_VERSION> TOTAL_CODEWORD_TABLE = {26, 44, 70, 100, 134, 172, 196, 242, 292, 346};
 
     // See https://www.thonky.com/qr-code-tutorial/error-correction-table
     // clang-format off
@@ -27,6 +20,12 @@ namespace ui::qr::data
         1, 1, 1, 1, // V2
         1, 1, 2, 2, // V3
         1, 2, 2, 4, // V4
+        1, 2, 4, 4, // V5
+        2, 4, 4, 4, // V6
+        2, 4, 6, 5, // V7
+        2, 4, 6, 6, // V8
+        2, 5, 8, 8, // V9
+        4, 5, 8, 8, // V10
     };
     // clang-format on
 
@@ -38,25 +37,53 @@ namespace ui::qr::data
         10, 16, 22, 28, // V2
         15, 26, 18, 22, // V3
         20, 18, 26, 16, // V4
+        26, 24, 18, 22, // V5
+        18, 16, 24, 28, // V6
+        20, 18, 18, 26, // V7
+        24, 22, 22, 26, // V8
+        30, 22, 20, 24, // V9
+        18, 26, 24, 28, // V10
     };
     // clang-format on
 
+    // See https://www.thonky.com/qr-code-tutorial/alignment-pattern-locations
+    // Row and column coordinates of the alignment pattern centers, unused entries are 0.
+    // clang-format off
+    constexpr std::array<std::array<int, 3>, MAX_VERSION> ALIGNMENT_POSITION_TABLE = {{
+        {},          // V1
+        {6, 18},     // V2
+        {6, 22},     // V3
+        {6, 26},     // V4
+        {6, 30},     // V5
+        {6, 34},     // V6
+        {6, 22, 38}, // V7
+        {6, 24, 42}, // V8
+        {6, 26, 46}, // V9
+        {6, 28, 50}, // V10
+    }};
+    // clang-format on
+
     constexpr auto get_table_index(auto version, auto ec) {
         return (static_cast<int>(version) - 1) * 4 + static_cast<int>(ec);
     }
 
-    constexpr auto get_data_capacity(auto version, auto ec) {
-        return DATA_CAPACITY_TABLE[get_table_index(version, ec)];
+    constexpr auto get_total_codeword_count(auto version) {
+        return TOTAL_CODEWORD_TABLE[static_cast<int>(version) - 1];
     }
 
     constexpr auto get_block_count(auto version, auto ec) {
         return EC_BLOCKS_TABLE[get_table_index(version, ec)];
     }
 
+    /// Error correction codewords per block.
     constexpr auto get_ec_codeword_count(auto version, auto ec) {
         return BLOCK_EC_WORD_TABLE[get_table_index(version, ec)];
     }
 
+    constexpr auto get_data_codeword_count(auto version, auto ec) {
+        return get_total_codeword_count(version) - get_block_count(version, ec) * get_ec_codeword_count(version, ec);
+    }
+
     // See https://www.thonky.com/qr-code-tutorial/log-antilog-table
     constexpr std::array<uint8_t, 256> GALOIS_EXP_TABLE = {
             1,   2,   4,   8,   16,  32,  64,  128, 29,  58,  116, 232, 205, 135, 19,  38,  76,  152, 45,  90,
@@ -0,0 +1,470 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "qr_code_data.hpp"
+#include "qr_code_galois.hpp"
+#include "qr_code_matrix.hpp"
+
+namespace ui::qr
+{
+
+    enum class Version {
+        AUTO = 0, ///< The smallest version the content fits in.
+        V1_21x21,
+        V2_25x25,
+        V3_29x29,
+        V4_33x33,
+        V5_37x37,
+        V6_41x41,
+        V7_45x45,
+        V8_49x49,
+        V9_53x53,
+        V10_57x57,
+    };
+
+    enum class ErrorCorrection {
+        LOW = 0,
+        MEDIUM,
+        QUARTER,
+        HIGH,
+    };
+
+    /// Encoding modes, from most to least compact.
+    enum class Mode {
+        NUMERIC = 0,  ///< Digits only.
+        ALPHANUMERIC, ///< Digits, upper case letters, space and `$%*+-./:`.
+        BYTE,
+    };
+
+    /// Pass as mask to `encode()` to pick the mask with the lowest penalty score.
+    constexpr int AUTO_MASK = -1;
+
+    constexpr int get_size(Version version) { return 17 + 4 * static_cast<int>(version); }
+
+    namespace internal
+    {
+
+        /// Largest number of codewords, data and error correction, of any supported version.
+        constexpr int MAX_CODEWORDS = data::TOTAL_CODEWORD_TABLE.back();
+
+        static_assert(get_size(static_cast<Version>(data::MAX_VERSION)) <= Matrix::MAX_SIZE);
+
+        constexpr std::string_view ALPHANUMERIC_CHARACTERS = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+
+        constexpr int get_alphanumeric_value(char ch) {
+            const auto pos = ALPHANUMERIC_CHARACTERS.find(ch);
+            return pos == std::string_view::npos ? -1 : static_cast<int>(pos);
+        }
+
+        constexpr int get_character_count_bits(Version version, Mode mode) {
+            constexpr std::array<int, 3> SMALL_VERSIONS = {10, 9, 8};
+            constexpr std::array<int, 3> LARGE_VERSIONS = {12, 11, 16};
+            return (version < Version::V10_57x57 ? SMALL_VERSIONS : LARGE_VERSIONS)[static_cast<int>(mode)];
+        }
+
+        /// Length of the encoded bit stream, without terminator and padding.
+        constexpr int get_data_bits(Version version, Mode mode, int length) {
+            int payload;
+            if (mode == Mode::NUMERIC)
+                payload = length / 3 * 10 + (length % 3 == 0 ? 0 : length % 3 * 3 + 1);
+            else if (mode == Mode::ALPHANUMERIC)
+                payload = length / 2 * 11 + length % 2 * 6;
+            else
+                payload = length * 8;
+            return 4 + get_character_count_bits(version, mode) + payload;
+        }
+
+        constexpr bool is_masked(int mask, int row, int col) {
+            switch (mask) {
+            case 0: return (row + col) % 2 == 0;
+            case 1: return row % 2 == 0;
+            case 2: return col % 3 == 0;
+            case 3: return (row + col) % 3 == 0;
+            case 4: return (row / 2 + col / 3) % 2 == 0;
+            case 5: return row * col % 2 + row * col % 3 == 0;
+            case 6: return (row * col % 2 + row * col % 3) % 2 == 0;
+            default: return ((row + col) % 2 + row * col % 3) % 2 == 0;
+            }
+        }
+
+        /// All mask patterns repeat every 12 rows, so a row of the mask is `MASK_PATTERNS[mask][row % 12]`.
+        constexpr auto MASK_PATTERNS = [] {
+            std::array<std::array<uint64_t, 12>, 8> result = {};
+            for (int mask = 0; mask < 8; mask++)
+                for (int row = 0; row < 12; row++)
+                    for (int col = 0; col < Matrix::MAX_SIZE; col++)
+                        if (is_masked(mask, row, col))
+                            result[mask][row] |= uint64_t(1) << col;
+            return result;
+        }();
+
+        /// The 15 format information bits: EC level and mask, protected by a BCH(15, 5) code.
+        constexpr uint32_t get_format_bits(ErrorCorrection ec, int mask) {
+            constexpr std::array<uint32_t, 4> EC_BITS = {1, 0, 3, 2};
+            const auto data = EC_BITS[static_cast<int>(ec)] << 3 | mask;
+            auto remainder = data;
+            for (int i = 0; i < 10; i++)
+                remainder = (remainder << 1) ^ ((remainder >> 9) * 0x537);
+            return (data << 10 | remainder) ^ 0x5412;
+        }
+
+        static_assert(get_format_bits(ErrorCorrection::MEDIUM, 0) == 0b101010000010010);
+        static_assert(get_format_bits(ErrorCorrection::LOW, 4) == 0b110011000101111);
+
+        /// The 18 version information bits of version 7 and up, protected by a BCH(18, 6) code.
+        constexpr uint32_t get_version_bits(Version version) {
+            const auto data = static_cast<uint32_t>(version);
+            auto remainder = data;
+            for (int i = 0; i < 12; i++)
+                remainder = (remainder << 1) ^ ((remainder >> 11) * 0x1F25);
+            return data << 12 | remainder;
+        }
+
+        static_assert(get_version_bits(Version::V7_45x45) == 0x07C94);
+        static_assert(get_version_bits(Version::V10_57x57) == 0x0A4D3);
+
+        /// Writes a bit stream into codewords, most significant bit first. The codewords must start out zeroed.
+        struct BitWriter {
+            std::span<uint8_t> codewords;
+            int position = 0;
+
+            [[nodiscard]] constexpr int remaining() const { return static_cast<int>(codewords.size()) * 8 - position; }
+
+            constexpr void write(uint32_t value, int bits) {
+                for (int i = bits - 1; i >= 0; i--, position++)
+                    codewords[position >> 3] |= ((value >> i) & 1) << (7 - (position & 7));
+            }
+        };
+
+        constexpr void add_finder(Matrix &modules, int x, int y) {
+            modules.fill(x, y, 7, 7);
+            modules.fill(x + 1, y + 1, 5, 5, false);
+            modules.fill(x + 2, y + 2, 3, 3);
+        }
+
+        constexpr void add_alignment(Matrix &modules, Matrix &reserved, int cx, int cy) {
+            modules.fill(cx - 2, cy - 2, 5, 5);
+            modules.fill(cx - 1, cy - 1, 3, 3, false);
+            modules.set(cx, cy);
+            reserved.fill(cx - 2, cy - 2, 5, 5);
+        }
+
+        /// Draw the finder, alignment and timing patterns and the version information, and mark them, with the
+        /// format areas, as reserved.
+        constexpr void add_function_patterns(Matrix &modules, Matrix &reserved, Version version) {
+            const int size = modules.size;
+
+            add_finder(modules, 0, 0);
+            add_finder(modules, size - 7, 0);
+            add_finder(modules, 0, size - 7);
+            // The finders with their separators and the format information next to them.
+            reserved.fill(0, 0, 9, 9);
+            reserved.fill(size - 8, 0, 8, 9);
+            reserved.fill(0, size - 8, 9, 8);
+
+            // Alignment patterns go on a grid, except where they would overlap the finders.
+            const auto &positions = data::ALIGNMENT_POSITION_TABLE[static_cast<int>(version) - 1];
+            for (const auto cy : positions) {
+                for (const auto cx : positions) {
+                    if (cx == 0 || cy == 0 || (cx == 6 && cy == 6) || (cx == 6 && cy == size - 7) ||
+                        (cx == size - 7 && cy == 6))
+                        continue;
+                    add_alignment(modules, reserved, cx, cy);
+                }
+            }
+
+            const auto timing = Matrix::bit_range(8, size - 16);
+            modules.rows[6] |= timing & 0x5555555555555555;
+            reserved.rows[6] |= timing;
+            for (int i = 8; i < size - 8; i++) {
+                modules.set(6, i, i % 2 == 0);
+                reserved.set(6, i);
+            }
+
+            // The dark module.
+            modules.set(8, size - 8);
+
+            if (version >= Version::V7_45x45) {
+                // Two 6x3 blocks, next to the top right and bottom left finders.
+                const auto bits = get_version_bits(version);
+                for (int i = 0; i < 18; i++) {
+                    const bool dark = (bits >> i) & 1;
+                    modules.set(size - 11 + i % 3, i / 3, dark);
+                    modules.set(i / 3, size - 11 + i % 3, dark);
+                }
+                reserved.fill(size - 11, 0, 3, 6);
+                reserved.fill(0, size - 11, 6, 3);
+            }
+        }
+
+        /// Fill the non-reserved modules in the two column wide zig-zag pattern, starting at the bottom right.
+        constexpr void add_codewords(Matrix &modules, const Matrix &reserved, std::span<const uint8_t> codewords) {
+            const int size = modules.size;
+            const int n_bits = static_cast<int>(codewords.size()) * 8;
+            int i = 0;
+            for (int right = size - 1; right >= 1; right -= 2) {
+                // Skip past the vertical timing pattern.
+                if (right == 6)
+                    right = 5;
+                const bool upwards = ((right + 1) & 2) == 0;
+                for (int step = 0; step < size; step++) {
+                    const int y = upwards ? size - 1 - step : step;
+                    for (int x = right; x >= right - 1; x--) {
+                        if (reserved.get(x, y) || i >= n_bits)
+                            continue;
+                        modules.set(x, y, (codewords[i >> 3] >> (7 - (i & 7))) & 1);
+                        i++;
+                    }
+                }
+            }
+        }
+
+        constexpr void apply_mask(Matrix &modules, const Matrix &reserved, int mask) {
+            const auto &pattern = MASK_PATTERNS[mask];
+            for (int y = 0; y < modules.size; y++)
+                modules.rows[y] ^= pattern[y % 12] & ~reserved.rows[y] & modules.row_mask();
+        }
+
+        constexpr void add_format_bits(Matrix &modules, ErrorCorrection ec, int mask) {
+            const int size = modules.size;
+            const auto bits = get_format_bits(ec, mask);
+            for (int i = 0; i < 15; i++) {
+                const bool dark = (bits >> i) & 1;
+                // Around the top left finder...
+                if (i < 6)
+                    modules.set(8, i, dark);
+                else if (i < 8)
+                    modules.set(8, i + 1, dark);
+                else if (i == 8)
+                    modules.set(7, 8, dark);
+                else
+                    modules.set(14 - i, 8, dark);
+                // ...and split between the other two.
+                if (i < 8)
+                    modules.set(size - 1 - i, 8, dark);
+                else
+                    modules.set(8, size - 15 + i, dark);
+            }
+        }
+
+        /**
+         * Penalty rules 1 and 3 for the rows of the matrix: runs of five or more modules of the same color, and
+         * patterns that look like a finder. Score the columns by passing the transposed matrix.
+         */
+        constexpr int get_line_penalty(const Matrix &modules) {
+            const int size = modules.size;
+            const auto inner = modules.row_mask() >> 1;
+            int penalty = 0;
+            for (int y = 0; y < size; y++) {
+                const auto row = modules.rows[y];
+
+                // Bit x of `ends` is set where the run containing module x ends.
+                auto ends = ((row ^ (row >> 1)) & inner) | (uint64_t(1) << (size - 1));
+                int start = 0;
+                while (ends) {
+                    const int end = std::countr_zero(ends) + 1;
+                    if (end - start >= 5)
+                        penalty += 3 + (end - start - 5);
+                    start = end;
+                    ends &= ends - 1;
+                }
+
+                // Dark-light-dark-dark-dark-light-dark starting at x, with four light modules before or after it.
+                // Modules outside the matrix are part of the quiet zone and count as light, which the shifts give
+                // us for free.
+                const auto finder = row & ~(row >> 1) & (row >> 2) & (row >> 3) & (row >> 4) & ~(row >> 5) & (row >> 6);
+                const auto light_before = ~((row << 1) | (row << 2) | (row << 3) | (row << 4));
+                const auto light_after = ~((row >> 7) | (row >> 8) | (row >> 9) | (row >> 10));
+                penalty += 40 * (std::popcount(finder & light_before) + std::popcount(finder & light_after));
+            }
+            return penalty;
+        }
+
+        /// Penalty rule 2: 2x2 blocks of the same color.
+        constexpr int get_block_penalty(const Matrix &modules) {
+            const auto inner = modules.row_mask() >> 1;
+            int blocks = 0;
+            for (int y = 0; y + 1 < modules.size; y++) {
+                const auto top = modules.rows[y];
+                const auto same_vertical = ~(top ^ modules.rows[y + 1]);
+                const auto same_horizontal = ~(top ^ (top >> 1));
+                blocks += std::popcount(same_vertical & (same_vertical >> 1) & same_horizontal & inner);
+            }
+            return 3 * blocks;
+        }
+
+        /// Penalty rule 4: 10 points for every 5% the share of dark modules is away from half.
+        constexpr int get_balance_penalty(const Matrix &modules) {
+            const int total = modules.size * modules.size;
+            const int dark = modules.count();
+            const int deviation = dark * 20 - total * 10;
+            return 10 * ((deviation < 0 ? -deviation : deviation) / total);
+        }
+
+        constexpr int get_penalty(const Matrix &modules) {
+            return get_line_penalty(modules) + get_line_penalty(modules.transposed()) + get_block_penalty(modules) +
+                   get_balance_penalty(modules);
+        }
+
+        /// Write the content as a single segment, followed by the terminator and padding.
+        constexpr void add_data_codewords(Version version, Mode mode, std::string_view content,
+                                          std::span<uint8_t> codewords) {
+            const int length = static_cast<int>(content.size());
+            BitWriter writer = {codewords};
+
+            writer.write(1 << static_cast<int>(mode), 4);
+            writer.write(length, get_character_count_bits(version, mode));
+            if (mode == Mode::NUMERIC) {
+                // Groups of three digits in 10 bits, with 7 or 4 bits for a shorter final group.
+                for (int i = 0; i < length; i += 3) {
+                    const int n = std::min(3, length - i);
+                    int value = 0;
+                    for (int j = 0; j < n; j++)
+                        value = value * 10 + (content[i + j] - '0');
+                    writer.write(value, n * 3 + 1);
+                }
+            }
+            else if (mode == Mode::ALPHANUMERIC) {
+                // Pairs of characters in 11 bits, with 6 bits for a final single character.
+                for (int i = 0; i < length; i += 2) {
+                    if (i + 1 < length)
+                        writer.write(get_alphanumeric_value(content[i]) * 45 + get_alphanumeric_value(content[i + 1]),
+                                     11);
+                    else
+                        writer.write(get_alphanumeric_value(content[i]), 6);
+                }
+            }
+            else {
+                for (const auto ch : content)
+                    writer.write(static_cast<uint8_t>(ch), 8);
+            }
+
+            writer.write(0, std::min(4, writer.remaining()));
+            writer.position = (writer.position + 7) / 8 * 8;
+            for (uint8_t pad = 236; writer.remaining() > 0; pad ^= 236 ^ 17)
+                writer.write(pad, 8);
+        }
+
+        /**
+         * Split the data codewords into blocks, add the error correction codewords of each block and interleave them
+         * into `codewords`. The last blocks are one data codeword longer when the data does not split evenly.
+         */
+        constexpr void add_ec_codewords(Version version, ErrorCorrection ec, std::span<const uint8_t> data,
+                                        std::span<uint8_t> codewords) {
+            const int n_blocks = data::get_block_count(version, ec);
+            const int n_ec = data::get_ec_codeword_count(version, ec);
+            const int n_short_blocks = n_blocks - data::get_total_codeword_count(version) % n_blocks;
+            const int short_length = static_cast<int>(data.size()) / n_blocks;
+
+            auto get_block = [&](int block) {
+                const int start = block * short_length + std::max(0, block - n_short_blocks);
+                return data.subspan(start, short_length + (block >= n_short_blocks ? 1 : 0));
+            };
+
+            std::array<uint8_t, MAX_CODEWORDS> ec_words = {};
+            for (int block = 0; block < n_blocks; block++)
+                compute_ec_codewords(get_block(block), std::span(ec_words).subspan(block * n_ec, n_ec));
+
+            int i = 0;
+            for (int column = 0; column <= short_length; column++)
+                for (int block = 0; block < n_blocks; block++)
+                    if (column < short_length || block >= n_short_blocks)
+                        codewords[i++] = get_block(block)[column];
+            for (int column = 0; column < n_ec; column++)
+                for (int block = 0; block < n_blocks; block++)
+                    codewords[i++] = ec_words[block * n_ec + column];
+        }
+
+    } // namespace internal
+
+    /// The most compact mode that can encode all of `content`.
+    constexpr Mode get_mode(std::string_view content) {
+        auto mode = Mode::NUMERIC;
+        for (const auto ch : content) {
+            if (internal::get_alphanumeric_value(ch) < 0)
+                return Mode::BYTE;
+            if (ch < '0' || ch > '9')
+                mode = Mode::ALPHANUMERIC;
+        }
+        return mode;
+    }
+
+    constexpr bool fits(Version version, ErrorCorrection ec, std::string_view content) {
+        const int length = static_cast<int>(content.size());
+        const auto mode = get_mode(content);
+        return length < (1 << internal::get_character_count_bits(version, mode)) &&
+               internal::get_data_bits(version, mode, length) <= data::get_data_codeword_count(version, ec) * 8;
+    }
+
+    /// The smallest version that can hold `content`, or `Version::AUTO` if it is too long for all of them.
+    constexpr Version get_min_version(ErrorCorrection ec, std::string_view content) {
+        for (int version = 1; version <= data::MAX_VERSION; version++)
+            if (fits(static_cast<Version>(version), ec, content))
+                return static_cast<Version>(version);
+        return Version::AUTO;
+    }
+
+    /**
+     * Encode `content` in the most compact mode it allows, in the given version or the smallest one it fits in.
+     * Unless a mask is given, all eight masks are tried and the one with the lowest penalty score according to the
+     * standard is used.
+     *
+     * Returns an empty matrix if the content does not fit the version and error correction level.
+     */
+    constexpr Matrix encode(Version version, ErrorCorrection ec, std::string_view content, int mask = AUTO_MASK) {
+        using namespace internal;
+
+        if (version == Version::AUTO)
+            version = get_min_version(ec, content);
+        if (version == Version::AUTO || !fits(version, ec, content))
+            return {};
+
+        Matrix modules = {get_size(version)};
+        Matrix reserved = {get_size(version)};
+        add_function_patterns(modules, reserved, version);
+
+        std::array<uint8_t, MAX_CODEWORDS> data_words = {};
+        std::array<uint8_t, MAX_CODEWORDS> codewords = {};
+        const auto n_data = data::get_data_codeword_count(version, ec);
+        add_data_codewords(version, get_mode(content), content, std::span(data_words).first(n_data));
+        add_ec_codewords(version, ec, std::span(data_words).first(n_data), codewords);
+        add_codewords(modules, reserved, std::span(codewords).first(data::get_total_codeword_count(version)));
+
+        if (mask != AUTO_MASK) {
+            apply_mask(modules, reserved, mask);
+            add_format_bits(modules, ec, mask);
+            return modules;
+        }
+
+        Matrix best = {};
+        int best_penalty = 0;
+        for (int candidate = 0; candidate < 8; candidate++) {
+            Matrix masked = modules;
+            apply_mask(masked, reserved, candidate);
+            add_format_bits(masked, ec, candidate);
+            const auto penalty = get_penalty(masked);
+            if (candidate == 0 || penalty < best_penalty) {
+                best = masked;
+                best_penalty = penalty;
+            }
+        }
+        return best;
+    }
+
+    /// The mask an encoded matrix uses, read back from its format information.
+    constexpr int get_mask(const Matrix &modules) {
+        uint32_t bits = 0;
+        for (int i = 0; i < 8; i++)
+            bits |= modules.get(modules.size - 1 - i, 8) << i;
+        for (int i = 8; i < 15; i++)
+            bits |= modules.get(8, modules.size - 15 + i) << i;
+        return ((bits ^ 0x5412) >> 10) & 7;
+    }
+
+} // namespace ui::qr
@@ -1,138 +1,85 @@
 #pragma once
 
 #include <array>
-#include <cassert>
 #include <cstdint>
-#include <vector>
+#include <span>
+
+#include "qr_code_data.hpp"
 
 namespace ui::qr
 {
 
-    struct codeword_t {
-        uint8_t value = 0;
-
-        constexpr codeword_t() = default;
-        constexpr codeword_t(const codeword_t &) = default;
-        constexpr codeword_t &operator=(const codeword_t &) = default;
-
-        constexpr explicit codeword_t(uint8_t v) : value(v) {}
-
-        constexpr codeword_t operator+(const codeword_t &rhs) const { return codeword_t(value ^ rhs.value); }
-
-        constexpr codeword_t operator-(const codeword_t &rhs) const { return codeword_t(value ^ rhs.value); }
-
-        constexpr codeword_t &operator+=(const codeword_t &rhs) {
-            value ^= rhs.value;
-            return *this;
-        }
-
-        constexpr codeword_t &operator-=(const codeword_t &rhs) {
-            value ^= rhs.value;
-            return *this;
-        }
-    };
-
-    static_assert(sizeof(codeword_t) == 1);
-
-    codeword_t operator*(const codeword_t &lhs, const codeword_t &rhs);
-    codeword_t operator/(const codeword_t &lhs, const codeword_t &rhs);
-
-    struct polynomial_t {
-        polynomial_t() = default;
-        ~polynomial_t() {
-            if (_coefficients)
-                delete[] _coefficients;
-        }
-
-        polynomial_t(const polynomial_t &copy) {
-            if (copy._coefficients == nullptr)
-                return;
-            _degree = copy._degree;
-            _coefficients = new codeword_t[_degree + 1];
-            for (int i = 0; i <= _degree; i++)
-                _coefficients[i] = copy._coefficients[i];
-        }
-
-        polynomial_t &operator=(const polynomial_t &copy) {
-            if (_degree != copy._degree) {
-                if (_coefficients)
-                    delete[] _coefficients;
-                _degree = copy._degree;
-                _coefficients = new codeword_t[_degree + 1];
-            }
-            if (_degree >= 0) {
-                assert(_coefficients && copy._coefficients);
-                for (int i = 0; i <= _degree; i++)
-                    _coefficients[i] = copy._coefficients[i];
+    /// Largest number of error correction codewords per block.
+    constexpr int MAX_EC_DEGREE = 30;
+
+    constexpr uint8_t gf_mul(uint8_t lhs, uint8_t rhs) {
+        if (lhs == 0 || rhs == 0)
+            return 0;
+        return data::GALOIS_EXP_TABLE[(data::GALOIS_LOG_TABLE[lhs] + data::GALOIS_LOG_TABLE[rhs]) % 255];
+    }
+
+    /**
+     * Generator polynomials of every degree up to `MAX_EC_DEGREE`, back to back: degree `d` starts at offset
+     * `d * (d - 1) / 2`. The leading coefficient (always 1) is left out and the others are stored as their
+     * logarithms, so the remainder loop needs a single table lookup per term.
+     */
+    constexpr auto GENERATOR_POLYNOMIAL_LOGS = [] {
+        std::array<uint8_t, MAX_EC_DEGREE * (MAX_EC_DEGREE + 1) / 2> result = {};
+        for (int degree = 1; degree <= MAX_EC_DEGREE; degree++) {
+            // Multiply out (x - 2^0) * (x - 2^1) * ... * (x - 2^(degree - 1)), highest order coefficient first.
+            std::array<uint8_t, MAX_EC_DEGREE> coefficients = {};
+            coefficients[degree - 1] = 1;
+            uint8_t root = 1;
+            for (int i = 0; i < degree; i++) {
+                for (int j = 0; j < degree; j++) {
+                    coefficients[j] = gf_mul(coefficients[j], root);
+                    if (j + 1 < degree)
+                        coefficients[j] ^= coefficients[j + 1];
+                }
+                root = gf_mul(root, 2);
             }
-            return *this;
+            for (int j = 0; j < degree; j++)
+                result[degree * (degree - 1) / 2 + j] = data::GALOIS_LOG_TABLE[coefficients[j]];
         }
-
-        polynomial_t(polynomial_t &&move) noexcept {
-            _coefficients = move._coefficients;
-            _degree = move._degree;
-            move._coefficients = nullptr;
-            move._degree = -1;
-        }
-
-        polynomial_t &operator=(polynomial_t &&move) noexcept {
-            if (_coefficients)
-                delete[] _coefficients;
-            _coefficients = move._coefficients;
-            _degree = move._degree;
-            move._coefficients = nullptr;
-            move._degree = -1;
-            return *this;
-        }
-
-        template<typename T>
-        polynomial_t(const std::initializer_list<T>& init) {
-            _degree = init.size() - 1;
-            _coefficients = new codeword_t[_degree + 1];
-            int i = 0;
-            for (const auto& k : init)
-                _coefficients[i++].value = k;
-        }
-
-        polynomial_t(const std::vector<codeword_t> &coefficients, int shift) {
-            _degree = coefficients.size() - 1 + shift;
-            _coefficients = new codeword_t[_degree + 1];
-            for (int i = 0; i <= _degree; i++) {
-                if (i < static_cast<int>(coefficients.size()))
-                    _coefficients[i] = coefficients[i];
-                else
-                    _coefficients[i] = {};
-            }
+        return result;
+    }();
+
+    /**
+     * Compute the Reed-Solomon error correction codewords of `data`, as many as `ec` has room for.
+     *
+     * This is the remainder of the polynomial division by the generator, done the way a hardware LFSR would: every
+     * data codeword shifts the remainder register by one and adds the generator scaled by the feedback term.
+     */
+    constexpr void compute_ec_codewords(std::span<const uint8_t> data, std::span<uint8_t> ec) {
+        const int degree = static_cast<int>(ec.size());
+        const auto *generator = &GENERATOR_POLYNOMIAL_LOGS[degree * (degree - 1) / 2];
+
+        for (auto &word : ec)
+            word = 0;
+        for (const auto word : data) {
+            const uint8_t feedback = word ^ ec[0];
+            for (int i = 0; i + 1 < degree; i++)
+                ec[i] = ec[i + 1];
+            ec[degree - 1] = 0;
+            if (feedback == 0)
+                continue;
+            const auto feedback_log = data::GALOIS_LOG_TABLE[feedback];
+            for (int i = 0; i < degree; i++)
+                ec[i] ^= data::GALOIS_EXP_TABLE[(generator[i] + feedback_log) % 255];
         }
-
-        codeword_t &operator[](int index) {
-            assert(index >= 0 && index <= _degree);
-            return _coefficients[index];
-        }
-
-        codeword_t operator[](int index) const {
-            assert(index >= 0 && index <= _degree);
-            return _coefficients[index];
-        }
-
-        std::vector<codeword_t> as_vector() const {
-            if (_coefficients)
-                return {_coefficients, _coefficients + _degree + 1};
-            else
-                return {};
+    }
+
+    namespace galois_test
+    {
+        constexpr auto get_ec_codewords(std::span<const uint8_t> data) {
+            std::array<uint8_t, 10> result = {};
+            compute_ec_codewords(data, result);
+            return result;
         }
 
-    private:
-        codeword_t *_coefficients = nullptr;
-        int _degree = -1;
-
-        friend polynomial_t operator*(const polynomial_t &lhs, const codeword_t &rhs);
-        friend polynomial_t operator*(const polynomial_t &lhs, const polynomial_t &rhs);
-        friend polynomial_t operator%(const polynomial_t &lhs, const polynomial_t &rhs);
-
-        friend polynomial_t construct_generator_polynomial(int degree);
-    };
-
-    std::vector<codeword_t> get_ec_codewords(const std::vector<codeword_t> &data, int degree);
+        // See https://www.thonky.com/qr-code-tutorial/error-correction-coding (1-M, "HELLO WORLD").
+        constexpr std::array<uint8_t, 16> DATA = {32, 91, 11, 120, 209, 114, 220, 77, 67, 64, 236, 17, 236, 17, 236, 17};
+        static_assert(get_ec_codewords(DATA) == std::array<uint8_t, 10>{196, 35, 39, 119, 235, 215, 231, 226, 93, 23});
+    } // namespace galois_test
 
 } // namespace ui::qr
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace ui::qr
+{
+
+    /**
+     * Square matrix of QR code modules, packed one row per 64-bit word with bit `x` holding column `x`. A set bit is
+     * a dark module. Keeping whole rows in a word lets masking and scoring work on all columns of a row at once.
+     */
+    struct Matrix {
+        static constexpr int MAX_SIZE = 64;
+
+        int size = 0;
+        std::array<uint64_t, MAX_SIZE> rows = {};
+
+        /// Bits `x` up to `x + width` (exclusive) set.
+        static constexpr uint64_t bit_range(int x, int width) {
+            return (width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1) << x;
+        }
+
+        [[nodiscard]] constexpr bool get(int x, int y) const { return (rows[y] >> x) & 1; }
+
+        constexpr void set(int x, int y, bool dark = true) {
+            if (dark)
+                rows[y] |= uint64_t(1) << x;
+            else
+                rows[y] &= ~(uint64_t(1) << x);
+        }
+
+        constexpr void fill(int x, int y, int width, int height, bool dark = true) {
+            const auto bits = bit_range(x, width);
+            for (int i = y; i < y + height; i++)
+                rows[i] = dark ? rows[i] | bits : rows[i] & ~bits;
+        }
+
+        /// The bits of a row that are within the matrix.
+        [[nodiscard]] constexpr uint64_t row_mask() const { return bit_range(0, size); }
+
+        /// Number of dark modules.
+        [[nodiscard]] constexpr int count() const {
+            int result = 0;
+            for (int y = 0; y < size; y++)
+                result += std::popcount(rows[y]);
+            return result;
+        }
+
+        /// Swap rows and columns, so column-wise operations can reuse the row-wise code.
+        [[nodiscard]] constexpr Matrix transposed() const {
+            // Recursively swap the off-diagonal blocks: 32x32 first, then 16x16 within those, and so on.
+            Matrix result = *this;
+            auto &a = result.rows;
+            uint64_t mask = 0x00000000FFFFFFFF;
+            for (int j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+                for (int k = 0; k < MAX_SIZE; k = ((k | j) + 1) & ~j) {
+                    const auto swap = ((a[k] >> j) ^ a[k | j]) & mask;
+                    a[k] ^= swap << j;
+                    a[k | j] ^= swap;
+                }
+            }
+            return result;
+        }
+
+        constexpr bool operator==(const Matrix &) const = default;
+    };
+
+} // namespace ui::qr
@@ -84,7 +84,7 @@ namespace ui
         int available_width = lcd::WIDTH - padding * 2;
 
         // Fetch the contents of the README.txt file.
-        const auto readme_bytes = fs::get_file_span("README  TXT");
+        const auto readme_bytes = fs::get_file_span("README.txt");
         const auto readme_text =
                 std::string_view(reinterpret_cast<const char *>(readme_bytes.data()), readme_bytes.size());
 
@@ -15,6 +15,7 @@ namespace ui
 
         void update(int delta_ms) override;
         void draw() override;
+        [[nodiscard]] bool is_static() const override { return !is_scrolling; }
 
         void pause() override;
         void resume() override;
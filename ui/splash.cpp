@@ -9,59 +9,55 @@
 namespace ui
 {
 
-    SplashScreen::SplashScreen() {
-        mask.reset(new uint8_t[lcd::WIDTH * lcd::HEIGHT]);
-        memset(mask.get(), 0, lcd::WIDTH * lcd::HEIGHT);
-
+    SplashScreen::SplashScreen() : State(TICK_DIVIDER) {
         bg_image = image::splash_bg;
-        bg_image.alpha_data = mask.get();
     }
 
-    SplashScreen::~SplashScreen() {
-        mask.reset();
+    void SplashScreen::resume() {
+        // The mask only lives while the splash screen is showing, so it borrows scratch memory.
+        mask = borrow_scratch(lcd::WIDTH * lcd::HEIGHT).data();
+        memset(mask, 0, lcd::WIDTH * lcd::HEIGHT);
+        bg_image.alpha_data = mask;
+        diagonal_ticks = 0;
     }
 
     void SplashScreen::update(int delta_ms) {
-        while (delta_ms > 0) {
-            delta_ms--;
-            time_ms++;
-
-            if (time_ms % TICK_DIVIDER != 0)
-                continue;
+        State::update(delta_ms);
+        if (time_ms > DURATION_MS)
+            pop_state();
+    }
 
-            int diagonal = time_ms / TICK_DIVIDER - 1;
+    void SplashScreen::tick() {
+        // Each tick reveals one more diagonal of the foreground, and later fades it back out.
+        int diagonal = diagonal_ticks++;
 
-            if (diagonal <= lcd::WIDTH + lcd::HEIGHT) {
-                for (int y = 0; y < lcd::HEIGHT; y++) {
-                    const int x = diagonal - y;
-                    if (x >= 0 && x < lcd::WIDTH)
-                        mask[y * lcd::WIDTH + x] = 255 - image::splash_fg.alpha_data[y * lcd::WIDTH + x];
-                }
+        if (diagonal <= lcd::WIDTH + lcd::HEIGHT) {
+            for (int y = 0; y < lcd::HEIGHT; y++) {
+                const int x = diagonal - y;
+                if (x >= 0 && x < lcd::WIDTH)
+                    mask[y * lcd::WIDTH + x] = 255 - image::splash_fg.alpha_data[y * lcd::WIDTH + x];
             }
+        }
 
-            diagonal -= DELAY_1;
+        diagonal -= DELAY_1;
 
-            if (diagonal >= 0 && diagonal <= lcd::WIDTH + lcd::HEIGHT) {
-                for (int y = 0; y < lcd::HEIGHT; y++) {
-                    const int x = diagonal - y;
-                    if (x >= 0 && x < lcd::WIDTH)
-                        mask[y * lcd::WIDTH + x] = image::splash_fg.alpha_data[y * lcd::WIDTH + x];
-                }
+        if (diagonal >= 0 && diagonal <= lcd::WIDTH + lcd::HEIGHT) {
+            for (int y = 0; y < lcd::HEIGHT; y++) {
+                const int x = diagonal - y;
+                if (x >= 0 && x < lcd::WIDTH)
+                    mask[y * lcd::WIDTH + x] = image::splash_fg.alpha_data[y * lcd::WIDTH + x];
             }
+        }
 
-            diagonal -= DELAY_2;
+        diagonal -= DELAY_2;
 
-            if (diagonal >= 0 && diagonal <= lcd::WIDTH + lcd::HEIGHT) {
-                for (int y = 0; y < lcd::HEIGHT; y++) {
-                    const int x = diagonal - y;
-                    if (x >= 0 && x < lcd::WIDTH)
-                        mask[y * lcd::WIDTH + x] = 0;
-                }
+        if (diagonal >= 0 && diagonal <= lcd::WIDTH + lcd::HEIGHT) {
+            for (int y = 0; y < lcd::HEIGHT; y++) {
+                const int x = diagonal - y;
+                if (x >= 0 && x < lcd::WIDTH)
+                    mask[y * lcd::WIDTH + x] = 0;
             }
         }
-
-        if (time_ms > DURATION_MS)
-            pop_state();
     }
 
     void SplashScreen::draw() {
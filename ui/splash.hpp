@@ -1,6 +1,6 @@
 #pragma once
 
-#include <memory>
+#include <cstdint>
 
 #include <badge/image.hpp>
 #include <ui/state.hpp>
@@ -11,19 +11,24 @@ namespace ui
     class SplashScreen final : public State {
     public:
         static constexpr auto DURATION_MS = 2'000;
-        static constexpr auto TICK_DIVIDER = 2;
+        static constexpr auto TICK_DIVIDER = 2; ///< Milliseconds per tick, and per diagonal of the animation.
         static constexpr auto DELAY_1 = 100;
         static constexpr auto DELAY_2 = 500;
 
         SplashScreen();
-        ~SplashScreen() override;
 
         void update(int delta_ms) override;
+        void tick() override;
         void draw() override;
 
+        void resume() override;
+
     protected:
-        std::unique_ptr<uint8_t[]> mask;
+        uint8_t *mask = nullptr;
         image::Image bg_image;
+
+        /// Ticks so far, which is also the diagonal being revealed.
+        int diagonal_ticks = 0;
     };
 
 }
@@ -1,18 +1,49 @@
 #include "state.hpp"
 
+#include <algorithm>
+
 namespace ui
 {
 
+    void State::advance(int delta_ms) {
+        update(delta_ms);
+        if (tick_interval_ms <= 0)
+            return;
+
+        // Stop ticking once this state is left, by `update()` or by a tick.
+        const int max_ticks = std::max(1, MAX_CATCH_UP_MS / tick_interval_ms);
+        tick_time_ms += delta_ms;
+        for (int i = 0; i < max_ticks && tick_time_ms >= tick_interval_ms && active; i++) {
+            tick_time_ms -= tick_interval_ms;
+            tick();
+        }
+        tick_time_ms = std::min(tick_time_ms, tick_interval_ms - 1);
+    }
+
     void State::update(int delta_ms) {
         time_ms += delta_ms;
     }
 
-    void State::pause() {
+    void State::tick() {}
+
+    void State::invalidate() {}
+
+    bool State::is_static() const {
+        return false;
+    }
+
+    void State::leave() {
         active = false;
+        pause();
     }
 
-    void State::resume() {
+    void State::enter() {
         active = true;
+        resume();
     }
 
+    void State::pause() {}
+
+    void State::resume() {}
+
 }
@@ -1,32 +1,55 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 namespace ui
 {
 
+    /// Most time ticked in a single frame. Anything beyond is dropped, so that a slow frame slows the game down rather
+    /// than making the next frames slower still while catching up.
+    constexpr int MAX_CATCH_UP_MS = 100;
+
     class State {
     public:
-        State() = default;
+        /// States that set `tick_interval_ms` get `tick()` called at that fixed rate, independent of the frame rate.
+        explicit State(int tick_interval_ms = 0) : tick_interval_ms(tick_interval_ms) {}
         virtual ~State() = default;
 
+        /// Advance by a frame: `update()` with the time passed, then `tick()` once for every tick interval passed.
+        void advance(int delta_ms);
+
+        /// Once per frame, for input and anything else that does not need a fixed rate.
         virtual void update(int delta_ms);
+
+        /// Fixed-rate logic, for anything that must play out the same way however long frames take.
+        virtual void tick();
+
         virtual void draw() = 0;
 
+        /// Something was drawn over the frame buffers, so states that only redraw what changed must redraw all of it.
+        virtual void invalidate();
+
+        /// Whether the screen stays the same until a button is pressed, so the badge may idle. Off by default, as
+        /// most states animate something.
+        [[nodiscard]] virtual bool is_static() const;
+
+        /// Called by `ui` when the state stops or starts being the current one. Only ticks while current.
+        void leave();
+        void enter();
+
+        /// Overridden by states to drop and set up what they only need while current. Called by `leave()` and
+        /// `enter()`.
         virtual void pause();
         virtual void resume();
 
     protected:
         bool active = false;
         uint32_t time_ms = 0;
-    };
 
-    using StatePtr = std::shared_ptr<State>;
+        const int tick_interval_ms;
 
-    template<typename T, typename... Args>
-    std::shared_ptr<T> make_state(Args&& ... args) {
-        return std::make_shared<T>(std::forward<Args>(args)...);
-    }
+    private:
+        int tick_time_ms = 0; ///< Time passed since the last tick.
+    };
 
 }
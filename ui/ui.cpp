@@ -1,56 +1,158 @@
 #include "ui.hpp"
 
+#include <algorithm>
+
+#include <pico.h>
+
 #include <badge/drawing.hpp>
+#include <badge/memory.hpp>
+#include <badge/profiler.hpp>
 
 namespace ui
 {
 
-    static uint32_t _ui_time_ms = 0;
-    StatePtr _current_state = nullptr;
-    StatePtr _state_stack[STATE_STACK_SIZE];
-    int _state_stack_size = 0;
+    namespace
+    {
+        struct Entry {
+            State *state = nullptr;
+            size_t arena_end = 0; ///< End of the state's arena memory, or zero if it lives elsewhere.
+        };
+
+        uint32_t _ui_time_ms = 0;
+
+        /// All entered states, with the current one on top.
+        Entry _stack[STATE_STACK_SIZE];
+        int _stack_size = 0;
+
+        /// States that were popped, to destroy at the end of the update.
+        Entry _popped[STATE_STACK_SIZE];
+        int _popped_count = 0;
+
+        alignas(8) uint8_t _arena[ARENA_SIZE];
+        size_t _arena_top = 0;
+        size_t _arena_peak = 0;
+
+        State *get_current() {
+            return _stack_size > 0 ? _stack[_stack_size - 1].state : nullptr;
+        }
+
+        size_t align_up(size_t offset, size_t alignment) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        void destroy_popped() {
+            for (int i = 0; i < _popped_count; i++)
+                _popped[i].state->~State();
+            _popped_count = 0;
+
+            // Everything above the topmost live state is free again.
+            _arena_top = 0;
+            for (int i = 0; i < _stack_size; i++)
+                _arena_top = std::max(_arena_top, _stack[i].arena_end);
+        }
+
+        /// Start measuring for a new current state, including what its constructor and `resume()` do.
+        void begin_state() {
+            profiler::clear_history();
+            memory::begin_state();
+        }
+
+        void push(const Entry &entry) {
+            if (_stack_size == STATE_STACK_SIZE)
+                panic("UI state stack is full");
+            if (auto *current = get_current())
+                current->leave();
+            _stack[_stack_size++] = entry;
+            begin_state();
+            entry.state->enter();
+        }
+    } // namespace
 
     void update(int delta_ms) {
         _ui_time_ms += delta_ms;
-        if (_current_state)
-            _current_state->update(delta_ms);
+        if (auto *current = get_current())
+            current->advance(delta_ms);
+        destroy_popped();
     }
 
     void draw() {
-        if (_current_state)
-            _current_state->draw();
+        if (auto *current = get_current())
+            current->draw();
         else
             drawing::clear(0);
     }
 
+    State *get_current_state() {
+        return get_current();
+    }
+
+    void request_full_redraw() {
+        if (auto *current = get_current())
+            current->invalidate();
+    }
+
+    bool is_static() {
+        const auto *current = get_current();
+        return current != nullptr && current->is_static();
+    }
+
     uint32_t get_time_ms() {
         return _ui_time_ms;
     }
 
-    void push_state(const StatePtr& state) {
-        if (_current_state) {
-            _state_stack[_state_stack_size++] = _current_state;
-            _current_state->pause();
-        }
-        _current_state = state;
-        if (_current_state) {
-            _current_state->resume();
-        }
+    void push_state(State *state) {
+        push({state, 0});
     }
 
-    StatePtr pop_state() {
-        auto prev_state = _current_state;
-        if (_state_stack_size == 0)
-            _current_state = nullptr;
-        else {
-            _current_state = _state_stack[--_state_stack_size];
-            _state_stack[_state_stack_size] = nullptr;
-        }
-        if (prev_state)
-            prev_state->pause();
-        if (_current_state)
-            _current_state->resume();
-        return prev_state;
+    void pop_state() {
+        if (_stack_size == 0)
+            return;
+        const auto popped = _stack[--_stack_size];
+        popped.state->leave();
+        if (popped.arena_end != 0)
+            _popped[_popped_count++] = popped;
+        begin_state();
+        if (auto *current = get_current())
+            current->enter();
+    }
+
+    std::span<uint8_t> borrow_scratch(size_t size) {
+        const auto start = align_up(_arena_top, 8);
+        if (start + size > ARENA_SIZE)
+            panic("Scratch memory of %zu bytes does not fit, %zu in use", size, _arena_top);
+        _arena_peak = std::max(_arena_peak, start + size);
+        return {_arena + start, size};
+    }
+
+    size_t get_arena_used() {
+        return _arena_top;
+    }
+
+    size_t get_arena_peak() {
+        return _arena_peak;
     }
 
+    namespace internal
+    {
+        void *begin_push(size_t size, size_t alignment) {
+            // The current state gives up its scratch memory now, before the new state is created on top of it.
+            if (auto *current = get_current())
+                current->leave();
+            begin_state();
+            const auto start = align_up(_arena_top, alignment);
+            if (start + size > ARENA_SIZE)
+                panic("State of %zu bytes does not fit in the arena, %zu in use", size, _arena_top);
+            _arena_top = start + size;
+            _arena_peak = std::max(_arena_peak, _arena_top);
+            return _arena + start;
+        }
+
+        void end_push(State *state) {
+            if (_stack_size == STATE_STACK_SIZE)
+                panic("UI state stack is full");
+            _stack[_stack_size++] = {state, _arena_top};
+            state->enter();
+        }
+    } // namespace internal
+
 }
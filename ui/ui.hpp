@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <new>
+#include <span>
+#include <utility>
 
 #include "state.hpp"
 
@@ -9,18 +13,58 @@ namespace ui
 
     constexpr int STATE_STACK_SIZE = 8;
 
+    /// Memory for the states created by `push_new_state()`, and for the scratch memory they borrow. States are only
+    /// created when they are entered and destroyed when they are left, in stack order, so the arena never has gaps.
+    /// It must fit the largest state, or a state plus the scratch memory it borrows.
+    constexpr size_t ARENA_SIZE = 28 * 1024;
+
     void update(int delta_ms);
     void draw();
 
+    /// Make the current state redraw the whole frame, see `State::invalidate()`.
+    void request_full_redraw();
+
+    /// The state on top of the stack, or null if there is none.
+    State *get_current_state();
+
+    /// Whether the current state is static, see `State::is_static()`.
+    bool is_static();
+
     uint32_t get_ui_time_ms();
 
-    void push_state(const StatePtr& state);
-    StatePtr pop_state();
+    /// Enter a state that lives elsewhere, like a menu kept for the whole run.
+    void push_state(State *state);
+
+    /// Leave the current state. A state created by `push_new_state()` is destroyed once the current `update()` is
+    /// done, so a state may pop itself.
+    void pop_state();
+
+    /**
+     * Borrow `size` bytes of the arena above the states, for a big buffer only needed while a state is current. It is
+     * valid from the state's `resume()` until its `pause()`, and borrowing again replaces it. Panics if it does not
+     * fit.
+     */
+    std::span<uint8_t> borrow_scratch(size_t size);
+
+    /// Bytes of the arena in use by states right now, and the most in use by states and scratch memory so far.
+    size_t get_arena_used();
+    size_t get_arena_peak();
+
+    namespace internal
+    {
+        /// Leave the current state and allocate arena memory for a new one.
+        void *begin_push(size_t size, size_t alignment);
+
+        /// Push a new state created by `begin_push()`, and enter it.
+        void end_push(State *state);
+    } // namespace internal
 
+    /// Create a state in the arena and enter it.
     template<typename T, typename ...Args>
-    StatePtr push_new_state(Args&& ... args) {
-        auto state = make_state<T>(std::forward<Args>(args)...);
-        push_state(state);
+    T *push_new_state(Args&& ... args) {
+        static_assert(sizeof(T) <= ARENA_SIZE, "State does not fit in the arena");
+        auto *state = new (internal::begin_push(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        internal::end_push(state);
         return state;
     }
 
@@ -0,0 +1,87 @@
+#include "data_port.hpp"
+
+#include <cstring>
+
+#include <tusb.h>
+
+#include <utils/ring_buffer.hpp>
+
+namespace usb::data_port
+{
+
+    namespace
+    {
+        /// Small packets queued from the main loop.
+        utils::RingBuffer<1024> _queue;
+
+        std::span<const uint8_t> _buffer;
+        uint32_t _bufferSent = 0;
+
+        /// Write as much of `data` as the CDC FIFO takes, returning the number of bytes written.
+        uint32_t write(std::span<const uint8_t> data) {
+            return tud_cdc_n_write(USB_CDC_DATA, data.data(), data.size());
+        }
+    } // namespace
+
+    bool is_connected() {
+        return tud_cdc_n_connected(USB_CDC_DATA);
+    }
+
+    bool send(PacketType type, uint8_t flags, uint32_t number, std::span<const uint8_t> payload) {
+        if (!is_connected())
+            return false;
+
+        // Push header and payload together, so the queue only ever holds whole packets.
+        uint8_t packet[sizeof(PacketHeader) + 64];
+        if (payload.size() > sizeof(packet) - sizeof(PacketHeader))
+            return false;
+        const auto header = make_header(type, flags, number, payload.size());
+        memcpy(packet, &header, sizeof(header));
+        memcpy(packet + sizeof(header), payload.data(), payload.size());
+        return _queue.push({packet, sizeof(header) + payload.size()});
+    }
+
+    bool send_buffer(std::span<const uint8_t> packet) {
+        if (is_sending_buffer() || !is_connected())
+            return false;
+        _buffer = packet;
+        _bufferSent = 0;
+        return true;
+    }
+
+    bool is_sending_buffer() {
+        return _bufferSent < _buffer.size();
+    }
+
+    uint32_t read(void *buffer, uint32_t size) {
+        return tud_cdc_n_read(USB_CDC_DATA, buffer, size);
+    }
+
+    void task() {
+        if (!is_connected()) {
+            _queue.pop(_queue.size());
+            _buffer = {};
+            _bufferSent = 0;
+            return;
+        }
+
+        // Packets must not be interleaved, so a buffer that is partly sent is finished first. Otherwise the queue
+        // is drained until empty, which is always at a packet boundary, before the next buffer starts.
+        if (_bufferSent > 0 && is_sending_buffer())
+            _bufferSent += write(_buffer.subspan(_bufferSent));
+
+        if (!is_sending_buffer() || _bufferSent == 0) {
+            while (_queue.size() > 0) {
+                const auto n = write(_queue.peek());
+                if (n == 0)
+                    break;
+                _queue.pop(n);
+            }
+            if (_queue.size() == 0 && is_sending_buffer())
+                _bufferSent += write(_buffer.subspan(_bufferSent));
+        }
+
+        tud_cdc_n_write_flush(USB_CDC_DATA);
+    }
+
+}
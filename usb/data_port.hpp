@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+/**
+ * Packet framing on the data CDC port.
+ *
+ * Everything the badge sends on the data port is wrapped in packets, so the host can tell screen mirroring frames
+ * and replies to remote commands apart, and resynchronize after opening the port in the middle of a packet. All
+ * values are little endian:
+ *
+ *     char     magic[2]   "BM"
+ *     uint8_t  type       PacketType
+ *     uint8_t  flags      Depends on the type
+ *     uint32_t number     Frame number the packet belongs to
+ *     uint32_t size       Size of the payload that follows
+ */
+namespace usb::data_port
+{
+
+    constexpr char PACKET_MAGIC[2] = {'B', 'M'};
+
+    enum PacketType : uint8_t {
+        PACKET_FRAME = 1,   ///< Screen contents, see `usb/mirror.hpp`.
+        PACKET_TIMING = 2,  ///< Frame timing, see `usb/remote.hpp`.
+        PACKET_ACK = 3,     ///< A remote command finished, see `usb/remote.hpp`.
+        PACKET_PROFILE = 4, ///< Profiler paths and samples, see `usb/remote.hpp`.
+        PACKET_MEMORY = 5,  ///< Heap and stack usage, see `usb/remote.hpp`.
+    };
+
+    struct __packed PacketHeader {
+        char magic[2];
+        uint8_t type;
+        uint8_t flags;
+        uint32_t number;
+        uint32_t size;
+    };
+
+    static_assert(sizeof(PacketHeader) == 12);
+
+    inline PacketHeader make_header(PacketType type, uint8_t flags, uint32_t number, uint32_t size) {
+        return {{PACKET_MAGIC[0], PACKET_MAGIC[1]}, type, flags, number, size};
+    }
+
+    /// Whether a host has the data port open.
+    bool is_connected();
+
+    /// Queue a small packet. Returns false, dropping the packet, if the queue is full or no host is connected.
+    bool send(PacketType type, uint8_t flags, uint32_t number, std::span<const uint8_t> payload);
+
+    /// Send a large packet, header included, without copying it. The data must stay untouched until
+    /// `is_sending_buffer()` returns false. Returns false if another buffer is still being sent.
+    bool send_buffer(std::span<const uint8_t> packet);
+
+    [[nodiscard]] bool is_sending_buffer();
+
+    /// Read received bytes, returning how many were read.
+    uint32_t read(void *buffer, uint32_t size);
+
+    /// Send queued data to the host. Called from `usb::task()`.
+    void task();
+
+}
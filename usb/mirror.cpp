@@ -0,0 +1,135 @@
+#include "mirror.hpp"
+
+#include <bitset>
+#include <cstring>
+
+#include <badge/lcd.hpp>
+
+#include "data_port.hpp"
+
+namespace usb::mirror
+{
+
+    namespace
+    {
+        using data_port::PacketHeader;
+
+        struct __packed FrameHeader {
+            uint16_t width;
+            uint16_t height;
+        };
+
+        static_assert(lcd::HEIGHT < END_OF_ROWS);
+
+        /// Large enough for typical UI changes, while full screen updates are spread over a few packets.
+        constexpr uint32_t BUFFER_SIZE = 8 * 1024;
+
+        uint8_t _buffer[BUFFER_SIZE];
+
+        /// Rows where the host's copy may differ from the frame on screen.
+        std::bitset<lcd::HEIGHT> _pendingRows;
+        bool _hostConnected = false;
+
+        /// Encode one row, skipping pixels that match `previous` unless it is null.
+        /// Returns the end of the encoded data, or null if it does not fit.
+        uint8_t *encode_row(uint8_t *out, const uint8_t *end, const Pixel *row, const Pixel *previous) {
+            const auto put_pixel = [&out](Pixel pixel) {
+                *out++ = pixel & 0xFF;
+                *out++ = pixel >> 8;
+            };
+            const auto same_as_previous = [&](int x) { return previous != nullptr && row[x] == previous[x]; };
+            const auto fill_length = [&](int x) {
+                int n = 1;
+                while (x + n < lcd::WIDTH && n < MAX_RUN && row[x + n] == row[x])
+                    n++;
+                return n;
+            };
+
+            int x = 0;
+            while (x < lcd::WIDTH) {
+                if (end - out < 1 + 2 * MAX_RUN)
+                    return nullptr;
+
+                if (same_as_previous(x)) {
+                    int n = 1;
+                    while (x + n < lcd::WIDTH && n < MAX_RUN && same_as_previous(x + n))
+                        n++;
+                    *out++ = RUN_SKIP | (n - 1);
+                    x += n;
+                    continue;
+                }
+
+                if (const auto n = fill_length(x); n >= 3) {
+                    *out++ = RUN_FILL | (n - 1);
+                    put_pixel(row[x]);
+                    x += n;
+                    continue;
+                }
+
+                // Copy pixels until a skip or fill run would be cheaper.
+                int n = 1;
+                while (x + n < lcd::WIDTH && n < MAX_RUN && !same_as_previous(x + n) && fill_length(x + n) < 3)
+                    n++;
+                *out++ = RUN_COPY | (n - 1);
+                for (int i = 0; i < n; i++)
+                    put_pixel(row[x + i]);
+                x += n;
+            }
+            return out;
+        }
+    } // namespace
+
+    void init() {
+        lcd::set_swap_callback(capture);
+    }
+
+    void capture(const Pixel *frame, const Pixel *previous) {
+        if (!data_port::is_connected()) {
+            _hostConnected = false;
+            return;
+        }
+
+        // A newly connected host knows nothing, so it needs every row.
+        if (!_hostConnected) {
+            _hostConnected = true;
+            _pendingRows.set();
+        }
+
+        // Rows that were already pending cannot be encoded relative to the previous frame, since the host never got
+        // that version of them.
+        const auto stale_rows = _pendingRows;
+        for (int y = 0; y < lcd::HEIGHT; y++) {
+            if (memcmp(&frame[y * lcd::WIDTH], &previous[y * lcd::WIDTH], lcd::WIDTH * sizeof(Pixel)) != 0)
+                _pendingRows.set(y);
+        }
+
+        if (data_port::is_sending_buffer())
+            return; // Still sending the last packet; drop this frame.
+
+        const FrameHeader frame_header = {lcd::WIDTH, lcd::HEIGHT};
+        memcpy(_buffer + sizeof(PacketHeader), &frame_header, sizeof(frame_header));
+
+        auto *out = _buffer + sizeof(PacketHeader) + sizeof(FrameHeader);
+        const auto *end = _buffer + BUFFER_SIZE - 1; // Keep room for the end marker.
+        for (int y = 0; y < lcd::HEIGHT; y++) {
+            if (!_pendingRows.test(y))
+                continue;
+            const auto *row_previous = stale_rows.test(y) ? nullptr : &previous[y * lcd::WIDTH];
+            auto *row_end = encode_row(out + 1, end, &frame[y * lcd::WIDTH], row_previous);
+            if (row_end == nullptr)
+                break; // Out of space; the remaining rows stay pending.
+            *out = y;
+            out = row_end;
+            _pendingRows.reset(y);
+        }
+        *out++ = END_OF_ROWS;
+
+        const auto header = data_port::make_header(data_port::PACKET_FRAME,
+                                                   _pendingRows.none() ? FRAME_COMPLETE : 0,
+                                                   lcd::get_frame_count(),
+                                                   out - _buffer - sizeof(PacketHeader));
+        memcpy(_buffer, &header, sizeof(header));
+        data_port::send_buffer({_buffer, static_cast<size_t>(out - _buffer)});
+    }
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include <badge/pixel.hpp>
+
+/**
+ * Screen mirroring over the data CDC port.
+ *
+ * While a host has the data port open, every frame passed to `lcd::swap()` is sent as a `PACKET_FRAME` packet (see
+ * `usb/data_port.hpp`), with the flag `FRAME_COMPLETE` set if every changed row is included. The payload starts with
+ * the screen width and height as `uint16_t`, followed by a list of rows. Each row is a row index followed by runs
+ * covering the whole row, and the list is terminated by the row index 0xFF. Each run starts with a byte holding the
+ * run type in the top two bits and the run length minus one in the lower six bits, like the skip/copy runs of the
+ * animation codec:
+ *
+ *     RUN_SKIP : Pixels did not change since the last packet.
+ *     RUN_COPY : RGB565 pixels follow.
+ *     RUN_FILL : One RGB565 pixel follows, repeated for the whole run.
+ *
+ * Only one frame is in flight at a time. When the host falls behind, frames are dropped rather than stalling the
+ * UI, and the rows that changed meanwhile are sent with the next packet. Rows that do not fit in a packet are
+ * carried over as well, so the host catches up over a few frames after large changes. Gaps in the frame numbers
+ * tell the host how many frames were dropped.
+ */
+namespace usb::mirror
+{
+
+    constexpr uint8_t FRAME_COMPLETE = 1 << 0;
+
+    constexpr uint8_t RUN_SKIP = 0x00;
+    constexpr uint8_t RUN_COPY = 0x40;
+    constexpr uint8_t RUN_FILL = 0x80;
+    constexpr int MAX_RUN = 64;
+
+    constexpr uint8_t END_OF_ROWS = 0xFF;
+
+    /// Start mirroring frames from `lcd::swap()`.
+    void init();
+
+    /// Encode a frame, if the previous one has been sent completely.
+    void capture(const Pixel *frame, const Pixel *previous);
+
+}
@@ -0,0 +1,279 @@
+#include "remote.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+
+#include <pico/time.h>
+
+#include <badge/buttons.hpp>
+#include <badge/lcd.hpp>
+#include <badge/memory.hpp>
+#include <badge/profiler.hpp>
+
+#include "data_port.hpp"
+
+namespace usb::remote
+{
+
+    namespace
+    {
+        bool _stepping = false;
+        bool _sendTiming = false;
+        bool _sendProfile = false;
+        /// Paths and samples the host has been sent.
+        int _profilePathsSent = 0;
+        uint32_t _profileSamplesSent = 0;
+
+        /// Buttons held, and frames left to run, for the current command.
+        uint32_t _actionButtons = 0;
+        int _actionFrames = 0;
+        /// A `press` is followed by a frame with the buttons released.
+        bool _releaseAfterAction = false;
+        bool _ackAfterFrame = false;
+
+        char _line[64];
+        int _lineLength = 0;
+
+        uint32_t _frameStartUs = 0;
+        uint32_t _frameIntervalUs = 0;
+
+        void ack(bool ok) {
+            const uint8_t status = ok ? 0 : 1;
+            data_port::send(data_port::PACKET_ACK, 0, lcd::get_frame_count(), {&status, 1});
+        }
+
+        std::string_view next_word(std::string_view &text) {
+            const auto start = text.find_first_not_of(' ');
+            if (start == std::string_view::npos) {
+                text = {};
+                return {};
+            }
+            text = text.substr(start);
+            const auto end = std::min(text.find(' '), text.size());
+            const auto word = text.substr(0, end);
+            text = text.substr(end);
+            return word;
+        }
+
+        bool parse_int(std::string_view text, int &value) {
+            const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+            return result.ec == std::errc() && result.ptr == text.data() + text.size() && value >= 0;
+        }
+
+        bool parse_buttons(std::string_view text, uint32_t &mask) {
+            struct Name {
+                std::string_view name;
+                int button;
+            };
+            constexpr Name NAMES[] = {
+                {"up", BTN_UP}, {"down", BTN_DOWN}, {"left", BTN_LEFT}, {"right", BTN_RIGHT}, {"push", BTN_PUSH},
+                {"a", BTN_A},   {"b", BTN_B},       {"c", BTN_C},       {"d", BTN_D},
+            };
+
+            mask = 0;
+            if (text == "none")
+                return true;
+            while (!text.empty()) {
+                const auto end = std::min(text.find('+'), text.size());
+                const auto name = text.substr(0, end);
+                const auto *it = std::find_if(std::begin(NAMES), std::end(NAMES), [name](const auto &n) {
+                    return n.name == name;
+                });
+                if (it == std::end(NAMES))
+                    return false;
+                mask |= 1 << it->button;
+                text = text.substr(std::min(end + 1, text.size()));
+            }
+            return mask != 0;
+        }
+
+        void set_profiling(bool on) {
+            _sendProfile = on;
+            _profilePathsSent = 0;
+            _profileSamplesSent = profiler::get_samples_taken();
+            profiler::set_used(profiler::USER_REMOTE, on);
+        }
+
+        void send_profile() {
+            const auto number = lcd::get_frame_count();
+            uint8_t payload[sizeof(ProfileSample) + 2 * profiler::MAX_PATHS];
+
+            for (; _profilePathsSent < profiler::get_path_count(); _profilePathsSent++) {
+                if (_profilePathsSent == profiler::ROOT_PATH)
+                    continue;
+                const auto path = profiler::get_path(_profilePathsSent);
+                const ProfilePath header = {static_cast<uint8_t>(_profilePathsSent), path.parent};
+                const std::string_view name = profiler::ZONE_NAMES[path.zone];
+                memcpy(payload, &header, sizeof(header));
+                memcpy(payload + sizeof(header), name.data(), name.size());
+                // With the queue full, the rest follows next frame. Samples make no sense to the host before that.
+                const std::span<const uint8_t> packet = {payload, sizeof(header) + name.size()};
+                if (!data_port::send(data_port::PACKET_PROFILE, PROFILE_PATH, number, packet))
+                    return;
+            }
+
+            if (_profileSamplesSent == profiler::get_samples_taken())
+                return;
+            _profileSamplesSent = profiler::get_samples_taken();
+            const auto &sample = profiler::get_sample(0);
+            const ProfileSample header = {sample.frame_us, sample.busy_us};
+            const auto times_size = (profiler::get_path_count() - 1) * sizeof(uint16_t);
+            memcpy(payload, &header, sizeof(header));
+            memcpy(payload + sizeof(header), &sample.self_us[profiler::ROOT_PATH + 1], times_size);
+            data_port::send(data_port::PACKET_PROFILE, PROFILE_SAMPLE, number, {payload, sizeof(header) + times_size});
+        }
+
+        void start_action(uint32_t buttons, int frames, bool release_after) {
+            _actionButtons = buttons;
+            _actionFrames = frames;
+            _releaseAfterAction = release_after;
+        }
+
+        void reset() {
+            _stepping = false;
+            _sendTiming = false;
+            if (_sendProfile)
+                set_profiling(false);
+            _actionFrames = 0;
+            _releaseAfterAction = false;
+            _ackAfterFrame = false;
+            _lineLength = 0;
+            buttons::clear_override();
+        }
+    } // namespace
+
+    bool execute(std::string_view line) {
+        const auto command = next_word(line);
+        const auto arg1 = next_word(line);
+        const auto arg2 = next_word(line);
+        if (!next_word(line).empty())
+            return false;
+
+        uint32_t mask = 0;
+        int n = 0;
+        if (command.empty() || command[0] == '#')
+            return true;
+        if (command == "pause" && arg1.empty()) {
+            _stepping = true;
+            return true;
+        }
+        if (command == "resume" && arg1.empty()) {
+            _stepping = false;
+            return true;
+        }
+        if (command == "hold" && parse_buttons(arg1, mask) && parse_int(arg2, n)) {
+            start_action(mask, n, false);
+            return true;
+        }
+        if (command == "press" && parse_buttons(arg1, mask) && arg2.empty()) {
+            start_action(mask, 1, true);
+            return true;
+        }
+        if (command == "wait" && parse_int(arg1, n) && arg2.empty()) {
+            start_action(0, n, false);
+            return true;
+        }
+        if (command == "timing" && (arg1 == "on" || arg1 == "off") && arg2.empty()) {
+            _sendTiming = arg1 == "on";
+            return true;
+        }
+        if (command == "memory" && arg1.empty()) {
+            const auto stats = memory::get_stats();
+            data_port::send(data_port::PACKET_MEMORY, 0, lcd::get_frame_count(),
+                            {reinterpret_cast<const uint8_t *>(&stats), sizeof(stats)});
+            return true;
+        }
+        if (command == "memory" && arg1 == "reset" && arg2.empty()) {
+            memory::reset_peak();
+            return true;
+        }
+        if (command == "profile" && (arg1 == "on" || arg1 == "off") && arg2.empty()) {
+            set_profiling(arg1 == "on");
+            return true;
+        }
+        return false;
+    }
+
+    void task() {
+        // Never leave the badge frozen when the host goes away in the middle of a script.
+        if (!data_port::is_connected()) {
+            if (_stepping || _actionFrames > 0 || _sendTiming || _sendProfile)
+                reset();
+            return;
+        }
+
+        // Commands that run frames are finished before the next one is read, so a script can be sent in one go and
+        // wait in the CDC receive buffer.
+        char ch;
+        while (_actionFrames == 0 && !_ackAfterFrame && data_port::read(&ch, 1) == 1) {
+            if (ch == '\r')
+                continue;
+            if (ch != '\n') {
+                if (_lineLength < static_cast<int>(sizeof(_line)))
+                    _line[_lineLength++] = ch;
+                continue;
+            }
+
+            const std::string_view line(_line, _lineLength);
+            _lineLength = 0;
+            const auto start = line.find_first_not_of(' ');
+            if (start == std::string_view::npos || line[start] == '#')
+                continue;
+
+            // Commands that run frames are acknowledged once their last frame has been drawn.
+            const bool ok = line.size() < sizeof(_line) && execute(line);
+            if (!ok || _actionFrames == 0)
+                ack(ok);
+        }
+    }
+
+    bool is_stepping() {
+        return _stepping;
+    }
+
+    bool begin_frame() {
+        if (_actionFrames > 0) {
+            buttons::set_override(_actionButtons);
+            if (--_actionFrames == 0) {
+                if (_releaseAfterAction)
+                    start_action(0, 1, false);
+                else
+                    _ackAfterFrame = true;
+            }
+        }
+        else if (_stepping) {
+            return false;
+        }
+        else {
+            buttons::clear_override();
+        }
+
+        const auto now = time_us_32();
+        _frameIntervalUs = now - _frameStartUs;
+        _frameStartUs = now;
+        return true;
+    }
+
+    void end_frame(uint32_t swap_us, uint32_t update_us, uint32_t draw_us) {
+        if (_sendTiming) {
+            const FrameTiming timing = {
+                .interval_us = _frameIntervalUs,
+                .swap_us = swap_us,
+                .update_us = update_us,
+                .draw_us = draw_us,
+                .buttons = buttons::get_current(~0u),
+            };
+            data_port::send(data_port::PACKET_TIMING, 0, lcd::get_frame_count(),
+                            {reinterpret_cast<const uint8_t *>(&timing), sizeof(timing)});
+        }
+        if (_sendProfile)
+            send_profile();
+        if (_ackAfterFrame) {
+            _ackAfterFrame = false;
+            ack(true);
+        }
+    }
+
+}
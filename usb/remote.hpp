@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Remote control of the UI through the data CDC port, for scripted tests and benchmarks.
+ *
+ * The host sends one command per line. Each command is answered with a `PACKET_ACK` packet (see
+ * `usb/data_port.hpp`) holding a single status byte, zero on success. Commands that run frames are answered once the
+ * last of their frames has been drawn, and further commands are not read before that.
+ *
+ *     pause               Only run frames when asked to by the commands below, with a fixed frame time.
+ *     resume              Run freely again, using the physical buttons.
+ *     hold <buttons> <n>  Run `n` frames with the given buttons held.
+ *     press <buttons>     Run one frame with the buttons held, then one with them released.
+ *     wait <n>            Run `n` frames with no buttons held.
+ *     timing on|off       Send a `PACKET_TIMING` packet with a `FrameTiming` payload after every frame.
+ *     profile on|off      Run the profiler (see `badge/profiler.hpp`) and send its samples in `PACKET_PROFILE` packets.
+ *     memory              Send a `PACKET_MEMORY` packet with a `memory::Stats` payload (see `badge/memory.hpp`).
+ *     memory reset        Start measuring the heap's peak again.
+ *
+ * Buttons are given by name (up, down, left, right, push, a, b, c, d) joined with '+', or as "none". Lines starting
+ * with '#' are ignored. The same lines make up the scripts run by `tools/ui-script.py`.
+ *
+ * While profiling, every frame sends a `PROFILE_SAMPLE` packet for the frame before it, preceded by a `PROFILE_PATH`
+ * packet for each path the host has not been told about yet. `tools/profile-flame.py` turns them into a flame chart.
+ */
+namespace usb::remote
+{
+
+    struct __packed FrameTiming {
+        uint32_t interval_us; ///< Time since the previous frame started.
+        uint32_t swap_us;     ///< Waiting for the previous frame to be sent to the LCD.
+        uint32_t update_us;
+        uint32_t draw_us;
+        uint32_t buttons;     ///< Buttons held during the frame, as a mask of `1 << BTN_*`.
+    };
+
+    /// Flags of `PACKET_PROFILE` packets, telling what the payload is.
+    enum ProfileFlags : uint8_t {
+        PROFILE_PATH = 0,   ///< A `ProfilePath` followed by the name of its innermost zone, not null terminated.
+        PROFILE_SAMPLE = 1, ///< A `ProfileSample` followed by the `uint16_t` time of every path but the root.
+    };
+
+    struct __packed ProfilePath {
+        uint8_t path;
+        uint8_t parent; ///< Path this one is nested in. The root path is 0 and is never sent.
+    };
+
+    struct __packed ProfileSample {
+        uint32_t frame_us;
+        uint32_t busy_us; ///< Time spent in the paths, so the root took the rest of the frame.
+    };
+
+    /// Execute one command line. Returns false if the command is invalid.
+    bool execute(std::string_view line);
+
+    /// Read and execute commands from the data port. Called from `usb::task()`.
+    void task();
+
+    /// Whether frames run only when requested, with a fixed frame time.
+    bool is_stepping();
+
+    /// Called by the main loop before a frame. Returns false if the frame should not run yet.
+    bool begin_frame();
+
+    /// Called by the main loop after a frame has been drawn.
+    void end_frame(uint32_t swap_us, uint32_t update_us, uint32_t draw_us);
+
+}
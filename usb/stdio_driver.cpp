@@ -1,27 +1,19 @@
 
 #include <pico/stdio/driver.h>
 
-#include <tusb.h>
+#include "usb.hpp"
 
 namespace
 {
+    // Output is only queued here; `usb::task()` sends it to the host from the main loop. This keeps `printf` fast
+    // even when called from time critical code, or when no host is listening.
     void out_chars(const char* buf, int len) {
-        if (tud_connected()) {
-            tud_cdc_write(buf, len);
-            tud_cdc_write_flush();
-            while (tud_task_event_ready())
-                tud_task();
-        }
-    }
-    void out_flush() {
-        if (tud_connected())
-            tud_cdc_write_flush();
+        usb::write(buf, len);
     }
 }
 
 stdio_driver usb_stdio_driver = {
     .out_chars = out_chars,
-    .out_flush = out_flush,
     .crlf_enabled = true,
 };
 
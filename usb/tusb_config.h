@@ -2,12 +2,13 @@
 
 #define CFG_TUSB_RHPORT0_MODE (OPT_MODE_DEVICE)
 
-#define CFG_TUD_CDC 1
+#define CFG_TUD_CDC 2
 #define CFG_TUD_CDC_RX_BUFSIZE 1024
 #define CFG_TUD_CDC_TX_BUFSIZE 1024
 
 #define CFG_TUD_MSC 1
-#define CFG_TUD_MSC_EP_BUFSIZE 1024
+// One whole FLASH sector per READ10/WRITE10 callback, so each callback is a single DMA transfer or cache line update.
+#define CFG_TUD_MSC_EP_BUFSIZE 4096
 
 #define USB_VID 0xcafe
 #define USB_PID 0xcafe
@@ -18,6 +19,8 @@ enum {
     USB_IF_NUM_CDC = 0,
     USB_IF_NUM_CDC_DATA,
     USB_IF_NUM_MSC,
+    USB_IF_NUM_DATA,
+    USB_IF_NUM_DATA_DATA,
     USB_IF_NUM_TOTAL
 };
 
@@ -28,6 +31,16 @@ enum {
 
     USB_EP_NUM_MSC_OUT   = 0x03,
     USB_EP_NUM_MSC_IN    = 0x83,
+
+    USB_EP_NUM_DATA_NOTIF = 0x84,
+    USB_EP_NUM_DATA_OUT   = 0x05,
+    USB_EP_NUM_DATA_IN    = 0x85,
+};
+
+/// CDC instances, in the order their interfaces appear in the configuration descriptor.
+enum {
+    USB_CDC_CONSOLE = 0, ///< Text console carrying the log output.
+    USB_CDC_DATA,        ///< Binary data port, see `usb/mirror.hpp`.
 };
 
 enum {
@@ -40,6 +53,8 @@ enum {
     USB_STRING_CDC_IF,
 
     USB_STRING_MSC_IF,
+
+    USB_STRING_DATA_IF,
 };
 
 #define USB_MSC_BLOCK_SIZE 512
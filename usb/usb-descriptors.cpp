@@ -26,7 +26,7 @@ constexpr tusb_desc_device_t device_descriptor = {
     .bNumConfigurations = 1
 };
 
-#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN)
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN + TUD_CDC_DESC_LEN)
 
 constexpr uint8_t fs_config_descriptor[] = {
 
@@ -59,6 +59,17 @@ constexpr uint8_t fs_config_descriptor[] = {
         USB_EP_NUM_MSC_IN,      // IN endpoint
         64                      // OUT/IN endpoint max packet size
     ),
+
+    // Data CDC Interface Descriptor
+    TUD_CDC_DESCRIPTOR(
+        USB_IF_NUM_DATA,        // Interface number
+        USB_STRING_DATA_IF,     // Interface name string index
+        USB_EP_NUM_DATA_NOTIF,  // Notification endpoint
+        8,                      // Notification max packet size
+        USB_EP_NUM_DATA_OUT,    // OUT endpoint
+        USB_EP_NUM_DATA_IN,     // IN endpoint
+        64                      // OUT/IN endpoint max packet size
+    ),
 };
 
 uint8_t const * tud_descriptor_device_cb() {
@@ -77,6 +88,7 @@ const char16_t* get_string(int index) {
         case USB_STRING_SERIAL:     return u"[Serial Number]";
         case USB_STRING_CDC_IF:     return u"Badge COM Port";
         case USB_STRING_MSC_IF:     return u"Badge Mass Storage";
+        case USB_STRING_DATA_IF:    return u"Badge Data Port";
         default:
             return nullptr;
     }
@@ -1,33 +1,146 @@
 #include "usb.hpp"
 
+#include <cstdio>
+#include <cstring>
+
+#include <hardware/sync.h>
+#include <pico/time.h>
+
 #include <tusb.h>
 
+#include <utils/ring_buffer.hpp>
+
+#include "data_port.hpp"
+#include "mirror.hpp"
+#include "remote.hpp"
+
 namespace usb
 {
 
+    namespace
+    {
+        /// Log output waiting to be sent. Large enough to hold the boot log until a terminal is opened.
+        utils::RingBuffer<4096> _logBuffer;
+
+        /// Serializes producers on both cores. It is only held while copying into the buffer, never while waiting
+        /// for the host.
+        spin_lock_t *_logLock = nullptr;
+
+        bool _hostActivity = false;
+
+        uint32_t _droppedBytes = 0;
+        uint32_t _reportedDroppedBytes = 0;
+
+        bool push(const char *data, int len) {
+            if (_logLock == nullptr)
+                return false; // Not initialized yet.
+            const auto save = spin_lock_blocking(_logLock);
+            const bool ok = _logBuffer.push({reinterpret_cast<const uint8_t *>(data), static_cast<size_t>(len)});
+            if (!ok)
+                _droppedBytes += len;
+            spin_unlock(_logLock, save);
+            return ok;
+        }
+    } // namespace
+
     void init() {
         printf("> Init USB ... ");
 
+        _logLock = spin_lock_instance(spin_lock_claim_unused(true));
+
         constexpr tusb_rhport_init_t dev_init = {
             .role = TUSB_ROLE_DEVICE,
             .speed = TUSB_SPEED_AUTO,
         };
         tusb_init(0, &dev_init);
 
+        mirror::init();
+
         printf("OK\n");
     }
 
+    void task() {
+        remote::task();
+        data_port::task();
+
+        // Keep the log buffered until a terminal is connected, so the boot log is not lost.
+        if (!tud_cdc_n_connected(USB_CDC_CONSOLE))
+            return;
+
+        while (tud_cdc_n_write_available(USB_CDC_CONSOLE) > 0) {
+            const auto pending = _logBuffer.peek();
+            if (pending.empty())
+                break;
+            const auto n = tud_cdc_n_write(USB_CDC_CONSOLE, pending.data(), pending.size());
+            _logBuffer.pop(n);
+        }
+
+        // Report dropped output once, after what was buffered before the overflow has been sent.
+        if (_droppedBytes != _reportedDroppedBytes && _logBuffer.size() == 0) {
+            char message[64];
+            const auto dropped = _droppedBytes;
+            snprintf(message, sizeof(message), "\r\n! USB: Dropped %lu bytes of log output\r\n",
+                     dropped - _reportedDroppedBytes);
+            if (push(message, static_cast<int>(strlen(message))))
+                _reportedDroppedBytes = dropped;
+        }
+
+        tud_cdc_n_write_flush(USB_CDC_CONSOLE);
+    }
+
     void write(const char *text) {
-        for (int i = 0; i < CFG_TUD_CDC_TX_BUFSIZE && text[i] != 0; i++) {
-            if (text[i] == '\n' && (i == 0 || text[i-1] != '\r')) {
-                tud_cdc_write_char('\r');
+        // Queue one line at a time, so a line is either sent as a whole or dropped as a whole.
+        char line[128];
+        int n = 0;
+        for (int i = 0; text[i] != 0; i++) {
+            if (text[i] == '\n' && (i == 0 || text[i-1] != '\r'))
+                line[n++] = '\r';
+            line[n++] = text[i];
+            if (text[i] == '\n' || n >= static_cast<int>(sizeof(line)) - 2) {
+                push(line, n);
+                n = 0;
             }
-            tud_cdc_write_char(text[i]);
-            if (text[i] == '\n')
-                tud_cdc_write_flush();
         }
+        if (n > 0)
+            push(line, n);
     }
 
-}
+    void write(const char *data, int len) {
+        push(data, len);
+    }
 
+    bool flush(uint32_t timeout_ms) {
+        const auto deadline = make_timeout_time_ms(timeout_ms);
+        while (_logBuffer.size() > 0) {
+            if (time_reached(deadline))
+                return false;
+            tud_task();
+            task();
+        }
+        return true;
+    }
+
+    void note_host_activity() {
+        _hostActivity = true;
+    }
 
+    bool take_host_activity() {
+        const auto activity = _hostActivity;
+        _hostActivity = false;
+        return activity;
+    }
+
+    bool has_host_activity() {
+        return _hostActivity;
+    }
+
+    uint32_t get_dropped_log_bytes() {
+        return _droppedBytes;
+    }
+
+}
+
+// Called by TinyUSB when data arrives on either serial port.
+extern "C" void tud_cdc_rx_cb(uint8_t) {
+    usb::note_host_activity();
+}
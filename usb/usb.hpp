@@ -1,10 +1,37 @@
 #pragma once
 
+#include <cstdint>
+
 namespace usb
 {
 
     void init();
 
+    /// Send pending log output to the host. Called from the main loop.
+    void task();
+
+    /// Queue text to be sent over CDC, converting line endings to CRLF. Never blocks: if the text does not fit in the
+    /// log buffer it is dropped, and the number of dropped bytes is reported once there is room again.
     void write(const char* text);
 
+    /// Queue raw bytes to be sent over CDC. Safe to call from either core and from interrupt handlers.
+    void write(const char* data, int len);
+
+    /// Send all queued log output before returning, for output larger than the log buffer. Waits for a terminal to
+    /// be connected for at most `timeout_ms`, so only for use outside the main loop. Returns whether all was sent.
+    bool flush(uint32_t timeout_ms);
+
+    /// Note that the host sent something: data on a serial port, or a drive read or write. Polling and output going
+    /// to the host do not count, so a terminal or drive left open does not keep the badge from idling.
+    void note_host_activity();
+
+    /// Whether the host sent anything since the last call.
+    bool take_host_activity();
+
+    /// Whether the host sent something since `take_host_activity()` was last called, without clearing it.
+    bool has_host_activity();
+
+    /// Total number of log bytes dropped because the buffer was full.
+    uint32_t get_dropped_log_bytes();
+
 }
@@ -53,17 +53,70 @@ namespace utils
         return result;
     }
 
-    constexpr auto CRC32_TABLE = compute_crc32_table();
+    // Slice-by-8 processes eight bytes per step, using one table per byte position. Table `n` holds the CRC of a
+    // byte followed by `n` zero bytes, so the eight lookups can be combined with XOR.
+    consteval auto compute_crc32_slice_tables() {
+        std::array<std::array<uint32_t, 256>, 8> result = {};
+        result[0] = compute_crc32_table();
+        for (int n = 1; n < 8; n++) {
+            for (int idx = 0; idx < 256; idx++) {
+                const auto prev = result[n - 1][idx];
+                result[n][idx] = result[0][prev & 0xFF] ^ (prev >> 8);
+            }
+        }
+        return result;
+    }
+
+    constexpr auto CRC32_TABLES = compute_crc32_slice_tables();
+    constexpr auto &CRC32_TABLE = CRC32_TABLES[0];
 
-    constexpr auto compute_crc32(std::span<const uint8_t> bytes) {
-        uint32_t crc = ~0;
+    /// Reference implementation, one byte at a time. `crc` is the internal (inverted) state.
+    constexpr uint32_t update_crc32_bytewise(uint32_t crc, std::span<const uint8_t> bytes) {
         for (auto byte : bytes)
             crc = CRC32_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8);
-        return ~crc;
+        return crc;
+    }
+
+    constexpr uint32_t update_crc32_slice8(uint32_t crc, std::span<const uint8_t> bytes) {
+        const auto *p = bytes.data();
+        auto size = bytes.size();
+        // Assemble the words from bytes; the data may not be aligned, and the Cortex-M0+ has no unaligned loads.
+        for (; size >= 8; p += 8, size -= 8) {
+            const uint32_t lo = crc ^ (p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24);
+            const uint32_t hi = p[4] | p[5] << 8 | p[6] << 16 | static_cast<uint32_t>(p[7]) << 24;
+            crc = CRC32_TABLES[7][lo & 0xFF] ^ CRC32_TABLES[6][(lo >> 8) & 0xFF] ^
+                  CRC32_TABLES[5][(lo >> 16) & 0xFF] ^ CRC32_TABLES[4][lo >> 24] ^
+                  CRC32_TABLES[3][hi & 0xFF] ^ CRC32_TABLES[2][(hi >> 8) & 0xFF] ^
+                  CRC32_TABLES[1][(hi >> 16) & 0xFF] ^ CRC32_TABLES[0][hi >> 24];
+        }
+        return update_crc32_bytewise(crc, {p, size});
     }
 
+    constexpr auto compute_crc32(std::span<const uint8_t> bytes, uint32_t crc = 0) {
+        return ~update_crc32_slice8(~crc, bytes);
+    }
+
+    constexpr auto compute_crc32_bytewise(std::span<const uint8_t> bytes, uint32_t crc = 0) {
+        return ~update_crc32_bytewise(~crc, bytes);
+    }
+
+    consteval auto make_crc32_test_data() {
+        std::array<uint8_t, 61> result = {};
+        for (size_t i = 0; i < result.size(); i++)
+            result[i] = i * 37 + 11;
+        return result;
+    }
+
+    constexpr auto CRC32_TEST_DATA = make_crc32_test_data();
+    constexpr auto CRC32_TEST_SPAN = std::span(CRC32_TEST_DATA);
+
+    static_assert(compute_crc32_bytewise(TEST_DATA) == 0xCBF43926);
     static_assert(compute_crc32(TEST_DATA) == 0xCBF43926);
+    static_assert(compute_crc32({}) == 0);
+    static_assert(compute_crc32(CRC32_TEST_DATA) == compute_crc32_bytewise(CRC32_TEST_DATA));
+    static_assert(compute_crc32(CRC32_TEST_SPAN.subspan(13), compute_crc32(CRC32_TEST_SPAN.first(13))) ==
+                  compute_crc32(CRC32_TEST_DATA));
 
-    uint32_t crc32(std::span<const uint8_t> data) { return compute_crc32(data); }
+    uint32_t crc32(std::span<const uint8_t> data, uint32_t crc) { return compute_crc32(data, crc); }
 
 }
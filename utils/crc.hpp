@@ -8,6 +8,12 @@ namespace utils
 
     uint8_t crc8(std::span<const uint8_t> data);
 
-    uint32_t crc32(std::span<const uint8_t> data);
+    /// CRC-32 as used by zlib, PNG, etc. To compute the CRC over data in several parts, pass the result for the
+    /// previous parts as `crc`.
+    uint32_t crc32(std::span<const uint8_t> data, uint32_t crc = 0);
+
+    /// Same as `crc32()`, but computed in hardware by the DMA sniffer while a DMA channel reads through the data.
+    /// Worth it for larger buffers; falls back to `crc32()` if no DMA channel is free.
+    uint32_t crc32_dma(std::span<const uint8_t> data, uint32_t crc = 0);
 
 }
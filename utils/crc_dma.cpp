@@ -0,0 +1,80 @@
+#include "crc.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+
+#include <hardware/dma.h>
+
+namespace utils
+{
+
+    namespace
+    {
+        /// The sniffer is checked against the software implementation on first use.
+        enum class SnifferState { UNTESTED, OK, BROKEN } _snifferState = SnifferState::UNTESTED;
+
+        uint32_t reverse_bits(uint32_t value) {
+            value = (value >> 1 & 0x55555555) | (value & 0x55555555) << 1;
+            value = (value >> 2 & 0x33333333) | (value & 0x33333333) << 2;
+            value = (value >> 4 & 0x0F0F0F0F) | (value & 0x0F0F0F0F) << 4;
+            return __builtin_bswap32(value);
+        }
+
+        bool sniff_crc32(std::span<const uint8_t> data, uint32_t crc, uint32_t &result) {
+            const int channel = dma_claim_unused_channel(false);
+            if (channel < 0)
+                return false;
+
+            // Read through the data one byte at a time into a dummy word. Byte transfers keep the sniffer input in
+            // memory order for any alignment and length, and still move a byte per clock.
+            static volatile uint8_t dummy;
+            auto cfg = dma_channel_get_default_config(channel);
+            channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+            channel_config_set_read_increment(&cfg, true);
+            channel_config_set_write_increment(&cfg, false);
+            channel_config_set_sniff_enable(&cfg, true);
+
+            // Mode 1 is CRC-32 with bit reversed input, which matches the LSB first CRC-32 of zlib. The accumulator
+            // holds the state MSB first, so it is seeded reversed, and read back reversed and inverted.
+            dma_sniffer_enable(channel, 0x1, true);
+            dma_sniffer_set_output_reverse_enabled(true);
+            dma_sniffer_set_output_invert_enabled(true);
+            dma_sniffer_set_data_accumulator(reverse_bits(~crc));
+
+            dma_channel_configure(channel, &cfg, &dummy, data.data(), data.size(), true);
+            dma_channel_wait_for_finish_blocking(channel);
+
+            result = dma_sniffer_get_data_accumulator();
+            dma_sniffer_disable();
+            dma_channel_unclaim(channel);
+            return true;
+        }
+
+        void check_sniffer() {
+            constexpr std::array<uint8_t, 9> TEST_DATA = {0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39};
+            const auto span = std::span(TEST_DATA);
+            uint32_t whole = 0;
+            uint32_t parts = 0;
+            if (!sniff_crc32(span, 0, whole) || !sniff_crc32(span.first(4), 0, parts) ||
+                !sniff_crc32(span.subspan(4), parts, parts))
+                return; // No free channel; try again next time.
+            if (whole != 0xCBF43926 || parts != 0xCBF43926) {
+                printf("! CRC: DMA sniffer gave %08" PRIx32 "/%08" PRIx32 ", using software\n", whole, parts);
+                _snifferState = SnifferState::BROKEN;
+                return;
+            }
+            _snifferState = SnifferState::OK;
+        }
+    } // namespace
+
+    uint32_t crc32_dma(std::span<const uint8_t> data, uint32_t crc) {
+        if (_snifferState == SnifferState::UNTESTED)
+            check_sniffer();
+        uint32_t result;
+        if (_snifferState == SnifferState::OK && !data.empty() && sniff_crc32(data, crc, result))
+            return result;
+        return crc32(data, crc);
+    }
+
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace utils
+{
+
+    /**
+     * Compact log of the input to a game, one entry per tick, from which the game can be played again exactly.
+     *
+     * A log is a fixed header followed by records of what changed: the buttons held, or the milliseconds passed per
+     * tick. Ticks where neither changed take no space at all. Each record is two LEB128 varints, the number of ticks
+     * since the previous record, and the new value shifted left by one with the kind of value in the lowest bit.
+     * Together with the seed of the game's `Random`, that is everything a game needs to be re-simulated.
+     */
+    namespace input_log
+    {
+
+        constexpr uint32_t MAGIC   = 0x474F4C49; // "ILOG"
+        constexpr uint16_t VERSION = 1;
+
+        struct Header {
+            uint32_t magic   = MAGIC;
+            uint16_t version = VERSION;
+            uint8_t  game    = 0; ///< Which game this is a log of, so a log is never replayed by the wrong game.
+            uint8_t  _reserved = 0;
+            uint32_t seed    = 0; ///< Seed the game was reset with.
+            uint32_t buttons = 0; ///< Buttons held before the first tick, so presses can be told from holds.
+            uint32_t ticks   = 0; ///< Number of ticks in the log.
+            int32_t  score   = 0; ///< Final score, to check the replay against.
+            uint32_t size    = 0; ///< Size of the records following the header, in bytes.
+        };
+
+        static_assert(sizeof(Header) == 28);
+
+        enum Kind : uint32_t {
+            KIND_BUTTONS = 0,
+            KIND_DELTA   = 1,
+        };
+
+    } // namespace input_log
+
+    class InputLogWriter {
+    public:
+        /// Start a new log in `buffer`, for `game` reset with `seed`, with `initial_buttons` held.
+        void start(std::span<uint8_t> buffer, uint8_t game, uint32_t seed, uint32_t initial_buttons) {
+            this->buffer = buffer;
+            header = {};
+            header.game = game;
+            header.seed = seed;
+            header.buttons = initial_buttons;
+            size = sizeof(input_log::Header);
+            overflow = buffer.size() < size;
+            gap = 0;
+            buttons = initial_buttons;
+            delta_ms = 0;
+        }
+
+        /// Add a tick with the buttons held and the milliseconds passed. Returns false once the buffer is full, after
+        /// which the log is incomplete and `finish()` returns nothing.
+        bool record(uint32_t tick_buttons, int tick_delta_ms) {
+            if (overflow)
+                return false;
+            if (tick_buttons != buttons) {
+                put_record(tick_buttons, input_log::KIND_BUTTONS);
+                buttons = tick_buttons;
+            }
+            const auto delta = static_cast<uint32_t>(tick_delta_ms > 0 ? tick_delta_ms : 0);
+            if (delta != delta_ms) {
+                put_record(delta, input_log::KIND_DELTA);
+                delta_ms = delta;
+            }
+            header.ticks++;
+            gap++;
+            return !overflow;
+        }
+
+        /// Complete the log with the final score. Returns the whole log, or an empty span if it did not fit.
+        std::span<const uint8_t> finish(int score) {
+            if (overflow)
+                return {};
+            header.score = score;
+            header.size = size - sizeof(input_log::Header);
+            memcpy(buffer.data(), &header, sizeof(header));
+            return buffer.first(size);
+        }
+
+        [[nodiscard]] bool is_overflowed() const { return overflow; }
+        [[nodiscard]] uint32_t get_ticks() const { return header.ticks; }
+        [[nodiscard]] size_t get_size() const { return size; }
+
+    private:
+        std::span<uint8_t> buffer;
+        input_log::Header header;
+        size_t size = 0;
+        bool overflow = false;
+
+        uint32_t gap = 0; ///< Ticks since the last record.
+        uint32_t buttons = 0;
+        uint32_t delta_ms = 0;
+
+        void put_record(uint32_t value, input_log::Kind kind) {
+            put_varint(gap);
+            put_varint(value << 1 | kind);
+            gap = 0;
+        }
+
+        void put_varint(uint32_t value) {
+            do {
+                if (size == buffer.size()) {
+                    overflow = true;
+                    return;
+                }
+                const auto byte = static_cast<uint8_t>(value & 0x7F);
+                value >>= 7;
+                buffer[size++] = value != 0 ? byte | 0x80 : byte;
+            } while (value != 0);
+        }
+    };
+
+    class InputLogReader {
+    public:
+        /// Read the log in `data`, which must stay around while reading. Check `is_valid()` before anything else.
+        explicit InputLogReader(std::span<const uint8_t> data) {
+            if (data.size() < sizeof(input_log::Header))
+                return;
+            memcpy(&header, data.data(), sizeof(header));
+            if (header.magic != input_log::MAGIC || header.version != input_log::VERSION ||
+                header.size > data.size() - sizeof(header))
+                return;
+            records = data.subspan(sizeof(header), header.size);
+            current_buttons = header.buttons;
+            valid = true;
+            if (!records.empty())
+                next_gap = get_varint();
+        }
+
+        [[nodiscard]] bool is_valid() const { return valid && !corrupt; }
+        [[nodiscard]] const input_log::Header &get_header() const { return header; }
+
+        /// Read the next tick into `buttons` and `delta_ms`. Returns false after the last tick, or if the records are
+        /// damaged.
+        bool next(uint32_t &buttons, int &delta_ms) {
+            if (!valid || corrupt || tick == header.ticks)
+                return false;
+            while (next_gap == 0 && position < records.size()) {
+                const auto value = get_varint();
+                if ((value & 1) == input_log::KIND_BUTTONS)
+                    current_buttons = value >> 1;
+                else
+                    current_delta_ms = static_cast<int>(value >> 1);
+                next_gap = position < records.size() ? get_varint() : UINT32_MAX;
+            }
+            if (corrupt)
+                return false;
+            next_gap--;
+            tick++;
+            buttons = current_buttons;
+            delta_ms = current_delta_ms;
+            return true;
+        }
+
+    private:
+        input_log::Header header;
+        std::span<const uint8_t> records;
+        size_t position = 0;
+        bool valid = false;
+        bool corrupt = false;
+
+        uint32_t tick = 0;
+        uint32_t next_gap = UINT32_MAX; ///< Ticks until the next record applies.
+        uint32_t current_buttons = 0;
+        int current_delta_ms = 0;
+
+        uint32_t get_varint() {
+            uint32_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                if (position == records.size())
+                    break;
+                const auto byte = records[position++];
+                value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+            corrupt = true;
+            return UINT32_MAX;
+        }
+    };
+
+} // namespace utils
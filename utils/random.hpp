@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace utils
+{
+
+    /**
+     * Small and fast xorshift32 pseudo-random number generator.
+     *
+     * Each game keeps its own, seeded when a game starts, so the same seed and the same input always play out the
+     * same way. That is what makes recorded games replayable.
+     */
+    class Random {
+    public:
+        constexpr explicit Random(uint32_t seed = 1) { this->seed(seed); }
+
+        /// Start over from `seed`. Xorshift never leaves zero, so zero is replaced by another constant.
+        constexpr void seed(uint32_t seed) { state = seed != 0 ? seed : 0x9E3779B9; }
+
+        constexpr uint32_t next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        /// A number from zero up to `n`, exclusive.
+        constexpr uint32_t below(uint32_t n) { return next() % n; }
+
+    private:
+        uint32_t state = 1;
+    };
+
+} // namespace utils
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace utils
+{
+
+    /**
+     * Lock-free single producer, single consumer byte queue.
+     *
+     * The producer and consumer may run on different cores, or one of them in an interrupt handler. The indices only
+     * ever grow (wrapping at 2^32), so a full buffer can be told apart from an empty one without wasting a slot.
+     * Several producers must be serialized by the caller.
+     */
+    template<size_t SIZE>
+    class RingBuffer {
+    public:
+        static_assert((SIZE & (SIZE - 1)) == 0, "Size must be a power of two");
+
+        /// Append all of `data`, or nothing at all if it does not fit.
+        bool push(std::span<const uint8_t> data) {
+            const auto head = this->head.load(std::memory_order_relaxed);
+            const auto tail = this->tail.load(std::memory_order_acquire);
+            if (data.size() > SIZE - (head - tail))
+                return false;
+
+            const auto start = head & (SIZE - 1);
+            const auto n = std::min(data.size(), SIZE - start);
+            memcpy(&buffer[start], data.data(), n);
+            memcpy(&buffer[0], data.data() + n, data.size() - n);
+
+            this->head.store(head + data.size(), std::memory_order_release);
+            return true;
+        }
+
+        /// The oldest bytes in the buffer, up to the point where it wraps around.
+        [[nodiscard]] std::span<const uint8_t> peek() const {
+            const auto tail = this->tail.load(std::memory_order_relaxed);
+            const auto head = this->head.load(std::memory_order_acquire);
+            const auto start = tail & (SIZE - 1);
+            return {&buffer[start], std::min<size_t>(head - tail, SIZE - start)};
+        }
+
+        /// Remove `size` bytes previously returned by `peek()`.
+        void pop(size_t size) {
+            tail.store(tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+        }
+
+        [[nodiscard]] size_t size() const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::array<uint8_t, SIZE> buffer = {};
+        std::atomic<uint32_t> head = 0;
+        std::atomic<uint32_t> tail = 0;
+    };
+
+} // namespace utils
@@ -2,19 +2,83 @@
 
 #include <array>
 #include <bit>
-#include <cassert>
 #include <cstdint>
 #include <span>
-#include <vector>
+#include <string_view>
 
 namespace utils
 {
 
     using sha1_t = std::array<uint8_t, 20>;
 
-    constexpr sha1_t sha1_digest(std::span<const uint8_t> data) {
+    /// SHA-1 hash in lowercase hex, null terminated.
+    using sha1_hex_t = std::array<char, 41>;
+
+    /**
+     * Streaming SHA-1 context. Feed data with `update()` in as many parts as needed, then get the hash with
+     * `finalize()`. Only a single block is buffered, so this never allocates, and it works in constant expressions.
+     */
+    class Sha1 {
+    public:
+        constexpr Sha1 &update(std::span<const uint8_t> data) {
+            length += data.size();
+            size_t i = 0;
+            // Top up a partial block first, then hash whole blocks straight from the input.
+            if (block_size > 0) {
+                while (i < data.size() && block_size < BLOCK_SIZE)
+                    block[block_size++] = data[i++];
+                if (block_size < BLOCK_SIZE)
+                    return *this;
+                process_block(block.data());
+                block_size = 0;
+            }
+            for (; data.size() - i >= BLOCK_SIZE; i += BLOCK_SIZE)
+                process_block(&data[i]);
+            while (i < data.size())
+                block[block_size++] = data[i++];
+            return *this;
+        }
+
+        constexpr Sha1 &update(std::string_view text) {
+            length += text.size();
+            for (const auto ch : text) {
+                block[block_size++] = static_cast<uint8_t>(ch);
+                if (block_size == BLOCK_SIZE) {
+                    process_block(block.data());
+                    block_size = 0;
+                }
+            }
+            return *this;
+        }
+
+        /// Pad the message and return its hash. The context must not be used afterwards.
+        constexpr sha1_t finalize() {
+            const uint64_t ml = length * 8;
 
-        // C.f. https://en.wikipedia.org/wiki/SHA-1
+            block[block_size++] = 0x80;
+            if (block_size > BLOCK_SIZE - 8) {
+                while (block_size < BLOCK_SIZE)
+                    block[block_size++] = 0;
+                process_block(block.data());
+                block_size = 0;
+            }
+            while (block_size < BLOCK_SIZE - 8)
+                block[block_size++] = 0;
+            for (int i = 56; i >= 0; i -= 8)
+                block[block_size++] = (ml >> i) & 0xFF;
+            process_block(block.data());
+
+            sha1_t result;
+            for (int i = 0; i < 5; i++) {
+                for (int j = 0; j < 4; j++) {
+                    result[i * 4 + j] = (h[i] >> ((3 - j) * 8)) & 0xFF;
+                }
+            }
+            return result;
+        }
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64;
 
         std::array<uint32_t, 5> h = {
             0x67452301,
@@ -23,31 +87,24 @@ namespace utils
             0x10325476,
             0xC3D2E1F0,
         };
+        std::array<uint8_t, BLOCK_SIZE> block = {};
+        size_t block_size = 0;
+        uint64_t length = 0;
 
-        std::vector<uint8_t> padded_data{data.begin(), data.end()};
-        padded_data.push_back(0x80);
-        while (padded_data.size() % 64 != 56)
-            padded_data.push_back(0);
-        const uint64_t ml = data.size() * 8;
-        for (int i = 56; i >= 0; i -= 8)
-            padded_data.push_back((ml >> i) & 0xff);
+        constexpr void process_block(const uint8_t *data) {
 
-        assert(padded_data.size() % 64 == 0);
+            // C.f. https://en.wikipedia.org/wiki/SHA-1
 
-        for (size_t i0 = 0; i0 < padded_data.size(); i0 += 64) {
-
-            std::array<uint32_t, 80> w = {};
+            // The message schedule only ever looks back 16 words, so keep it in a circular buffer instead of
+            // expanding all 80 words up front.
+            std::array<uint32_t, 16> w = {};
 
             for (int i = 0; i < 16; i++) {
                 for (int j = 0; j < 4; j++) {
-                    w[i] = (w[i] << 8) | padded_data[i0 + i * 4 + j];
+                    w[i] = (w[i] << 8) | data[i * 4 + j];
                 }
             }
 
-            for (int i = 16; i < 80; i++) {
-                w[i] = std::rotl<uint32_t>(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
-            }
-
             uint32_t a = h[0];
             uint32_t b = h[1];
             uint32_t c = h[2];
@@ -57,6 +114,11 @@ namespace utils
             uint32_t k;
 
             for (int i = 0; i < 80; i++) {
+                if (i >= 16) {
+                    w[i & 15] = std::rotl<uint32_t>(w[(i - 3) & 15] ^ w[(i - 8) & 15] ^ w[(i - 14) & 15] ^ w[i & 15],
+                                                    1);
+                }
+
                 if (i < 20) {
                     f = (b & c) | (~b & d);
                     k = 0x5A827999;
@@ -74,7 +136,7 @@ namespace utils
                     k = 0xCA62C1D6;
                 }
 
-                const uint32_t temp = std::rotl<uint32_t>(a, 5) + f + e + k + w[i];
+                const uint32_t temp = std::rotl<uint32_t>(a, 5) + f + e + k + w[i & 15];
                 e = d;
                 d = c;
                 c = std::rotl<uint32_t>(b, 30);
@@ -87,38 +149,67 @@ namespace utils
             h[2] += c;
             h[3] += d;
             h[4] += e;
-
         }
+    };
 
-        sha1_t result;
-        for (int i = 0; i < 5; i++) {
-            for (int j = 0; j < 4; j++) {
-                result[i * 4 + j] = (h[i] >> ((3 - j) * 8)) & 0xFF;
-            }
-        }
-
-        return result;
-
+    constexpr sha1_t sha1_digest(std::span<const uint8_t> data) {
+        return Sha1().update(data).finalize();
     }
 
-    constexpr sha1_t sha1_digest(const std::string& text) {
-        std::vector<uint8_t> data(text.begin(), text.end());
-        return sha1_digest(data);
+    constexpr sha1_t sha1_digest(std::string_view text) {
+        return Sha1().update(text).finalize();
     }
 
-    constexpr std::string sha1_hex_string(const auto& data) {
+    constexpr sha1_hex_t sha1_hex(const sha1_t &hash) {
         constexpr auto HEX_ALPHABET = "0123456789abcdef";
-        const auto hash = sha1_digest(data);
-        char buffer[41];
+        sha1_hex_t buffer = {};
         for (int i = 0; i < 20; i++) {
             buffer[i * 2 + 0] = HEX_ALPHABET[hash[i] >> 4];
             buffer[i * 2 + 1] = HEX_ALPHABET[hash[i] & 0xF];
         }
         buffer[40] = 0;
-        return {buffer};
+        return buffer;
+    }
+
+    constexpr sha1_hex_t sha1_hex(std::string_view text) {
+        return sha1_hex(sha1_digest(text));
     }
 
-    static_assert(sha1_hex_string("") == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
-    static_assert(sha1_hex_string("The quick brown fox jumps over the lazy dog") == "2fd4e1c67a2d28fced849ee1bb76e7391b93eb12");
+    namespace sha1_test
+    {
+        constexpr bool hex_equals(const sha1_hex_t &hex, std::string_view expected) {
+            return std::string_view(hex.data(), 40) == expected;
+        }
+
+        /// Hash `text` fed in parts of `part_size` bytes, to exercise the block buffering.
+        constexpr sha1_hex_t hex_in_parts(std::string_view text, size_t part_size) {
+            Sha1 sha1;
+            for (size_t i = 0; i < text.size(); i += part_size)
+                sha1.update(text.substr(i, part_size));
+            return sha1_hex(sha1.finalize());
+        }
+
+        constexpr std::string_view LONG_TEXT = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+        constexpr std::string_view LONG_TEXT_HEX = "84983e441c3bd26ebaae4aa1f95129e5e54670f1";
+
+        static_assert(hex_equals(sha1_hex(""), "da39a3ee5e6b4b0d3255bfef95601890afd80709"));
+        static_assert(hex_equals(sha1_hex("The quick brown fox jumps over the lazy dog"),
+                                 "2fd4e1c67a2d28fced849ee1bb76e7391b93eb12"));
+        static_assert(hex_equals(sha1_hex(LONG_TEXT), LONG_TEXT_HEX));
+        static_assert(hex_equals(hex_in_parts(LONG_TEXT, 1), LONG_TEXT_HEX));
+        static_assert(hex_equals(hex_in_parts(LONG_TEXT, 7), LONG_TEXT_HEX));
+
+        constexpr auto BYTES = [] {
+            std::array<uint8_t, 200> result = {};
+            for (size_t i = 0; i < result.size(); i++)
+                result[i] = i * 7 + 3;
+            return result;
+        }();
+        constexpr auto BYTES_SPAN = std::span(BYTES);
+
+        static_assert(Sha1().update(BYTES_SPAN.first(70)).update(BYTES_SPAN.subspan(70)).finalize() ==
+                      sha1_digest(BYTES));
+        static_assert(hex_equals(sha1_hex(sha1_digest(BYTES)), "892b673ca3c696ab13ab8aab3cf3abfbc3aaeb3b"));
+    } // namespace sha1_test
 
 }